@@ -9,15 +9,20 @@ find_library(AVFORMAT_LIBRARY avformat)
 find_path(AVUTIL_INCLUDE_DIR NAMES libavutil/avutil.h PATH_SUFFIXES ffmpeg)
 find_library(AVUTIL_LIBRARY avutil)
 
+find_path(SWRESAMPLE_INCLUDE_DIR NAMES libswresample/swresample.h PATH_SUFFIXES ffmpeg)
+find_library(SWRESAMPLE_LIBRARY swresample)
+
 include(FindPackageHandleStandardArgs)
 
 FIND_PACKAGE_HANDLE_STANDARD_ARGS(
         FFMPEGAV
         FOUND_VAR FFMPEGAV_FOUND
-        REQUIRED_VARS AVUTIL_LIBRARY AVFORMAT_LIBRARY
+        REQUIRED_VARS AVUTIL_LIBRARY AVFORMAT_LIBRARY AVCODEC_LIBRARY SWRESAMPLE_LIBRARY
 )
 
+mark_as_advanced(AVCODEC_LIBRARY)
 mark_as_advanced(AVFORMAT_LIBRARY)
 mark_as_advanced(AVUTIL_LIBRARY)
+mark_as_advanced(SWRESAMPLE_LIBRARY)
 
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#if LMS_SUPPORT_IMAGE_STB
+#include "stb/RawImage.hpp"
+using RawImage = CoverArt::STB::RawImage;
+#elif LMS_SUPPORT_IMAGE_GM
+#include "graphicsmagick/RawImage.hpp"
+using RawImage = CoverArt::GraphicsMagick::RawImage;
+#endif
+
+// The source image is read from LMS_BENCHMARK_IMAGE if set,
+// otherwise a synthetic 1200x1200 picture (typical embedded cover size) is used
+namespace
+{
+	void
+	writeLittleEndian(std::vector<std::byte>& data, std::uint32_t value, std::size_t byteCount)
+	{
+		for (std::size_t i {}; i < byteCount; ++i)
+			data.push_back(static_cast<std::byte>((value >> (i * 8)) & 0xFF));
+	}
+
+	// Uncompressed 24 bits BMP, decoded by all the supported image libraries
+	std::vector<std::byte>
+	generateBMPImage(std::uint32_t width, std::uint32_t height)
+	{
+		const std::uint32_t rowSize {(width * 3 + 3) & ~3u};
+		const std::uint32_t headerSize {14 + 40};
+
+		std::vector<std::byte> data;
+		data.reserve(headerSize + rowSize * height);
+
+		// file header
+		data.push_back(std::byte {'B'});
+		data.push_back(std::byte {'M'});
+		writeLittleEndian(data, headerSize + rowSize * height, 4);
+		writeLittleEndian(data, 0, 4);
+		writeLittleEndian(data, headerSize, 4);
+
+		// info header
+		writeLittleEndian(data, 40, 4);
+		writeLittleEndian(data, width, 4);
+		writeLittleEndian(data, height, 4);
+		writeLittleEndian(data, 1, 2);	// planes
+		writeLittleEndian(data, 24, 2);	// bits per pixel
+		writeLittleEndian(data, 0, 4);	// no compression
+		writeLittleEndian(data, rowSize * height, 4);
+		writeLittleEndian(data, 2835, 4);
+		writeLittleEndian(data, 2835, 4);
+		writeLittleEndian(data, 0, 4);
+		writeLittleEndian(data, 0, 4);
+
+		// gradients and some high frequency content, so that the encoder has something to do
+		for (std::uint32_t y {}; y < height; ++y)
+		{
+			for (std::uint32_t x {}; x < width; ++x)
+			{
+				data.push_back(static_cast<std::byte>(x * 255 / width));
+				data.push_back(static_cast<std::byte>(y * 255 / height));
+				data.push_back(static_cast<std::byte>(((x / 8) ^ (y / 8)) & 1 ? 200 : 50));
+			}
+			for (std::uint32_t i {width * 3}; i < rowSize; ++i)
+				data.push_back(std::byte {0});
+		}
+
+		return data;
+	}
+
+	const std::vector<std::byte>&
+	getSourceImage()
+	{
+		static const std::vector<std::byte> image {[]
+		{
+			if (const char* path {std::getenv("LMS_BENCHMARK_IMAGE")})
+			{
+				std::ifstream ifs {path, std::ios_base::binary};
+				std::vector<char> content {std::istreambuf_iterator<char> {ifs}, std::istreambuf_iterator<char> {}};
+
+				std::vector<std::byte> res(content.size());
+				std::transform(std::cbegin(content), std::cend(content), std::begin(res), [](char c) { return static_cast<std::byte>(c); });
+				return res;
+			}
+
+			return generateBMPImage(1200, 1200);
+		}()};
+
+		return image;
+	}
+}
+
+static void
+BM_Cover_Decode(benchmark::State& state)
+{
+	const std::vector<std::byte>& sourceImage {getSourceImage()};
+
+	for (auto _ : state)
+	{
+		RawImage image {sourceImage.data(), sourceImage.size()};
+		benchmark::DoNotOptimize(image);
+	}
+
+	state.SetBytesProcessed(state.iterations() * sourceImage.size());
+}
+BENCHMARK(BM_Cover_Decode)->Unit(benchmark::kMillisecond);
+
+// What the cover grabber does for each request that misses the cache
+static void
+BM_Cover_ResizeEncode(benchmark::State& state)
+{
+	const std::vector<std::byte>& sourceImage {getSourceImage()};
+	const CoverArt::ImageSize size {static_cast<CoverArt::ImageSize>(state.range(0))};
+
+	std::size_t encodedSize {};
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		RawImage image {sourceImage.data(), sourceImage.size()};
+		state.ResumeTiming();
+
+		image.resize(size);
+		const std::unique_ptr<CoverArt::IEncodedImage> encodedImage {image.encodeToJPEG(75)};
+		encodedSize = encodedImage->getDataSize();
+	}
+
+	state.counters["encoded_size"] = static_cast<double>(encodedSize);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Cover_ResizeEncode)->Arg(128)->Arg(512)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+#if LMS_SUPPORT_IMAGE_GM
+	CoverArt::GraphicsMagick::init(argv[0]);
+#endif
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return EXIT_FAILURE;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	return EXIT_SUCCESS;
+}
+
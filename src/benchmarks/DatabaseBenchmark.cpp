@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <sstream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "database/TrackFeatures.hpp"
+
+namespace
+{
+	// Same layout and order of magnitude of size as the AcousticBrainz low level documents
+	std::string
+	generateJsonEncodedFeatures()
+	{
+		const std::vector<std::pair<std::string, std::size_t>> descriptors
+		{
+			{"average_loudness", 1},
+			{"barkbands", 27},
+			{"dissonance", 1},
+			{"erbbands", 40},
+			{"gfcc", 13},
+			{"melbands", 40},
+			{"mfcc", 13},
+			{"spectral_centroid", 1},
+			{"spectral_contrast_coeffs", 6},
+			{"spectral_contrast_valleys", 6},
+			{"spectral_energyband_high", 1},
+			{"spectral_rolloff", 1},
+			{"zerocrossingrate", 1},
+		};
+		const std::vector<std::string> statistics {"dmean", "dmean2", "dvar", "dvar2", "max", "mean", "median", "min", "var"};
+
+		std::mt19937 generator {42};
+		std::uniform_real_distribution<double> distribution {0, 1000};
+
+		boost::property_tree::ptree lowlevel;
+		for (const auto& [name, dimCount] : descriptors)
+		{
+			boost::property_tree::ptree descriptor;
+			for (const std::string& statistic : statistics)
+			{
+				if (dimCount == 1)
+				{
+					descriptor.put(statistic, distribution(generator));
+					continue;
+				}
+
+				boost::property_tree::ptree values;
+				for (std::size_t i {}; i < dimCount; ++i)
+				{
+					boost::property_tree::ptree value;
+					value.put("", distribution(generator));
+					values.push_back({"", value});
+				}
+				descriptor.add_child(statistic, values);
+			}
+			lowlevel.add_child(name, descriptor);
+		}
+
+		boost::property_tree::ptree root;
+		root.add_child("lowlevel", lowlevel);
+
+		std::ostringstream oss;
+		boost::property_tree::write_json(oss, root, false);
+		return oss.str();
+	}
+}
+
+// Done for each track when the features similarity engine is loaded
+static void
+BM_TrackFeatures_GetFeatureValuesMap(benchmark::State& state)
+{
+	const std::string features {generateJsonEncodedFeatures()};
+	const Database::TrackFeatures trackFeatures {{}, features};
+
+	// default similarity settings
+	const std::unordered_set<Database::FeatureName> featureNames
+	{
+		"lowlevel.spectral_energyband_high.mean",
+		"lowlevel.spectral_rolloff.median",
+		"lowlevel.spectral_contrast_valleys.var",
+		"lowlevel.erbbands.mean",
+		"lowlevel.gfcc.mean",
+	};
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(trackFeatures.getFeatureValuesMap(featureNames));
+
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * features.size());
+}
+BENCHMARK(BM_TrackFeatures_GetFeatureValuesMap)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
+
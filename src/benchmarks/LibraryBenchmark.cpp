@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// End to end benchmark on a real library (see lms-library-generator to generate a synthetic one):
+// - full scan of the library, in a fresh database
+// - rescan with no change
+// - incremental scan, after touching some of the files
+// - a fixed mix of Subsonic requests, sent by concurrent clients over HTTP to an in-process server
+// Reports the scan throughputs and the request latency percentiles, optionally as JSON
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/program_options.hpp>
+#include <Wt/WServer.h>
+
+#include "auth/IPasswordService.hpp"
+#include "cover/ICoverArtGrabber.hpp"
+#include "database/Artist.hpp"
+#include "database/Db.hpp"
+#include "database/Release.hpp"
+#include "database/ScanSettings.hpp"
+#include "database/Session.hpp"
+#include "database/Track.hpp"
+#include "database/User.hpp"
+#include "recommendation/IEngine.hpp"
+#include "scanner/IScanner.hpp"
+#include "subsonic/SubsonicResource.hpp"
+#include "utils/IConfig.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+
+namespace
+{
+	const std::string userName {"benchmark"};
+	const std::string userPassword {"benchmark-password"};
+
+	struct ScanResult
+	{
+		std::string	name;
+		std::chrono::duration<double>	duration;
+		Scanner::ScanStats	stats;
+	};
+
+	struct RequestType
+	{
+		std::string	name;
+		std::vector<double>	latencies;	// in ms
+		std::size_t	errorCount {};
+	};
+
+	struct QueryInputs
+	{
+		std::vector<Database::IdType>	releaseIds;
+		std::vector<std::string>	searchQueries;
+	};
+
+	ScanResult
+	runScan(Scanner::IScanner& scanner, const std::string& name)
+	{
+		std::cout << "Running " << name << "..." << std::endl;
+
+		std::promise<Scanner::ScanStats> scanComplete;
+		auto connection {scanner.getEvents().scanComplete.connect([&](const Scanner::ScanStats& stats)
+		{
+			scanComplete.set_value(stats);
+		})};
+
+		const auto start {std::chrono::steady_clock::now()};
+		scanner.requestImmediateScan(false);
+
+		ScanResult res;
+		res.name = name;
+		res.stats = scanComplete.get_future().get();
+		res.duration = std::chrono::steady_clock::now() - start;
+
+		connection.disconnect();
+
+		return res;
+	}
+
+	void
+	touchFiles(const std::filesystem::path& libraryPath, float ratio, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> ratioDist {0, 1};
+		const auto now {std::filesystem::file_time_type::clock::now()};
+
+		std::size_t count {};
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator {libraryPath})
+		{
+			if (entry.is_regular_file() && ratioDist(rng) < ratio)
+			{
+				std::filesystem::last_write_time(entry.path(), now);
+				count++;
+			}
+		}
+
+		std::cout << "Touched " << count << " files" << std::endl;
+	}
+
+	void
+	prepareDatabase(Database::Db& db, const std::filesystem::path& libraryPath)
+	{
+		Database::Session session {db};
+		session.prepareTables();
+
+		auto transaction {session.createUniqueTransaction()};
+
+		Database::ScanSettings::pointer scanSettings {Database::ScanSettings::get(session)};
+		scanSettings.modify()->setMediaDirectory(libraryPath);
+
+		Database::User::pointer user {Database::User::create(session, userName)};
+		user.modify()->setPasswordHash(Service<Auth::IPasswordService>::get()->hashPassword(userPassword));
+	}
+
+	QueryInputs
+	getQueryInputs(Database::Db& db, std::mt19937& rng)
+	{
+		QueryInputs res;
+
+		Database::Session session {db};
+		auto transaction {session.createSharedTransaction()};
+
+		res.releaseIds = Database::Release::getAllIds(session);
+
+		std::vector<Database::IdType> artistIds {Database::Artist::getAllIds(session)};
+		std::shuffle(std::begin(artistIds), std::end(artistIds), rng);
+		artistIds.resize(std::min<std::size_t>(artistIds.size(), 100));
+
+		for (const Database::IdType artistId : artistIds)
+		{
+			const Database::Artist::pointer artist {Database::Artist::getById(session, artistId)};
+			if (!artist)
+				continue;
+
+			// search on the first word only, to get several matches
+			const std::string& name {artist->getName()};
+			res.searchQueries.push_back(name.substr(0, name.find(' ')));
+		}
+
+		return res;
+	}
+
+	std::string
+	urlEncode(const std::string& str)
+	{
+		std::ostringstream oss;
+		oss << std::hex << std::uppercase;
+		for (const unsigned char c : str)
+		{
+			if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+				oss << c;
+			else
+				oss << '%' << std::setw(2) << std::setfill('0') << static_cast<unsigned>(c);
+		}
+
+		return oss.str();
+	}
+
+	// Minimal blocking HTTP/1.0 client: one connection per request, as many simple clients do
+	// Returns true if the request succeeded, as seen by a Subsonic client
+	bool
+	sendRequest(unsigned short port, const std::string& target)
+	{
+		boost::asio::ip::tcp::iostream stream {"127.0.0.1", std::to_string(port)};
+		if (!stream)
+			return false;
+
+		stream << "GET " << target << " HTTP/1.0\r\n"
+			<< "Host: 127.0.0.1\r\n"
+			<< "Connection: close\r\n\r\n" << std::flush;
+
+		std::string httpVersion;
+		unsigned statusCode {};
+		stream >> httpVersion >> statusCode;
+
+		// consume the whole response, as a client would do
+		const std::string response {std::istreambuf_iterator<char> {stream}, std::istreambuf_iterator<char> {}};
+
+		return statusCode == 200 && response.find("\"status\":\"failed\"") == std::string::npos;
+	}
+
+	// Requests use the API version announced by the server: requests made using a more recent version are rejected
+	std::string
+	makeRequestTarget(const std::string& entryPoint, const std::string& parameters)
+	{
+		return "/rest/" + entryPoint + "?u=" + urlEncode(userName) + "&p=" + urlEncode(userPassword) + "&v=1.16.0&c=lms-benchmark&f=json" + (parameters.empty() ? "" : "&" + parameters);
+	}
+
+	std::vector<RequestType>
+	runRequests(unsigned short port, const QueryInputs& inputs, std::size_t requestCountPerType, std::size_t clientCount, std::uint32_t seed)
+	{
+		using RequestGenerator = std::function<std::string(std::mt19937&)>;
+
+		auto pick = [](const auto& container, std::mt19937& rng) -> const auto&
+		{
+			return container[std::uniform_int_distribution<std::size_t> {0, container.size() - 1}(rng)];
+		};
+
+		const std::size_t releaseCount {inputs.releaseIds.size()};
+
+		std::vector<std::pair<std::string, RequestGenerator>> requestGenerators
+		{
+			{"getAlbumList2(alphabeticalByName)", [=](std::mt19937& rng)
+				{
+					return makeRequestTarget("getAlbumList2", "type=alphabeticalByName&size=50&offset=" + std::to_string(std::uniform_int_distribution<std::size_t> {0, releaseCount}(rng)));
+				}},
+			{"getAlbumList2(newest)", [=](std::mt19937& rng)
+				{
+					return makeRequestTarget("getAlbumList2", "type=newest&size=50&offset=" + std::to_string(std::uniform_int_distribution<std::size_t> {0, std::min<std::size_t>(releaseCount, 500)}(rng)));
+				}},
+			{"getAlbumList2(random)", [](std::mt19937&)
+				{
+					return makeRequestTarget("getAlbumList2", "type=random&size=50");
+				}},
+			{"search3", [&](std::mt19937& rng)
+				{
+					return makeRequestTarget("search3", "query=" + urlEncode(pick(inputs.searchQueries, rng)) + "&artistCount=20&albumCount=20&songCount=20");
+				}},
+			{"getRandomSongs", [](std::mt19937&)
+				{
+					return makeRequestTarget("getRandomSongs", "size=50");
+				}},
+			{"getCoverArt", [&](std::mt19937& rng)
+				{
+					return makeRequestTarget("getCoverArt", "id=al-" + std::to_string(pick(inputs.releaseIds, rng)) + "&size=256");
+				}},
+		};
+
+		std::vector<RequestType> res;
+		for (const auto& [name, generator] : requestGenerators)
+			res.push_back(RequestType {name, {}, {}});
+
+		std::mutex resultMutex;
+		std::vector<std::thread> clients;
+		for (std::size_t client {}; client < clientCount; ++client)
+		{
+			clients.emplace_back([&, client]
+			{
+				std::mt19937 rng {seed + static_cast<std::uint32_t>(client)};
+				std::vector<RequestType> clientResults {res};
+
+				// interleave the request types, as real clients do
+				for (std::size_t i {client}; i < requestCountPerType; i += clientCount)
+				{
+					for (std::size_t requestType {}; requestType < requestGenerators.size(); ++requestType)
+					{
+						const std::string target {requestGenerators[requestType].second(rng)};
+
+						const auto start {std::chrono::steady_clock::now()};
+						const bool success {sendRequest(port, target)};
+						const std::chrono::duration<double, std::milli> duration {std::chrono::steady_clock::now() - start};
+
+						clientResults[requestType].latencies.push_back(duration.count());
+						if (!success)
+							clientResults[requestType].errorCount++;
+					}
+				}
+
+				std::scoped_lock lock {resultMutex};
+				for (std::size_t requestType {}; requestType < res.size(); ++requestType)
+				{
+					res[requestType].latencies.insert(std::end(res[requestType].latencies), std::cbegin(clientResults[requestType].latencies), std::cend(clientResults[requestType].latencies));
+					res[requestType].errorCount += clientResults[requestType].errorCount;
+				}
+			});
+		}
+
+		for (std::thread& client : clients)
+			client.join();
+
+		for (RequestType& requestType : res)
+			std::sort(std::begin(requestType.latencies), std::end(requestType.latencies));
+
+		return res;
+	}
+
+	double
+	getPercentile(const std::vector<double>& sortedValues, double percentile)
+	{
+		if (sortedValues.empty())
+			return 0;
+
+		const std::size_t index {static_cast<std::size_t>(std::ceil(percentile * sortedValues.size()))};
+		return sortedValues[std::clamp<std::size_t>(index, 1, sortedValues.size()) - 1];
+	}
+
+	double
+	getScanThroughput(const ScanResult& scan)
+	{
+		// skipped files are included, since checking them is part of the scan
+		return scan.duration.count() > 0 ? (scan.stats.scans + scan.stats.skips) / scan.duration.count() : 0;
+	}
+
+	void
+	printReport(std::ostream& os, const std::vector<ScanResult>& scans, const std::vector<RequestType>& requestTypes)
+	{
+		os << std::fixed << std::setprecision(2);
+
+		os << "\n*** Scans ***\n";
+		for (const ScanResult& scan : scans)
+		{
+			os << scan.name << ": " << scan.duration.count() << " s"
+				<< ", scanned = " << scan.stats.scans
+				<< ", skipped = " << scan.stats.skips
+				<< ", additions = " << scan.stats.additions
+				<< ", updates = " << scan.stats.updates
+				<< ", errors = " << scan.stats.errors.size()
+				<< ", throughput = " << getScanThroughput(scan) << " files/s\n";
+		}
+
+		os << "\n*** Requests (latencies in ms) ***\n";
+		os << std::left << std::setw(36) << "request" << std::right
+			<< std::setw(8) << "count" << std::setw(8) << "errors"
+			<< std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+		for (const RequestType& requestType : requestTypes)
+		{
+			os << std::left << std::setw(36) << requestType.name << std::right
+				<< std::setw(8) << requestType.latencies.size() << std::setw(8) << requestType.errorCount
+				<< std::setw(10) << getPercentile(requestType.latencies, 0.5)
+				<< std::setw(10) << getPercentile(requestType.latencies, 0.9)
+				<< std::setw(10) << getPercentile(requestType.latencies, 0.99)
+				<< std::setw(10) << getPercentile(requestType.latencies, 1) << "\n";
+		}
+		os << std::flush;
+	}
+
+	void
+	writeJSONReport(const std::filesystem::path& path, const std::vector<ScanResult>& scans, const std::vector<RequestType>& requestTypes)
+	{
+		std::ofstream os {path};
+		if (!os)
+			throw std::runtime_error {"Cannot write report '" + path.string() + "'"};
+
+		os << "{\n\t\"scans\": [\n";
+		for (std::size_t i {}; i < scans.size(); ++i)
+		{
+			const ScanResult& scan {scans[i]};
+			os << "\t\t{\"name\": \"" << scan.name << "\""
+				<< ", \"duration_s\": " << scan.duration.count()
+				<< ", \"scanned\": " << scan.stats.scans
+				<< ", \"skipped\": " << scan.stats.skips
+				<< ", \"additions\": " << scan.stats.additions
+				<< ", \"updates\": " << scan.stats.updates
+				<< ", \"errors\": " << scan.stats.errors.size()
+				<< ", \"files_per_second\": " << getScanThroughput(scan) << "}"
+				<< (i + 1 < scans.size() ? "," : "") << "\n";
+		}
+		os << "\t],\n\t\"requests\": [\n";
+		for (std::size_t i {}; i < requestTypes.size(); ++i)
+		{
+			const RequestType& requestType {requestTypes[i]};
+			os << "\t\t{\"name\": \"" << requestType.name << "\""
+				<< ", \"count\": " << requestType.latencies.size()
+				<< ", \"errors\": " << requestType.errorCount
+				<< ", \"p50_ms\": " << getPercentile(requestType.latencies, 0.5)
+				<< ", \"p90_ms\": " << getPercentile(requestType.latencies, 0.9)
+				<< ", \"p99_ms\": " << getPercentile(requestType.latencies, 0.99)
+				<< ", \"max_ms\": " << getPercentile(requestType.latencies, 1) << "}"
+				<< (i + 1 < requestTypes.size() ? "," : "") << "\n";
+		}
+		os << "\t]\n}\n";
+	}
+
+	std::vector<std::string>
+	generateWtServerArgs(const char* execPath, const std::filesystem::path& workingDir, std::size_t threadCount)
+	{
+		// quiet server, the access log would be way too verbose
+		const std::filesystem::path wtConfigPath {workingDir / "wt_config.xml"};
+		{
+			std::ofstream ofs {wtConfigPath};
+			ofs << "<server><application-settings location=\"*\"><log-config>* -debug -info</log-config></application-settings></server>\n";
+		}
+
+		return {
+			execPath,
+			"--config=" + wtConfigPath.string(),
+			"--docroot=" + workingDir.string(),
+			"--http-address=127.0.0.1",
+			"--http-port=0",
+			"--accesslog=-",
+			"--threads=" + std::to_string(threadCount),
+		};
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		namespace po = boost::program_options;
+
+		po::options_description desc{"Allowed options"};
+		desc.add_options()
+		("help,h", "print usage message")
+		("library,l", po::value<std::string>()->required(), "library to scan")
+		("working-dir,w", po::value<std::string>()->default_value((std::filesystem::temp_directory_path() / "lms-bench-library").string()), "working directory, the database is recreated from scratch")
+		("conf,c", po::value<std::string>(), "LMS config file, to benchmark some specific settings")
+		("default-cover", po::value<std::string>()->default_value(LMS_BENCHMARK_APPROOT "/images/unknown-cover.jpg"), "default cover file")
+		("touch-ratio", po::value<float>()->default_value(0.01f), "ratio of files touched before the incremental scan")
+		("requests,r", po::value<std::size_t>()->default_value(500), "number of requests per request type")
+		("clients", po::value<std::size_t>()->default_value(4), "number of concurrent clients")
+		("server-threads", po::value<std::size_t>()->default_value(std::max<std::size_t>(std::thread::hardware_concurrency(), 1)), "number of server threads")
+		("seed", po::value<std::uint32_t>()->default_value(42), "random seed")
+		("report", po::value<std::string>(), "JSON report file")
+		("verbose,v", "log to stdout")
+		;
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+
+		if (vm.count("help"))
+		{
+			std::cout << desc << std::endl;
+			return EXIT_SUCCESS;
+		}
+		po::notify(vm);
+
+		std::unique_ptr<Service<Logger>> logger;
+		if (vm.count("verbose"))
+			logger = std::make_unique<Service<Logger>>(std::make_unique<StreamLogger>(std::cout));
+
+		const std::filesystem::path libraryPath {std::filesystem::canonical(vm["library"].as<std::string>())};
+		const std::filesystem::path workingDir {vm["working-dir"].as<std::string>()};
+		std::filesystem::remove_all(workingDir);
+		std::filesystem::create_directories(workingDir);
+
+		std::filesystem::path configPath {workingDir / "lms.conf"};
+		if (vm.count("conf"))
+			configPath = vm["conf"].as<std::string>();
+		else
+			std::ofstream ofs {configPath};	// empty config: defaults for all settings
+
+		Service<IConfig> config {createConfig(configPath)};
+
+		std::mt19937 rng {vm["seed"].as<std::uint32_t>()};
+
+		Database::Db db {workingDir / "lms.db"};
+
+		Service<Auth::IPasswordService> passwordService {Auth::createPasswordService(config->getULong("login-throttler-max-entriees", 10000))};
+		Service<CoverArt::IGrabber> coverArtService {CoverArt::createGrabber(argv[0],
+				vm["default-cover"].as<std::string>(),
+				config->getULong("cover-max-cache-size", 30) * 1000 * 1000,
+				config->getULong("cover-max-file-size", 10) * 1000 * 1000,
+				config->getULong("cover-jpeg-quality", 75))};
+
+		prepareDatabase(db, libraryPath);
+
+		Service<Recommendation::IEngine> recommendationEngineService {Recommendation::createEngine(db)};
+		const std::unique_ptr<Scanner::IScanner> scanner {Scanner::createScanner(db, *recommendationEngineService)};
+
+		std::vector<ScanResult> scans;
+		scans.push_back(runScan(*scanner, "full scan"));
+		scans.push_back(runScan(*scanner, "rescan (no change)"));
+		touchFiles(libraryPath, vm["touch-ratio"].as<float>(), rng);
+		scans.push_back(runScan(*scanner, "incremental scan"));
+
+		const QueryInputs queryInputs {getQueryInputs(db, rng)};
+		if (queryInputs.releaseIds.empty() || queryInputs.searchQueries.empty())
+			throw std::runtime_error {"No release found in library '" + libraryPath.string() + "'"};
+
+		const std::vector<std::string> wtServerArgs {generateWtServerArgs(argv[0], workingDir, vm["server-threads"].as<std::size_t>())};
+		std::vector<const char*> wtArgv;
+		for (const std::string& arg : wtServerArgs)
+			wtArgv.push_back(arg.c_str());
+
+		Wt::WServer server {argv[0]};
+		server.setServerConfiguration(wtArgv.size(), const_cast<char**>(wtArgv.data()));
+
+		API::Subsonic::SubsonicResource subsonicResource {db};
+		server.addResource(&subsonicResource, subsonicResource.getPath());
+		server.start();
+
+		const std::size_t clientCount {std::max<std::size_t>(vm["clients"].as<std::size_t>(), 1)};
+		std::cout << "Sending requests using " << clientCount << " clients..." << std::endl;
+		const std::vector<RequestType> requestTypes {runRequests(static_cast<unsigned short>(server.httpPort()), queryInputs, vm["requests"].as<std::size_t>(), clientCount, vm["seed"].as<std::uint32_t>())};
+
+		server.stop();
+
+		printReport(std::cout, scans, requestTypes);
+		if (vm.count("report"))
+			writeJSONReport(vm["report"].as<std::string>(), scans, requestTypes);
+
+		// Latencies of failed requests are meaningless
+		const std::size_t errorCount {std::accumulate(std::cbegin(requestTypes), std::cend(requestTypes), std::size_t {}, [](std::size_t count, const RequestType& requestType) { return count + requestType.errorCount; })};
+		if (errorCount > 0)
+		{
+			std::cerr << errorCount << " request(s) failed" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "metadata/TagLibParser.hpp"
+#include "utils/String.hpp"
+
+// The corpus is made of the audio files found in the directory set in LMS_BENCHMARK_AUDIO_DIR
+namespace
+{
+	const std::vector<std::filesystem::path>&
+	getCorpus()
+	{
+		static const std::vector<std::filesystem::path> corpus {[]
+		{
+			std::vector<std::filesystem::path> res;
+
+			const char* directory {std::getenv("LMS_BENCHMARK_AUDIO_DIR")};
+			if (!directory)
+				return res;
+
+			const std::set<std::string> extensions {".mp3", ".ogg", ".oga", ".m4a", ".flac", ".wav", ".opus", ".mpc", ".ape", ".wma", ".aif", ".aiff"};
+
+			std::error_code ec;
+			for (std::filesystem::recursive_directory_iterator it {directory, ec}; !ec && it != std::filesystem::recursive_directory_iterator {}; it.increment(ec))
+			{
+				if (it->is_regular_file() && extensions.count(StringUtils::stringToLower(it->path().extension().string())))
+					res.push_back(it->path());
+			}
+
+			return res;
+		}()};
+
+		return corpus;
+	}
+}
+
+static void
+BM_TagLibParser_Parse(benchmark::State& state)
+{
+	const std::vector<std::filesystem::path>& corpus {getCorpus()};
+	if (corpus.empty())
+	{
+		state.SkipWithError("No audio file found, set LMS_BENCHMARK_AUDIO_DIR");
+		return;
+	}
+
+	MetaData::TagLibParser tagLibParser;
+	MetaData::IParser& parser {tagLibParser};
+	parser.setClusterTypeNames({"ALBUMMOOD", "MOOD", "ALBUMGROUPING", "ALBUMGENRE", "GENRE"});
+
+	std::size_t i {};
+	std::size_t failureCount {};
+	for (auto _ : state)
+	{
+		const std::optional<MetaData::Track> track {parser.parse(corpus[i])};
+		if (!track)
+			failureCount++;
+
+		benchmark::DoNotOptimize(track);
+		i = (i + 1) % corpus.size();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.counters["corpus_size"] = static_cast<double>(corpus.size());
+	state.counters["failures"] = static_cast<double>(failureCount);
+}
+BENCHMARK(BM_TagLibParser_Parse)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
+
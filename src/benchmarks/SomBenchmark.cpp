@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "som/Network.hpp"
+
+namespace
+{
+	constexpr std::size_t inputDimCount {32};	// order of magnitude of the default feature settings
+
+	std::vector<SOM::InputVector>
+	generateSamples(std::size_t sampleCount)
+	{
+		std::mt19937 generator {42};
+		std::uniform_real_distribution<SOM::InputVector::value_type> distribution {0, 1};
+
+		std::vector<SOM::InputVector> samples(sampleCount, SOM::InputVector {inputDimCount});
+		for (SOM::InputVector& sample : samples)
+		{
+			for (std::size_t i {}; i < inputDimCount; ++i)
+				sample[i] = distribution(generator);
+		}
+
+		return samples;
+	}
+}
+
+static void
+BM_SOM_Train(benchmark::State& state)
+{
+	const SOM::Coordinate size {static_cast<SOM::Coordinate>(state.range(0))};
+	const std::vector<SOM::InputVector> samples {generateSamples(static_cast<std::size_t>(state.range(1)))};
+	constexpr std::size_t iterationCount {5};
+
+	for (auto _ : state)
+	{
+		SOM::Network network {size, size, inputDimCount};
+		network.train(samples, iterationCount);
+		benchmark::DoNotOptimize(network);
+	}
+
+	state.SetItemsProcessed(state.iterations() * samples.size() * iterationCount);
+}
+BENCHMARK(BM_SOM_Train)->Args({10, 1000})->Args({20, 2000})->Unit(benchmark::kMillisecond);
+
+static void
+BM_SOM_GetClosestRefVectorPosition(benchmark::State& state)
+{
+	const SOM::Coordinate size {static_cast<SOM::Coordinate>(state.range(0))};
+	const std::vector<SOM::InputVector> samples {generateSamples(1000)};
+
+	SOM::Network network {size, size, inputDimCount};
+	network.train(samples, 1);
+
+	std::size_t i {};
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(network.getClosestRefVectorPosition(samples[i]));
+		i = (i + 1) % samples.size();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SOM_GetClosestRefVectorPosition)->Arg(10)->Arg(20)->Arg(40);
+
+BENCHMARK_MAIN();
+
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+
+#include <benchmark/benchmark.h>
+
+#include "SubsonicResponse.hpp"
+
+using namespace API::Subsonic;
+
+namespace
+{
+	// Only the size of the response matters here, not its kind:
+	// a failed response does not need any request context
+	class BenchmarkError : public GenericError
+	{
+		std::string getMessage() const override { return "benchmark"; }
+	};
+
+	// Same attributes as the song nodes of the real responses
+	Response::Node
+	createSongNode(std::size_t id)
+	{
+		Response::Node songNode;
+
+		songNode.setAttribute("id", "tr-" + std::to_string(id));
+		songNode.setAttribute("isDir", false);
+		songNode.setAttribute("title", "Some track title " + std::to_string(id));
+		songNode.setAttribute("track", id % 12 + 1);
+		songNode.setAttribute("discNumber", 1);
+		songNode.setAttribute("year", 1990 + id % 30);
+		songNode.setAttribute("path", "Some artist/Some release/" + std::to_string(id % 12 + 1) + " - Some track title.mp3");
+		songNode.setAttribute("size", 8 * 1024 * 1024 + id);
+		songNode.setAttribute("suffix", "mp3");
+		songNode.setAttribute("contentType", "audio/mpeg");
+		songNode.setAttribute("bitRate", 320);
+		songNode.setAttribute("coverArt", "tr-" + std::to_string(id));
+		songNode.setAttribute("artist", "Some \"quoted\" artist & co");
+		songNode.setAttribute("artistId", "ar-" + std::to_string(id / 100));
+		songNode.setAttribute("album", "Some release");
+		songNode.setAttribute("albumId", "al-" + std::to_string(id / 12));
+		songNode.setAttribute("parent", "al-" + std::to_string(id / 12));
+		songNode.setAttribute("duration", 180 + id % 120);
+		songNode.setAttribute("type", "music");
+		songNode.setAttribute("genre", "Rock");
+
+		return songNode;
+	}
+
+	ResponseFormat
+	getFormat(const benchmark::State& state)
+	{
+		return state.range(1) ? ResponseFormat::json : ResponseFormat::xml;
+	}
+}
+
+static void
+BM_Response_Write(benchmark::State& state)
+{
+	const std::size_t songCount {static_cast<std::size_t>(state.range(0))};
+
+	Response response {Response::createFailedResponse(BenchmarkError {})};
+	Response::Node& songsNode {response.createNode("songsByGenre")};
+	for (std::size_t i {}; i < songCount; ++i)
+		songsNode.addArrayChild("song", createSongNode(i));
+
+	std::size_t outputSize {};
+	for (auto _ : state)
+	{
+		std::ostringstream oss;
+		response.write(oss, getFormat(state));
+		outputSize = oss.tellp();
+	}
+
+	state.SetItemsProcessed(state.iterations() * songCount);
+	state.SetBytesProcessed(state.iterations() * outputSize);
+}
+BENCHMARK(BM_Response_Write)->ArgsProduct({{100, 10000}, {0, 1}})->ArgNames({"songs", "json"})->Unit(benchmark::kMillisecond);
+
+// Nodes produced while the response is being written
+static void
+BM_Response_WriteGenerated(benchmark::State& state)
+{
+	const std::size_t songCount {static_cast<std::size_t>(state.range(0))};
+
+	std::size_t outputSize {};
+	for (auto _ : state)
+	{
+		Response response {Response::createFailedResponse(BenchmarkError {})};
+		Response::Node& songsNode {response.createNode("songsByGenre")};
+		songsNode.addArrayChildGenerator("song", [=](const Response::Node::ArrayChildConsumer& consumer)
+		{
+			for (std::size_t i {}; i < songCount; ++i)
+				consumer(createSongNode(i));
+		});
+
+		std::ostringstream oss;
+		response.write(oss, getFormat(state));
+		outputSize = oss.tellp();
+	}
+
+	state.SetItemsProcessed(state.iterations() * songCount);
+	state.SetBytesProcessed(state.iterations() * outputSize);
+}
+BENCHMARK(BM_Response_WriteGenerated)->ArgsProduct({{100, 10000}, {0, 1}})->ArgNames({"songs", "json"})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
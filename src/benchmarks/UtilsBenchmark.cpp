@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "utils/Crc32Calculator.hpp"
+#include "utils/Path.hpp"
+#include "utils/Zipper.hpp"
+
+namespace
+{
+	std::vector<std::byte>
+	generateData(std::size_t size)
+	{
+		std::mt19937 generator {42};
+		std::uniform_int_distribution<int> distribution {0, 255};
+
+		std::vector<std::byte> data(size);
+		for (std::byte& byte : data)
+			byte = static_cast<std::byte>(distribution(generator));
+
+		return data;
+	}
+
+	// Files of a typical release, created once for all the zip benchmarks
+	class ReleaseFiles
+	{
+		public:
+			static constexpr std::size_t fileCount {12};
+			static constexpr std::size_t fileSize {8 * 1024 * 1024};
+
+			static const ReleaseFiles& get()
+			{
+				static const ReleaseFiles files;
+				return files;
+			}
+
+			~ReleaseFiles()
+			{
+				std::error_code ec;
+				std::filesystem::remove_all(_directory, ec);
+			}
+
+			const std::map<std::string, Zip::Entry>& getEntries() const { return _entries; }
+			const std::map<std::string, Zip::Entry>& getEntriesWithCrc() const { return _entriesWithCrc; }
+
+		private:
+			ReleaseFiles()
+			: _directory {std::filesystem::temp_directory_path() / ("lms-bench-zip-" + std::to_string(std::random_device {}()))}
+			{
+				std::filesystem::create_directories(_directory);
+
+				const std::vector<std::byte> data {generateData(fileSize)};
+
+				Utils::Crc32Calculator crc32;
+				crc32.processBytes(data.data(), data.size());
+
+				for (std::size_t i {}; i < fileCount; ++i)
+				{
+					const std::filesystem::path filePath {_directory / ("track" + std::to_string(i) + ".mp3")};
+					{
+						std::ofstream ofs {filePath, std::ios_base::binary};
+						ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+					}
+
+					const std::string fileName {"Artist/Release/" + filePath.filename().string()};
+					_entries.emplace(fileName, Zip::Entry {filePath, std::nullopt, {}});
+					_entriesWithCrc.emplace(fileName, Zip::Entry {filePath, crc32.getResult(), getLastWriteTime(filePath)});
+				}
+			}
+
+			const std::filesystem::path		_directory;
+			std::map<std::string, Zip::Entry>	_entries;
+			std::map<std::string, Zip::Entry>	_entriesWithCrc;
+	};
+
+	void
+	writeZip(benchmark::State& state, const std::map<std::string, Zip::Entry>& entries)
+	{
+		std::vector<std::byte> buffer(static_cast<std::size_t>(state.range(0)));
+
+		Zip::SizeType totalSize {};
+		for (auto _ : state)
+		{
+			Zip::Zipper zipper {entries};
+			while (!zipper.isComplete())
+				totalSize += zipper.writeSome(buffer.data(), buffer.size());
+
+			benchmark::ClobberMemory();
+		}
+
+		state.SetBytesProcessed(static_cast<std::int64_t>(totalSize));
+	}
+}
+
+static void
+BM_Crc32(benchmark::State& state)
+{
+	const std::vector<std::byte> data {generateData(static_cast<std::size_t>(state.range(0)))};
+
+	for (auto _ : state)
+	{
+		Utils::Crc32Calculator crc32;
+		crc32.processBytes(data.data(), data.size());
+		benchmark::DoNotOptimize(crc32.getResult());
+	}
+
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32)->Arg(64)->Arg(4096)->Arg(1024 * 1024);
+
+// CRCs computed while writing the archive
+static void
+BM_Zipper_WriteSome(benchmark::State& state)
+{
+	writeZip(state, ReleaseFiles::get().getEntries());
+}
+BENCHMARK(BM_Zipper_WriteSome)->Arg(Zip::Zipper::minOutputBufferSize)->Arg(16 * 1024)->Arg(256 * 1024)->Unit(benchmark::kMillisecond);
+
+// CRCs known in advance (computed by the scanner)
+static void
+BM_Zipper_WriteSome_PrecomputedCrc(benchmark::State& state)
+{
+	writeZip(state, ReleaseFiles::get().getEntriesWithCrc());
+}
+BENCHMARK(BM_Zipper_WriteSome_PrecomputedCrc)->Arg(16 * 1024)->Arg(256 * 1024)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
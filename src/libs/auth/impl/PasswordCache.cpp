@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PasswordCache.hpp"
+
+#include <Wt/Auth/HashFunction.h>
+#include <Wt/WRandom.h>
+
+#include "utils/Random.hpp"
+
+namespace Auth {
+
+PasswordCache::PasswordCache(std::size_t maxEntries, std::chrono::seconds ttl)
+: _maxEntries {maxEntries}
+, _ttl {ttl}
+, _salt {Wt::WRandom::generateId(32)}
+{
+}
+
+std::string
+PasswordCache::computeKey(const std::string& loginName, const std::string& password) const
+{
+	const Wt::Auth::SHA1HashFunction hashFunc;
+
+	return loginName + '\0' + hashFunc.compute(password, _salt);
+}
+
+bool
+PasswordCache::isVerified(const std::string& loginName, const std::string& password, const std::string& storedPasswordHash) const
+{
+	auto it {_entries.find(computeKey(loginName, password))};
+	if (it == std::cend(_entries))
+		return false;
+
+	const Entry& entry {it->second};
+	return entry.storedPasswordHash == storedPasswordHash && entry.expiry > std::chrono::steady_clock::now();
+}
+
+void
+PasswordCache::removeOutdatedEntries()
+{
+	const auto now {std::chrono::steady_clock::now()};
+
+	for (auto it {std::begin(_entries)}; it != std::end(_entries); )
+	{
+		if (it->second.expiry <= now)
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+}
+
+void
+PasswordCache::onVerified(const std::string& loginName, const std::string& password, const std::string& storedPasswordHash)
+{
+	if (_entries.size() >= _maxEntries)
+		removeOutdatedEntries();
+	if (_entries.size() >= _maxEntries)
+		_entries.erase(Random::pickRandom(_entries));
+
+	_entries[computeKey(loginName, password)] = Entry {storedPasswordHash, std::chrono::steady_clock::now() + _ttl};
+}
+
+void
+PasswordCache::invalidate(const std::string& loginName)
+{
+	const std::string prefix {loginName + '\0'};
+
+	for (auto it {std::begin(_entries)}; it != std::end(_entries); )
+	{
+		if (it->first.compare(0, prefix.size(), prefix) == 0)
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+}
+
+} // Auth
+
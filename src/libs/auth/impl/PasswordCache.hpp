@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace Auth {
+
+// Remembers successfully verified passwords for a while, in order to avoid costly hash computations
+// Passwords are not stored as is, only a digest salted with a random per process value
+class PasswordCache
+{
+	public:
+		PasswordCache(std::size_t maxEntries, std::chrono::seconds ttl);
+
+		// user must lock these calls to avoid races
+		// storedPasswordHash is used to invalidate entries when the password is changed
+		bool isVerified(const std::string& loginName, const std::string& password, const std::string& storedPasswordHash) const;
+		void onVerified(const std::string& loginName, const std::string& password, const std::string& storedPasswordHash);
+		// forget everything about this user
+		void invalidate(const std::string& loginName);
+
+	private:
+		std::string computeKey(const std::string& loginName, const std::string& password) const;
+		void removeOutdatedEntries();
+
+		struct Entry
+		{
+			std::string storedPasswordHash;
+			std::chrono::steady_clock::time_point expiry;
+		};
+
+		const std::size_t _maxEntries;
+		const std::chrono::seconds _ttl;
+		const std::string _salt;
+
+		std::unordered_map<std::string, Entry> _entries;
+};
+
+} // Auth
+
@@ -19,8 +19,11 @@
 
 #include "PasswordService.hpp"
 
+#include <cctype>
+
 #include <Wt/Auth/HashFunction.h>
 #include <Wt/Auth/PasswordStrengthValidator.h>
+#include <Wt/Utils.h>
 #include <Wt/WRandom.h>
 
 #include "database/Session.hpp"
@@ -38,7 +41,8 @@ std::unique_ptr<IPasswordService> createPasswordService(std::size_t maxThrottler
 }
 
 PasswordService::PasswordService(std::size_t maxThrottlerEntries)
-: _loginThrottler{maxThrottlerEntries}
+: _loginThrottler {maxThrottlerEntries}
+, _passwordCache {maxThrottlerEntries, std::chrono::minutes {10}}
 {
 }
 
@@ -60,9 +64,8 @@ PasswordService::isAuthModeSupported(Database::User::AuthMode authMode) const
 	return false;
 }
 
-static
 bool
-checkUserPassword(Database::Session& session, const std::string& loginName, const std::string& password)
+PasswordService::verifyUserPassword(Database::Session& session, const std::string& loginName, const std::string& password)
 {
 	Database::User::AuthMode authMode;
 	Database::User::PasswordHash passwordHash;
@@ -77,24 +80,51 @@ checkUserPassword(Database::Session& session, const std::string& loginName, cons
 		passwordHash = user->getPasswordHash();
 	}
 
+	// Cache entries are bound to the stored hash, so that they are invalidated by a password change
+	const std::string storedPasswordHash {authMode == Database::User::AuthMode::Internal ? passwordHash.hash : ""};
+	{
+		std::shared_lock<std::shared_timed_mutex> lock {_mutex};
+
+		if (_passwordCache.isVerified(loginName, password, storedPasswordHash))
+			return true;
+	}
+
+	bool match {};
 	switch (authMode)
 	{
 		case Database::User::AuthMode::Internal:
 		{
 			LMS_LOG(AUTH, DEBUG) << "Checking internal password for user '" << loginName << "'";
 			const Wt::Auth::BCryptHashFunction hashFunc {7}; // TODO parametrize this
-			return hashFunc.verify(password, passwordHash.salt, passwordHash.hash);
+			match = hashFunc.verify(password, passwordHash.salt, passwordHash.hash);
+			break;
 		}
 
 		case Database::User::AuthMode::PAM:
 #ifdef LMS_SUPPORT_PAM
-			return PAM::checkUserPassword(loginName, password);
-#else
-			return false;
+			match = PAM::checkUserPassword(loginName, password);
 #endif
+			break;
 	}
 
-	return false;
+	{
+		std::unique_lock<std::shared_timed_mutex> lock {_mutex};
+
+		if (match)
+			_passwordCache.onVerified(loginName, password, storedPasswordHash);
+		else
+			_passwordCache.invalidate(loginName); // be conservative
+	}
+
+	return match;
+}
+
+void
+PasswordService::clearCachedPasswords(const std::string& loginName)
+{
+	std::unique_lock<std::shared_timed_mutex> lock {_mutex};
+
+	_passwordCache.invalidate(loginName);
 }
 
 PasswordService::PasswordCheckResult
@@ -108,23 +138,73 @@ PasswordService::checkUserPassword(Database::Session& session, const boost::asio
 			return PasswordCheckResult::Throttled;
 	}
 
-	const bool match {Auth::checkUserPassword(session, loginName, password)};
+	const bool match {verifyUserPassword(session, loginName, password)};
+
+	return processCheckResult(clientAddress, match);
+}
+
+static
+bool
+verifyUserApiKeyToken(Database::Session& session, const std::string& loginName, const std::string& token, const std::string& salt)
+{
+	std::string apiKey;
 	{
-		std::unique_lock<std::shared_timed_mutex> lock {_mutex};
+		auto transaction {session.createSharedTransaction()};
+
+		const Database::User::pointer user {Database::User::getByLoginName(session, loginName)};
+		if (!user)
+			return false;
+
+		apiKey = user->getSubsonicApiKey();
+	}
+
+	if (apiKey.empty() || salt.empty())
+		return false;
+
+	const std::string expectedToken {Wt::Utils::hexEncode(Wt::Utils::md5(apiKey + salt))};
+	if (token.size() != expectedToken.size())
+		return false;
+
+	// Do not exit early to avoid timing attacks
+	unsigned char diff {};
+	for (std::size_t i {}; i < token.size(); ++i)
+		diff |= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(token[i])) ^ expectedToken[i]);
+
+	return diff == 0;
+}
+
+PasswordService::PasswordCheckResult
+PasswordService::checkUserApiKeyToken(Database::Session& session, const boost::asio::ip::address& clientAddress, const std::string& loginName, const std::string& token, const std::string& salt)
+{
+	{
+		std::shared_lock<std::shared_timed_mutex> lock {_mutex};
 
 		if (_loginThrottler.isClientThrottled(clientAddress))
 			return PasswordCheckResult::Throttled;
+	}
 
-		if (match)
-		{
-			_loginThrottler.onGoodClientAttempt(clientAddress);
-			return PasswordCheckResult::Match;
-		}
-		else
-		{
-			_loginThrottler.onBadClientAttempt(clientAddress);
-			return PasswordCheckResult::Mismatch;
-		}
+	const bool match {verifyUserApiKeyToken(session, loginName, token, salt)};
+
+	return processCheckResult(clientAddress, match);
+}
+
+PasswordService::PasswordCheckResult
+PasswordService::processCheckResult(const boost::asio::ip::address& clientAddress, bool match)
+{
+	std::unique_lock<std::shared_timed_mutex> lock {_mutex};
+
+	if (_loginThrottler.isClientThrottled(clientAddress))
+		return PasswordCheckResult::Throttled;
+
+	if (match)
+	{
+		_loginThrottler.onGoodClientAttempt(clientAddress);
+		return PasswordCheckResult::Match;
+	}
+	else
+	{
+		_loginThrottler.onBadClientAttempt(clientAddress);
+		return PasswordCheckResult::Mismatch;
 	}
 }
 
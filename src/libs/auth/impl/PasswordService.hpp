@@ -23,6 +23,7 @@
 #include "auth/IPasswordService.hpp"
 
 #include "LoginThrottler.hpp"
+#include "PasswordCache.hpp"
 
 namespace Database
 {
@@ -47,11 +48,17 @@ namespace Auth {
 
 			bool isAuthModeSupported(Database::User::AuthMode authMode) const override;
 			PasswordCheckResult		checkUserPassword(Database::Session& session, const boost::asio::ip::address& clientAddress, const std::string& loginName, const std::string& password) override;
+			PasswordCheckResult		checkUserApiKeyToken(Database::Session& session, const boost::asio::ip::address& clientAddress, const std::string& loginName, const std::string& token, const std::string& salt) override;
+			void				clearCachedPasswords(const std::string& loginName) override;
 			Database::User::PasswordHash	hashPassword(const std::string& password) const override;
 			bool				evaluatePasswordStrength(const std::string& loginName, const std::string& password) const override;
 
+			bool verifyUserPassword(Database::Session& session, const std::string& loginName, const std::string& password);
+			PasswordCheckResult processCheckResult(const boost::asio::ip::address& clientAddress, bool match);
+
 			std::shared_timed_mutex	_mutex;
 			LoginThrottler	_loginThrottler;
+			PasswordCache	_passwordCache;
 	};
 
 }
@@ -52,6 +52,10 @@ namespace Auth {
 			virtual bool isAuthModeSupported(Database::User::AuthMode authMode) const = 0;
 
 			virtual PasswordCheckResult	checkUserPassword(Database::Session& session, const boost::asio::ip::address& clientAddress, const std::string& loginName, const std::string& password) = 0;
+			// Subsonic like token check: token must be the hex encoded md5(apiKey + salt), using the user's API key
+			virtual PasswordCheckResult	checkUserApiKeyToken(Database::Session& session, const boost::asio::ip::address& clientAddress, const std::string& loginName, const std::string& token, const std::string& salt) = 0;
+			// Successfully checked passwords are cached for a while: must be called when a user's password is set or when the user is removed
+			virtual void				clearCachedPasswords(const std::string& loginName) = 0;
 			virtual Database::User::PasswordHash	hashPassword(const std::string& password) const = 0;
 			virtual bool				evaluatePasswordStrength(const std::string& loginName, const std::string& password) const = 0;
 	};
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "av/AudioDecoder.hpp"
+
+extern "C"
+{
+#define __STDC_CONSTANT_MACROS
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/error.h>
+#include <libswresample/swresample.h>
+}
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "utils/Logger.hpp"
+#include "AudioFile.hpp"
+
+namespace Av
+{
+
+class AudioDecoderException : public Av::Exception
+{
+	public:
+		AudioDecoderException(const std::string& message, int avError)
+			: Av::Exception {"AudioDecoderException: " + message + ": " + averror_to_string(avError)}
+		{}
+};
+
+namespace
+{
+	struct FormatContextDeleter
+	{
+		void operator()(AVFormatContext* context) { avformat_close_input(&context); }
+	};
+
+	struct CodecContextDeleter
+	{
+		void operator()(AVCodecContext* context) { avcodec_free_context(&context); }
+	};
+
+	struct ResampleContextDeleter
+	{
+		void operator()(SwrContext* context) { swr_free(&context); }
+	};
+
+	struct PacketDeleter
+	{
+		void operator()(AVPacket* packet) { av_packet_free(&packet); }
+	};
+
+	struct FrameDeleter
+	{
+		void operator()(AVFrame* frame) { av_frame_free(&frame); }
+	};
+
+	// Converts the decoded frames to the requested format and hands them to the callback
+	class Resampler
+	{
+		public:
+			Resampler(const AVCodecContext& codecContext, const DecodeParameters& parameters, DecodedSamplesCallback callback)
+			: _channelCount {parameters.channelCount}
+			, _maxSampleCount {parameters.maxDuration ? static_cast<std::size_t>(parameters.maxDuration->count()) * parameters.sampleRate / 1000 * parameters.channelCount : std::numeric_limits<std::size_t>::max()}
+			, _callback {std::move(callback)}
+			{
+				const std::int64_t inputChannelLayout {codecContext.channel_layout ? static_cast<std::int64_t>(codecContext.channel_layout) : av_get_default_channel_layout(codecContext.channels)};
+
+				_context.reset(swr_alloc_set_opts(nullptr,
+							av_get_default_channel_layout(parameters.channelCount), AV_SAMPLE_FMT_FLT, parameters.sampleRate,
+							inputChannelLayout, codecContext.sample_fmt, codecContext.sample_rate,
+							0, nullptr));
+				if (!_context)
+					throw AudioDecoderException {"cannot allocate resampler", AVERROR(ENOMEM)};
+
+				const int error {swr_init(_context.get())};
+				if (error < 0)
+					throw AudioDecoderException {"cannot init resampler", error};
+			}
+
+			// nullptr to flush, returns false once the requested duration is reached
+			bool process(const AVFrame* frame)
+			{
+				const int inputSampleCount {frame ? frame->nb_samples : 0};
+				const int maxOutputSampleCount {swr_get_out_samples(_context.get(), inputSampleCount)};
+				if (maxOutputSampleCount <= 0)
+					return true;
+
+				_buffer.resize(static_cast<std::size_t>(maxOutputSampleCount) * _channelCount);
+				std::uint8_t* output {reinterpret_cast<std::uint8_t*>(_buffer.data())};
+
+				const int outputSampleCount {swr_convert(_context.get(), &output, maxOutputSampleCount,
+						frame ? const_cast<const std::uint8_t**>(frame->extended_data) : nullptr, inputSampleCount)};
+				if (outputSampleCount < 0)
+					throw AudioDecoderException {"cannot convert samples", outputSampleCount};
+
+				const std::size_t sampleCount {std::min(static_cast<std::size_t>(outputSampleCount) * _channelCount, _maxSampleCount - _processedSampleCount)};
+				if (sampleCount > 0)
+					_callback(_buffer.data(), sampleCount);
+
+				_processedSampleCount += sampleCount;
+				return _processedSampleCount < _maxSampleCount;
+			}
+
+		private:
+			const std::size_t _channelCount;
+			const std::size_t _maxSampleCount;
+			DecodedSamplesCallback _callback;
+
+			std::unique_ptr<SwrContext, ResampleContextDeleter> _context;
+			std::vector<float> _buffer;
+			std::size_t _processedSampleCount {};
+	};
+}
+
+void
+decodeAudioFile(const std::filesystem::path& p, const DecodeParameters& parameters, DecodedSamplesCallback callback)
+{
+	std::unique_ptr<AVFormatContext, FormatContextDeleter> formatContext;
+	{
+		AVFormatContext* context {};
+		const int error {avformat_open_input(&context, p.string().c_str(), nullptr, nullptr)};
+		if (error < 0)
+			throw AudioDecoderException {"cannot open '" + p.string() + "'", error};
+
+		formatContext.reset(context);
+	}
+
+	int error {avformat_find_stream_info(formatContext.get(), nullptr)};
+	if (error < 0)
+		throw AudioDecoderException {"cannot find stream information", error};
+
+	AVCodec* codec {};
+	const int streamIndex {av_find_best_stream(formatContext.get(), AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0)};
+	if (streamIndex < 0)
+		throw AudioDecoderException {"cannot find audio stream", streamIndex};
+
+	std::unique_ptr<AVCodecContext, CodecContextDeleter> codecContext {avcodec_alloc_context3(codec)};
+	if (!codecContext)
+		throw AudioDecoderException {"cannot allocate codec context", AVERROR(ENOMEM)};
+
+	error = avcodec_parameters_to_context(codecContext.get(), formatContext->streams[streamIndex]->codecpar);
+	if (error < 0)
+		throw AudioDecoderException {"cannot copy codec parameters", error};
+
+	error = avcodec_open2(codecContext.get(), codec, nullptr);
+	if (error < 0)
+		throw AudioDecoderException {"cannot open codec", error};
+
+	Resampler resampler {*codecContext, parameters, std::move(callback)};
+
+	std::unique_ptr<AVPacket, PacketDeleter> packet {av_packet_alloc()};
+	std::unique_ptr<AVFrame, FrameDeleter> frame {av_frame_alloc()};
+	if (!packet || !frame)
+		throw AudioDecoderException {"cannot allocate frame", AVERROR(ENOMEM)};
+
+	// returns false once the requested duration is reached
+	auto receiveFrames {[&]
+	{
+		while (true)
+		{
+			const int receiveError {avcodec_receive_frame(codecContext.get(), frame.get())};
+			if (receiveError == AVERROR(EAGAIN) || receiveError == AVERROR_EOF)
+				return true;
+			if (receiveError < 0)
+				throw AudioDecoderException {"cannot decode frame", receiveError};
+
+			const bool needMoreFrames {resampler.process(frame.get())};
+			av_frame_unref(frame.get());
+			if (!needMoreFrames)
+				return false;
+		}
+	}};
+
+	while (av_read_frame(formatContext.get(), packet.get()) >= 0)
+	{
+		if (packet->stream_index != streamIndex)
+		{
+			av_packet_unref(packet.get());
+			continue;
+		}
+
+		error = avcodec_send_packet(codecContext.get(), packet.get());
+		av_packet_unref(packet.get());
+		if (error < 0)
+		{
+			// corrupted packets are just skipped
+			LMS_LOG(AV, DEBUG) << "Skipping packet in '" << p.string() << "': " << averror_to_string(error);
+			continue;
+		}
+
+		if (!receiveFrames())
+			return;
+	}
+
+	// flush the decoder, then the resampler
+	avcodec_send_packet(codecContext.get(), nullptr);
+	if (receiveFrames())
+		resampler.process(nullptr);
+}
+
+} // namespace Av
+
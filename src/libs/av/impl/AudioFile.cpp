@@ -34,7 +34,7 @@ extern "C"
 
 namespace Av {
 
-static std::string averror_to_string(int error)
+std::string averror_to_string(int error)
 {
 	std::array<char, 128> buf = {0};
 
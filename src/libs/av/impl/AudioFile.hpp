@@ -27,6 +27,7 @@ struct AVFormatContext;
 
 namespace Av
 {
+	std::string averror_to_string(int error);
 
 	class AudioFile final : public IAudioFile
 	{
@@ -26,6 +26,7 @@
 #include "utils/IConfig.hpp"
 #include "utils/Path.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
 #include "utils/Service.hpp"
 
 namespace Av {
@@ -35,6 +36,22 @@ namespace Av {
 static std::atomic<size_t>		globalId {};
 static std::filesystem::path	ffmpegPath;
 
+static
+Metrics::Counter&
+getSpawnedTranscoderCounter()
+{
+	static Metrics::Counter& counter {Metrics::getRegistry().getCounter("lms_transcoder_spawns_total", "Number of transcoding processes started")};
+	return counter;
+}
+
+static
+Metrics::Gauge&
+getActiveTranscoderGauge()
+{
+	static Metrics::Gauge& gauge {Metrics::getRegistry().getGauge("lms_transcoder_active_jobs", "Number of transcoding processes currently running")};
+	return gauge;
+}
+
 void
 Transcoder::init()
 {
@@ -50,7 +67,11 @@ Transcoder::Transcoder(const std::filesystem::path& filePath, const TranscodePar
 {
 }
 
-Transcoder::~Transcoder() = default;
+Transcoder::~Transcoder()
+{
+	if (_childProcess)
+		getActiveTranscoderGauge().dec();
+}
 
 bool
 Transcoder::start()
@@ -185,6 +206,9 @@ Transcoder::start()
 		return false;
 	}
 
+	getSpawnedTranscoderCounter().inc();
+	getActiveTranscoderGauge().inc();
+
 	return true;
 }
 
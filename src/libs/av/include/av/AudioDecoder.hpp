@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+#include "Types.hpp"
+
+namespace Av
+{
+	struct DecodeParameters
+	{
+		unsigned	sampleRate {44100};
+		unsigned	channelCount {1};	// samples are interleaved
+		std::optional<std::chrono::milliseconds>	maxDuration;	// decode the whole stream if not set
+	};
+
+	// Called as soon as some samples are decoded
+	// sampleCount is a multiple of the channel count
+	using DecodedSamplesCallback = std::function<void(const float* samples, std::size_t sampleCount)>;
+
+	// Decodes the best audio stream of the file, as float samples in [-1, 1]
+	// Throws Av::Exception if the file cannot be decoded
+	void decodeAudioFile(const std::filesystem::path& p, const DecodeParameters& parameters, DecodedSamplesCallback callback);
+
+} // namespace Av
+
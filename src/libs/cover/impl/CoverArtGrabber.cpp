@@ -98,7 +98,11 @@ Grabber::Grabber(const std::filesystem::path& execPath,
 		std::size_t maxCacheSize,
 		std::size_t maxFileSize,
 		unsigned jpegQuality)
-	: _defaultCoverPath {defaultCoverPath}
+	: _cacheHitsMetric {Metrics::getRegistry().getCounter("lms_cover_cache_hits_total", "Number of covers served from the cache")}
+	, _cacheMissesMetric {Metrics::getRegistry().getCounter("lms_cover_cache_misses_total", "Number of covers not found in the cache")}
+	, _cacheSizeMetric {Metrics::getRegistry().getGauge("lms_cover_cache_bytes", "Size of the covers in the cache")}
+	, _cacheEntryCountMetric {Metrics::getRegistry().getGauge("lms_cover_cache_entries", "Number of covers in the cache")}
+	, _defaultCoverPath {defaultCoverPath}
 	, _maxCacheSize {maxCacheSize}
 	, _maxFileSize {maxFileSize}
 	, _jpegQuality {clamp<unsigned>(jpegQuality, 1, 100)}
@@ -420,6 +424,9 @@ Grabber::flushCache()
 	_cacheMisses = 0;
 	_cacheSize = 0;
 	_cache.clear();
+
+	_cacheSizeMetric.set(0);
+	_cacheEntryCountMetric.set(0);
 }
 
 void
@@ -436,6 +443,9 @@ Grabber::saveToCache(const CacheEntryDesc& entryDesc, std::shared_ptr<IEncodedIm
 
 	_cacheSize += image->getDataSize();
 	_cache[entryDesc] = image;
+
+	_cacheSizeMetric.set(_cacheSize);
+	_cacheEntryCountMetric.set(_cache.size());
 }
 
 std::shared_ptr<IEncodedImage>
@@ -447,10 +457,12 @@ Grabber::loadFromCache(const CacheEntryDesc& entryDesc)
 	if (it == std::cend(_cache))
 	{
 		++_cacheMisses;
+		_cacheMissesMetric.inc();
 		return nullptr;
 	}
 
 	++_cacheHits;
+	_cacheHitsMetric.inc();
 	return it->second;
 }
 
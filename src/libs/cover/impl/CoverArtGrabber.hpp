@@ -31,6 +31,7 @@
 #include "cover/ICoverArtGrabber.hpp"
 #include "cover/IEncodedImage.hpp"
 #include "database/Types.hpp"
+#include "utils/Metrics.hpp"
 
 namespace Database
 {
@@ -123,6 +124,10 @@ namespace CoverArt
 			std::atomic<std::size_t>	_cacheMisses {};
 			std::atomic<std::size_t>	_cacheHits {};
 			std::size_t					_cacheSize {};
+			Metrics::Counter&			_cacheHitsMetric;
+			Metrics::Counter&			_cacheMissesMetric;
+			Metrics::Gauge&				_cacheSizeMetric;
+			Metrics::Gauge&				_cacheEntryCountMetric;
 
 			void saveToCache(const CacheEntryDesc& entryDesc, std::shared_ptr<IEncodedImage> image);
 			std::shared_ptr<IEncodedImage> loadFromCache(const CacheEntryDesc& entryDesc);
@@ -26,6 +26,7 @@
 #include "database/Track.hpp"
 #include "database/User.hpp"
 #include "utils/Logger.hpp"
+#include "RandomIdSampler.hpp"
 #include "SqlQuery.hpp"
 
 
@@ -66,6 +67,25 @@ Artist::getById(Session& session, IdType id)
 	return session.getDboSession().find<Artist>().where("id = ?").bind(id);
 }
 
+std::vector<Artist::pointer>
+Artist::getByIds(Session& session, const std::vector<IdType>& ids)
+{
+	session.checkSharedLocked();
+
+	std::vector<pointer> res;
+	forEachIdsChunk(ids, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().find<Artist>().where("id IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<pointer> artists = query;
+		res.insert(std::end(res), std::begin(artists), std::end(artists));
+	});
+
+	return res;
+}
+
 Artist::pointer
 Artist::create(Session& session, const std::string& name, const std::optional<UUID>& MBID)
 {
@@ -221,14 +241,16 @@ Artist::getAllIdsRandom(Session& session, const std::set<IdType>& clusters, std:
 {
 	session.checkSharedLocked();
 
-	auto query {createQuery<IdType>(session, "SELECT DISTINCT a.id from artist a", clusters, {}, linkType)};
-
-	Wt::Dbo::collection<IdType> res = query
-		.orderBy("RANDOM()")
-		.limit(size ? static_cast<int>(*size) : -1);
-
-	return std::vector<IdType>(res.begin(), res.end());
+	const std::string idSetName {linkType ? "artist/" + std::to_string(static_cast<int>(*linkType)) : "artist"};
 
+	return session.getRandomIdSampler().sample(session.getLibraryGeneration(),
+			RandomIdSampler::getIdSetKey(idSetName, clusters),
+			size,
+			[&]
+			{
+				Wt::Dbo::collection<IdType> res = createQuery<IdType>(session, "SELECT DISTINCT a.id from artist a", clusters, {}, linkType);
+				return std::vector<IdType>(res.begin(), res.end());
+			});
 }
 
 std::vector<Artist::pointer>
@@ -281,10 +303,10 @@ Artist::getByFilter(Session& session,
 		case Artist::SortMethod::None:
 			break;
 		case Artist::SortMethod::ByName:
-			query.orderBy("a.name COLLATE NOCASE");
+			query.orderBy("a.name COLLATE NOCASE, a.id");
 			break;
 		case Artist::SortMethod::BySortName:
-			query.orderBy("a.sort_name COLLATE NOCASE");
+			query.orderBy("a.sort_name COLLATE NOCASE, a.id");
 			break;
 	}
 
@@ -305,6 +327,31 @@ Artist::getByFilter(Session& session,
 	return res;
 }
 
+std::vector<Artist::pointer>
+Artist::getByFilter(Session& session,
+		const std::set<IdType>& clusters,
+		const std::vector<std::string>& keywords,
+		std::optional<TrackArtistLinkType> linkType,
+		SortMethod sortMethod,
+		KeysetRange& range,
+		bool& moreResults)
+{
+	session.checkSharedLocked();
+
+	auto query {createQuery<Artist::pointer>(session, "SELECT DISTINCT a from artist a", clusters, keywords, linkType)};
+	switch (sortMethod)
+	{
+		case Artist::SortMethod::None:
+			return getKeysetRange(query, "", "a.id", range, moreResults, [](const pointer&) { return std::string {}; });
+		case Artist::SortMethod::ByName:
+			return getKeysetRange(query, "a.name", "a.id", range, moreResults, [](const pointer& artist) { return artist->getName(); });
+		case Artist::SortMethod::BySortName:
+			return getKeysetRange(query, "a.sort_name", "a.id", range, moreResults, [](const pointer& artist) { return artist->getSortName(); });
+	}
+
+	return {};
+}
+
 std::vector<Artist::pointer>
 Artist::getLastWritten(Session& session,
 		std::optional<Wt::WDateTime> after,
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/ArtistSummary.hpp"
+
+#include <unordered_map>
+
+#include "database/Artist.hpp"
+#include "database/Session.hpp"
+#include "SqlQuery.hpp"
+
+namespace Database
+{
+
+ArtistSummary::ArtistSummary(Wt::Dbo::ptr<Artist> artist)
+: _artist {artist}
+{
+}
+
+ArtistSummary::pointer
+ArtistSummary::getByArtist(Session& session, IdType artistId)
+{
+	session.checkSharedLocked();
+
+	return session.getDboSession().find<ArtistSummary>().where("artist_id = ?").bind(artistId);
+}
+
+ArtistSummary::pointer
+ArtistSummary::get(Session& session, Wt::Dbo::ptr<Artist> artist)
+{
+	session.checkSharedLocked();
+
+	if (pointer summary {getByArtist(session, artist.id())})
+		return summary;
+
+	// Not computed by the scanner yet: do not persist it as we may only hold a shared lock
+	auto summary {std::make_unique<ArtistSummary>(artist)};
+	summary->compute(artist);
+
+	return pointer {std::move(summary)};
+}
+
+std::vector<ArtistSummary::pointer>
+ArtistSummary::get(Session& session, const std::vector<Wt::Dbo::ptr<Artist>>& artists)
+{
+	session.checkSharedLocked();
+
+	std::vector<IdType> artistIds;
+	artistIds.reserve(artists.size());
+	for (const Wt::Dbo::ptr<Artist>& artist : artists)
+		artistIds.push_back(artist.id());
+
+	std::unordered_map<IdType, pointer> summaries;
+	forEachIdsChunk(artistIds, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().find<ArtistSummary>().where("artist_id IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<pointer> collection = query;
+		for (const pointer& summary : collection)
+			summaries.emplace(summary->_artist.id(), summary);
+	});
+
+	std::vector<pointer> res;
+	res.reserve(artists.size());
+	for (const Wt::Dbo::ptr<Artist>& artist : artists)
+	{
+		auto it {summaries.find(artist.id())};
+		res.push_back(it != std::cend(summaries) ? it->second : get(session, artist));
+	}
+
+	return res;
+}
+
+std::vector<IdType>
+ArtistSummary::getAllArtistIdsToRefresh(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<IdType> res = session.getDboSession().query<IdType>("SELECT a.id FROM artist a LEFT OUTER JOIN artist_summary a_s ON a_s.artist_id = a.id WHERE a_s.id IS NULL OR a_s.outdated <> 0");
+	return std::vector<IdType>(res.begin(), res.end());
+}
+
+void
+ArtistSummary::markOutdated(Session& session, IdType artistId)
+{
+	session.checkUniqueLocked();
+
+	session.getDboSession().execute
+		("UPDATE artist_summary SET outdated = 1 WHERE artist_id = ?").bind(artistId);
+}
+
+void
+ArtistSummary::refresh(Session& session, Wt::Dbo::ptr<Artist> artist)
+{
+	session.checkUniqueLocked();
+
+	pointer summary {getByArtist(session, artist.id())};
+	if (!summary)
+		summary = session.getDboSession().add(std::make_unique<ArtistSummary>(artist));
+
+	summary.modify()->compute(artist);
+}
+
+void
+ArtistSummary::compute(const Wt::Dbo::ptr<Artist>& artist)
+{
+	_releaseCount = static_cast<int>(artist->getReleaseCount());
+	_outdated = false;
+}
+
+} // namespace Database
+
@@ -76,6 +76,28 @@ Cluster::getById(Session& session, IdType id)
 	return session.getDboSession().find<Cluster>().where("id = ?").bind(id);
 }
 
+std::vector<std::tuple<IdType, std::string>>
+Cluster::getTrackClusterNames(Session& session, const std::vector<IdType>& trackIds, IdType clusterTypeId)
+{
+	session.checkSharedLocked();
+
+	std::vector<std::tuple<IdType, std::string>> res;
+	forEachIdsChunk(trackIds, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().query<std::tuple<IdType, std::string>>("SELECT t_c.track_id, c.name FROM cluster c INNER JOIN track_cluster t_c ON t_c.cluster_id = c.id")
+			.where("c.cluster_type_id = ?").bind(clusterTypeId)
+			.where("t_c.track_id IN " + getInClausePlaceholders(chunkIds.size()))
+			.orderBy("c.id")};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<std::tuple<IdType, std::string>> names = query;
+		res.insert(std::end(res), std::begin(names), std::end(names));
+	});
+
+	return res;
+}
+
 void
 Cluster::addTrack(Wt::Dbo::ptr<Track> track)
 {
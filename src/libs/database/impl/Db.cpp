@@ -19,18 +19,88 @@
 
 #include "database/Db.hpp"
 
+#include <algorithm>
+#include <chrono>
+
+#include <sqlite3.h>
+
 #include <Wt/Dbo/FixedSqlConnectionPool.h>
 #include <Wt/Dbo/backend/Sqlite3.h>
 
 #include "database/Session.hpp"
 #include "database/User.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
+#include "RandomIdSampler.hpp"
 
 namespace Database {
 
+static
+std::uint64_t
+getCurrentTimeMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static constexpr std::size_t connectionPoolSize {10};
+
+static
+int
+onSqliteTraceEvent(unsigned type, void* context, void* statement, void* data)
+{
+	static Metrics::Histogram& queryTime {Metrics::getRegistry().getHistogram("lms_db_query_seconds", "Time spent executing SQLite statements", Metrics::getDurationBuckets())};
+
+	QueryTracer* queryTracer {static_cast<QueryTracer*>(context)};
+	switch (type)
+	{
+		case SQLITE_TRACE_PROFILE:
+		{
+			const std::chrono::nanoseconds duration {*static_cast<const sqlite3_int64*>(data)};
+			queryTime.observe(std::chrono::duration<double> {duration}.count());
+			if (queryTracer)
+				queryTracer->onStatementProfiled(static_cast<sqlite3_stmt*>(statement), duration);
+			break;
+		}
+
+		case SQLITE_TRACE_ROW:
+			if (queryTracer)
+				queryTracer->onStatementRow(static_cast<sqlite3_stmt*>(statement));
+			break;
+	}
+
+	return 0;
+}
+
+static
+void
+setupTraceHooks(Wt::Dbo::SqlConnectionPool& connectionPool, QueryTracer* queryTracer)
+{
+	const unsigned traceMask {queryTracer ? (SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW) : SQLITE_TRACE_PROFILE};
+
+	// Take all the connections (cloned by the pool) to install the trace hook on each of them
+	std::vector<std::unique_ptr<Wt::Dbo::SqlConnection>> connections;
+	for (std::size_t i {}; i < connectionPoolSize; ++i)
+	{
+		std::unique_ptr<Wt::Dbo::SqlConnection> connection {connectionPool.getConnection()};
+		if (auto* sqlite3Connection {dynamic_cast<Wt::Dbo::backend::Sqlite3*>(connection.get())})
+			sqlite3_trace_v2(sqlite3Connection->connection(), traceMask, &onSqliteTraceEvent, queryTracer);
+
+		connections.push_back(std::move(connection));
+	}
+
+	for (std::unique_ptr<Wt::Dbo::SqlConnection>& connection : connections)
+		connectionPool.returnConnection(std::move(connection));
+}
+
 // Session living class handling the database and the login
-Db::Db(const std::filesystem::path& dbPath)
+Db::Db(const std::filesystem::path& dbPath, const std::optional<QueryTracer::Settings>& queryTracerSettings, bool enableQueryMetrics)
+: _initialGeneration {getCurrentTimeMs()}
+, _libraryGeneration {_initialGeneration}
+, _randomIdSampler {std::make_unique<RandomIdSampler>(64)}
 {
+	if (queryTracerSettings)
+		_queryTracer = std::make_unique<QueryTracer>(dbPath, *queryTracerSettings);
+
 	LMS_LOG(DB, INFO) << "Creating connection pool on file " << dbPath.string();
 
 	std::unique_ptr<Wt::Dbo::backend::Sqlite3> connection {std::make_unique<Wt::Dbo::backend::Sqlite3>(dbPath.string())};
@@ -38,8 +108,10 @@ Db::Db(const std::filesystem::path& dbPath)
 	connection->executeSql("pragma journal_mode=WAL");
 	connection->executeSql("pragma synchronous=normal");
 
-	auto connectionPool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), 10);
+	auto connectionPool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), connectionPoolSize);
 	connectionPool->setTimeout(std::chrono::seconds(10));
+	if (enableQueryMetrics || _queryTracer)
+		setupTraceHooks(*connectionPool, _queryTracer.get());
 
 	_connectionPool = std::move(connectionPool);
 }
@@ -58,6 +130,40 @@ Db::executeSql(const std::string& sql)
 	connection->executeSql(sql);
 }
 
+// Generations are timestamps in ms, that must strictly increase even if the clock goes backward
+static
+std::uint64_t
+getNextGeneration(std::uint64_t generation)
+{
+	return std::max(generation + 1, getCurrentTimeMs());
+}
+
+void
+Db::bumpLibraryGeneration()
+{
+	std::uint64_t generation {_libraryGeneration.load()};
+	while (!_libraryGeneration.compare_exchange_weak(generation, getNextGeneration(generation)))
+		;
+}
+
+std::uint64_t
+Db::getUserGeneration(IdType userId) const
+{
+	std::scoped_lock lock {_userGenerationsMutex};
+
+	auto it {_userGenerations.find(userId)};
+	return it != std::cend(_userGenerations) ? it->second : _initialGeneration;
+}
+
+void
+Db::bumpUserGeneration(IdType userId)
+{
+	std::scoped_lock lock {_userGenerationsMutex};
+
+	std::uint64_t& generation {_userGenerations.try_emplace(userId, _initialGeneration).first->second};
+	generation = getNextGeneration(generation);
+}
+
 Session&
 Db::getTLSSession()
 {
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/PlayStats.hpp"
+
+#include <Wt/Dbo/WtSqlTraits.h>
+
+#include "database/Artist.hpp"
+#include "database/Release.hpp"
+#include "database/Session.hpp"
+#include "database/Track.hpp"
+#include "database/User.hpp"
+#include "SqlQuery.hpp"
+
+namespace Database
+{
+
+static const std::string topOrder {"s.play_count DESC, s.last_played DESC"};
+static const std::string recentOrder {"s.last_played DESC"};
+// releases and artists, grouped by entity
+static const std::string aggregatedTopOrder {"SUM(s.play_count) DESC, MAX(s.last_played) DESC"};
+static const std::string aggregatedRecentOrder {"MAX(s.last_played) DESC"};
+
+// ids of the tracks that belong to all the clusters, cluster ids to be bound in order
+static
+std::string
+getTrackIdsInClustersQuery(const std::set<IdType>& clusterIds)
+{
+	return "SELECT t_c.track_id FROM track_cluster t_c"
+		" WHERE t_c.cluster_id IN " + getInClausePlaceholders(clusterIds.size()) +
+		" GROUP BY t_c.track_id HAVING COUNT(*) = " + std::to_string(clusterIds.size());
+}
+
+template <typename T>
+static
+void
+bindClusterIds(Wt::Dbo::Query<T>& query, const std::set<IdType>& clusterIds)
+{
+	for (const IdType clusterId : clusterIds)
+		query.bind(clusterId);
+}
+
+template <typename T>
+static
+std::vector<Wt::Dbo::ptr<T>>
+fetchRange(Wt::Dbo::Query<Wt::Dbo::ptr<T>>& query, const std::string& order, std::optional<Range> range, bool& moreResults)
+{
+	Wt::Dbo::collection<Wt::Dbo::ptr<T>> collection = query
+		.orderBy(order)
+		.limit(range ? static_cast<int>(range->limit) + 1 : -1)
+		.offset(range ? static_cast<int>(range->offset) : -1);
+
+	std::vector<Wt::Dbo::ptr<T>> res (collection.begin(), collection.end());
+	if (range && res.size() == static_cast<std::size_t>(range->limit) + 1)
+	{
+		moreResults = true;
+		res.pop_back();
+	}
+	else
+		moreResults = false;
+
+	return res;
+}
+
+static
+TrackPlayStats::pointer
+getOrCreateStats(Session& session, const User::pointer& user, const Track::pointer& track)
+{
+	session.checkUniqueLocked();
+
+	TrackPlayStats::pointer stats {session.getDboSession().find<TrackPlayStats>()
+		.where("user_id = ?").bind(user.id())
+		.where("track_id = ?").bind(track.id())};
+
+	if (!stats)
+		stats = session.getDboSession().add(std::make_unique<TrackPlayStats>(user, track));
+
+	return stats;
+}
+
+TrackPlayStats::TrackPlayStats(Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track)
+: _user {user}
+, _track {track}
+{
+}
+
+void
+TrackPlayStats::addPlay(Session& session, Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track, IdType playedEntryId)
+{
+	pointer stats {getOrCreateStats(session, user, track)};
+
+	stats.modify()->_playCount++;
+	stats.modify()->_lastPlayed = playedEntryId;
+}
+
+static
+Wt::Dbo::Query<Track::pointer>
+createTracksQuery(Session& session, IdType userId, const std::set<IdType>& clusterIds)
+{
+	session.checkSharedLocked();
+
+	auto query {session.getDboSession().query<Track::pointer>("SELECT t FROM track t INNER JOIN track_play_stats s ON s.track_id = t.id")};
+	query.where("s.user_id = ?").bind(userId);
+
+	if (!clusterIds.empty())
+	{
+		query.where("t.id IN (" + getTrackIdsInClustersQuery(clusterIds) + ")");
+		bindClusterIds(query, clusterIds);
+	}
+
+	return query;
+}
+
+std::vector<Track::pointer>
+TrackPlayStats::getTopTracks(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createTracksQuery(session, userId, clusterIds)};
+	return fetchRange(query, topOrder, range, moreResults);
+}
+
+std::vector<Track::pointer>
+TrackPlayStats::getRecentTracks(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createTracksQuery(session, userId, clusterIds)};
+	return fetchRange(query, recentOrder, range, moreResults);
+}
+
+static
+Wt::Dbo::Query<Release::pointer>
+createReleasesQuery(Session& session, IdType userId, const std::set<IdType>& clusterIds)
+{
+	session.checkSharedLocked();
+
+	auto query {session.getDboSession().query<Release::pointer>("SELECT r FROM release r"
+			" INNER JOIN track t ON t.release_id = r.id"
+			" INNER JOIN track_play_stats s ON s.track_id = t.id")};
+	query.where("s.user_id = ?").bind(userId);
+
+	if (!clusterIds.empty())
+	{
+		query.where("t.id IN (" + getTrackIdsInClustersQuery(clusterIds) + ")");
+		bindClusterIds(query, clusterIds);
+	}
+
+	query.groupBy("r.id");
+
+	return query;
+}
+
+std::vector<Release::pointer>
+TrackPlayStats::getTopReleases(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createReleasesQuery(session, userId, clusterIds)};
+	return fetchRange(query, aggregatedTopOrder, range, moreResults);
+}
+
+std::vector<Release::pointer>
+TrackPlayStats::getRecentReleases(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createReleasesQuery(session, userId, clusterIds)};
+	return fetchRange(query, aggregatedRecentOrder, range, moreResults);
+}
+
+static
+Wt::Dbo::Query<Artist::pointer>
+createArtistsQuery(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<TrackArtistLinkType> linkType)
+{
+	session.checkSharedLocked();
+
+	// Stats of the played tracks, once per distinct artist of each track
+	std::string playedTracksQuery {"SELECT DISTINCT t_a_l.artist_id AS artist_id, s.track_id AS track_id, s.play_count AS play_count, s.last_played AS last_played"
+		" FROM track_play_stats s"
+		" INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = s.track_id"
+		" WHERE s.user_id = ?"};
+	if (linkType)
+		playedTracksQuery += " AND t_a_l.type = ?";
+	if (!clusterIds.empty())
+		playedTracksQuery += " AND s.track_id IN (" + getTrackIdsInClustersQuery(clusterIds) + ")";
+
+	auto query {session.getDboSession().query<Artist::pointer>("SELECT a FROM artist a"
+			" INNER JOIN (" + playedTracksQuery + ") s ON s.artist_id = a.id")};
+	query.bind(userId);
+	if (linkType)
+		query.bind(*linkType);
+	bindClusterIds(query, clusterIds);
+
+	query.groupBy("a.id");
+
+	return query;
+}
+
+std::vector<Artist::pointer>
+TrackPlayStats::getTopArtists(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<TrackArtistLinkType> linkType, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createArtistsQuery(session, userId, clusterIds, linkType)};
+	return fetchRange(query, aggregatedTopOrder, range, moreResults);
+}
+
+std::vector<Artist::pointer>
+TrackPlayStats::getRecentArtists(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<TrackArtistLinkType> linkType, std::optional<Range> range, bool& moreResults)
+{
+	auto query {createArtistsQuery(session, userId, clusterIds, linkType)};
+	return fetchRange(query, aggregatedRecentOrder, range, moreResults);
+}
+
+} // namespace Database
+
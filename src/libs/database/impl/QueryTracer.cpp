@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/QueryTracer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string_view>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sqlite3.h>
+
+#include "utils/Logger.hpp"
+
+namespace Database {
+
+namespace
+{
+	// Rows returned by the statements being executed by this thread (a connection is used by only one thread at a time)
+	thread_local std::unordered_map<sqlite3_stmt*, std::size_t> currentRowCounts;
+
+	// "IN (?, ?, ?)" -> "IN (?, ...)", so that queries only differing by the number of bound values are grouped
+	std::string
+	normalizeSql(std::string_view sql)
+	{
+		std::string res;
+		res.reserve(sql.size());
+
+		std::size_t i {};
+		while (i < sql.size())
+		{
+			res += sql[i];
+			if (sql[i] != '?')
+			{
+				++i;
+				continue;
+			}
+
+			// skip the following ", ?" sequences
+			std::size_t next {i + 1};
+			bool collapsed {};
+			while (true)
+			{
+				std::size_t j {next};
+				while (j < sql.size() && sql[j] == ' ')
+					++j;
+				if (j >= sql.size() || sql[j] != ',')
+					break;
+				++j;
+				while (j < sql.size() && sql[j] == ' ')
+					++j;
+				if (j >= sql.size() || sql[j] != '?')
+					break;
+
+				next = j + 1;
+				collapsed = true;
+			}
+
+			if (collapsed)
+				res += ", ...";
+			i = next;
+		}
+
+		return res;
+	}
+
+	std::string
+	demangle(const char* symbolName)
+	{
+		int status {};
+		char* demangled {abi::__cxa_demangle(symbolName, nullptr, nullptr, &status)};
+		if (status != 0 || !demangled)
+			return symbolName;
+
+		std::string res {demangled};
+		std::free(demangled);
+		return res;
+	}
+
+	// Best effort: first function of the Database namespace found in the call stack, once outside of the trace hook
+	// Only exported symbols can be resolved
+	std::string
+	getCaller()
+	{
+		std::array<void*, 64> frames;
+		const int frameCount {backtrace(frames.data(), static_cast<int>(frames.size()))};
+
+		Dl_info selfInfo;
+		if (!dladdr(reinterpret_cast<void*>(&getCaller), &selfInfo))
+			return "unknown";
+
+		bool inTraceHook {true};
+		for (int i {}; i < frameCount; ++i)
+		{
+			Dl_info info;
+			if (!dladdr(frames[i], &info))
+				continue;
+
+			if (inTraceHook)
+			{
+				// wait to get out of this library (sqlite3, Wt::Dbo backend)
+				if (info.dli_fbase != selfInfo.dli_fbase)
+					inTraceHook = false;
+				continue;
+			}
+
+			if (!info.dli_sname || info.dli_fbase != selfInfo.dli_fbase)
+				continue;
+
+			std::string name {demangle(info.dli_sname)};
+			if (name.rfind("Database::", 0) == 0)
+				return name;
+		}
+
+		return "unknown";
+	}
+
+	std::string
+	formatDuration(std::chrono::nanoseconds duration)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(3) << std::chrono::duration<double, std::milli> {duration}.count() << " ms";
+		return oss.str();
+	}
+}
+
+QueryTracer::QueryTracer(const std::filesystem::path& dbPath, const Settings& settings)
+: _settings {settings}
+, _dbPath {dbPath}
+{
+	LMS_LOG(DB, INFO) << "Query tracing enabled: keeping the " << _settings.maxEntryCount << " slowest queries, explaining the ones taking more than " << _settings.queryPlanThreshold.count() << " ms";
+}
+
+QueryTracer::~QueryTracer()
+{
+	if (_explainConnection)
+		sqlite3_close(_explainConnection);
+}
+
+std::vector<QueryTraceEntry>
+QueryTracer::getEntries() const
+{
+	std::vector<QueryTraceEntry> res;
+
+	{
+		std::scoped_lock lock {_mutex};
+
+		res.reserve(_entries.size());
+		for (const auto& [sql, entry] : _entries)
+			res.push_back(entry);
+	}
+
+	std::sort(std::begin(res), std::end(res), [](const QueryTraceEntry& lhs, const QueryTraceEntry& rhs) { return lhs.maxDuration > rhs.maxDuration; });
+
+	return res;
+}
+
+void
+QueryTracer::writeReport(std::ostream& os) const
+{
+	const std::vector<QueryTraceEntry> entries {getEntries()};
+
+	os << "Slowest queries: " << entries.size() << " (max " << _settings.maxEntryCount << "), plan threshold = " << _settings.queryPlanThreshold.count() << " ms\n";
+
+	std::size_t rank {1};
+	for (const QueryTraceEntry& entry : entries)
+	{
+		os << "\n#" << rank++ << ": max = " << formatDuration(entry.maxDuration)
+			<< ", avg = " << formatDuration(entry.totalDuration / entry.executionCount)
+			<< ", count = " << entry.executionCount
+			<< ", binds = " << entry.bindCount
+			<< ", rows = " << entry.maxDurationRowCount
+			<< ", caller = " << entry.maxDurationCaller << "\n";
+		os << "\t" << entry.sql << "\n";
+
+		if (entry.queryPlan)
+			os << "\tQuery plan:\n" << *entry.queryPlan;
+	}
+}
+
+void
+QueryTracer::clear()
+{
+	std::scoped_lock lock {_mutex};
+	_entries.clear();
+}
+
+void
+QueryTracer::onStatementRow(sqlite3_stmt* statement)
+{
+	currentRowCounts[statement]++;
+}
+
+void
+QueryTracer::onStatementProfiled(sqlite3_stmt* statement, std::chrono::nanoseconds duration)
+{
+	std::size_t rowCount {};
+	if (auto itRowCount {currentRowCounts.find(statement)}; itRowCount != std::cend(currentRowCounts))
+	{
+		rowCount = itRowCount->second;
+		currentRowCounts.erase(itRowCount);
+	}
+
+	const char* rawSql {sqlite3_sql(statement)};
+	if (!rawSql)
+		return;
+
+	std::string sql {normalizeSql(rawSql)};
+
+	// Walking the stack and explaining the plan are slow: check what is needed first, and do it outside of the lock
+	bool needCaller {};
+	bool needQueryPlan {};
+	{
+		std::scoped_lock lock {_mutex};
+
+		auto itEntry {_entries.find(sql)};
+		if (itEntry == std::cend(_entries))
+		{
+			if (!canInsertEntry(duration))
+				return;
+
+			needCaller = true;
+			needQueryPlan = duration >= _settings.queryPlanThreshold;
+		}
+		else
+		{
+			const QueryTraceEntry& entry {itEntry->second};
+			needCaller = duration > entry.maxDuration;
+			needQueryPlan = !entry.queryPlan && duration >= _settings.queryPlanThreshold;
+		}
+	}
+
+	std::optional<std::string> caller;
+	if (needCaller)
+		caller = getCaller();
+
+	std::optional<std::string> queryPlan;
+	if (needQueryPlan)
+		queryPlan = explainQueryPlan(rawSql);
+
+	// Entries may have changed in the meantime
+	std::scoped_lock lock {_mutex};
+
+	auto itEntry {_entries.find(sql)};
+	if (itEntry == std::end(_entries))
+	{
+		if (!canInsertEntry(duration))
+			return;
+
+		if (_entries.size() >= _settings.maxEntryCount)
+			_entries.erase(findFastestEntry());
+
+		itEntry = _entries.emplace(sql, QueryTraceEntry {}).first;
+		itEntry->second.sql = std::move(sql);
+		itEntry->second.bindCount = static_cast<std::size_t>(sqlite3_bind_parameter_count(statement));
+	}
+
+	QueryTraceEntry& entry {itEntry->second};
+	entry.executionCount++;
+	entry.totalDuration += duration;
+	if (entry.executionCount == 1 || duration > entry.maxDuration)
+	{
+		entry.maxDuration = duration;
+		entry.maxDurationRowCount = rowCount;
+		entry.maxDurationCaller = caller ? std::move(*caller) : "unknown";
+	}
+
+	if (!entry.queryPlan && queryPlan)
+		entry.queryPlan = std::move(queryPlan);
+}
+
+std::unordered_map<std::string, QueryTraceEntry>::iterator
+QueryTracer::findFastestEntry()
+{
+	return std::min_element(std::begin(_entries), std::end(_entries),
+			[](const auto& lhs, const auto& rhs) { return lhs.second.maxDuration < rhs.second.maxDuration; });
+}
+
+bool
+QueryTracer::canInsertEntry(std::chrono::nanoseconds duration)
+{
+	if (_settings.maxEntryCount == 0)
+		return false;
+
+	// Replace the fastest entry, if slower
+	if (_entries.size() >= _settings.maxEntryCount)
+		return findFastestEntry()->second.maxDuration < duration;
+
+	return true;
+}
+
+std::string
+QueryTracer::explainQueryPlan(const std::string& sql)
+{
+	// The explain connection is not thread safe
+	std::scoped_lock lock {_explainMutex};
+
+	// Dedicated connection, opened on first use (the database may not exist yet at construction)
+	// Statements cannot be run on the traced connection from the trace hook
+	if (!_explainConnection)
+	{
+		if (sqlite3_open_v2(_dbPath.c_str(), &_explainConnection, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+		{
+			const std::string error {sqlite3_errmsg(_explainConnection)};
+			LMS_LOG(DB, ERROR) << "Cannot open connection to explain query plans: " << error;
+			sqlite3_close(_explainConnection);
+			_explainConnection = nullptr;
+			return "\t\t(plan unavailable: " + error + ")\n";
+		}
+	}
+
+	// Failures are recorded as the plan, so that they are not retried (and logged) on each execution
+	sqlite3_stmt* statement {};
+	if (sqlite3_prepare_v2(_explainConnection, ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &statement, nullptr) != SQLITE_OK)
+	{
+		const std::string error {sqlite3_errmsg(_explainConnection)};
+		LMS_LOG(DB, ERROR) << "Cannot explain query plan: " << error;
+		return "\t\t(plan unavailable: " + error + ")\n";
+	}
+
+	// Columns are id, parent, notused, detail: nodes are indented according to their depth
+	std::map<int, std::size_t> depthById;
+	std::string res;
+	while (sqlite3_step(statement) == SQLITE_ROW)
+	{
+		const int id {sqlite3_column_int(statement, 0)};
+		const int parent {sqlite3_column_int(statement, 1)};
+		const unsigned char* detail {sqlite3_column_text(statement, 3)};
+
+		auto itParent {depthById.find(parent)};
+		const std::size_t depth {itParent != std::cend(depthById) ? itParent->second + 1 : 0};
+		depthById[id] = depth;
+
+		res += "\t\t";
+		res += std::string(depth * 2, ' ');
+		res += detail ? reinterpret_cast<const char*>(detail) : "";
+		res += '\n';
+	}
+	sqlite3_finalize(statement);
+
+	return res;
+}
+
+} // namespace Database
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RandomIdSampler.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+#include "utils/Logger.hpp"
+#include "utils/Random.hpp"
+
+namespace Database
+{
+	RandomIdSampler::RandomIdSampler(std::size_t maxIdSetCount)
+	: _maxIdSetCount {maxIdSetCount}
+	{
+	}
+
+	std::vector<IdType>
+	RandomIdSampler::sample(std::uint64_t generation, const std::string& idSetKey, std::optional<std::size_t> count, const IdsLoader& loadIds)
+	{
+		const IdSet idSet {getIdSet(generation, idSetKey, loadIds)};
+		const std::vector<IdType>& ids {*idSet};
+
+		std::vector<IdType> res;
+		if (!count || *count >= ids.size())
+		{
+			res = ids;
+		}
+		else
+		{
+			// Floyd's algorithm: count distinct positions, whatever the number of ids
+			std::unordered_set<std::size_t> positions;
+			positions.reserve(*count);
+			res.reserve(*count);
+
+			for (std::size_t j {ids.size() - *count}; j < ids.size(); ++j)
+			{
+				std::uniform_int_distribution<std::size_t> dist {0, j};
+				std::size_t position {dist(Random::getRandGenerator())};
+				if (!positions.insert(position).second)
+				{
+					// j cannot have been selected yet
+					position = j;
+					positions.insert(position);
+				}
+
+				res.push_back(ids[position]);
+			}
+		}
+
+		// Floyd's algorithm does not give uniformly ordered results
+		Random::shuffleContainer(res);
+
+		return res;
+	}
+
+	std::string
+	RandomIdSampler::getIdSetKey(std::string_view entityName, const std::set<IdType>& clusterIds)
+	{
+		std::string key {entityName};
+		for (const IdType clusterId : clusterIds)
+		{
+			key += ',';
+			key += std::to_string(clusterId);
+		}
+
+		return key;
+	}
+
+	RandomIdSampler::IdSet
+	RandomIdSampler::getIdSet(std::uint64_t generation, const std::string& idSetKey, const IdsLoader& loadIds)
+	{
+		{
+			std::shared_lock lock {_mutex};
+
+			if (generation == _generation)
+			{
+				auto it {_idSets.find(idSetKey)};
+				if (it != std::cend(_idSets))
+					return it->second;
+			}
+		}
+
+		// Several threads may load the same id set at the same time, this is harmless
+		IdSet idSet {std::make_shared<const std::vector<IdType>>(loadIds())};
+
+		{
+			std::unique_lock lock {_mutex};
+
+			if (generation < _generation)
+				return idSet;
+
+			if (generation > _generation)
+			{
+				LMS_LOG(DB, DEBUG) << "New library generation, dropping " << _idSets.size() << " random id sets";
+				_idSets.clear();
+				_generation = generation;
+			}
+
+			while (_idSets.size() >= _maxIdSetCount && !_idSets.empty())
+				_idSets.erase(Random::pickRandom(_idSets));
+
+			_idSets[idSetKey] = idSet;
+		}
+
+		return idSet;
+	}
+} // namespace Database
+
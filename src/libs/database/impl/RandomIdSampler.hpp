@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "database/Types.hpp"
+
+namespace Database
+{
+	// Draws random ids without making the database sort a whole table using ORDER BY RANDOM()
+	// The ids of each id set (entity type + filters) are loaded once per library generation and kept in memory
+	class RandomIdSampler
+	{
+		public:
+			RandomIdSampler(std::size_t maxIdSetCount);
+
+			RandomIdSampler(const RandomIdSampler&) = delete;
+			RandomIdSampler(RandomIdSampler&&) = delete;
+			RandomIdSampler& operator=(const RandomIdSampler&) = delete;
+			RandomIdSampler& operator=(RandomIdSampler&&) = delete;
+
+			using IdsLoader = std::function<std::vector<IdType>()>;
+
+			// Returns up to count distinct ids, in random order (all the ids if count is not set)
+			// loadIds is called (in the caller's transaction) if the ids of idSetKey are not known for this generation
+			std::vector<IdType> sample(std::uint64_t generation, const std::string& idSetKey, std::optional<std::size_t> count, const IdsLoader& loadIds);
+
+			static std::string getIdSetKey(std::string_view entityName, const std::set<IdType>& clusterIds);
+
+		private:
+			using IdSet = std::shared_ptr<const std::vector<IdType>>;
+
+			IdSet getIdSet(std::uint64_t generation, const std::string& idSetKey, const IdsLoader& loadIds);
+
+			const std::size_t _maxIdSetCount;
+
+			std::shared_mutex _mutex;
+			std::uint64_t _generation {};
+			std::unordered_map<std::string, IdSet> _idSets;
+	};
+} // namespace Database
+
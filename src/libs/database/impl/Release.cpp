@@ -27,6 +27,8 @@
 #include "database/Track.hpp"
 #include "database/User.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Random.hpp"
+#include "RandomIdSampler.hpp"
 #include "SqlQuery.hpp"
 
 namespace Database
@@ -71,6 +73,22 @@ createQuery(Session& session,
 	return query;
 }
 
+// Without filter, releases are directly queried so that the name index can be used to both sort and seek
+static
+Wt::Dbo::Query<Release::pointer>
+createFilterQuery(Session& session,
+			const std::set<IdType>& clusterIds,
+			const std::vector<std::string>& keywords)
+{
+	if (clusterIds.empty() && keywords.empty())
+		return session.getDboSession().query<Release::pointer>("SELECT r from release r");
+
+	auto query {createQuery<Release::pointer>(session, "SELECT r from release r", clusterIds, keywords)};
+	query.groupBy("r.id");
+
+	return query;
+}
+
 Release::Release(const std::string& name, const std::optional<UUID>& MBID)
 : _name {std::string(name, 0 , _maxNameLength)},
 _MBID {MBID ? MBID->getAsString() : ""}
@@ -103,6 +121,25 @@ Release::getById(Session& session, IdType id)
 	return session.getDboSession().find<Release>().where("id = ?").bind(id);
 }
 
+std::vector<Release::pointer>
+Release::getByIds(Session& session, const std::vector<IdType>& ids)
+{
+	session.checkSharedLocked();
+
+	std::vector<pointer> res;
+	forEachIdsChunk(ids, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().find<Release>().where("id IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<pointer> releases = query;
+		res.insert(std::end(res), std::begin(releases), std::end(releases));
+	});
+
+	return res;
+}
+
 Release::pointer
 Release::create(Session& session, const std::string& name, const std::optional<UUID>& MBID)
 {
@@ -167,13 +204,10 @@ Release::getAllRandom(Session& session, const std::set<IdType>& clusterIds, std:
 {
 	session.checkSharedLocked();
 
-	auto query {createQuery<Release::pointer>(session, "SELECT DISTINCT r from release r", clusterIds,{})};
-
-	Wt::Dbo::collection<pointer> res = query
-		.orderBy("RANDOM()")
-		.limit(size ? static_cast<int>(*size) : -1);
+	std::vector<pointer> res {getByIds(session, getAllIdsRandom(session, clusterIds, size))};
+	Random::shuffleContainer(res);
 
-	return std::vector<pointer>(res.begin(), res.end());
+	return res;
 }
 
 std::vector<IdType>
@@ -181,13 +215,14 @@ Release::getAllIdsRandom(Session& session, const std::set<IdType>& clusterIds, s
 {
 	session.checkSharedLocked();
 
-	auto query {createQuery<IdType>(session, "SELECT DISTINCT r.id from release r", clusterIds,{})};
-
-	Wt::Dbo::collection<IdType> res = query
-		.orderBy("RANDOM()")
-		.limit(size ? static_cast<int>(*size) : -1);
-
-	return std::vector<IdType>(res.begin(), res.end());
+	return session.getRandomIdSampler().sample(session.getLibraryGeneration(),
+			RandomIdSampler::getIdSetKey("release", clusterIds),
+			size,
+			[&]
+			{
+				Wt::Dbo::collection<IdType> res = createQuery<IdType>(session, "SELECT DISTINCT r.id from release r", clusterIds, {});
+				return std::vector<IdType>(res.begin(), res.end());
+			});
 }
 
 
@@ -306,9 +341,8 @@ Release::getByFilter(Session& session,
 {
 	session.checkSharedLocked();
 
-	Wt::Dbo::collection<pointer> collection = createQuery<Release::pointer>(session, "SELECT r from release r", clusterIds, keywords)
-		.groupBy("r.id")
-		.orderBy("r.name COLLATE NOCASE")
+	Wt::Dbo::collection<pointer> collection = createFilterQuery(session, clusterIds, keywords)
+		.orderBy("r.name COLLATE NOCASE, r.id")
 		.limit(range ? static_cast<int>(range->limit) + 1 : -1)
 		.offset(range ? static_cast<int>(range->offset) : -1);
 
@@ -325,6 +359,19 @@ Release::getByFilter(Session& session,
 	return res;
 }
 
+std::vector<Release::pointer>
+Release::getByFilter(Session& session,
+		const std::set<IdType>& clusterIds,
+		const std::vector<std::string>& keywords,
+		KeysetRange& range,
+		bool& moreResults)
+{
+	session.checkSharedLocked();
+
+	auto query {createFilterQuery(session, clusterIds, keywords)};
+	return getKeysetRange(query, "r.name", "r.id", range, moreResults, [](const pointer& release) { return release->getName(); });
+}
+
 std::vector<IdType>
 Release::getAllIdsWithClusters(Session& session, std::optional<std::size_t> limit)
 {
@@ -339,6 +386,20 @@ Release::getAllIdsWithClusters(Session& session, std::optional<std::size_t> limi
 	return std::vector<IdType>(res.begin(), res.end());
 }
 
+std::vector<IdType>
+Release::getAllIdsWithoutReplayGain(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<IdType> res = session.getDboSession().query<IdType>
+		("SELECT release_id FROM track")
+		.where("release_id IS NOT NULL")
+		.groupBy("release_id")
+		.having("COUNT(track_replay_gain) = 0");
+
+	return std::vector<IdType>(res.begin(), res.end());
+}
+
 
 std::optional<std::size_t>
 Release::getTotalTrack(void) const
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/ReleaseSummary.hpp"
+
+#include <unordered_map>
+
+#include <Wt/Dbo/WtSqlTraits.h>
+
+#include "database/Artist.hpp"
+#include "database/Cluster.hpp"
+#include "database/Release.hpp"
+#include "database/Session.hpp"
+#include "SqlQuery.hpp"
+#include "utils/String.hpp"
+
+namespace Database
+{
+
+ReleaseSummary::ReleaseSummary(Wt::Dbo::ptr<Release> release)
+: _release {release}
+{
+}
+
+ReleaseSummary::pointer
+ReleaseSummary::getByRelease(Session& session, IdType releaseId)
+{
+	session.checkSharedLocked();
+
+	return session.getDboSession().find<ReleaseSummary>().where("release_id = ?").bind(releaseId);
+}
+
+ReleaseSummary::pointer
+ReleaseSummary::get(Session& session, Wt::Dbo::ptr<Release> release)
+{
+	session.checkSharedLocked();
+
+	if (pointer summary {getByRelease(session, release.id())})
+		return summary;
+
+	// Not computed by the scanner yet: do not persist it as we may only hold a shared lock
+	auto summary {std::make_unique<ReleaseSummary>(release)};
+	summary->compute(session, release);
+
+	return pointer {std::move(summary)};
+}
+
+std::vector<ReleaseSummary::pointer>
+ReleaseSummary::get(Session& session, const std::vector<Wt::Dbo::ptr<Release>>& releases)
+{
+	session.checkSharedLocked();
+
+	std::vector<IdType> releaseIds;
+	releaseIds.reserve(releases.size());
+	for (const Wt::Dbo::ptr<Release>& release : releases)
+		releaseIds.push_back(release.id());
+
+	std::unordered_map<IdType, pointer> summaries;
+	forEachIdsChunk(releaseIds, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().find<ReleaseSummary>().where("release_id IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<pointer> collection = query;
+		for (const pointer& summary : collection)
+			summaries.emplace(summary->_release.id(), summary);
+	});
+
+	std::vector<pointer> res;
+	res.reserve(releases.size());
+	for (const Wt::Dbo::ptr<Release>& release : releases)
+	{
+		auto it {summaries.find(release.id())};
+		res.push_back(it != std::cend(summaries) ? it->second : get(session, release));
+	}
+
+	return res;
+}
+
+std::vector<IdType>
+ReleaseSummary::getAllReleaseIdsToRefresh(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<IdType> res = session.getDboSession().query<IdType>("SELECT r.id FROM release r LEFT OUTER JOIN release_summary r_s ON r_s.release_id = r.id WHERE r_s.id IS NULL OR r_s.outdated <> 0");
+	return std::vector<IdType>(res.begin(), res.end());
+}
+
+void
+ReleaseSummary::markOutdated(Session& session, IdType releaseId)
+{
+	session.checkUniqueLocked();
+
+	session.getDboSession().execute
+		("UPDATE release_summary SET outdated = 1 WHERE release_id = ?").bind(releaseId);
+}
+
+void
+ReleaseSummary::refresh(Session& session, Wt::Dbo::ptr<Release> release)
+{
+	session.checkUniqueLocked();
+
+	pointer summary {getByRelease(session, release.id())};
+	if (!summary)
+		summary = session.getDboSession().add(std::make_unique<ReleaseSummary>(release));
+
+	summary.modify()->compute(session, release);
+}
+
+std::optional<int>
+ReleaseSummary::getReleaseYear(bool originalDate) const
+{
+	const int year {originalDate ? _originalYear : _year};
+	if (year > 0)
+		return year;
+
+	return std::nullopt;
+}
+
+std::vector<IdType>
+ReleaseSummary::getArtistIds() const
+{
+	std::vector<IdType> res;
+
+	for (const std::string& strId : StringUtils::splitString(_artistIds, " "))
+	{
+		if (const std::optional<IdType> id {StringUtils::readAs<IdType>(strId)})
+			res.push_back(*id);
+	}
+
+	return res;
+}
+
+std::optional<std::string>
+ReleaseSummary::getGenre() const
+{
+	if (_genre.empty())
+		return std::nullopt;
+
+	return _genre;
+}
+
+void
+ReleaseSummary::compute(Session& session, const Wt::Dbo::ptr<Release>& release)
+{
+	_trackCount = static_cast<int>(release->getTracksCount());
+	_duration = std::chrono::duration_cast<std::chrono::duration<int, std::milli>>(release->getDuration());
+	_year = release->getReleaseYear(false).value_or(0);
+	_originalYear = release->getReleaseYear(true).value_or(0);
+	_lastWritten = release->getLastWritten();
+	_outdated = false;
+
+	{
+		std::vector<Artist::pointer> artists {release->getReleaseArtists()};
+		if (artists.empty())
+			artists = release->getArtists();
+
+		std::vector<std::string> strIds;
+		strIds.reserve(artists.size());
+		for (const Artist::pointer& artist : artists)
+			strIds.push_back(std::to_string(artist.id()));
+
+		_artistIds = StringUtils::joinStrings(strIds, " ");
+	}
+
+	_genre.clear();
+	if (const ClusterType::pointer clusterType {ClusterType::getByName(session, genreClusterTypeName)})
+	{
+		const auto clusterGroups {release->getClusterGroups({clusterType}, 1)};
+		if (!clusterGroups.empty() && !clusterGroups.front().empty())
+			_genre = clusterGroups.front().front()->getName();
+	}
+}
+
+} // namespace Database
+
@@ -25,22 +25,27 @@
 
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
 
 #include "database/Artist.hpp"
+#include "database/ArtistSummary.hpp"
 #include "database/Cluster.hpp"
 #include "database/Db.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
 #include "database/ScanSettings.hpp"
 #include "database/Track.hpp"
 #include "database/TrackBookmark.hpp"
 #include "database/TrackArtistLink.hpp"
 #include "database/TrackList.hpp"
 #include "database/TrackFeatures.hpp"
+#include "database/TrackFingerprint.hpp"
 #include "database/User.hpp"
 
 namespace Database {
 
-#define LMS_DATABASE_VERSION	28
+#define LMS_DATABASE_VERSION	38
 
 using Version = std::size_t;
 
@@ -290,6 +295,111 @@ CREATE TABLE "user_backup" (
 			// Just increment the scan version of the settings to make the next scheduled scan rescan everything
 			ScanSettings::get(*this).modify()->incScanVersion();
 		}
+		else if (version == 28)
+		{
+			// File CRC32, computed by the scanner if enabled
+			_session.execute("ALTER TABLE track ADD file_crc32 INTEGER");
+		}
+		else if (version == 29)
+		{
+			// Subsonic token based auth
+			_session.execute("ALTER TABLE user ADD subsonic_api_key TEXT NOT NULL DEFAULT ''");
+		}
+		else if (version == 30)
+		{
+			// Release and artist summaries, filled by the next scan
+			_session.execute(R"(
+CREATE TABLE IF NOT EXISTS "release_summary" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "track_count" integer not null,
+  "duration" integer,
+  "year" integer not null,
+  "original_year" integer not null,
+  "last_written" text,
+  "artist_ids" text not null,
+  "genre" text not null,
+  "release_id" bigint,
+  constraint "fk_release_summary_release" foreign key ("release_id") references "release" ("id") on delete cascade deferrable initially deferred
+))");
+			_session.execute(R"(
+CREATE TABLE IF NOT EXISTS "artist_summary" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "release_count" integer not null,
+  "artist_id" bigint,
+  constraint "fk_artist_summary_artist" foreign key ("artist_id") references "artist" ("id") on delete cascade deferrable initially deferred
+))");
+		}
+		else if (version == 31)
+		{
+			// File size and audio properties, to avoid stat'ing files when building responses
+			_session.execute("ALTER TABLE track ADD file_size INTEGER NOT NULL DEFAULT 0");
+			_session.execute("ALTER TABLE track ADD bitrate INTEGER NOT NULL DEFAULT 0");
+			_session.execute("ALTER TABLE track ADD sample_rate INTEGER NOT NULL DEFAULT 0");
+			_session.execute("ALTER TABLE track ADD channel_count INTEGER NOT NULL DEFAULT 0");
+			_session.execute("ALTER TABLE track ADD codec TEXT NOT NULL DEFAULT ''");
+			// Just increment the scan version of the settings to make the next scheduled scan rescan everything
+			ScanSettings::get(*this).modify()->incScanVersion();
+		}
+		else if (version == 32)
+		{
+			// Track play stats, computed from the existing listen history ('__played_tracks__' internal track lists)
+			_session.execute(R"(
+CREATE TABLE IF NOT EXISTS "track_play_stats" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "play_count" integer not null,
+  "last_played" bigint not null,
+  "user_id" bigint,
+  "track_id" bigint,
+  constraint "fk_track_play_stats_user" foreign key ("user_id") references "user" ("id") on delete cascade deferrable initially deferred,
+  constraint "fk_track_play_stats_track" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred
+))");
+
+			const std::string playedTrackLists {"p.name = '__played_tracks__' AND p.type = " + std::to_string(static_cast<int>(TrackList::Type::Internal))};
+
+			_session.execute("INSERT INTO track_play_stats (version, play_count, last_played, user_id, track_id)"
+				" SELECT 0, COUNT(*), MAX(p_e.id), p.user_id, p_e.track_id"
+				" FROM tracklist_entry p_e INNER JOIN tracklist p ON p.id = p_e.tracklist_id"
+				" WHERE " + playedTrackLists +
+				" GROUP BY p.user_id, p_e.track_id");
+		}
+		else if (version == 33)
+		{
+			// Acoustic fingerprints, computed by the next scan
+			_session.execute(R"(
+CREATE TABLE IF NOT EXISTS "track_fingerprint" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "data" blob not null,
+  "track_id" bigint,
+  constraint "fk_track_fingerprint_track" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred
+))");
+		}
+		else if (version == 34)
+		{
+			// Remember the CRC32 computations that did not give any result, not to retry them on each scan
+			_session.execute("ALTER TABLE track ADD file_crc32_computed BOOLEAN NOT NULL DEFAULT 0");
+			_session.execute("UPDATE track SET file_crc32_computed = 1 WHERE file_crc32 IS NOT NULL");
+		}
+		else if (version == 35)
+		{
+			// Persisted summary invalidations
+			_session.execute("ALTER TABLE release_summary ADD outdated BOOLEAN NOT NULL DEFAULT 0");
+			_session.execute("ALTER TABLE artist_summary ADD outdated BOOLEAN NOT NULL DEFAULT 0");
+		}
+		else if (version == 36)
+		{
+			// Remember the loudness measures that did not give any replay gain, not to retry them on each scan
+			_session.execute("ALTER TABLE track ADD loudness_measured BOOLEAN NOT NULL DEFAULT 0");
+		}
+		else if (version == 37)
+		{
+			// Release and artist play stats are now aggregated from the track play stats, using the current track links
+			_session.execute("DROP TABLE IF EXISTS release_play_stats");
+			_session.execute("DROP TABLE IF EXISTS artist_play_stats");
+		}
 		else
 		{
 			LMS_LOG(DB, ERROR) << "Database version " << version << " cannot be handled using migration";
@@ -307,15 +417,19 @@ Session::Session(Db& db)
 
 	_session.mapClass<VersionInfo>("version_info");
 	_session.mapClass<Artist>("artist");
+	_session.mapClass<ArtistSummary>("artist_summary");
 	_session.mapClass<AuthToken>("auth_token");
 	_session.mapClass<Cluster>("cluster");
 	_session.mapClass<ClusterType>("cluster_type");
+	_session.mapClass<TrackPlayStats>("track_play_stats");
 	_session.mapClass<Release>("release");
+	_session.mapClass<ReleaseSummary>("release_summary");
 	_session.mapClass<ScanSettings>("scan_settings");
 	_session.mapClass<Track>("track");
 	_session.mapClass<TrackBookmark>("track_bookmark");
 	_session.mapClass<TrackArtistLink>("track_artist_link");
 	_session.mapClass<TrackFeatures>("track_features");
+	_session.mapClass<TrackFingerprint>("track_fingerprint");
 	_session.mapClass<TrackList>("tracklist");
 	_session.mapClass<TrackListEntry>("tracklist_entry");
 	_session.mapClass<User>("user");
@@ -331,8 +445,62 @@ enum class OwnedLock
 
 static thread_local std::map<std::shared_mutex*, OwnedLock> lockDebug;
 
+namespace
+{
+	struct LockMetrics
+	{
+		Metrics::Histogram& waitTime;
+		Metrics::Histogram& holdTime;
+	};
+
+	LockMetrics
+	createLockMetrics(const std::string& mode)
+	{
+		return LockMetrics {
+			Metrics::getRegistry().getHistogram("lms_db_lock_wait_seconds", "Time spent waiting for the database lock", Metrics::getDurationBuckets(), {{"mode", mode}}),
+			Metrics::getRegistry().getHistogram("lms_db_lock_hold_seconds", "Time the database lock is held", Metrics::getDurationBuckets(), {{"mode", mode}}),
+		};
+	}
+
+	const LockMetrics&
+	getUniqueLockMetrics()
+	{
+		static const LockMetrics metrics {createLockMetrics("unique")};
+		return metrics;
+	}
+
+	const LockMetrics&
+	getSharedLockMetrics()
+	{
+		static const LockMetrics metrics {createLockMetrics("shared")};
+		return metrics;
+	}
+
+	double
+	toSeconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double> {duration}.count();
+	}
+}
+
+TransactionLockTimer::TransactionLockTimer(Mode mode, std::chrono::steady_clock::time_point lockRequestTime)
+: _mode {mode}
+, _lockAcquiredTime {std::chrono::steady_clock::now()}
+{
+	const LockMetrics& metrics {_mode == Mode::Unique ? getUniqueLockMetrics() : getSharedLockMetrics()};
+	metrics.waitTime.observe(toSeconds(_lockAcquiredTime - lockRequestTime));
+}
+
+TransactionLockTimer::~TransactionLockTimer()
+{
+	const LockMetrics& metrics {_mode == Mode::Unique ? getUniqueLockMetrics() : getSharedLockMetrics()};
+	metrics.holdTime.observe(toSeconds(std::chrono::steady_clock::now() - _lockAcquiredTime));
+}
+
 UniqueTransaction::UniqueTransaction(std::shared_mutex& mutex, Wt::Dbo::Session& session)
-: _lock {mutex},
+: _lockRequestTime {std::chrono::steady_clock::now()},
+ _lock {mutex},
+ _lockTimer {TransactionLockTimer::Mode::Unique, _lockRequestTime},
  _transaction {session}
 {
 	assert(lockDebug[_lock.mutex()] == OwnedLock::None);
@@ -346,7 +514,9 @@ UniqueTransaction::~UniqueTransaction()
 }
 
 SharedTransaction::SharedTransaction(std::shared_mutex& mutex, Wt::Dbo::Session& session)
-: _lock {mutex},
+: _lockRequestTime {std::chrono::steady_clock::now()},
+ _lock {mutex},
+ _lockTimer {TransactionLockTimer::Mode::Shared, _lockRequestTime},
  _transaction {session}
 {
 	assert(lockDebug[_lock.mutex()] == OwnedLock::None);
@@ -383,6 +553,36 @@ Session::createSharedTransaction()
 	return SharedTransaction {_db.getMutex(), _session};
 }
 
+std::uint64_t
+Session::getLibraryGeneration() const
+{
+	return _db.getLibraryGeneration();
+}
+
+void
+Session::bumpLibraryGeneration()
+{
+	_db.bumpLibraryGeneration();
+}
+
+std::uint64_t
+Session::getUserGeneration(IdType userId) const
+{
+	return _db.getUserGeneration(userId);
+}
+
+void
+Session::bumpUserGeneration(IdType userId)
+{
+	_db.bumpUserGeneration(userId);
+}
+
+RandomIdSampler&
+Session::getRandomIdSampler()
+{
+	return _db.getRandomIdSampler();
+}
+
 void
 Session::prepareTables()
 {
@@ -403,8 +603,10 @@ Session::prepareTables()
 	{
 		auto uniqueTransaction {createUniqueTransaction()};
 		_session.execute("CREATE INDEX IF NOT EXISTS artist_name_idx ON artist(name)");
+		_session.execute("CREATE INDEX IF NOT EXISTS artist_name_nocase_idx ON artist(name COLLATE NOCASE)");
 		_session.execute("CREATE INDEX IF NOT EXISTS artist_sort_name_nocase_idx ON artist(sort_name COLLATE NOCASE)");
 		_session.execute("CREATE INDEX IF NOT EXISTS artist_mbid_idx ON artist(mbid)");
+		_session.execute("CREATE INDEX IF NOT EXISTS artist_summary_artist_idx ON artist_summary(artist_id)");
 		_session.execute("CREATE INDEX IF NOT EXISTS auth_token_user_idx ON auth_token(user_id)");
 		_session.execute("CREATE INDEX IF NOT EXISTS auth_token_expiry_idx ON auth_token(expiry)");
 		_session.execute("CREATE INDEX IF NOT EXISTS auth_token_value_idx ON auth_token(value)");
@@ -414,6 +616,7 @@ Session::prepareTables()
 		_session.execute("CREATE INDEX IF NOT EXISTS release_name_idx ON release(name)");
 		_session.execute("CREATE INDEX IF NOT EXISTS release_name_nocase_idx ON release(name COLLATE NOCASE)");
 		_session.execute("CREATE INDEX IF NOT EXISTS release_mbid_idx ON release(mbid)");
+		_session.execute("CREATE INDEX IF NOT EXISTS release_summary_release_idx ON release_summary(release_id)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_file_last_write_idx ON track(file_last_write)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_path_idx ON track(file_path)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_name_idx ON track(name)");
@@ -425,6 +628,10 @@ Session::prepareTables()
 		_session.execute("CREATE INDEX IF NOT EXISTS tracklist_name_idx ON tracklist(name)");
 		_session.execute("CREATE INDEX IF NOT EXISTS tracklist_user_idx ON tracklist(user_id)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_features_track_idx ON track_features(track_id)");
+		_session.execute("CREATE INDEX IF NOT EXISTS track_fingerprint_track_idx ON track_fingerprint(track_id)");
+		_session.execute("CREATE INDEX IF NOT EXISTS track_play_stats_user_track_idx ON track_play_stats(user_id,track_id)");
+		_session.execute("CREATE INDEX IF NOT EXISTS track_play_stats_user_play_count_idx ON track_play_stats(user_id,play_count DESC,last_played DESC)");
+		_session.execute("CREATE INDEX IF NOT EXISTS track_play_stats_user_last_played_idx ON track_play_stats(user_id,last_played DESC)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_artist_link_artist_idx ON track_artist_link(artist_id)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_artist_link_name_idx ON track_artist_link(name)");
 		_session.execute("CREATE INDEX IF NOT EXISTS track_artist_link_track_idx ON track_artist_link(track_id)");
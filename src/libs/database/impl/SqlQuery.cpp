@@ -197,3 +197,19 @@ SqlQuery::get(void) const
 	return oss.str();
 }
 
+namespace Database
+{
+	std::string
+	getInClausePlaceholders(std::size_t count)
+	{
+		assert(count > 0);
+
+		std::string res {"(?"};
+		for (std::size_t i {1}; i < count; ++i)
+			res += ", ?";
+		res += ")";
+
+		return res;
+	}
+}
+
@@ -19,8 +19,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <list>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include <Wt/Dbo/Dbo.h>
+
+#include "database/Types.hpp"
 
 
 class WhereClause
@@ -133,3 +140,67 @@ class SqlQuery
 		GroupByStatement	_groupByStatement;	// GROUP BY statement
 };
 
+namespace Database
+{
+	// Keep the number of bound parameters per query well below the SQLite limit
+	static constexpr std::size_t maxBoundIdsPerQuery {500};
+
+	// "(?, ?, ..., ?)"
+	std::string getInClausePlaceholders(std::size_t count);
+
+	template <typename Func>
+	void
+	forEachIdsChunk(const std::vector<IdType>& ids, Func&& func)
+	{
+		for (std::size_t offset {}; offset < ids.size(); offset += maxBoundIdsPerQuery)
+		{
+			const std::vector<IdType> chunk (std::cbegin(ids) + offset, std::cbegin(ids) + std::min(offset + maxBoundIdsPerQuery, ids.size()));
+			func(chunk);
+		}
+	}
+
+	// Gets the next page of a keyset range, sorted by (sortColumn COLLATE NOCASE, idColumn)
+	// An empty sortColumn means the entries are only sorted by id
+	// getSortKey must return the value of sortColumn for a given entry
+	template <typename T, typename SortKeyFunc>
+	std::vector<Wt::Dbo::ptr<T>>
+	getKeysetRange(Wt::Dbo::Query<Wt::Dbo::ptr<T>>& query, std::string_view sortColumn, std::string_view idColumn, KeysetRange& range, bool& moreResults, SortKeyFunc getSortKey)
+	{
+		const std::string id {idColumn};
+		if (sortColumn.empty())
+		{
+			if (range.after)
+				query.where(id + " > ?").bind(range.after->id);
+			query.orderBy(id);
+		}
+		else
+		{
+			const std::string sort {std::string {sortColumn} + " COLLATE NOCASE"};
+			if (range.after)
+			{
+				// Same as "sort > ? OR (sort = ? AND id > ?)", written so that an index on sortColumn can be used to seek the first entry
+				query.where(sort + " >= ? AND (" + sort + " > ? OR " + id + " > ?)")
+					.bind(range.after->sortKey)
+					.bind(range.after->sortKey)
+					.bind(range.after->id);
+			}
+			query.orderBy(sort + ", " + id);
+		}
+
+		Wt::Dbo::collection<Wt::Dbo::ptr<T>> collection = query.limit(static_cast<int>(range.limit) + 1);
+
+		std::vector<Wt::Dbo::ptr<T>> res (collection.begin(), collection.end());
+		if (res.size() == range.limit + 1)
+		{
+			moreResults = true;
+			res.pop_back();
+		}
+		else
+			moreResults = false;
+
+		if (!res.empty())
+			range.after = KeysetRange::Key {sortColumn.empty() ? std::string {} : getSortKey(res.back()), res.back().id()};
+
+		return res;
+	}
+}
@@ -26,9 +26,12 @@
 #include "database/Release.hpp"
 #include "database/TrackArtistLink.hpp"
 #include "database/TrackFeatures.hpp"
+#include "database/TrackFingerprint.hpp"
 #include "database/Session.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Random.hpp"
 
+#include "RandomIdSampler.hpp"
 #include "SqlQuery.hpp"
 
 namespace Database {
@@ -100,13 +103,10 @@ Track::getAllRandom(Session& session, const std::set<IdType>& clusterIds, std::o
 {
 	session.checkSharedLocked();
 
-	auto query {createQuery<Track::pointer>(session, "SELECT t from track t", clusterIds, {})};
-
-	Wt::Dbo::collection<Track::pointer> collection = query
-		.orderBy("RANDOM()")
-		.limit(limit ? static_cast<int>(*limit) + 1: -1);
+	std::vector<pointer> res {getByIds(session, getAllIdsRandom(session, clusterIds, limit))};
+	Random::shuffleContainer(res);
 
-	return std::vector<pointer>(collection.begin(), collection.end());
+	return res;
 }
 
 std::vector<Database::IdType>
@@ -114,13 +114,14 @@ Track::getAllIdsRandom(Session& session, const std::set<IdType>& clusterIds, std
 {
 	session.checkSharedLocked();
 
-	auto query {createQuery<IdType>(session, "SELECT t.id from track t", clusterIds, {})};
-
-	Wt::Dbo::collection<IdType> collection = query
-		.orderBy("RANDOM()")
-		.limit(limit ? static_cast<int>(*limit) + 1: -1);
-
-	return std::vector<IdType>(collection.begin(), collection.end());
+	return session.getRandomIdSampler().sample(session.getLibraryGeneration(),
+			RandomIdSampler::getIdSetKey("track", clusterIds),
+			limit ? std::make_optional(*limit + 1) : std::nullopt,
+			[&]
+			{
+				Wt::Dbo::collection<IdType> collection = createQuery<IdType>(session, "SELECT t.id from track t", clusterIds, {});
+				return std::vector<IdType>(collection.begin(), collection.end());
+			});
 }
 
 
@@ -150,6 +151,25 @@ Track::getById(Session& session, IdType id)
 		.where("id = ?").bind(id);
 }
 
+std::vector<Track::pointer>
+Track::getByIds(Session& session, const std::vector<IdType>& ids)
+{
+	session.checkSharedLocked();
+
+	std::vector<pointer> res;
+	forEachIdsChunk(ids, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().find<Track>().where("id IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<pointer> tracks = query;
+		res.insert(std::end(res), std::begin(tracks), std::end(tracks));
+	});
+
+	return res;
+}
+
 Track::pointer
 Track::getByMBID(Session& session, const UUID& mbid)
 {
@@ -240,6 +260,41 @@ Track::getAllWithMBIDAndMissingFeatures(Session& session)
 	return std::vector<pointer>(res.begin(), res.end());
 }
 
+std::vector<Track::pointer>
+Track::getAllWithMissingFeatures(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<pointer> res = session.getDboSession().query<pointer>
+		("SELECT t FROM track t")
+		.where("NOT EXISTS (SELECT * FROM track_features t_f WHERE t_f.track_id = t.id)");
+	return std::vector<pointer>(res.begin(), res.end());
+}
+
+std::vector<Track::pointer>
+Track::getAllWithMissingFingerprint(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<pointer> res = session.getDboSession().query<pointer>
+		("SELECT t FROM track t")
+		.where("NOT EXISTS (SELECT * FROM track_fingerprint t_f WHERE t_f.track_id = t.id)");
+	return std::vector<pointer>(res.begin(), res.end());
+}
+
+std::vector<Track::pointer>
+Track::getAllWithMissingReplayGain(Session& session)
+{
+	session.checkSharedLocked();
+
+	Wt::Dbo::collection<pointer> res = session.getDboSession().query<pointer>
+		("SELECT t FROM track t")
+		.where("t.track_replay_gain IS NULL")
+		.where("NOT t.loudness_measured")
+		.orderBy("t.release_id");
+	return std::vector<pointer>(res.begin(), res.end());
+}
+
 std::vector<IdType>
 Track::getAllIdsWithFeatures(Session& session, std::optional<std::size_t> limit)
 {
@@ -339,6 +394,7 @@ Track::getByFilter(Session& session,
 	session.checkSharedLocked();
 
 	Wt::Dbo::collection<pointer> collection = createQuery<Track::pointer>(session, "SELECT t from track t", clusterIds, keywords)
+		.orderBy("t.id")
 		.limit(range ? static_cast<int>(range->limit) + 1 : -1)
 		.offset(range ? static_cast<int>(range->offset) : -1);
 
@@ -354,6 +410,19 @@ Track::getByFilter(Session& session,
 	return res;
 }
 
+std::vector<Track::pointer>
+Track::getByFilter(Session& session,
+		const std::set<IdType>& clusterIds,
+		const std::vector<std::string>& keywords,
+		KeysetRange& range,
+		bool& moreResults)
+{
+	session.checkSharedLocked();
+
+	auto query {createQuery<Track::pointer>(session, "SELECT t from track t", clusterIds, keywords)};
+	return getKeysetRange(query, "", "t.id", range, moreResults, [](const pointer&) { return std::string {}; });
+}
+
 std::vector<Track::pointer>
 Track::getSimilarTracks(Session& session,
 				const std::unordered_set<IdType>& tracks,
@@ -480,6 +549,36 @@ Track::getCopyrightURL() const
 	return _copyrightURL != "" ? std::make_optional<std::string>(_copyrightURL) : std::nullopt;
 }
 
+std::optional<std::uintmax_t>
+Track::getFileSize() const
+{
+	return _fileSize > 0 ? std::make_optional<std::uintmax_t>(_fileSize) : std::nullopt;
+}
+
+std::optional<std::size_t>
+Track::getBitrate() const
+{
+	return _bitrate > 0 ? std::make_optional<std::size_t>(_bitrate) : std::nullopt;
+}
+
+std::optional<std::size_t>
+Track::getSampleRate() const
+{
+	return _sampleRate > 0 ? std::make_optional<std::size_t>(_sampleRate) : std::nullopt;
+}
+
+std::optional<std::size_t>
+Track::getChannelCount() const
+{
+	return _channelCount > 0 ? std::make_optional<std::size_t>(_channelCount) : std::nullopt;
+}
+
+std::optional<std::string>
+Track::getCodec() const
+{
+	return _codec != "" ? std::make_optional<std::string>(_codec) : std::nullopt;
+}
+
 std::vector<Wt::Dbo::ptr<Artist>>
 Track::getArtists(EnumSet<TrackArtistLinkType> linkTypes) const
 {
@@ -571,6 +670,12 @@ Track::getTrackFeatures() const
 	return _trackFeatures.lock();
 }
 
+Wt::Dbo::ptr<TrackFingerprint>
+Track::getTrackFingerprint() const
+{
+	return _trackFingerprint.lock();
+}
+
 std::vector<std::vector<Cluster::pointer>>
 Track::getClusterGroups(std::vector<ClusterType::pointer> clusterTypes, std::size_t size) const
 {
@@ -22,6 +22,7 @@
 #include "database/Artist.hpp"
 #include "database/Session.hpp"
 #include "database/Track.hpp"
+#include "SqlQuery.hpp"
 
 namespace Database {
 
@@ -53,5 +54,27 @@ TrackArtistLink::getUsedTypes(Session& session)
 	return EnumSet<TrackArtistLinkType>(std::begin(collection), std::end(collection));
 }
 
+std::vector<std::tuple<IdType, IdType>>
+TrackArtistLink::getTrackArtistIds(Session& session, const std::vector<IdType>& trackIds, TrackArtistLinkType type)
+{
+	session.checkSharedLocked();
+
+	std::vector<std::tuple<IdType, IdType>> res;
+	forEachIdsChunk(trackIds, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.getDboSession().query<std::tuple<IdType, IdType>>("SELECT track_id, artist_id FROM track_artist_link")
+			.where("type = ?").bind(type)
+			.where("track_id IN " + getInClausePlaceholders(chunkIds.size()))
+			.orderBy("id")};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<std::tuple<IdType, IdType>> links = query;
+		res.insert(std::end(res), std::begin(links), std::end(links));
+	});
+
+	return res;
+}
+
 }
 
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/TrackFingerprint.hpp"
+
+#include "database/Session.hpp"
+#include "database/Track.hpp"
+
+namespace Database {
+
+TrackFingerprint::TrackFingerprint(Wt::Dbo::ptr<Track> track, const std::vector<unsigned char>& data)
+: _data {data}
+, _track {track}
+{
+}
+
+TrackFingerprint::pointer
+TrackFingerprint::create(Session& session, Wt::Dbo::ptr<Track> track, const std::vector<unsigned char>& data)
+{
+	session.checkUniqueLocked();
+	return session.getDboSession().add(std::make_unique<TrackFingerprint>(track, data));
+}
+
+std::vector<std::tuple<IdType, std::chrono::milliseconds, std::vector<unsigned char>>>
+TrackFingerprint::getAll(Session& session)
+{
+	session.checkSharedLocked();
+
+	using ResultType = std::tuple<IdType, std::chrono::milliseconds, std::vector<unsigned char>>;
+	Wt::Dbo::collection<ResultType> res = session.getDboSession().query<ResultType>("SELECT t_f.track_id, t.duration, t_f.data FROM track_fingerprint t_f")
+		.join("track t ON t.id = t_f.track_id");
+
+	return std::vector<ResultType>(res.begin(), res.end());
+}
+
+} // namespace Database
+
@@ -147,6 +147,18 @@ TrackList::getEntries(std::optional<std::size_t> offset, std::optional<std::size
 	return std::vector<Wt::Dbo::ptr<TrackListEntry>>(entries.begin(), entries.end());
 }
 
+std::vector<Wt::Dbo::ptr<TrackListEntry>>
+TrackList::getEntries(KeysetRange& range, bool& moreResults) const
+{
+	assert(session());
+	assert(IdIsValid(self()->id()));
+
+	auto query {session()->find<TrackListEntry>()};
+	query.where("tracklist_id = ?").bind(self().id());
+
+	return getKeysetRange(query, "", "id", range, moreResults, [](const Wt::Dbo::ptr<TrackListEntry>&) { return std::string {}; });
+}
+
 std::vector<Wt::Dbo::ptr<TrackListEntry>>
 TrackList::getEntriesReverse(std::optional<std::size_t> offset, std::optional<std::size_t> size) const
 {
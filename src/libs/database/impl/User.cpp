@@ -20,14 +20,47 @@
 #include "database/User.hpp"
 
 #include "database/Artist.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
 #include "database/Session.hpp"
 #include "database/Track.hpp"
 #include "database/TrackList.hpp"
 #include "utils/Logger.hpp"
+#include "SqlQuery.hpp"
 
 namespace Database {
 
+static
+std::set<IdType>
+getStarredIds(Wt::Dbo::Session& session, IdType userId, const std::string& starredTable, const std::string& idColumn, const std::vector<IdType>& ids)
+{
+	std::set<IdType> res;
+	forEachIdsChunk(ids, [&](const std::vector<IdType>& chunkIds)
+	{
+		auto query {session.query<IdType>("SELECT " + idColumn + " FROM " + starredTable)
+			.where("user_id = ?").bind(userId)
+			.where(idColumn + " IN " + getInClausePlaceholders(chunkIds.size()))};
+		for (const IdType id : chunkIds)
+			query.bind(id);
+
+		Wt::Dbo::collection<IdType> starredIds = query;
+		res.insert(std::begin(starredIds), std::end(starredIds));
+	});
+
+	return res;
+}
+
+static
+std::vector<IdType>
+getAllStarredIds(Wt::Dbo::Session& session, IdType userId, const std::string& starredTable, const std::string& idColumn)
+{
+	Wt::Dbo::collection<IdType> starredIds = session.query<IdType>("SELECT " + idColumn + " FROM " + starredTable)
+		.where("user_id = ?").bind(userId)
+		.orderBy(idColumn);
+
+	return std::vector<IdType>(std::begin(starredIds), std::end(starredIds));
+}
+
 
 AuthToken::AuthToken(const std::string& value, const Wt::WDateTime& expiry, Wt::Dbo::ptr<User> user)
 : _value {value}
@@ -143,6 +176,18 @@ User::getPlayedTrackList(Session& session) const
 	return TrackList::get(session, playedListName, TrackList::Type::Internal, self());
 }
 
+void
+User::addPlayedTrack(Session& session, Wt::Dbo::ptr<Track> track) const
+{
+	assert(self());
+	assert(track);
+	session.checkUniqueLocked();
+
+	const TrackListEntry::pointer entry {TrackListEntry::create(session, track, getPlayedTrackList(session))};
+
+	TrackPlayStats::addPlay(session, self(), track, entry.id());
+}
+
 Wt::Dbo::ptr<TrackList>
 User::getQueuedTrackList(Session& session) const
 {
@@ -172,6 +217,22 @@ User::hasStarredArtist(Wt::Dbo::ptr<Artist> artist) const
 	return _starredArtists.count(artist) != 0;
 }
 
+std::set<IdType>
+User::getStarredArtistIds(const std::vector<IdType>& artistIds) const
+{
+	assert(session());
+
+	return getStarredIds(*session(), self()->id(), "user_artist_starred", "artist_id", artistIds);
+}
+
+std::vector<IdType>
+User::getAllStarredArtistIds() const
+{
+	assert(session());
+
+	return getAllStarredIds(*session(), self()->id(), "user_artist_starred", "artist_id");
+}
+
 void
 User::starRelease(Wt::Dbo::ptr<Release> release)
 {
@@ -192,6 +253,22 @@ User::hasStarredRelease(Wt::Dbo::ptr<Release> release) const
 	return _starredReleases.count(release) != 0;
 }
 
+std::set<IdType>
+User::getStarredReleaseIds(const std::vector<IdType>& releaseIds) const
+{
+	assert(session());
+
+	return getStarredIds(*session(), self()->id(), "user_release_starred", "release_id", releaseIds);
+}
+
+std::vector<IdType>
+User::getAllStarredReleaseIds() const
+{
+	assert(session());
+
+	return getAllStarredIds(*session(), self()->id(), "user_release_starred", "release_id");
+}
+
 void
 User::starTrack(Wt::Dbo::ptr<Track> track)
 {
@@ -212,6 +289,22 @@ User::hasStarredTrack(Wt::Dbo::ptr<Track> track) const
 	return _starredTracks.count(track) != 0;
 }
 
+std::set<IdType>
+User::getStarredTrackIds(const std::vector<IdType>& trackIds) const
+{
+	assert(session());
+
+	return getStarredIds(*session(), self()->id(), "user_track_starred", "track_id", trackIds);
+}
+
+std::vector<IdType>
+User::getAllStarredTrackIds() const
+{
+	assert(session());
+
+	return getAllStarredIds(*session(), self()->id(), "user_track_starred", "track_id");
+}
+
 } // namespace Database
 
 
@@ -62,6 +62,7 @@ class Artist : public Wt::Dbo::Dbo<Artist>
 		// Accessors
 		static pointer			getByMBID(Session& session, const UUID& MBID);
 		static pointer			getById(Session& session, IdType id);
+		static std::vector<pointer>	getByIds(Session& session, const std::vector<IdType>& ids);
 		static std::vector<pointer>	getByName(Session& session, const std::string& name);		// exact match on name field
 		static std::vector<pointer> 	getByClusters(Session& session,
 								const std::set<IdType>& clusters,		// at least one track that belongs to  these clusters
@@ -74,6 +75,14 @@ class Artist : public Wt::Dbo::Dbo<Artist>
 								SortMethod sortMethod,
 								std::optional<Range> range,
 								bool& moreExpected);
+		// same, using keyset pagination (sorted by id if sortMethod is None)
+		static std::vector<pointer> 	getByFilter(Session& session,
+								const std::set<IdType>& clusters,
+								const std::vector<std::string>& keywords,
+								std::optional<TrackArtistLinkType> linkType,
+								SortMethod sortMethod,
+								KeysetRange& range,
+								bool& moreExpected);
 
 		static std::vector<pointer>	getAll(Session& session);
 		static std::vector<pointer>	getAll(Session& session, SortMethod sortMethod);
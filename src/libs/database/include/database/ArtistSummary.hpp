@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Wt/Dbo/Dbo.h>
+
+#include "Types.hpp"
+
+namespace Database
+{
+
+class Artist;
+class Session;
+
+// Denormalized artist data, maintained by the scanner
+class ArtistSummary : public Wt::Dbo::Dbo<ArtistSummary>
+{
+	public:
+		using pointer = Wt::Dbo::ptr<ArtistSummary>;
+
+		ArtistSummary() = default;
+		ArtistSummary(Wt::Dbo::ptr<Artist> artist);
+
+		// Accessors
+		static pointer			getByArtist(Session& session, IdType artistId);
+		// Materialized summary if any, transient summary computed on the fly otherwise
+		static pointer			get(Session& session, Wt::Dbo::ptr<Artist> artist);
+		static std::vector<pointer>	get(Session& session, const std::vector<Wt::Dbo::ptr<Artist>>& artists); // same order as artists
+		static std::vector<IdType>	getAllArtistIdsToRefresh(Session& session); // artists that have no summary yet, or an outdated one
+
+		// Create or update the summary of the artist
+		static void			refresh(Session& session, Wt::Dbo::ptr<Artist> artist);
+		// Persisted, so that an aborted scan does not leave outdated summaries behind
+		static void			markOutdated(Session& session, IdType artistId);
+
+		std::size_t	getReleaseCount() const	{ return _releaseCount; }
+
+		template<class Action>
+		void persist(Action& a)
+		{
+			Wt::Dbo::field(a, _releaseCount,	"release_count");
+			Wt::Dbo::field(a, _outdated,		"outdated");
+
+			Wt::Dbo::belongsTo(a, _artist, "artist", Wt::Dbo::OnDeleteCascade);
+		}
+
+	private:
+		void compute(const Wt::Dbo::ptr<Artist>& artist);
+
+		int			_releaseCount {};
+		bool			_outdated {};
+
+		Wt::Dbo::ptr<Artist>	_artist;
+};
+
+} // namespace Database
+
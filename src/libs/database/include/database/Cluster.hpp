@@ -21,6 +21,7 @@
 
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
 #include <Wt/Dbo/Dbo.h>
@@ -48,6 +49,8 @@ class Cluster : public Wt::Dbo::Dbo<Cluster>
 		static std::vector<pointer> getAll(Session& session);
 		static std::vector<pointer> getAllOrphans(Session& session);
 		static pointer getById(Session& session, IdType id);
+		// (track id, cluster name) of the given tracks, for the given cluster type
+		static std::vector<std::tuple<IdType, std::string>> getTrackClusterNames(Session& session, const std::vector<IdType>& trackIds, IdType clusterTypeId);
 
 		// Create utility
 		static pointer create(Session& session, Wt::Dbo::ptr<ClusterType> type, std::string_view name);
@@ -19,19 +19,30 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <unordered_map>
 
 #include <Wt/Dbo/SqlConnectionPool.h>
 
+#include "database/QueryTracer.hpp"
+#include "database/Types.hpp"
+
 namespace Database {
 
+class RandomIdSampler;
 class Session;
 class Db
 {
 	public:
 
-		Db(const std::filesystem::path& dbPath);
+		// SQLite trace hooks are only installed if query metrics or query tracing are enabled
+		Db(const std::filesystem::path& dbPath, const std::optional<QueryTracer::Settings>& queryTracerSettings = std::nullopt, bool enableQueryMetrics = false);
 		~Db();
 
 		Db(const Db&) = delete;
@@ -41,10 +52,18 @@ class Db
 
 		Session& getTLSSession();
 
+		// nullptr if query tracing is not enabled
+		QueryTracer* getQueryTracer() { return _queryTracer.get(); }
+
 	private:
 		friend class Session;
 
 		std::shared_mutex&		getMutex() { return _sharedMutex; }
+		std::uint64_t			getLibraryGeneration() const { return _libraryGeneration; }
+		void				bumpLibraryGeneration();
+		std::uint64_t			getUserGeneration(IdType userId) const;
+		void				bumpUserGeneration(IdType userId);
+		RandomIdSampler&		getRandomIdSampler() { return *_randomIdSampler; }
 		Wt::Dbo::SqlConnectionPool&	getConnectionPool() { return *_connectionPool; }
 
 		class ScopedConnection
@@ -89,7 +108,13 @@ class Db
 		void executeSql(const std::string& sql);
 
 		std::shared_mutex				_sharedMutex;
+		const std::uint64_t				_initialGeneration;
+		std::atomic<std::uint64_t>			_libraryGeneration;
+		mutable std::mutex				_userGenerationsMutex;
+		std::unordered_map<IdType, std::uint64_t>	_userGenerations; // only for the users that have been bumped
+		std::unique_ptr<QueryTracer>			_queryTracer; // must outlive the connections
 		std::unique_ptr<Wt::Dbo::SqlConnectionPool>	_connectionPool;
+		std::unique_ptr<RandomIdSampler>		_randomIdSampler;
 
 		std::mutex _tlsSessionsMutex;
 		std::vector<std::unique_ptr<Session>> _tlsSessions;
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+#include <set>
+#include <vector>
+
+#include <Wt/Dbo/Dbo.h>
+
+#include "Types.hpp"
+
+namespace Database
+{
+
+class Artist;
+class Release;
+class Session;
+class Track;
+class User;
+
+// Per user track play statistics, updated each time a track is played (see User::addPlayedTrack)
+// They allow to get the most/recently played entities without aggregating the whole listen history
+// lastPlayed is the id of the played track list entry of the last play: it only makes sense to order plays
+// Filters have the same meaning as in the getByFilter functions of the entities
+// Releases and artists are ranked by aggregating the stats of their played tracks, using the current track links:
+// retagging or removing tracks is therefore taken into account
+// For artists, a play counts once for each distinct artist of the track, whatever its link types
+
+class TrackPlayStats : public Wt::Dbo::Dbo<TrackPlayStats>
+{
+	public:
+		using pointer = Wt::Dbo::ptr<TrackPlayStats>;
+
+		TrackPlayStats() = default;
+		TrackPlayStats(Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track);
+
+		static void					addPlay(Session& session, Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track, IdType playedEntryId);
+		static std::vector<Wt::Dbo::ptr<Track>>		getTopTracks(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults);
+		static std::vector<Wt::Dbo::ptr<Track>>		getRecentTracks(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults);
+		static std::vector<Wt::Dbo::ptr<Release>>	getTopReleases(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults);
+		static std::vector<Wt::Dbo::ptr<Release>>	getRecentReleases(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<Range> range, bool& moreResults);
+		static std::vector<Wt::Dbo::ptr<Artist>>	getTopArtists(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<TrackArtistLinkType> linkType, std::optional<Range> range, bool& moreResults);
+		static std::vector<Wt::Dbo::ptr<Artist>>	getRecentArtists(Session& session, IdType userId, const std::set<IdType>& clusterIds, std::optional<TrackArtistLinkType> linkType, std::optional<Range> range, bool& moreResults);
+
+		std::size_t	getPlayCount() const { return _playCount; }
+
+		template<class Action>
+		void persist(Action& a)
+		{
+			Wt::Dbo::field(a, _playCount,	"play_count");
+			Wt::Dbo::field(a, _lastPlayed,	"last_played");
+
+			Wt::Dbo::belongsTo(a, _user, "user", Wt::Dbo::OnDeleteCascade);
+			Wt::Dbo::belongsTo(a, _track, "track", Wt::Dbo::OnDeleteCascade);
+		}
+
+	private:
+		int			_playCount {};
+		IdType			_lastPlayed {};
+
+		Wt::Dbo::ptr<User>	_user;
+		Wt::Dbo::ptr<Track>	_track;
+};
+
+} // namespace Database
+
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace Database {
+
+// Slowest SQL statements, grouped by normalized SQL (bound values are not part of the SQL, lists of '?' are collapsed)
+struct QueryTraceEntry
+{
+	std::string			sql;
+	std::size_t			bindCount {};
+	std::size_t			executionCount {};
+	std::chrono::nanoseconds	totalDuration {};
+	// slowest execution
+	std::chrono::nanoseconds	maxDuration {};
+	std::size_t			maxDurationRowCount {};
+	std::string			maxDurationCaller;
+	std::optional<std::string>	queryPlan; // only for statements slower than the plan threshold (or the reason why it is unavailable)
+};
+
+// Opt-in statement tracing, fed by the SQLite trace hook of each pooled connection
+// Only keeps the maxEntryCount slowest statements
+class QueryTracer
+{
+	public:
+		struct Settings
+		{
+			std::size_t			maxEntryCount {50};
+			std::chrono::milliseconds	queryPlanThreshold {100};
+		};
+
+		QueryTracer(const std::filesystem::path& dbPath, const Settings& settings);
+		~QueryTracer();
+
+		QueryTracer(const QueryTracer&) = delete;
+		QueryTracer(QueryTracer&&) = delete;
+		QueryTracer& operator=(const QueryTracer&) = delete;
+		QueryTracer& operator=(QueryTracer&&) = delete;
+
+		// Sorted by decreasing max duration
+		std::vector<QueryTraceEntry>	getEntries() const;
+		void				writeReport(std::ostream& os) const;
+		void				clear();
+
+		// Called from the SQLite trace hook
+		void onStatementRow(sqlite3_stmt* statement);
+		void onStatementProfiled(sqlite3_stmt* statement, std::chrono::nanoseconds duration);
+
+	private:
+		std::string explainQueryPlan(const std::string& sql);
+
+		// _mutex must be held
+		std::unordered_map<std::string, QueryTraceEntry>::iterator findFastestEntry();
+		bool canInsertEntry(std::chrono::nanoseconds duration);
+
+		const Settings			_settings;
+		const std::filesystem::path	_dbPath;
+
+		std::mutex			_explainMutex;
+		sqlite3*			_explainConnection {};
+
+		mutable std::mutex	_mutex;
+		std::unordered_map<std::string, QueryTraceEntry> _entries;
+};
+
+} // namespace Database
+
@@ -53,6 +53,7 @@ class Release : public Wt::Dbo::Dbo<Release>
 		static pointer			getByMBID(Session& session, const UUID& MBID);
 		static std::vector<pointer>	getByName(Session& session, const std::string& name);
 		static pointer			getById(Session& session, IdType id);
+		static std::vector<pointer>	getByIds(Session& session, const std::vector<IdType>& ids);
 		static std::vector<pointer>	getAllOrphans(Session& session); // no track related
 		static std::vector<pointer>	getAll(Session& session, std::optional<Range> range = std::nullopt);
 		static std::vector<IdType>	getAllIds(Session& session);
@@ -69,7 +70,14 @@ class Release : public Wt::Dbo::Dbo<Release>
 							const std::vector<std::string>& keywords,	// if non empty, name must match all of these keywords
 							std::optional<Range> range,
 							bool& moreExpected);
+		// same, using keyset pagination
+		static std::vector<pointer>	getByFilter(Session& session,
+							const std::set<IdType>& clusters,
+							const std::vector<std::string>& keywords,
+							KeysetRange& range,
+							bool& moreExpected);
 		static std::vector<IdType>	getAllIdsWithClusters(Session& session, std::optional<std::size_t> limit = {});
+		static std::vector<IdType>	getAllIdsWithoutReplayGain(Session& session); // none of the tracks has a replay gain
 
 		std::vector<Wt::Dbo::ptr<Track>> getTracks(const std::set<IdType>& clusters = std::set<IdType>()) const;
 		std::size_t			getTracksCount() const;
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <Wt/WDateTime.h>
+#include <Wt/Dbo/Dbo.h>
+
+#include "Types.hpp"
+
+namespace Database
+{
+
+class Release;
+class Session;
+
+// Denormalized release data, maintained by the scanner
+// Used by list views to avoid running several aggregate queries per release
+class ReleaseSummary : public Wt::Dbo::Dbo<ReleaseSummary>
+{
+	public:
+		using pointer = Wt::Dbo::ptr<ReleaseSummary>;
+
+		static inline const std::string genreClusterTypeName {"GENRE"};
+
+		ReleaseSummary() = default;
+		ReleaseSummary(Wt::Dbo::ptr<Release> release);
+
+		// Accessors
+		static pointer			getByRelease(Session& session, IdType releaseId);
+		// Materialized summary if any, transient summary computed on the fly otherwise
+		static pointer			get(Session& session, Wt::Dbo::ptr<Release> release);
+		static std::vector<pointer>	get(Session& session, const std::vector<Wt::Dbo::ptr<Release>>& releases); // same order as releases
+		static std::vector<IdType>	getAllReleaseIdsToRefresh(Session& session); // releases that have no summary yet, or an outdated one
+
+		// Create or update the summary of the release
+		static void			refresh(Session& session, Wt::Dbo::ptr<Release> release);
+		// Persisted, so that an aborted scan does not leave outdated summaries behind
+		static void			markOutdated(Session& session, IdType releaseId);
+
+		std::size_t			getTracksCount() const		{ return _trackCount; }
+		std::chrono::milliseconds	getDuration() const		{ return _duration; }
+		std::optional<int>		getReleaseYear(bool originalDate = false) const; // unset if unknown or various
+		Wt::WDateTime			getLastWritten() const		{ return _lastWritten; }
+		std::vector<IdType>		getArtistIds() const; // release artists, or artists if there is no release artist
+		std::optional<std::string>	getGenre() const;
+
+		template<class Action>
+		void persist(Action& a)
+		{
+			Wt::Dbo::field(a, _trackCount,		"track_count");
+			Wt::Dbo::field(a, _duration,		"duration");
+			Wt::Dbo::field(a, _year,		"year");
+			Wt::Dbo::field(a, _originalYear,	"original_year");
+			Wt::Dbo::field(a, _lastWritten,		"last_written");
+			Wt::Dbo::field(a, _artistIds,		"artist_ids");
+			Wt::Dbo::field(a, _genre,		"genre");
+			Wt::Dbo::field(a, _outdated,		"outdated");
+
+			Wt::Dbo::belongsTo(a, _release, "release", Wt::Dbo::OnDeleteCascade);
+		}
+
+	private:
+		void compute(Session& session, const Wt::Dbo::ptr<Release>& release);
+
+		int					_trackCount {};
+		std::chrono::duration<int, std::milli>	_duration {};
+		int					_year {};
+		int					_originalYear {};
+		Wt::WDateTime				_lastWritten;
+		std::string				_artistIds;	// space separated
+		std::string				_genre;
+		bool					_outdated {};
+
+		Wt::Dbo::ptr<Release>	_release;
+};
+
+} // namespace Database
+
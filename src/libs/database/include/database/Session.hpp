@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <map>
 #include <memory>
@@ -28,8 +30,34 @@
 #include <Wt/Dbo/Dbo.h>
 #include <Wt/Dbo/SqlConnectionPool.h>
 
+#include "database/Types.hpp"
+
 namespace Database {
 
+// Reports the time spent waiting for the database lock, and the time it is held
+class TransactionLockTimer
+{
+	public:
+		~TransactionLockTimer();
+
+		TransactionLockTimer(const TransactionLockTimer&) = delete;
+		TransactionLockTimer& operator=(const TransactionLockTimer&) = delete;
+
+	private:
+		friend class UniqueTransaction;
+		friend class SharedTransaction;
+
+		enum class Mode
+		{
+			Unique,
+			Shared,
+		};
+		TransactionLockTimer(Mode mode, std::chrono::steady_clock::time_point lockRequestTime);
+
+		const Mode _mode;
+		const std::chrono::steady_clock::time_point _lockAcquiredTime;
+};
+
 class UniqueTransaction
 {
 	public:
@@ -39,7 +67,9 @@ class UniqueTransaction
 		friend class Session;
 		UniqueTransaction(std::shared_mutex& mutex, Wt::Dbo::Session& session);
 
+		const std::chrono::steady_clock::time_point _lockRequestTime;
 		std::unique_lock<std::shared_mutex> _lock;
+		TransactionLockTimer _lockTimer; // destroyed after the commit, before the unlock
 		Wt::Dbo::Transaction _transaction;
 };
 
@@ -52,11 +82,14 @@ class SharedTransaction
 		friend class Session;
 		SharedTransaction(std::shared_mutex& mutex, Wt::Dbo::Session& session);
 
+		const std::chrono::steady_clock::time_point _lockRequestTime;
 		std::shared_lock<std::shared_mutex> _lock;
+		TransactionLockTimer _lockTimer; // destroyed after the commit, before the unlock
 		Wt::Dbo::Transaction _transaction;
 };
 
 class Db;
+class RandomIdSampler;
 class Session
 {
 	public:
@@ -75,6 +108,21 @@ class Session
 
 		void optimize();
 
+		// Library generation: changes each time the shared content of the library changes (only bumped by the scanner)
+		// Values are strictly increasing timestamps (ms since epoch), so that they can also be used as a last modification date.
+		// Not persisted: restarting the server makes the generation change, as if everything had been modified
+		// Readers must get the generation *before* reading the data it refers to
+		std::uint64_t getLibraryGeneration() const;
+		void bumpLibraryGeneration();
+
+		// User generation: same as the library generation, for the data of a given user (stars, playlists, settings...)
+		// Must be bumped in the transaction modifying the data, so that a reader getting it in a transaction gets the matching data
+		std::uint64_t getUserGeneration(IdType userId) const;
+		void bumpUserGeneration(IdType userId);
+
+		// Random ids, drawn from in memory id sets kept for the current library generation
+		RandomIdSampler& getRandomIdSampler();
+
 		void prepareTables(); // need to run only once at startup
 
 		Wt::Dbo::Session& getDboSession() { return _session; }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <optional>
 #include <string>
@@ -44,6 +45,7 @@ class Release;
 class Session;
 class TrackArtistLink;
 class TrackFeatures;
+class TrackFingerprint;
 class TrackListEntry;
 class TrackStats;
 class User;
@@ -61,6 +63,7 @@ class Track : public Wt::Dbo::Dbo<Track>
 		static std::size_t getCount(Session& session);
 		static pointer getByPath(Session& session, const std::filesystem::path& p);
 		static pointer getById(Session& session, IdType id);
+		static std::vector<pointer> getByIds(Session& session, const std::vector<IdType>& ids);
 		static pointer getByMBID(Session& session, const UUID& MBID);
 		static std::vector<pointer>	getSimilarTracks(Session& session,
 							const std::unordered_set<IdType>& trackIds,
@@ -73,6 +76,12 @@ class Track : public Wt::Dbo::Dbo<Track>
 							const std::vector<std::string>& keywords,    // if non empty, name must match all of these keywords
 							std::optional<Range> range,
 							bool& moreExpected);
+		// same, using keyset pagination (sorted by id)
+		static std::vector<pointer>	getByFilter(Session& session,
+							const std::set<IdType>& clusters,
+							const std::vector<std::string>& keywords,
+							KeysetRange& range,
+							bool& moreExpected);
 
 		static std::vector<pointer>	getAll(Session& session, std::optional<std::size_t> limit = std::nullopt);
 		static std::vector<pointer>	getAllRandom(Session& session, const std::set<IdType>& clusters, std::optional<std::size_t> limit = std::nullopt);
@@ -82,6 +91,9 @@ class Track : public Wt::Dbo::Dbo<Track>
 		static std::vector<pointer>	getMBIDDuplicates(Session& session);
 		static std::vector<pointer>	getLastWritten(Session& session, std::optional<Wt::WDateTime> after, const std::set<IdType>& clusters, std::optional<Range> range, bool& moreResults);
 		static std::vector<pointer>	getAllWithMBIDAndMissingFeatures(Session& session);
+		static std::vector<pointer>	getAllWithMissingFeatures(Session& session);
+		static std::vector<pointer>	getAllWithMissingFingerprint(Session& session);
+		static std::vector<pointer>	getAllWithMissingReplayGain(Session& session); // ordered by release
 		static std::vector<IdType>	getAllIdsWithFeatures(Session& session, std::optional<std::size_t> limit = {});
 		static std::vector<IdType>	getAllIdsWithClusters(Session& session, std::optional<std::size_t> limit = {});
 		static std::vector<pointer>	getStarred(Session& session,
@@ -109,8 +121,16 @@ class Track : public Wt::Dbo::Dbo<Track>
 		void setMBID(const std::optional<UUID>& MBID)			{ _MBID = MBID ? MBID->getAsString() : ""; }
 		void setCopyright(const std::string& copyright)			{ _copyright = std::string(copyright, 0, _maxCopyrightLength); }
 		void setCopyrightURL(const std::string& copyrightURL)		{ _copyrightURL = std::string(copyrightURL, 0, _maxCopyrightURLLength); }
-		void setTrackReplayGain(float replayGain)			{ _trackReplayGain = replayGain; }
-		void setReleaseReplayGain(float replayGain)			{ _releaseReplayGain = replayGain; }
+		void setTrackReplayGain(std::optional<float> replayGain)	{ _trackReplayGain = replayGain; }
+		void setReleaseReplayGain(std::optional<float> replayGain)	{ _releaseReplayGain = replayGain; }
+		void setLoudnessMeasured(bool measured)				{ _loudnessMeasured = measured; }
+		void setFileCrc32(std::optional<std::uint32_t> crc32)		{ _fileCrc32 = crc32; }
+		void setFileCrc32Computed(bool computed)			{ _fileCrc32Computed = computed; }
+		void setFileSize(std::uintmax_t fileSize)			{ _fileSize = static_cast<long long>(fileSize); }
+		void setBitrate(std::size_t bitrate)				{ _bitrate = static_cast<int>(bitrate); }
+		void setSampleRate(std::size_t sampleRate)			{ _sampleRate = static_cast<int>(sampleRate); }
+		void setChannelCount(std::size_t channelCount)			{ _channelCount = static_cast<int>(channelCount); }
+		void setCodec(const std::string& codec)				{ _codec = codec; }
 		void clearArtistLinks();
 		void addArtistLink(const Wt::Dbo::ptr<TrackArtistLink>& artistLink);
 		void setRelease(Wt::Dbo::ptr<Release> release)			{ _release = release; }
@@ -136,6 +156,18 @@ class Track : public Wt::Dbo::Dbo<Track>
 		std::optional<std::string>		getCopyrightURL() const;
 		std::optional<float>			getTrackReplayGain() const	{ return _trackReplayGain; }
 		std::optional<float>			getReleaseReplayGain() const	{ return _releaseReplayGain; }
+		// true if the loudness has been measured for the current last write time, even if it gave no replay gain (silent or undecodable track)
+		bool					isLoudnessMeasured() const	{ return _loudnessMeasured; }
+		// valid only for the current last write time
+		std::optional<std::uint32_t>		getFileCrc32() const		{ return _fileCrc32 ? std::make_optional(static_cast<std::uint32_t>(*_fileCrc32)) : std::nullopt; }
+		// true if the CRC32 has been computed for the current last write time, even if it failed
+		bool					isFileCrc32Computed() const	{ return _fileCrc32Computed; }
+		// audio properties, filled at scan time
+		std::optional<std::uintmax_t>		getFileSize() const;
+		std::optional<std::size_t>		getBitrate() const; // bps
+		std::optional<std::size_t>		getSampleRate() const;
+		std::optional<std::size_t>		getChannelCount() const;
+		std::optional<std::string>		getCodec() const;
 
 		// no artistLinkTypes means get all
 		std::vector<Wt::Dbo::ptr<Artist>>	getArtists(EnumSet<TrackArtistLinkType> artistLinkTypes) const;
@@ -146,6 +178,7 @@ class Track : public Wt::Dbo::Dbo<Track>
 		std::vector<IdType>			getClusterIds() const;
 		bool					hasTrackFeatures() const;
 		Wt::Dbo::ptr<TrackFeatures>		getTrackFeatures() const;
+		Wt::Dbo::ptr<TrackFingerprint>		getTrackFingerprint() const;
 
 		std::vector<std::vector<Wt::Dbo::ptr<Cluster>>> getClusterGroups(std::vector<Wt::Dbo::ptr<ClusterType>> clusterTypes, std::size_t size) const;
 
@@ -171,12 +204,21 @@ class Track : public Wt::Dbo::Dbo<Track>
 				Wt::Dbo::field(a, _copyrightURL,	"copyright_url");
 				Wt::Dbo::field(a, _trackReplayGain,	"track_replay_gain");
 				Wt::Dbo::field(a, _releaseReplayGain,	"release_replay_gain");
+				Wt::Dbo::field(a, _loudnessMeasured,	"loudness_measured");
+				Wt::Dbo::field(a, _fileCrc32,		"file_crc32");
+				Wt::Dbo::field(a, _fileCrc32Computed,	"file_crc32_computed");
+				Wt::Dbo::field(a, _fileSize,		"file_size");
+				Wt::Dbo::field(a, _bitrate,		"bitrate");
+				Wt::Dbo::field(a, _sampleRate,		"sample_rate");
+				Wt::Dbo::field(a, _channelCount,	"channel_count");
+				Wt::Dbo::field(a, _codec,		"codec");
 				Wt::Dbo::belongsTo(a, _release, "release", Wt::Dbo::OnDeleteCascade);
 				Wt::Dbo::hasMany(a, _trackArtistLinks, Wt::Dbo::ManyToOne, "track");
 				Wt::Dbo::hasMany(a, _clusters, Wt::Dbo::ManyToMany, "track_cluster", "", Wt::Dbo::OnDeleteCascade);
 				Wt::Dbo::hasMany(a, _playlistEntries, Wt::Dbo::ManyToOne, "track");
 				Wt::Dbo::hasMany(a, _starringUsers, Wt::Dbo::ManyToMany, "user_track_starred", "", Wt::Dbo::OnDeleteCascade);
 				Wt::Dbo::hasOne(a, _trackFeatures);
+				Wt::Dbo::hasOne(a, _trackFingerprint);
 			}
 
 	private:
@@ -206,6 +248,14 @@ class Track : public Wt::Dbo::Dbo<Track>
 		std::string				_copyrightURL;
 		std::optional<float>			_trackReplayGain;
 		std::optional<float>			_releaseReplayGain;
+		bool					_loudnessMeasured {};
+		std::optional<long long>		_fileCrc32;
+		bool					_fileCrc32Computed {};
+		long long				_fileSize {};
+		int					_bitrate {};
+		int					_sampleRate {};
+		int					_channelCount {};
+		std::string				_codec;
 
 		Wt::Dbo::ptr<Release>				_release;
 		Wt::Dbo::collection<Wt::Dbo::ptr<TrackArtistLink>> _trackArtistLinks;
@@ -213,6 +263,7 @@ class Track : public Wt::Dbo::Dbo<Track>
 		Wt::Dbo::collection<Wt::Dbo::ptr<TrackListEntry>> _playlistEntries;
 		Wt::Dbo::collection<Wt::Dbo::ptr<User>>		_starringUsers;
 		Wt::Dbo::weak_ptr<TrackFeatures>		_trackFeatures;
+		Wt::Dbo::weak_ptr<TrackFingerprint>		_trackFingerprint;
 
 };
 
@@ -20,6 +20,8 @@
 #pragma once
 
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <Wt/Dbo/Dbo.h>
 
@@ -44,6 +46,8 @@ namespace Database
 			static pointer create(Session& session, Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<Artist> artist, TrackArtistLinkType type);
 
 			static EnumSet<TrackArtistLinkType> getUsedTypes(Session& session);
+			// (track id, artist id) of the given tracks, in link creation order
+			static std::vector<std::tuple<IdType, IdType>> getTrackArtistIds(Session& session, const std::vector<IdType>& trackIds, TrackArtistLinkType type);
 
 			Wt::Dbo::ptr<Track>		getTrack() const { return _track; }
 			Wt::Dbo::ptr<Artist>	getArtist() const { return _artist; }
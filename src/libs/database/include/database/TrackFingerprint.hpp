@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <tuple>
+#include <vector>
+
+#include <Wt/Dbo/Dbo.h>
+
+#include "Types.hpp"
+
+namespace Database {
+
+class Session;
+class Track;
+
+// Acoustic fingerprint of the audio content of a track, used to detect duplicates
+class TrackFingerprint : public Wt::Dbo::Dbo<TrackFingerprint>
+{
+	public:
+
+		using pointer = Wt::Dbo::ptr<TrackFingerprint>;
+
+		TrackFingerprint() = default;
+		TrackFingerprint(Wt::Dbo::ptr<Track> track, const std::vector<unsigned char>& data);
+
+		// Create utility
+		static pointer create(Session& session, Wt::Dbo::ptr<Track> track, const std::vector<unsigned char>& data);
+
+		// (track id, track duration, data) of all the fingerprints, without loading the tracks
+		static std::vector<std::tuple<IdType, std::chrono::milliseconds, std::vector<unsigned char>>> getAll(Session& session);
+
+		const std::vector<unsigned char>&	getData() const { return _data; }
+
+		template<class Action>
+		void persist(Action& a)
+		{
+			Wt::Dbo::field(a, _data,	"data");
+			Wt::Dbo::belongsTo(a, _track, "track", Wt::Dbo::OnDeleteCascade);
+		}
+
+	private:
+
+		std::vector<unsigned char> _data;
+		Wt::Dbo::ptr<Track> _track;
+};
+
+} // namespace Database
+
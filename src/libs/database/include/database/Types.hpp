@@ -19,6 +19,9 @@
 
 #pragma once
 
+#include <optional>
+#include <string>
+
 #include <Wt/Dbo/ptr.h>
 
 namespace Database
@@ -36,6 +39,21 @@ namespace Database
 		std::size_t limit {};
 	};
 
+	// Keyset (aka cursor) pagination: a page starts right after the last entry of the previous page
+	// Unlike Range, the cost of a page does not depend on how deep it is
+	// Queries using it update 'after' so that the same range can be used to get the next page
+	struct KeysetRange
+	{
+		struct Key
+		{
+			std::string sortKey;	// unused if entries are only sorted by id
+			IdType id {};
+		};
+
+		std::optional<Key> after;	// not set means first page
+		std::size_t limit {};
+	};
+
 	enum class TrackArtistLinkType
 	{
 		Artist,	// regular artist
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <optional>
+#include <set>
 #include <vector>
 
 #include <Wt/Dbo/Dbo.h>
@@ -161,12 +162,14 @@ class User : public Wt::Dbo::Dbo<User>
 		// accessors
 		const std::string& getLoginName() const { return _loginName; }
 		PasswordHash getPasswordHash() const { return PasswordHash {_passwordSalt, _passwordHash}; }
+		const std::string& getSubsonicApiKey() const { return _subsonicApiKey; }
 		Wt::WDateTime getLastLogin() const { return _lastLogin; }
 		std::size_t getAuthTokensCount() const { return _authTokens.size(); }
 
 		// write
 		void setLastLogin(const Wt::WDateTime& dateTime)	{ _lastLogin = dateTime; }
 		void setPasswordHash(const PasswordHash& passwordHash)	{ _passwordSalt = passwordHash.salt; _passwordHash = passwordHash.hash; }
+		void setSubsonicApiKey(const std::string& apiKey)	{ _subsonicApiKey = apiKey; }
 		void setType(Type type)					{ _type = type; }
 		void setSubsonicTranscodeEnable(bool value) 		{ _subsonicTranscodeEnable = value; }
 		void setSubsonicTranscodeFormat(AudioFormat encoding)	{ _subsonicTranscodeFormat = encoding; }
@@ -194,19 +197,27 @@ class User : public Wt::Dbo::Dbo<User>
 
 		Wt::Dbo::ptr<TrackList>	getPlayedTrackList(Session& session) const;
 		Wt::Dbo::ptr<TrackList>	getQueuedTrackList(Session& session) const;
+		// Appends the track to the played track list and updates the play stats
+		void			addPlayedTrack(Session& session, Wt::Dbo::ptr<Track> track) const;
 
 		void			starArtist(Wt::Dbo::ptr<Artist> artist);
 		void			unstarArtist(Wt::Dbo::ptr<Artist> artist);
 		bool			hasStarredArtist(Wt::Dbo::ptr<Artist> artist) const;
+		std::set<IdType>	getStarredArtistIds(const std::vector<IdType>& artistIds) const; // starred ones among artistIds
+		std::vector<IdType>	getAllStarredArtistIds() const; // sorted
 
 		void			starRelease(Wt::Dbo::ptr<Release> release);
 		void			unstarRelease(Wt::Dbo::ptr<Release> release);
 		bool			hasStarredRelease(Wt::Dbo::ptr<Release> release) const;
+		std::set<IdType>	getStarredReleaseIds(const std::vector<IdType>& releaseIds) const; // starred ones among releaseIds
+		std::vector<IdType>	getAllStarredReleaseIds() const; // sorted
 
 		// Stars
 		void			starTrack(Wt::Dbo::ptr<Track> track);
 		void			unstarTrack(Wt::Dbo::ptr<Track> track);
 		bool			hasStarredTrack(Wt::Dbo::ptr<Track> track) const;
+		std::set<IdType>	getStarredTrackIds(const std::vector<IdType>& trackIds) const; // starred ones among trackIds
+		std::vector<IdType>	getAllStarredTrackIds() const; // sorted
 
 		template<class Action>
 		void persist(Action& a)
@@ -215,6 +226,7 @@ class User : public Wt::Dbo::Dbo<User>
 			Wt::Dbo::field(a, _loginName, "login_name");
 			Wt::Dbo::field(a, _passwordSalt, "password_salt");
 			Wt::Dbo::field(a, _passwordHash, "password_hash");
+			Wt::Dbo::field(a, _subsonicApiKey, "subsonic_api_key");
 			Wt::Dbo::field(a, _lastLogin, "last_login");
 			Wt::Dbo::field(a, _subsonicTranscodeEnable, "subsonic_transcode_enable");
 			Wt::Dbo::field(a, _subsonicTranscodeFormat, "subsonic_transcode_format");
@@ -238,6 +250,7 @@ class User : public Wt::Dbo::Dbo<User>
 		std::string	_loginName;
 		std::string	_passwordSalt;
 		std::string	_passwordHash;
+		std::string	_subsonicApiKey; // used for token based auth, must be stored as is
 		Wt::WDateTime	_lastLogin;
 		UITheme		_uiTheme {defaultUITheme};
 
@@ -76,6 +76,40 @@ getPropertyValuesAs(const TagLib::PropertyMap& properties, const std::string& ke
 	return getPropertyValuesFirstMatchAs<T>(properties, {std::move(key)});
 }
 
+static
+std::string
+getCodecName(const TagLib::File* file, const TagLib::AudioProperties* properties)
+{
+	if (dynamic_cast<const TagLib::MPEG::File*>(file))
+		return "mp3";
+	if (dynamic_cast<const TagLib::FLAC::File*>(file))
+		return "flac";
+	if (dynamic_cast<const TagLib::Ogg::Vorbis::File*>(file))
+		return "vorbis";
+	if (dynamic_cast<const TagLib::Ogg::Opus::File*>(file))
+		return "opus";
+	if (dynamic_cast<const TagLib::MPC::File*>(file))
+		return "mpc";
+	if (dynamic_cast<const TagLib::WavPack::File*>(file))
+		return "wavpack";
+	if (dynamic_cast<const TagLib::ASF::File*>(file))
+		return "wma";
+	if (dynamic_cast<const TagLib::MP4::File*>(file))
+	{
+		if (const auto* mp4Properties {dynamic_cast<const TagLib::MP4::Properties*>(properties)})
+		{
+			switch (mp4Properties->codec())
+			{
+				case TagLib::MP4::Properties::AAC: return "aac";
+				case TagLib::MP4::Properties::ALAC: return "alac";
+				default: break;
+			}
+		}
+	}
+
+	return "";
+}
+
 static
 std::vector<std::string>
 splitAndTrimString(const std::string& str, const std::string& delimiters)
@@ -284,6 +318,9 @@ TagLibParser::parse(const std::filesystem::path& p, bool debug)
 		track.duration = std::chrono::milliseconds {properties->length() * 1000};
 
 		MetaData::AudioStream audioStream {static_cast<unsigned>(properties->bitrate() * 1000)};
+		audioStream.sampleRate = static_cast<unsigned>(properties->sampleRate());
+		audioStream.channelCount = static_cast<unsigned>(properties->channels());
+		audioStream.codec = getCodecName(f.file(), properties);
 		track.audioStreams = {std::move(audioStream)};
 	}
 
@@ -52,6 +52,9 @@ namespace MetaData
 	struct AudioStream
 	{
 		unsigned bitRate;
+		unsigned sampleRate {};
+		unsigned channelCount {};
+		std::string codec;	// lowercase name ("mp3", "flac", ...), empty if unknown
 	};
 
 	struct Track
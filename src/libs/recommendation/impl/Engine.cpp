@@ -30,9 +30,16 @@
 #include "database/ScanSettings.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
 
 namespace Recommendation {
 
+static
+Metrics::Histogram&
+getQueryTimeHistogram(const std::string& query)
+{
+	return Metrics::getRegistry().getHistogram("lms_recommendation_query_seconds", "Time spent computing recommendations", Metrics::getDurationBuckets(), {{"query", query}});
+}
 
 static
 std::unique_ptr<IClassifier>
@@ -66,6 +73,9 @@ Engine::Engine(Database::Db& db)
 std::unordered_set<Database::IdType>
 Engine::getSimilarTracksFromTrackList(Database::Session& session, Database::IdType trackListId, std::size_t maxCount)
 {
+	static Metrics::Histogram& queryTime {getQueryTimeHistogram("similar_tracks_from_tracklist")};
+	Metrics::ScopedTimer timer {queryTime};
+
 	std::unordered_set<Database::IdType> res;
 
 	std::shared_lock lock {_classifiersMutex};
@@ -86,6 +96,9 @@ Engine::getSimilarTracksFromTrackList(Database::Session& session, Database::IdTy
 std::unordered_set<Database::IdType>
 Engine::getSimilarTracks(Database::Session& dbSession, const std::unordered_set<Database::IdType>& trackIds, std::size_t maxCount)
 {
+	static Metrics::Histogram& queryTime {getQueryTimeHistogram("similar_tracks")};
+	Metrics::ScopedTimer timer {queryTime};
+
 	std::unordered_set<Database::IdType> res;
 
 	std::shared_lock lock {_classifiersMutex};
@@ -110,6 +123,9 @@ Engine::getSimilarTracks(Database::Session& dbSession, const std::unordered_set<
 std::unordered_set<Database::IdType>
 Engine::getSimilarReleases(Database::Session& dbSession, Database::IdType releaseId, std::size_t maxCount)
 {
+	static Metrics::Histogram& queryTime {getQueryTimeHistogram("similar_releases")};
+	Metrics::ScopedTimer timer {queryTime};
+
 	std::unordered_set<Database::IdType> res;
 
 	std::shared_lock lock {_classifiersMutex};
@@ -137,6 +153,9 @@ Engine::getSimilarArtists(Database::Session& dbSession,
 		EnumSet<Database::TrackArtistLinkType> linkTypes,
 		std::size_t maxCount)
 {
+	static Metrics::Histogram& queryTime {getQueryTimeHistogram("similar_artists")};
+	Metrics::ScopedTimer timer {queryTime};
+
 	std::unordered_set<Database::IdType> res;
 
 	std::shared_lock lock {_classifiersMutex};
@@ -19,6 +19,8 @@
 
 #include "FeaturesClassifier.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 
 #include "database/Artist.hpp"
@@ -87,13 +89,46 @@ getTrackFeatureValuesFromDb(Database::Session& session, Database::IdType trackId
 }
 
 static
+SOM::InputVector
+getInputVectorWeights(const FeatureSettingsMap& featureSettingsMap, std::size_t nbDimensions)
+{
+	SOM::InputVector weights {nbDimensions};
+	std::size_t index {};
+	for (const auto& [featureName, featureSettings] : featureSettingsMap)
+	{
+		const std::size_t featureNbDimensions {getFeatureDef(featureName).nbDimensions};
+
+		for (std::size_t i {}; i < featureNbDimensions; ++i)
+			weights[index++] = (1. / featureNbDimensions * featureSettings.weight);
+	}
+
+	assert(index == nbDimensions);
+
+	return weights;
+}
+
+std::size_t
+FeaturesClassifier::getInputDimCount(const FeatureSettingsMap& featureSettingsMap)
+{
+	return std::accumulate(std::cbegin(featureSettingsMap), std::cend(featureSettingsMap), std::size_t {0},
+			[](std::size_t sum, const auto& itFeatureSetting) { return sum + getFeatureDef(itFeatureSetting.first).nbDimensions; });
+}
+
 std::optional<SOM::InputVector>
-convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, std::size_t nbDimensions)
+FeaturesClassifier::convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, const FeatureSettingsMap& featureSettingsMap)
 {
 	std::size_t i {};
-	std::optional<SOM::InputVector> res {SOM::InputVector {nbDimensions}};
-	for (const auto& [featureName, values] : featureValuesMap)
+	std::optional<SOM::InputVector> res {SOM::InputVector {getInputDimCount(featureSettingsMap)}};
+	for (const auto& [featureName, featureSettings] : featureSettingsMap)
 	{
+		const auto itValues {featureValuesMap.find(featureName)};
+		if (itValues == std::cend(featureValuesMap))
+		{
+			res.reset();
+			break;
+		}
+
+		const FeatureValues& values {itValues->second};
 		if (values.size() != getFeatureDef(featureName).nbDimensions)
 		{
 			LMS_LOG(RECOMMENDATION, WARNING) << "Dimension mismatch for feature '" << featureName << "'. Expected " << getFeatureDef(featureName).nbDimensions << ", got " << values.size();
@@ -108,23 +143,34 @@ convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, s
 	return res;
 }
 
-static
-SOM::InputVector
-getInputVectorWeights(const FeatureSettingsMap& featureSettingsMap, std::size_t nbDimensions)
+SOM::Network
+FeaturesClassifier::trainNetwork(std::vector<SOM::InputVector>& samples,
+		const TrainSettings& trainSettings,
+		const SOM::Network::ProgressCallback& progressCallback,
+		const SOM::Network::RequestStopCallback& requestStopCallback)
 {
-	SOM::InputVector weights {nbDimensions};
-	std::size_t index {};
-	for (const auto& [featureName, featureSettings] : featureSettingsMap)
-	{
-		const std::size_t featureNbDimensions {getFeatureDef(featureName).nbDimensions};
+	const std::size_t nbDimensions {getInputDimCount(trainSettings.featureSettingsMap)};
 
-		for (std::size_t i {}; i < featureNbDimensions; ++i)
-			weights[index++] = (1. / featureNbDimensions * featureSettings.weight);
-	}
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Normalizing data...";
+	SOM::DataNormalizer dataNormalizer {nbDimensions};
 
-	assert(index == nbDimensions);
+	dataNormalizer.computeNormalizationFactors(samples);
+	for (auto& sample : samples)
+		dataNormalizer.normalizeData(sample);
 
-	return weights;
+	const SOM::Coordinate size {std::max(SOM::Coordinate {1}, static_cast<SOM::Coordinate>(std::sqrt(samples.size() / trainSettings.sampleCountPerNeuron)))};
+	LMS_LOG(RECOMMENDATION, INFO) << "Found " << samples.size() << " tracks, constructing a " << size << "*" << size << " network";
+
+	SOM::Network network {size, size, nbDimensions};
+
+	SOM::InputVector weights {getInputVectorWeights(trainSettings.featureSettingsMap, nbDimensions)};
+	network.setDataWeights(weights);
+
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network...";
+	network.train(samples, trainSettings.iterationCount, progressCallback, requestStopCallback);
+	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network DONE";
+
+	return network;
 }
 
 bool
@@ -136,8 +182,7 @@ FeaturesClassifier::loadFromTraining(Database::Session& session, const TrainSett
 	std::transform(std::cbegin(trainSettings.featureSettingsMap), std::cend(trainSettings.featureSettingsMap), std::inserter(featureNames, std::begin(featureNames)),
 		[](const auto& itFeatureSetting) { return itFeatureSetting.first; });
 
-	const std::size_t nbDimensions {std::accumulate(std::cbegin(featureNames), std::cend(featureNames), std::size_t {0},
-			[](std::size_t sum, const FeatureName& featureName) { return sum + getFeatureDef(featureName).nbDimensions; })};
+	const std::size_t nbDimensions {getInputDimCount(trainSettings.featureSettingsMap)};
 
 	LMS_LOG(RECOMMENDATION, DEBUG) << "Features dimension = " << nbDimensions;
 
@@ -172,7 +217,7 @@ FeaturesClassifier::loadFromTraining(Database::Session& session, const TrainSett
 		if (!featureValuesMap)
 			continue;
 
-		std::optional<SOM::InputVector> inputVector {convertFeatureValuesMapToInputVector(*featureValuesMap, nbDimensions)};
+		std::optional<SOM::InputVector> inputVector {convertFeatureValuesMapToInputVector(*featureValuesMap, trainSettings.featureSettingsMap)};
 		if (!inputVector)
 			continue;
 
@@ -187,32 +232,15 @@ FeaturesClassifier::loadFromTraining(Database::Session& session, const TrainSett
 		return false;
 	}
 
-	LMS_LOG(RECOMMENDATION, DEBUG) << "Normalizing data...";
-	SOM::DataNormalizer dataNormalizer {nbDimensions};
-
-	dataNormalizer.computeNormalizationFactors(samples);
-	for (auto& sample : samples)
-		dataNormalizer.normalizeData(sample);
-
-	const SOM::Coordinate size {static_cast<SOM::Coordinate>(std::sqrt(samples.size() / trainSettings.sampleCountPerNeuron))};
-	LMS_LOG(RECOMMENDATION, INFO) << "Found " << samples.size() << " tracks, constructing a " << size << "*" << size << " network";
-
-	SOM::Network network {size, size, nbDimensions};
-
-	SOM::InputVector weights {getInputVectorWeights(trainSettings.featureSettingsMap, nbDimensions)};
-	network.setDataWeights(weights);
-
 	auto somProgressCallback{[&](const SOM::Network::CurrentIteration& iter)
 	{
 		LMS_LOG(RECOMMENDATION, DEBUG) << "Current pass = " << iter.idIteration << " / " << iter.iterationCount;
 		progressCallback(Progress {iter.idIteration, iter.iterationCount});
 	}};
 
-	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network...";
-	network.train(samples, trainSettings.iterationCount,
+	SOM::Network network {trainNetwork(samples, trainSettings,
 			progressCallback ? somProgressCallback : SOM::Network::ProgressCallback {},
-			[this] { return _loadCancelled; });
-	LMS_LOG(RECOMMENDATION, DEBUG) << "Training network DONE";
+			[this] { return _loadCancelled; })};
 
 	if (_loadCancelled)
 		return false;
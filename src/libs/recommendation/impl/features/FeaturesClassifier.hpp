@@ -55,6 +55,24 @@ class FeaturesClassifier : public IClassifier
 
 		static const FeatureSettingsMap& getDefaultTrainFeatureSettings();
 
+		struct TrainSettings
+		{
+			std::size_t iterationCount {10};
+			float sampleCountPerNeuron {4};
+			FeatureSettingsMap featureSettingsMap;
+		};
+
+		// Sample dimensions are the concatenation of the feature values, in the iteration order of the feature settings map
+		static std::size_t getInputDimCount(const FeatureSettingsMap& featureSettingsMap);
+		static std::optional<SOM::InputVector> convertFeatureValuesMapToInputVector(const FeatureValuesMap& featureValuesMap, const FeatureSettingsMap& featureSettingsMap);
+
+		// Normalizes the samples in place, and trains a network sized using the train settings
+		// Uses the calling thread random generator: seed it to get reproducible results
+		static SOM::Network trainNetwork(std::vector<SOM::InputVector>& samples,
+				const TrainSettings& trainSettings,
+				const SOM::Network::ProgressCallback& progressCallback = {},
+				const SOM::Network::RequestStopCallback& requestStopCallback = {});
+
 	private:
 
 		std::string_view getName() const override { return "Features"; }
@@ -73,12 +91,6 @@ class FeaturesClassifier : public IClassifier
 		bool loadFromCache(Database::Session& session, const FeaturesClassifierCache& cache);
 
 		// Use training (may be very slow)
-		struct TrainSettings
-		{
-			std::size_t iterationCount {10};
-			float sampleCountPerNeuron {4};
-			FeatureSettingsMap featureSettingsMap;
-		};
 		bool loadFromTraining(Database::Session& session, const TrainSettings& trainSettings, const ProgressCallback& progressCallback);
 
 		using ObjectPositions = std::unordered_map<Database::IdType, std::unordered_set<SOM::Position>>;
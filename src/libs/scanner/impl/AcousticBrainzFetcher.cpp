@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AcousticBrainzFetcher.hpp"
+
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string_view>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <Wt/Http/Client.h>
+
+#include "utils/Logger.hpp"
+#include "utils/String.hpp"
+
+namespace AcousticBrainz
+{
+
+namespace
+{
+	struct PendingRequest
+	{
+		std::vector<UUID> mbids;
+		std::size_t retryCount {};
+	};
+
+	// body is not set if the request definitely failed
+	using ResponseCallback = std::function<void(const std::vector<UUID>& mbids, std::optional<std::string_view> body)>;
+
+	// Runs the requests using at most maxConcurrentRequests HTTP clients, on the calling thread
+	class RequestScheduler
+	{
+		public:
+			RequestScheduler(const Fetcher::Parameters& parameters, std::deque<PendingRequest> requests, ResponseCallback callback, const std::atomic<bool>& abort)
+			: _parameters {parameters}
+			, _requests {std::move(requests)}
+			, _callback {std::move(callback)}
+			, _abort {abort}
+			{}
+
+			void run()
+			{
+				const std::size_t slotCount {std::max<std::size_t>(1, std::min(_parameters.maxConcurrentRequests, _requests.size()))};
+				for (std::size_t i {}; i < slotCount; ++i)
+				{
+					Slot& slot {*_slots.emplace_back(std::make_unique<Slot>(_ioService, _parameters))};
+					slot.client.done().connect([this, &slot](Wt::AsioWrapper::error_code ec, const Wt::Http::Message& msg)
+					{
+						onRequestDone(slot, ec, msg);
+					});
+
+					sendNextRequest(slot);
+				}
+
+				_ioService.run();
+			}
+
+		private:
+			struct Slot
+			{
+				Slot(boost::asio::io_service& ioService, const Fetcher::Parameters& parameters)
+				: client {ioService}
+				, retryTimer {ioService}
+				{
+					client.setFollowRedirect(true);
+					client.setSslCertificateVerificationEnabled(true);
+					client.setMaximumResponseSize(parameters.maxRecordingsPerRequest * 256 * 1024);
+					client.setTimeout(parameters.requestTimeout);
+				}
+
+				Wt::Http::Client client;
+				boost::asio::steady_timer retryTimer;
+				PendingRequest request;
+				std::string url;
+			};
+
+			void sendNextRequest(Slot& slot)
+			{
+				if (_abort || _requests.empty())
+					return;
+
+				slot.request = std::move(_requests.front());
+				_requests.pop_front();
+
+				std::vector<std::string> mbids;
+				mbids.reserve(slot.request.mbids.size());
+				for (const UUID& mbid : slot.request.mbids)
+					mbids.emplace_back(mbid.getAsString());
+
+				slot.url = _parameters.apiUrl + "low-level?recording_ids=" + StringUtils::joinStrings(mbids, ";");
+
+				sendRequest(slot);
+			}
+
+			void sendRequest(Slot& slot)
+			{
+				LMS_LOG(DBUPDATER, DEBUG) << "GET " << slot.url;
+
+				if (!slot.client.get(slot.url))
+				{
+					LMS_LOG(DBUPDATER, ERROR) << "Cannot perform a GET request to url '" << slot.url << "'";
+					_callback(slot.request.mbids, std::nullopt);
+					postNextRequest(slot);
+				}
+			}
+
+			void postNextRequest(Slot& slot)
+			{
+				// do not reuse the client from its own completion handler
+				_ioService.post([this, &slot] { sendNextRequest(slot); });
+			}
+
+			void onRequestDone(Slot& slot, Wt::AsioWrapper::error_code ec, const Wt::Http::Message& msg)
+			{
+				if (!ec && msg.status() == 200)
+				{
+					_callback(slot.request.mbids, std::string_view {msg.body()});
+					postNextRequest(slot);
+					return;
+				}
+
+				if (ec)
+					LMS_LOG(DBUPDATER, ERROR) << "GET request to url '" << slot.url << "' failed: " << ec.message();
+				else
+					LMS_LOG(DBUPDATER, ERROR) << "GET request to url '" << slot.url << "' failed: status = " << msg.status();
+
+				// Only network errors, throttling and server errors are worth retrying
+				const bool isRetryable {ec || msg.status() == 429 || msg.status() >= 500};
+				if (isRetryable && !_abort && slot.request.retryCount < _parameters.maxRetryCount)
+				{
+					const auto delay {_parameters.retryBaseDelay * (1 << slot.request.retryCount)};
+					slot.request.retryCount++;
+
+					LMS_LOG(DBUPDATER, INFO) << "Retrying in " << std::chrono::duration_cast<std::chrono::milliseconds>(delay).count() << " ms (attempt " << slot.request.retryCount << "/" << _parameters.maxRetryCount << ")";
+
+					slot.retryTimer.expires_after(delay);
+					slot.retryTimer.async_wait([this, &slot](const boost::system::error_code& timerEc)
+					{
+						if (timerEc)
+							return;
+
+						sendRequest(slot);
+					});
+					return;
+				}
+
+				_callback(slot.request.mbids, std::nullopt);
+				postNextRequest(slot);
+			}
+
+			const Fetcher::Parameters& _parameters;
+			std::deque<PendingRequest> _requests;
+			ResponseCallback _callback;
+			const std::atomic<bool>& _abort;
+
+			boost::asio::io_service _ioService;
+			std::vector<std::unique_ptr<Slot>> _slots;
+	};
+}
+
+Fetcher::Fetcher(const Parameters& parameters)
+: _parameters {parameters}
+{
+	if (_parameters.cacheDirectory)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(*_parameters.cacheDirectory, ec);
+		if (ec)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot create AcousticBrainz cache directory '" << _parameters.cacheDirectory->string() << "': " << ec.message() << ", disabling cache";
+			_parameters.cacheDirectory.reset();
+		}
+	}
+}
+
+void
+Fetcher::fetch(const std::vector<UUID>& mbids, FeaturesCallback callback, const std::atomic<bool>& abort)
+{
+	std::deque<PendingRequest> requests;
+	std::size_t fetchCount {};
+	for (const UUID& mbid : mbids)
+	{
+		if (std::optional<std::string> cachedFeatures {getCachedFeatures(mbid)})
+		{
+			callback(mbid, *cachedFeatures);
+			continue;
+		}
+
+		if (requests.empty() || requests.back().mbids.size() >= _parameters.maxRecordingsPerRequest)
+			requests.emplace_back();
+
+		requests.back().mbids.push_back(mbid);
+		fetchCount++;
+	}
+
+	LMS_LOG(DBUPDATER, INFO) << "Fetching features of " << fetchCount << " recording(s) using " << requests.size() << " request(s), " << (mbids.size() - fetchCount) << " recording(s) found in cache";
+
+	if (requests.empty())
+		return;
+
+	RequestScheduler scheduler {_parameters, std::move(requests), [&](const std::vector<UUID>& requestMbids, std::optional<std::string_view> body)
+	{
+		boost::property_tree::ptree root;
+		if (body)
+		{
+			try
+			{
+				std::istringstream iss {std::string {*body}};
+				boost::property_tree::read_json(iss, root);
+			}
+			catch (const boost::property_tree::ptree_error& error)
+			{
+				LMS_LOG(DBUPDATER, ERROR) << "Cannot parse AcousticBrainz response: " << error.what();
+				body.reset();
+			}
+		}
+
+		for (const UUID& mbid : requestMbids)
+		{
+			std::string features;
+
+			if (body)
+			{
+				// Response is indexed by recording MBID, then by submission: only keep the first one
+				// Missing recordings are cached as well, as the data set is not updated anymore
+				const auto recording {root.get_child_optional(std::string {mbid.getAsString()})};
+				if (const auto submission {recording ? recording->get_child_optional("0") : boost::none})
+				{
+					std::ostringstream oss;
+					boost::property_tree::write_json(oss, *submission, false);
+					features = oss.str();
+				}
+
+				cacheFeatures(mbid, features);
+			}
+
+			callback(mbid, features);
+		}
+	}, abort};
+
+	scheduler.run();
+}
+
+std::optional<std::string>
+Fetcher::getCachedFeatures(const UUID& mbid) const
+{
+	if (!_parameters.cacheDirectory)
+		return std::nullopt;
+
+	std::ifstream ifs {getCacheFilePath(mbid), std::ios::binary};
+	if (!ifs)
+		return std::nullopt;
+
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+
+	return oss.str();
+}
+
+void
+Fetcher::cacheFeatures(const UUID& mbid, const std::string& jsonEncodedFeatures) const
+{
+	if (!_parameters.cacheDirectory)
+		return;
+
+	// write then rename, so that an interrupted write never leaves a truncated entry
+	const std::filesystem::path path {getCacheFilePath(mbid)};
+	std::filesystem::path tmpPath {path};
+	tmpPath += ".tmp";
+
+	{
+		std::ofstream ofs {tmpPath, std::ios::binary | std::ios::trunc};
+		if (!ofs)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot write AcousticBrainz cache file '" << tmpPath.string() << "'";
+			return;
+		}
+
+		ofs << jsonEncodedFeatures;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, path, ec);
+	if (ec)
+		LMS_LOG(DBUPDATER, ERROR) << "Cannot rename AcousticBrainz cache file '" << tmpPath.string() << "': " << ec.message();
+}
+
+std::filesystem::path
+Fetcher::getCacheFilePath(const UUID& mbid) const
+{
+	return *_parameters.cacheDirectory / (std::string {mbid.getAsString()} + ".json");
+}
+
+} // namespace AcousticBrainz
+
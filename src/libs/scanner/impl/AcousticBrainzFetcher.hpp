@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "utils/UUID.hpp"
+
+namespace AcousticBrainz
+{
+	// Fetches the low level features of recordings, using the bulk API
+	// Requests are run concurrently on a single IO service, failed requests are retried with an exponential backoff
+	// Raw features are cached on disk: a recording is only fetched once, even if the database is rebuilt
+	class Fetcher
+	{
+		public:
+			struct Parameters
+			{
+				std::string apiUrl;	// ends with '/'
+				std::optional<std::filesystem::path> cacheDirectory;
+				std::size_t maxConcurrentRequests {4};
+				std::size_t maxRecordingsPerRequest {25};	// limit set by the API
+				std::size_t maxRetryCount {3};
+				std::chrono::milliseconds retryBaseDelay {std::chrono::seconds {1}};
+				std::chrono::seconds requestTimeout {30};
+			};
+
+			Fetcher(const Parameters& parameters);
+
+			Fetcher(const Fetcher&) = delete;
+			Fetcher(Fetcher&&) = delete;
+			Fetcher& operator=(const Fetcher&) = delete;
+			Fetcher& operator=(Fetcher&&) = delete;
+
+			// Called from the fetching thread once per requested recording
+			// jsonEncodedFeatures is empty if no features are available for the recording
+			using FeaturesCallback = std::function<void(const UUID& mbid, const std::string& jsonEncodedFeatures)>;
+
+			// Blocks until all the recordings are processed, or abort is set
+			void fetch(const std::vector<UUID>& mbids, FeaturesCallback callback, const std::atomic<bool>& abort);
+
+		private:
+			std::optional<std::string>	getCachedFeatures(const UUID& mbid) const;
+			void				cacheFeatures(const UUID& mbid, const std::string& jsonEncodedFeatures) const;
+			std::filesystem::path		getCacheFilePath(const UUID& mbid) const;
+
+			Parameters _parameters;	// cache disabled if its directory cannot be created
+	};
+} // namespace AcousticBrainz
+
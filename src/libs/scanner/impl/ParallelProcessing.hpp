@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace Scanner
+{
+	// Processes the inputs on a pool of worker threads
+	// Results are handed to resultFunc on the calling thread, in completion order, so that they can be stored using the calling thread's database session
+	// A result is not set if the processing failed
+	// Stops dispatching inputs as soon as abort is set
+	template <typename Input, typename Result>
+	void
+	processInParallel(std::size_t threadCount,
+			const std::vector<Input>& inputs,
+			std::function<std::optional<Result>(const Input&)> processFunc,
+			std::function<void(const Input&, std::optional<Result>&&)> resultFunc,
+			const std::atomic<bool>& abort)
+	{
+		std::atomic<std::size_t> nextInputIndex {};
+		std::atomic<bool> stop {};
+
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<std::pair<std::size_t, std::optional<Result>>> completedInputs;
+		std::size_t runningWorkerCount {std::max<std::size_t>(1, std::min(threadCount, inputs.size()))};
+
+		auto worker {[&]
+		{
+			while (!abort && !stop)
+			{
+				const std::size_t inputIndex {nextInputIndex++};
+				if (inputIndex >= inputs.size())
+					break;
+
+				std::optional<Result> result;
+				try
+				{
+					result = processFunc(inputs[inputIndex]);
+				}
+				catch (const std::exception&)
+				{
+					// processFunc is expected to report its own errors
+				}
+
+				{
+					std::scoped_lock lock {mutex};
+					completedInputs.emplace_back(inputIndex, std::move(result));
+				}
+				cv.notify_one();
+			}
+
+			{
+				std::scoped_lock lock {mutex};
+				runningWorkerCount--;
+			}
+			cv.notify_one();
+		}};
+
+		std::vector<std::thread> threads;
+		const std::size_t workerCount {runningWorkerCount};
+		for (std::size_t i {}; i < workerCount; ++i)
+			threads.emplace_back(worker);
+
+		auto joinThreads {[&]
+		{
+			for (std::thread& thread : threads)
+				thread.join();
+		}};
+
+		try
+		{
+			while (true)
+			{
+				std::deque<std::pair<std::size_t, std::optional<Result>>> results;
+				bool done {};
+				{
+					std::unique_lock lock {mutex};
+					cv.wait(lock, [&] { return !completedInputs.empty() || runningWorkerCount == 0; });
+
+					results.swap(completedInputs);
+					done = (runningWorkerCount == 0);
+				}
+
+				for (auto& [inputIndex, result] : results)
+					resultFunc(inputs[inputIndex], std::move(result));
+
+				if (done)
+					break;
+			}
+		}
+		catch (...)
+		{
+			stop = true;
+			joinThreads();
+			throw;
+		}
+
+		joinThreads();
+	}
+} // namespace Scanner
+
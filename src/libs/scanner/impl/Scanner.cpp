@@ -19,25 +19,41 @@
 
 #include "Scanner.hpp"
 
+#include <array>
 #include <ctime>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/asio/placeholders.hpp>
 
 #include <Wt/WLocalDateTime.h>
 
 #include "database/Artist.hpp"
+#include "database/ArtistSummary.hpp"
 #include "database/Cluster.hpp"
 #include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
 #include "database/ScanSettings.hpp"
 #include "database/Track.hpp"
 #include "database/TrackArtistLink.hpp"
 #include "database/TrackFeatures.hpp"
+#include "database/TrackFingerprint.hpp"
 #include "metadata/TagLibParser.hpp"
 #include "recommendation/IEngine.hpp"
 #include "utils/Exception.hpp"
+#include "utils/IConfig.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
 #include "utils/Path.hpp"
+#include "utils/Service.hpp"
 #include "utils/UUID.hpp"
-#include "AcousticBrainzUtils.hpp"
+#include "analysis/FeatureExtractor.hpp"
+#include "analysis/Fingerprint.hpp"
+#include "analysis/LoudnessMeter.hpp"
+#include "av/AudioDecoder.hpp"
+#include "AcousticBrainzFetcher.hpp"
+#include "ParallelProcessing.hpp"
 
 using namespace Database;
 
@@ -65,6 +81,38 @@ getNextFirstOfMonth(Wt::WDate current)
 	return current;
 }
 
+const char*
+getScanStepMetricName(Scanner::ScanProgressStep step)
+{
+	switch (step)
+	{
+		case Scanner::ScanProgressStep::ChekingForMissingFiles:		return "checking_for_missing_files";
+		case Scanner::ScanProgressStep::DiscoveringFiles:		return "discovering_files";
+		case Scanner::ScanProgressStep::ScanningFiles:			return "scanning_files";
+		case Scanner::ScanProgressStep::ComputingTrackFingerprints:	return "computing_track_fingerprints";
+		case Scanner::ScanProgressStep::ComputingTrackLoudness:		return "computing_track_loudness";
+		case Scanner::ScanProgressStep::FetchingTrackFeatures:		return "fetching_track_features";
+		case Scanner::ScanProgressStep::ExtractingTrackFeatures:	return "extracting_track_features";
+		case Scanner::ScanProgressStep::ReloadingSimilarityEngine:	return "reloading_similarity_engine";
+	}
+	return "";
+}
+
+Metrics::Counter&
+getProcessedElemsCounter(Scanner::ScanProgressStep step)
+{
+	static const std::array<Metrics::Counter*, Scanner::ScanProgressStepCount> counters {[]
+	{
+		std::array<Metrics::Counter*, Scanner::ScanProgressStepCount> res;
+		for (unsigned i {}; i < Scanner::ScanProgressStepCount; ++i)
+			res[i] = &Metrics::getRegistry().getCounter("lms_scanner_processed_elements_total", "Number of elements processed by each scan step", {{"step", getScanStepMetricName(static_cast<Scanner::ScanProgressStep>(i))}});
+
+		return res;
+	}()};
+
+	return *counters[static_cast<unsigned>(step)];
+}
+
 bool
 isFileSupported(const std::filesystem::path& file, const std::unordered_set<std::filesystem::path>& extensions)
 {
@@ -238,6 +286,13 @@ getOrCreateClusters(Session& session, const MetaData::Clusters& clustersNames)
 	return clusters;
 }
 
+std::size_t
+getAnalysisThreadCount()
+{
+	const std::size_t threadCount {Service<IConfig>::get()->getULong("scanner-analysis-thread-count", 0)};
+	return threadCount ? threadCount : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
 } // namespace
 
 namespace Scanner {
@@ -251,6 +306,7 @@ createScanner(Database::Db& db, Recommendation::IEngine& recommendationEngine)
 Scanner::Scanner(Database::Db& db, Recommendation::IEngine& recommendationEngine)
 : _recommendationEngine {recommendationEngine}
 , _dbSession {db}
+, _computeFileCrc32 {Service<IConfig>::get()->getBool("scanner-compute-file-crc32", false)}
 {
 	// For now, always use TagLib
 	_metadataParser = std::make_unique<MetaData::TagLibParser>();
@@ -498,15 +554,22 @@ Scanner::scan(bool forceScan)
 	LMS_LOG(DBUPDATER, INFO) << "scaning media directory '" << _mediaDirectory.string() << "' DONE";
 
 	removeOrphanEntries();
+	refreshSummaries();
+
+	if (stats.nbChanges() > 0)
+		_dbSession.bumpLibraryGeneration();
 
 	if (!_abortScan)
 	{
+		computeTrackFingerprints(stats);
+		computeTrackLoudness(stats);
 		checkDuplicatedAudioFiles(stats);
 		fetchTrackFeatures(stats);
+		extractTrackFeatures(stats);
 		reloadSimilarityEngine(stats);
 	}
 
-	LMS_LOG(DBUPDATER, INFO) << "Scan " << (_abortScan ? "aborted" : "complete") << ". Changes = " << stats.nbChanges() << " (added = " << stats.additions << ", removed = " << stats.deletions << ", updated = " << stats.updates << "), Not changed = " << stats.skips << ", Scanned = " << stats.scans << " (errors = " << stats.errors.size() << "), features fetched = " << stats.featuresFetched << ",  duplicates = " << stats.duplicates.size();
+	LMS_LOG(DBUPDATER, INFO) << "Scan " << (_abortScan ? "aborted" : "complete") << ". Changes = " << stats.nbChanges() << " (added = " << stats.additions << ", removed = " << stats.deletions << ", updated = " << stats.updates << "), Not changed = " << stats.skips << ", Scanned = " << stats.scans << " (errors = " << stats.errors.size() << "), features fetched = " << stats.featuresFetched << ", features extracted = " << stats.featuresExtracted << ", fingerprints computed = " << stats.fingerprintsComputed << ", replay gains computed = " << stats.replayGainsComputed << ",  duplicates = " << stats.duplicates.size();
 
 	_dbSession.optimize();
 
@@ -536,30 +599,300 @@ Scanner::scan(bool forceScan)
 	}
 }
 
-bool
-Scanner::fetchTrackFeatures(Database::IdType trackId, const UUID& MBID)
+void
+Scanner::computeTrackFingerprints(ScanStats& stats)
 {
-	std::map<std::string, double> features;
+	if (!Service<IConfig>::get()->getBool("scanner-fingerprint-tracks", true))
+		return;
+
+	ScanStepStats stepStats{stats.startTime, ScanProgressStep::ComputingTrackFingerprints};
+
+	LMS_LOG(DBUPDATER, INFO) << "Computing missing track fingerprints...";
 
-	LMS_LOG(DBUPDATER, INFO) << "Fetching low level features for track '" << MBID.getAsString() << "'";
-	const std::string data {AcousticBrainz::extractLowLevelFeatures(MBID)};
-	if (data.empty())
+	struct TrackInfo
 	{
-		LMS_LOG(DBUPDATER, ERROR) << "Track " << trackId << ", MBID = '" << MBID.getAsString() << "': cannot extract features using AcousticBrainz";
-		return false;
-	}
+		Database::IdType id;
+		std::filesystem::path path;
+	};
 
+	// Only new or modified files have no fingerprint
+	const auto tracksToAnalyze {[&]()
 	{
+		std::vector<TrackInfo> res;
+
+		auto transaction {_dbSession.createSharedTransaction()};
+
+		for (const Database::Track::pointer& track : Database::Track::getAllWithMissingFingerprint(_dbSession))
+			res.emplace_back(TrackInfo {track.id(), track->getPath()});
+
+		return res;
+	}()};
+
+	stepStats.totalElems = tracksToAnalyze.size();
+	notifyInProgress(stepStats);
+
+	LMS_LOG(DBUPDATER, INFO) << "Found " << tracksToAnalyze.size() << " track(s) to fingerprint!";
+
+	// Fingerprints are stored by batches, using a single transaction per batch
+	constexpr std::size_t batchSize {100};
+	std::vector<std::pair<Database::IdType, std::vector<unsigned char>>> pendingFingerprints;
+	auto storePendingFingerprints {[&]
+	{
+		if (pendingFingerprints.empty())
+			return;
+
 		auto uniqueTransaction {_dbSession.createUniqueTransaction()};
 
-		Wt::Dbo::ptr<Database::Track> track {Database::Track::getById(_dbSession, trackId)};
-		if (!track)
-			return false;
+		for (const auto& [trackId, fingerprint] : pendingFingerprints)
+		{
+			const Database::Track::pointer track {Database::Track::getById(_dbSession, trackId)};
+			if (!track || track->getTrackFingerprint())
+				continue;
+
+			Database::TrackFingerprint::create(_dbSession, track, fingerprint);
+			stats.fingerprintsComputed++;
+		}
+
+		pendingFingerprints.clear();
+	}};
+
+	processInParallel<TrackInfo, std::vector<unsigned char>>(getAnalysisThreadCount(), tracksToAnalyze,
+		[](const TrackInfo& trackInfo) -> std::optional<std::vector<unsigned char>>
+		{
+			try
+			{
+				Analysis::FingerprintExtractor extractor;
+
+				Av::DecodeParameters parameters;
+				parameters.sampleRate = Analysis::FingerprintExtractor::sampleRate;
+				parameters.channelCount = 1;
+				parameters.maxDuration = Analysis::FingerprintExtractor::maxDuration;
+
+				Av::decodeAudioFile(trackInfo.path, parameters, [&](const float* samples, std::size_t sampleCount)
+				{
+					extractor.process(samples, sampleCount);
+				});
+
+				const std::optional<Analysis::Fingerprint> fingerprint {extractor.getFingerprint()};
+				if (!fingerprint)
+				{
+					LMS_LOG(DBUPDATER, DEBUG) << "Cannot compute fingerprint of '" << trackInfo.path.string() << "': not enough audio";
+					return std::vector<unsigned char> {}; // do not try again
+				}
+
+				return fingerprint->serialize();
+			}
+			catch (const Av::Exception& e)
+			{
+				LMS_LOG(DBUPDATER, ERROR) << "Cannot compute fingerprint of '" << trackInfo.path.string() << "': " << e.what();
+				return std::nullopt;
+			}
+		},
+		[&](const TrackInfo& trackInfo, std::optional<std::vector<unsigned char>>&& fingerprint)
+		{
+			if (fingerprint)
+			{
+				pendingFingerprints.emplace_back(trackInfo.id, std::move(*fingerprint));
+				if (pendingFingerprints.size() >= batchSize)
+					storePendingFingerprints();
+			}
+
+			stepStats.processedElems++;
+			notifyInProgressIfNeeded(stepStats);
+		},
+		_abortScan);
+
+	storePendingFingerprints();
+
+	notifyInProgress(stepStats);
+	LMS_LOG(DBUPDATER, INFO) << "Track fingerprints computed!";
+}
+
+void
+Scanner::computeTrackLoudness(ScanStats& stats)
+{
+	if (!Service<IConfig>::get()->getBool("scanner-compute-replay-gain", false))
+		return;
 
-		Database::TrackFeatures::create(_dbSession, track, data);
+	ScanStepStats stepStats{stats.startTime, ScanProgressStep::ComputingTrackLoudness};
+
+	LMS_LOG(DBUPDATER, INFO) << "Computing missing replay gains...";
+
+	struct TrackInfo
+	{
+		Database::IdType id;
+		std::filesystem::path path;
+		std::size_t channelCount;
+		std::optional<Database::IdType> releaseId;	// set if the release gain has to be computed too
+	};
+
+	// Tracks are grouped by release, so that only a few releases are being measured at once
+	std::vector<TrackInfo> tracksToAnalyze;
+	std::unordered_map<Database::IdType, std::size_t> releaseRemainingTrackCounts;
+	{
+		auto transaction {_dbSession.createSharedTransaction()};
+
+		// Release gains are only computed if none of the tracks has tags, otherwise the tagged tracks would not be taken into account
+		const std::vector<Database::IdType> releaseIds {Database::Release::getAllIdsWithoutReplayGain(_dbSession)};
+		const std::unordered_set<Database::IdType> releaseIdsToAnalyze(std::cbegin(releaseIds), std::cend(releaseIds));
+
+		for (const Database::Track::pointer& track : Database::Track::getAllWithMissingReplayGain(_dbSession))
+		{
+			TrackInfo trackInfo {track.id(), track->getPath(), std::min<std::size_t>(track->getChannelCount().value_or(2), Analysis::LoudnessMeter::maxChannelCount), std::nullopt};
+			if (track->getRelease() && releaseIdsToAnalyze.find(track->getRelease().id()) != std::cend(releaseIdsToAnalyze))
+			{
+				trackInfo.releaseId = track->getRelease().id();
+				releaseRemainingTrackCounts[*trackInfo.releaseId]++;
+			}
+
+			tracksToAnalyze.emplace_back(std::move(trackInfo));
+		}
 	}
 
-	return true;
+	stepStats.totalElems = tracksToAnalyze.size();
+	notifyInProgress(stepStats);
+
+	LMS_LOG(DBUPDATER, INFO) << "Found " << tracksToAnalyze.size() << " track(s) to analyze!";
+
+	// Gains are stored by batches, using a single transaction per batch
+	constexpr std::size_t batchSize {100};
+	// No track gain means the track was measured without result, not to measure it again on each scan
+	std::vector<std::pair<Database::IdType, std::optional<float>>> pendingTrackGains;
+	std::vector<std::pair<Database::IdType, float>> pendingReleaseGains;
+	auto storePendingGains {[&]
+	{
+		if (pendingTrackGains.empty() && pendingReleaseGains.empty())
+			return;
+
+		auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+
+		for (const auto& [trackId, gain] : pendingTrackGains)
+		{
+			const Database::Track::pointer track {Database::Track::getById(_dbSession, trackId)};
+			if (!track || track->getTrackReplayGain() || track->isLoudnessMeasured())
+				continue;
+
+			track.modify()->setLoudnessMeasured(true);
+			if (gain)
+			{
+				track.modify()->setTrackReplayGain(*gain);
+				stats.replayGainsComputed++;
+			}
+		}
+
+		for (const auto& [trackId, gain] : pendingReleaseGains)
+		{
+			const Database::Track::pointer track {Database::Track::getById(_dbSession, trackId)};
+			if (!track || track->getReleaseReplayGain())
+				continue;
+
+			track.modify()->setReleaseReplayGain(gain);
+		}
+
+		pendingTrackGains.clear();
+		pendingReleaseGains.clear();
+	}};
+
+	struct LoudnessMeasure
+	{
+		Analysis::LoudnessMeter::Histogram histogram;
+		float truePeak;
+	};
+
+	// Track gains of a release are only stored once the whole release is measured:
+	// an aborted scan must not leave releases with track gains only
+	struct ReleaseMeasure
+	{
+		std::vector<std::pair<Database::IdType, std::optional<float>>> trackGains;
+		Analysis::LoudnessMeter::Histogram histogram;
+		float truePeak {};
+		bool complete {true};
+	};
+	std::unordered_map<Database::IdType, ReleaseMeasure> releaseMeasures;
+
+	processInParallel<TrackInfo, LoudnessMeasure>(getAnalysisThreadCount(), tracksToAnalyze,
+		[](const TrackInfo& trackInfo) -> std::optional<LoudnessMeasure>
+		{
+			try
+			{
+				Analysis::LoudnessMeter meter {trackInfo.channelCount};
+
+				Av::DecodeParameters parameters;
+				parameters.sampleRate = Analysis::LoudnessMeter::sampleRate;
+				parameters.channelCount = trackInfo.channelCount;
+
+				Av::decodeAudioFile(trackInfo.path, parameters, [&](const float* samples, std::size_t sampleCount)
+				{
+					meter.process(samples, sampleCount);
+				});
+
+				return LoudnessMeasure {meter.getHistogram(), meter.getTruePeak()};
+			}
+			catch (const Av::Exception& e)
+			{
+				LMS_LOG(DBUPDATER, ERROR) << "Cannot compute loudness of '" << trackInfo.path.string() << "': " << e.what();
+				return std::nullopt;
+			}
+		},
+		[&](const TrackInfo& trackInfo, std::optional<LoudnessMeasure>&& measure)
+		{
+			const std::optional<float> loudness {measure ? measure->histogram.computeIntegratedLoudness() : std::nullopt};
+			std::optional<float> trackGain;
+			if (loudness)
+			{
+				trackGain = Analysis::computeReplayGain(*loudness, measure->truePeak);
+				LMS_LOG(DBUPDATER, DEBUG) << "Track '" << trackInfo.path.string() << "': loudness = " << *loudness << " LUFS, true peak = " << measure->truePeak;
+			}
+			else if (measure)
+				LMS_LOG(DBUPDATER, DEBUG) << "Cannot compute loudness of '" << trackInfo.path.string() << "': silent track";
+
+			if (!trackInfo.releaseId)
+			{
+				pendingTrackGains.emplace_back(trackInfo.id, trackGain);
+			}
+			else
+			{
+				ReleaseMeasure& releaseMeasure {releaseMeasures[*trackInfo.releaseId]};
+				releaseMeasure.trackGains.emplace_back(trackInfo.id, trackGain);
+				if (trackGain)
+				{
+					releaseMeasure.histogram.merge(measure->histogram);
+					releaseMeasure.truePeak = std::max(releaseMeasure.truePeak, measure->truePeak);
+				}
+				else if (!measure)
+					releaseMeasure.complete = false;
+
+				if (--releaseRemainingTrackCounts[*trackInfo.releaseId] == 0)
+				{
+					pendingTrackGains.insert(std::end(pendingTrackGains), std::cbegin(releaseMeasure.trackGains), std::cend(releaseMeasure.trackGains));
+
+					const std::optional<float> releaseLoudness {releaseMeasure.histogram.computeIntegratedLoudness()};
+					if (releaseMeasure.complete && releaseLoudness)
+					{
+						const float releaseGain {Analysis::computeReplayGain(*releaseLoudness, releaseMeasure.truePeak)};
+						for (const auto& [trackId, gain] : releaseMeasure.trackGains)
+						{
+							if (gain)
+								pendingReleaseGains.emplace_back(trackId, releaseGain);
+						}
+					}
+
+					releaseMeasures.erase(*trackInfo.releaseId);
+				}
+			}
+
+			if (pendingTrackGains.size() >= batchSize)
+				storePendingGains();
+
+			stepStats.processedElems++;
+			notifyInProgressIfNeeded(stepStats);
+		},
+		_abortScan);
+
+	storePendingGains();
+
+	notifyInProgress(stepStats);
+	LMS_LOG(DBUPDATER, INFO) << "Replay gains computed!";
 }
 
 void
@@ -572,44 +905,191 @@ Scanner::fetchTrackFeatures(ScanStats& stats)
 
 	LMS_LOG(DBUPDATER, INFO) << "Fetching missing track features...";
 
+	// several tracks may share the same recording
+	std::unordered_map<std::string, std::vector<Database::IdType>> trackIdsByMBID;
+	std::vector<UUID> mbidsToFetch;
+	{
+		auto transaction {_dbSession.createSharedTransaction()};
+
+		for (const Database::Track::pointer& track : Database::Track::getAllWithMBIDAndMissingFeatures(_dbSession))
+		{
+			const UUID mbid {*track->getMBID()};
+
+			std::vector<Database::IdType>& trackIds {trackIdsByMBID[std::string {mbid.getAsString()}]};
+			if (trackIds.empty())
+				mbidsToFetch.push_back(mbid);
+
+			trackIds.push_back(track.id());
+		}
+	}
+
+	stepStats.totalElems = mbidsToFetch.size();
+	notifyInProgress(stepStats);
+
+	LMS_LOG(DBUPDATER, INFO) << "Found " << mbidsToFetch.size() << " recording(s) to fetch!";
+
+	// Features are stored by batches, using a single transaction per batch
+	constexpr std::size_t batchSize {100};
+	std::vector<std::pair<Database::IdType, std::string>> pendingFeatures;
+	auto storePendingFeatures {[&]
+	{
+		if (pendingFeatures.empty())
+			return;
+
+		auto uniqueTransaction {_dbSession.createUniqueTransaction()};
+
+		for (const auto& [trackId, features] : pendingFeatures)
+		{
+			const Database::Track::pointer track {Database::Track::getById(_dbSession, trackId)};
+			if (!track)
+				continue;
+
+			Database::TrackFeatures::create(_dbSession, track, features);
+			stats.featuresFetched++;
+		}
+
+		pendingFeatures.clear();
+	}};
+
+	const AcousticBrainz::Fetcher::Parameters parameters
+	{
+		Service<IConfig>::get()->getString("acousticbrainz-api-url", "https://acousticbrainz.org/api/v1/"),
+		Service<IConfig>::get()->getPath("working-dir") / "cache" / "acousticbrainz",
+		Service<IConfig>::get()->getULong("acousticbrainz-max-concurrent-requests", 4),
+	};
+
+	AcousticBrainz::Fetcher fetcher {parameters};
+	fetcher.fetch(mbidsToFetch, [&](const UUID& mbid, const std::string& features)
+	{
+		if (features.empty())
+			LMS_LOG(DBUPDATER, DEBUG) << "MBID = '" << mbid.getAsString() << "': no features available using AcousticBrainz";
+		else
+		{
+			for (const Database::IdType trackId : trackIdsByMBID[std::string {mbid.getAsString()}])
+				pendingFeatures.emplace_back(trackId, features);
+
+			if (pendingFeatures.size() >= batchSize)
+				storePendingFeatures();
+		}
+
+		stepStats.processedElems++;
+		notifyInProgressIfNeeded(stepStats);
+	}, _abortScan);
+
+	storePendingFeatures();
+
+	notifyInProgress(stepStats);
+	LMS_LOG(DBUPDATER, INFO) << "Track features fetched!";
+}
+
+void
+Scanner::extractTrackFeatures(ScanStats& stats)
+{
+	if (_recommendationEngineType != ScanSettings::RecommendationEngineType::Features)
+		return;
+
+	if (!Service<IConfig>::get()->getBool("scanner-extract-features", true))
+		return;
+
+	ScanStepStats stepStats{stats.startTime, ScanProgressStep::ExtractingTrackFeatures};
+
+	LMS_LOG(DBUPDATER, INFO) << "Extracting missing track features...";
+
 	struct TrackInfo
 	{
 		Database::IdType id;
-		UUID mbid;
+		std::filesystem::path path;
 	};
 
-	const auto tracksToFetch {[&]()
+	const auto tracksToAnalyze {[&]()
 	{
 		std::vector<TrackInfo> res;
 
 		auto transaction {_dbSession.createSharedTransaction()};
 
-		auto tracks {Database::Track::getAllWithMBIDAndMissingFeatures(_dbSession)};
-		for (const auto& track : tracks)
-			res.emplace_back(TrackInfo {track.id(), *track->getMBID()});
+		for (const Database::Track::pointer& track : Database::Track::getAllWithMissingFeatures(_dbSession))
+			res.emplace_back(TrackInfo {track.id(), track->getPath()});
 
 		return res;
 	}()};
 
-	stepStats.totalElems = tracksToFetch.size();
+	stepStats.totalElems = tracksToAnalyze.size();
 	notifyInProgress(stepStats);
 
-	LMS_LOG(DBUPDATER, INFO) << "Found " << tracksToFetch.size() << " track(s) to fetch!";
+	LMS_LOG(DBUPDATER, INFO) << "Found " << tracksToAnalyze.size() << " track(s) to analyze!";
 
-	for (const TrackInfo& trackToFetch : tracksToFetch)
+	// Features are stored by batches, using a single transaction per batch
+	constexpr std::size_t batchSize {100};
+	std::vector<std::pair<Database::IdType, std::string>> pendingFeatures;
+	auto storePendingFeatures {[&]
 	{
-		if (_abortScan)
+		if (pendingFeatures.empty())
 			return;
 
-		if (fetchTrackFeatures(trackToFetch.id, trackToFetch.mbid))
-			stats.featuresFetched++;
+		auto uniqueTransaction {_dbSession.createUniqueTransaction()};
 
-		stepStats.processedElems++;
-		notifyInProgressIfNeeded(stepStats);
-	}
+		for (const auto& [trackId, features] : pendingFeatures)
+		{
+			const Database::Track::pointer track {Database::Track::getById(_dbSession, trackId)};
+			if (!track || track->getTrackFeatures())
+				continue;
+
+			Database::TrackFeatures::create(_dbSession, track, features);
+			stats.featuresExtracted++;
+		}
+
+		pendingFeatures.clear();
+	}};
+
+	processInParallel<TrackInfo, std::string>(getAnalysisThreadCount(), tracksToAnalyze,
+		[](const TrackInfo& trackInfo) -> std::optional<std::string>
+		{
+			try
+			{
+				Analysis::FeatureExtractor extractor;
+
+				Av::DecodeParameters parameters;
+				parameters.sampleRate = Analysis::FeatureExtractor::sampleRate;
+				parameters.channelCount = 1;
+
+				Av::decodeAudioFile(trackInfo.path, parameters, [&](const float* samples, std::size_t sampleCount)
+				{
+					extractor.process(samples, sampleCount);
+				});
+
+				std::string features {extractor.getJsonEncodedFeatures()};
+				if (features.empty())
+				{
+					LMS_LOG(DBUPDATER, ERROR) << "Cannot extract features from '" << trackInfo.path.string() << "': no audio";
+					return std::nullopt;
+				}
+
+				return features;
+			}
+			catch (const Av::Exception& e)
+			{
+				LMS_LOG(DBUPDATER, ERROR) << "Cannot extract features from '" << trackInfo.path.string() << "': " << e.what();
+				return std::nullopt;
+			}
+		},
+		[&](const TrackInfo& trackInfo, std::optional<std::string>&& features)
+		{
+			if (features)
+			{
+				pendingFeatures.emplace_back(trackInfo.id, std::move(*features));
+				if (pendingFeatures.size() >= batchSize)
+					storePendingFeatures();
+			}
+
+			stepStats.processedElems++;
+			notifyInProgressIfNeeded(stepStats);
+		},
+		_abortScan);
+
+	storePendingFeatures();
 
 	notifyInProgress(stepStats);
-	LMS_LOG(DBUPDATER, INFO) << "Track features fetched!";
+	LMS_LOG(DBUPDATER, INFO) << "Track features extracted!";
 }
 
 void
@@ -649,6 +1129,14 @@ Scanner::notifyInProgress(const ScanStepStats& stepStats)
 {
 	{
 		std::unique_lock lock {_statusMutex};
+
+		// Only account for the elements processed since the last notification of the same step
+		std::size_t previousProcessedElems {};
+		if (_currentScanStepStats && _currentScanStepStats->startTime == stepStats.startTime && _currentScanStepStats->currentStep == stepStats.currentStep)
+			previousProcessedElems = _currentScanStepStats->processedElems;
+		if (stepStats.processedElems > previousProcessedElems)
+			getProcessedElemsCounter(stepStats.currentStep).inc(stepStats.processedElems - previousProcessedElems);
+
 		_currentScanStepStats = stepStats;
 	}
 
@@ -689,7 +1177,8 @@ Scanner::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanSt
 		const Track::pointer track {Track::getByPath(_dbSession, file)};
 
 		if (track && track->getLastWriteTime().toTime_t() == lastWriteTime.toTime_t()
-				&& track->getScanVersion() == _scanVersion)
+				&& track->getScanVersion() == _scanVersion
+				&& (!_computeFileCrc32 || track->isFileCrc32Computed()))
 		{
 			stats.skips++;
 			return;
@@ -703,11 +1192,44 @@ Scanner::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanSt
 		return;
 	}
 
+	std::uintmax_t fileSize {};
+	{
+		std::error_code ec;
+		fileSize = std::filesystem::file_size(file, ec);
+		if (ec)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot get file size for '" << file.string() << "': " << ec.message();
+			fileSize = 0;
+		}
+	}
+
+	std::optional<std::uint32_t> fileCrc32;
+	if (_computeFileCrc32)
+	{
+		try
+		{
+			fileCrc32 = computeCrc32(file);
+
+			// CRC is only valid for a given last write time
+			if (getLastWriteTime(file) != lastWriteTime)
+			{
+				LMS_LOG(DBUPDATER, INFO) << "File '" << file.string() << "' modified during scan, CRC discarded";
+				fileCrc32.reset();
+			}
+		}
+		catch (LmsException& e)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot compute CRC32: " << e.what();
+		}
+	}
+
 	stats.scans++;
 
 	auto uniqueTransaction {_dbSession.createUniqueTransaction()};
 
 	Track::pointer track {Track::getByPath(_dbSession, file) };
+	if (track)
+		invalidateSummaries(track);
 
 	// We estimate this is an audio file if:
 	// - we found a least one audio stream
@@ -763,6 +1285,18 @@ Scanner::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanSt
 	{
 		LMS_LOG(DBUPDATER, INFO) << "Updating '" << file.string() << "'";
 
+		// Audio content may have changed
+		if (track->getLastWriteTime().toTime_t() != lastWriteTime.toTime_t())
+		{
+			if (Database::TrackFingerprint::pointer fingerprint {track->getTrackFingerprint()})
+				fingerprint.remove();
+
+			// computed replay gains are not valid anymore, tags are read again below
+			track.modify()->setTrackReplayGain(std::nullopt);
+			track.modify()->setReleaseReplayGain(std::nullopt);
+			track.modify()->setLoudnessMeasured(false);
+		}
+
 		stats.updates++;
 	}
 
@@ -802,6 +1336,18 @@ Scanner::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanSt
 		track.modify()->setRelease(getOrCreateRelease(_dbSession, *trackInfo->album));
 	track.modify()->setClusters(getOrCreateClusters(_dbSession, trackInfo->clusters));
 	track.modify()->setLastWriteTime(lastWriteTime);
+	track.modify()->setFileCrc32(fileCrc32);
+	// Failures are not retried until the file is modified
+	track.modify()->setFileCrc32Computed(_computeFileCrc32);
+	track.modify()->setFileSize(fileSize);
+	{
+		// Only the first audio stream is considered
+		const MetaData::AudioStream& audioStream {trackInfo->audioStreams.front()};
+		track.modify()->setBitrate(audioStream.bitRate);
+		track.modify()->setSampleRate(audioStream.sampleRate);
+		track.modify()->setChannelCount(audioStream.channelCount);
+		track.modify()->setCodec(audioStream.codec);
+	}
 	track.modify()->setName(title);
 	track.modify()->setDuration(trackInfo->duration);
 	track.modify()->setAddedTime(Wt::WLocalDateTime::currentServerDateTime().toUTC());
@@ -827,6 +1373,8 @@ Scanner::scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanSt
 		track.modify()->setTrackReplayGain(*trackInfo->trackReplayGain);
 	if (trackInfo->albumReplayGain)
 		track.modify()->setReleaseReplayGain(*trackInfo->albumReplayGain);
+
+	invalidateSummaries(track);
 }
 
 void
@@ -948,6 +1496,7 @@ Scanner::removeMissingTracks(ScanStats& stats)
 				Track::pointer track {Track::getById(_dbSession, trackId)};
 				if (track)
 				{
+					invalidateSummaries(track);
 					track.remove();
 					stats.deletions++;
 				}
@@ -1006,6 +1555,61 @@ Scanner::removeOrphanEntries()
 	LMS_LOG(DBUPDATER, INFO) << "Check audio files done!";
 }
 
+void
+Scanner::invalidateSummaries(const Track::pointer& track)
+{
+	// Done in the same transaction as the track update
+	if (const Release::pointer release {track->getRelease()})
+		ReleaseSummary::markOutdated(_dbSession, release.id());
+
+	for (const IdType artistId : track->getArtistIds({}))
+		ArtistSummary::markOutdated(_dbSession, artistId);
+}
+
+void
+Scanner::refreshSummaries()
+{
+	static constexpr std::size_t batchSize {50};
+
+	// Outdated summaries are persisted: also catches up the entries of aborted scans and the ones that have never been summarized (database migration, etc.)
+	std::vector<IdType> releaseIds;
+	std::vector<IdType> artistIds;
+	{
+		auto transaction {_dbSession.createSharedTransaction()};
+
+		releaseIds = ReleaseSummary::getAllReleaseIdsToRefresh(_dbSession);
+		artistIds = ArtistSummary::getAllArtistIdsToRefresh(_dbSession);
+	}
+
+	LMS_LOG(DBUPDATER, DEBUG) << "Refreshing summaries of " << releaseIds.size() << " releases and " << artistIds.size() << " artists...";
+
+	for (std::size_t offset {}; !_abortScan && offset < releaseIds.size(); offset += batchSize)
+	{
+		auto transaction {_dbSession.createUniqueTransaction()};
+
+		for (std::size_t i {offset}; i < std::min(offset + batchSize, releaseIds.size()); ++i)
+		{
+			// May have been removed in the meantime
+			if (const Release::pointer release {Release::getById(_dbSession, releaseIds[i])})
+				ReleaseSummary::refresh(_dbSession, release);
+		}
+	}
+
+	for (std::size_t offset {}; !_abortScan && offset < artistIds.size(); offset += batchSize)
+	{
+		auto transaction {_dbSession.createUniqueTransaction()};
+
+		for (std::size_t i {offset}; i < std::min(offset + batchSize, artistIds.size()); ++i)
+		{
+			// May have been removed in the meantime
+			if (const Artist::pointer artist {Artist::getById(_dbSession, artistIds[i])})
+				ArtistSummary::refresh(_dbSession, artist);
+		}
+	}
+
+	LMS_LOG(DBUPDATER, DEBUG) << "Summaries refreshed!";
+}
+
 void
 Scanner::checkDuplicatedAudioFiles(ScanStats& stats)
 {
@@ -1023,6 +1627,36 @@ Scanner::checkDuplicatedAudioFiles(ScanStats& stats)
 		}
 	}
 
+	if (Service<IConfig>::get()->getBool("scanner-fingerprint-tracks", true))
+	{
+		// Max bit error rate between the fingerprints of two encodings of the same recording
+		constexpr float maxBitErrorRate {0.15f};
+
+		Analysis::FingerprintIndex index;
+		for (const auto& [trackId, duration, data] : Database::TrackFingerprint::getAll(_dbSession))
+		{
+			if (std::optional<Analysis::Fingerprint> fingerprint {Analysis::Fingerprint::deserialize(data)})
+				index.add(trackId, std::move(*fingerprint), duration);
+		}
+
+		std::set<Database::IdType> duplicatedTrackIds;
+		for (const auto& [trackId1, trackId2] : index.findDuplicates(maxBitErrorRate))
+		{
+			duplicatedTrackIds.insert(trackId1);
+			duplicatedTrackIds.insert(trackId2);
+		}
+
+		for (const Database::IdType trackId : duplicatedTrackIds)
+		{
+			const Track::pointer track {Track::getById(_dbSession, trackId)};
+			if (!track)
+				continue;
+
+			LMS_LOG(DBUPDATER, INFO) << "Found duplicated audio content, file: " << track->getPath().string() << " - " << track->getName();
+			stats.duplicates.emplace_back(ScanDuplicate {track.id(), DuplicateReason::SameFingerprint});
+		}
+	}
+
 	LMS_LOG(DBUPDATER, INFO) << "Checking duplicated audio files done!";
 }
 
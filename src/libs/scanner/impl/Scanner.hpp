@@ -32,11 +32,10 @@
 #include "database/Types.hpp"
 #include "database/ScanSettings.hpp"
 #include "database/Session.hpp"
+#include "database/Track.hpp"
 #include "metadata/IParser.hpp"
 #include "scanner/IScanner.hpp"
 
-class UUID;
-
 namespace Recommendation
 {
 	class IEngine;
@@ -75,8 +74,10 @@ class Scanner : public IScanner
 		void scan(bool force);
 
 		void scanMediaDirectory( const std::filesystem::path& mediaDirectory, bool forceScan, ScanStats& stats);
-		bool fetchTrackFeatures(Database::IdType trackId, const UUID& MBID);
+		void computeTrackFingerprints(ScanStats& stats);
+		void computeTrackLoudness(ScanStats& stats);
 		void fetchTrackFeatures(ScanStats& stats);
+		void extractTrackFeatures(ScanStats& stats);
 
 		// Helpers
 		void refreshScanSettings();
@@ -84,6 +85,8 @@ class Scanner : public IScanner
 		void countAllFiles(ScanStats& stats);
 		void removeMissingTracks(ScanStats& stats);
 		void removeOrphanEntries();
+		void invalidateSummaries(const Database::Track::pointer& track);
+		void refreshSummaries();
 		void checkDuplicatedAudioFiles(ScanStats& stats);
 		void scanAudioFile(const std::filesystem::path& file, bool forceScan, ScanStats& stats);
 		Database::IdType doScanAudioFile(const std::filesystem::path& file, ScanStats& stats);
@@ -101,6 +104,7 @@ class Scanner : public IScanner
 		std::chrono::system_clock::time_point	_lastScanInProgressEmit {};
 		Database::Session						_dbSession;
 		std::unique_ptr<MetaData::IParser>		_metadataParser;
+		const bool								_computeFileCrc32;
 
 		mutable std::shared_mutex			_statusMutex;
 		State								_curState {State::NotScheduled};
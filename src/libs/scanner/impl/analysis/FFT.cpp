@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FFT.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace Analysis
+{
+	FFT::FFT(std::size_t size)
+	: _size {size}
+	, _bitReversedIndexes(size)
+	, _re(size)
+	, _im(size)
+	{
+		if (size < 2 || (size & (size - 1)) != 0)
+			throw std::invalid_argument {"FFT size must be a power of 2"};
+
+		std::size_t bitCount {};
+		while ((std::size_t {1} << bitCount) < size)
+			bitCount++;
+
+		for (std::size_t i {}; i < size; ++i)
+		{
+			std::uint32_t reversed {};
+			for (std::size_t bit {}; bit < bitCount; ++bit)
+			{
+				if (i & (std::size_t {1} << bit))
+					reversed |= std::uint32_t {1} << (bitCount - 1 - bit);
+			}
+			_bitReversedIndexes[i] = reversed;
+		}
+
+		// stage with butterflies of length 'len' uses twiddles [len / 2 - 1, len - 1)
+		_twiddlesRe.reserve(size);
+		_twiddlesIm.reserve(size);
+		for (std::size_t len {2}; len <= size; len <<= 1)
+		{
+			for (std::size_t j {}; j < len / 2; ++j)
+			{
+				const double angle {-2 * M_PI * static_cast<double>(j) / static_cast<double>(len)};
+				_twiddlesRe.push_back(static_cast<float>(std::cos(angle)));
+				_twiddlesIm.push_back(static_cast<float>(std::sin(angle)));
+			}
+		}
+	}
+
+	void
+	FFT::computePowerSpectrum(const float* input, float* output)
+	{
+		for (std::size_t i {}; i < _size; ++i)
+		{
+			_re[_bitReversedIndexes[i]] = input[i];
+			_im[i] = 0;
+		}
+
+		transform();
+
+		const std::size_t spectrumSize {getSpectrumSize()};
+		const float* __restrict re {_re.data()};
+		const float* __restrict im {_im.data()};
+		for (std::size_t i {}; i < spectrumSize; ++i)
+			output[i] = re[i] * re[i] + im[i] * im[i];
+	}
+
+	void
+	FFT::transform()
+	{
+		float* __restrict re {_re.data()};
+		float* __restrict im {_im.data()};
+
+		std::size_t twiddleOffset {};
+		for (std::size_t len {2}; len <= _size; len <<= 1)
+		{
+			const std::size_t half {len / 2};
+			const float* __restrict wRe {_twiddlesRe.data() + twiddleOffset};
+			const float* __restrict wIm {_twiddlesIm.data() + twiddleOffset};
+
+			for (std::size_t i {}; i < _size; i += len)
+			{
+				float* __restrict uRe {re + i};
+				float* __restrict uIm {im + i};
+				float* __restrict xRe {re + i + half};
+				float* __restrict xIm {im + i + half};
+
+				for (std::size_t j {}; j < half; ++j)
+				{
+					const float vRe {xRe[j] * wRe[j] - xIm[j] * wIm[j]};
+					const float vIm {xRe[j] * wIm[j] + xIm[j] * wRe[j]};
+
+					xRe[j] = uRe[j] - vRe;
+					xIm[j] = uIm[j] - vIm;
+					uRe[j] += vRe;
+					uIm[j] += vIm;
+				}
+			}
+
+			twiddleOffset += half;
+		}
+
+		assert(twiddleOffset == _size - 1);
+	}
+} // namespace Analysis
+
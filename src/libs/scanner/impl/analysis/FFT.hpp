@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Analysis
+{
+	// Radix-2 FFT of real frames
+	// Data is kept as separate real/imaginary arrays and the twiddle factors are stored stage by stage,
+	// so that the butterfly loops run on contiguous memory and can be vectorized by the compiler
+	// Not thread safe: use one instance per thread
+	class FFT
+	{
+		public:
+			FFT(std::size_t size); // must be a power of 2
+
+			std::size_t getSize() const { return _size; }
+			std::size_t getSpectrumSize() const { return _size / 2 + 1; }
+
+			// input: getSize() samples, output: getSpectrumSize() bins of squared magnitudes
+			void computePowerSpectrum(const float* input, float* output);
+
+		private:
+			void transform();
+
+			const std::size_t _size;
+			std::vector<std::uint32_t> _bitReversedIndexes;
+			std::vector<float> _twiddlesRe;
+			std::vector<float> _twiddlesIm;
+			std::vector<float> _re;
+			std::vector<float> _im;
+	};
+} // namespace Analysis
+
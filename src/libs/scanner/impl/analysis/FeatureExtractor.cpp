@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FeatureExtractor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace Analysis
+{
+	namespace
+	{
+		constexpr float binFrequency {static_cast<float>(FeatureExtractor::sampleRate) / FeatureExtractor::frameSize};
+
+		std::size_t
+		frequencyToBin(float frequency)
+		{
+			return std::min(static_cast<std::size_t>(std::lround(frequency / binFrequency)), FeatureExtractor::frameSize / 2);
+		}
+
+		float
+		frequencyToErbRate(float frequency)
+		{
+			return 21.4f * std::log10(1.f + 0.00437f * frequency);
+		}
+
+		float
+		erbRateToFrequency(float erbRate)
+		{
+			return (std::pow(10.f, erbRate / 21.4f) - 1.f) / 0.00437f;
+		}
+
+		struct Statistics
+		{
+			float mean {};
+			float median {};
+			float var {};
+			float min {};
+			float max {};
+		};
+
+		// values of the dimension 'dimension', for each frame
+		Statistics
+		computeStatistics(const std::vector<float>& values, std::size_t dimensionCount, std::size_t dimension)
+		{
+			std::vector<float> dimensionValues;
+			dimensionValues.reserve(values.size() / dimensionCount);
+			for (std::size_t i {dimension}; i < values.size(); i += dimensionCount)
+				dimensionValues.push_back(std::isfinite(values[i]) ? values[i] : 0.f);
+
+			Statistics res;
+			if (dimensionValues.empty())
+				return res;
+
+			double sum {};
+			for (const float value : dimensionValues)
+				sum += value;
+			res.mean = static_cast<float>(sum / dimensionValues.size());
+
+			double squaredDiffSum {};
+			for (const float value : dimensionValues)
+				squaredDiffSum += (value - res.mean) * (value - res.mean);
+			res.var = static_cast<float>(squaredDiffSum / dimensionValues.size());
+
+			const auto [itMin, itMax] {std::minmax_element(std::cbegin(dimensionValues), std::cend(dimensionValues))};
+			res.min = *itMin;
+			res.max = *itMax;
+
+			auto itMedian {std::begin(dimensionValues) + dimensionValues.size() / 2};
+			std::nth_element(std::begin(dimensionValues), itMedian, std::end(dimensionValues));
+			res.median = *itMedian;
+
+			return res;
+		}
+
+		void
+		writeDescriptor(std::ostream& os, const std::string& name, const std::vector<float>& values, std::size_t dimensionCount)
+		{
+			std::vector<Statistics> statistics;
+			for (std::size_t dimension {}; dimension < dimensionCount; ++dimension)
+				statistics.push_back(computeStatistics(values, dimensionCount, dimension));
+
+			auto writeStatistic {[&](const char* statisticName, float Statistics::* statistic)
+			{
+				os << "\"" << statisticName << "\":";
+				if (dimensionCount == 1)
+				{
+					os << statistics.front().*statistic;
+					return;
+				}
+
+				os << "[";
+				for (std::size_t dimension {}; dimension < dimensionCount; ++dimension)
+					os << (dimension > 0 ? "," : "") << statistics[dimension].*statistic;
+				os << "]";
+			}};
+
+			os << "\"" << name << "\":{";
+			writeStatistic("mean", &Statistics::mean);
+			os << ",";
+			writeStatistic("median", &Statistics::median);
+			os << ",";
+			writeStatistic("var", &Statistics::var);
+			os << ",";
+			writeStatistic("min", &Statistics::min);
+			os << ",";
+			writeStatistic("max", &Statistics::max);
+			os << "}";
+		}
+	}
+
+	FeatureExtractor::FeatureExtractor()
+	: _fft {frameSize}
+	, _window(frameSize)
+	, _frame(frameSize)
+	, _windowedFrame(frameSize)
+	, _powerSpectrum(_fft.getSpectrumSize())
+	, _magnitudes(_fft.getSpectrumSize())
+	{
+		// Hann window, normalized so that the spectrum of a full scale sine has a unit peak
+		double windowSum {};
+		for (std::size_t i {}; i < frameSize; ++i)
+		{
+			_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * M_PI * i / (frameSize - 1)));
+			windowSum += _window[i];
+		}
+		for (float& value : _window)
+			value = static_cast<float>(value * 2 / windowSum);
+
+		// Triangular filters, equally spaced on the ERB scale
+		{
+			constexpr float lowFrequency {50};
+			constexpr float highFrequency {sampleRate / 2};
+
+			const float lowErbRate {frequencyToErbRate(lowFrequency)};
+			const float highErbRate {frequencyToErbRate(highFrequency)};
+
+			std::array<float, erbBandCount + 2> edges;
+			for (std::size_t i {}; i < edges.size(); ++i)
+				edges[i] = erbRateToFrequency(lowErbRate + (highErbRate - lowErbRate) * i / (edges.size() - 1));
+
+			for (std::size_t band {}; band < erbBandCount; ++band)
+			{
+				const float low {edges[band]};
+				const float center {edges[band + 1]};
+				const float high {edges[band + 2]};
+
+				Triangle& triangle {_erbFilters[band]};
+				triangle.firstBin = static_cast<std::size_t>(std::ceil(low / binFrequency));
+				for (std::size_t bin {triangle.firstBin}; bin < _powerSpectrum.size() && bin * binFrequency <= high; ++bin)
+				{
+					const float frequency {bin * binFrequency};
+					triangle.weights.push_back(frequency <= center ? (frequency - low) / (center - low) : (high - frequency) / (high - center));
+				}
+
+				// narrow low bands may fall between two bins
+				if (triangle.weights.empty())
+				{
+					triangle.firstBin = frequencyToBin(center);
+					triangle.weights.push_back(1);
+				}
+			}
+		}
+
+		// Spectral contrast bands, octave like between 20 and 11000 Hz
+		{
+			constexpr float lowFrequency {20};
+			constexpr float highFrequency {11000};
+
+			for (std::size_t i {}; i < _contrastBandBins.size(); ++i)
+			{
+				const float frequency {lowFrequency * std::pow(highFrequency / lowFrequency, static_cast<float>(i) / contrastBandCount)};
+				_contrastBandBins[i] = std::max(frequencyToBin(frequency), i > 0 ? _contrastBandBins[i - 1] + 1 : 0);
+			}
+		}
+
+		// Orthonormal DCT-II
+		for (std::size_t k {}; k < gfccCount; ++k)
+		{
+			const double scale {k == 0 ? std::sqrt(1. / erbBandCount) : std::sqrt(2. / erbBandCount)};
+			for (std::size_t n {}; n < erbBandCount; ++n)
+				_dctMatrix[k * erbBandCount + n] = static_cast<float>(scale * std::cos(M_PI / erbBandCount * (n + 0.5) * k));
+		}
+	}
+
+	void
+	FeatureExtractor::process(const float* samples, std::size_t sampleCount)
+	{
+		while (sampleCount > 0)
+		{
+			const std::size_t count {std::min(sampleCount, frameSize - _frameFill)};
+			std::copy(samples, samples + count, std::begin(_frame) + _frameFill);
+			_frameFill += count;
+			samples += count;
+			sampleCount -= count;
+
+			if (_frameFill == frameSize)
+			{
+				processFrame();
+
+				std::copy(std::cbegin(_frame) + hopSize, std::cend(_frame), std::begin(_frame));
+				_frameFill = frameSize - hopSize;
+			}
+		}
+	}
+
+	void
+	FeatureExtractor::processFrame()
+	{
+		{
+			const float* __restrict frame {_frame.data()};
+			const float* __restrict window {_window.data()};
+			float* __restrict windowedFrame {_windowedFrame.data()};
+			for (std::size_t i {}; i < frameSize; ++i)
+				windowedFrame[i] = frame[i] * window[i];
+		}
+
+		_fft.computePowerSpectrum(_windowedFrame.data(), _powerSpectrum.data());
+
+		const std::size_t binCount {_powerSpectrum.size()};
+		const float* __restrict power {_powerSpectrum.data()};
+
+		// Energy in the [4000, 20000] Hz band
+		{
+			float energy {};
+			for (std::size_t bin {frequencyToBin(4000)}; bin <= frequencyToBin(20000); ++bin)
+				energy += power[bin];
+
+			_energyBandHigh.push_back(energy);
+		}
+
+		// Frequency below which 85% of the energy lies
+		{
+			float totalEnergy {};
+			for (std::size_t bin {}; bin < binCount; ++bin)
+				totalEnergy += power[bin];
+
+			const float threshold {totalEnergy * 0.85f};
+			float energy {};
+			std::size_t bin {};
+			for (; bin < binCount - 1; ++bin)
+			{
+				energy += power[bin];
+				if (energy >= threshold)
+					break;
+			}
+
+			_rolloff.push_back(totalEnergy > 0 ? bin * binFrequency : 0);
+		}
+
+		// Spectral contrast valleys: log of the mean of the 40% lowest magnitudes of each band
+		{
+			float* __restrict magnitudes {_magnitudes.data()};
+			for (std::size_t bin {}; bin < binCount; ++bin)
+				magnitudes[bin] = std::sqrt(power[bin]);
+
+			for (std::size_t band {}; band < contrastBandCount; ++band)
+			{
+				auto itBegin {std::begin(_magnitudes) + _contrastBandBins[band]};
+				auto itEnd {std::begin(_magnitudes) + _contrastBandBins[band + 1]};
+				const std::size_t valleyCount {std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(0.4 * std::distance(itBegin, itEnd))))};
+
+				std::nth_element(itBegin, itBegin + (valleyCount - 1), itEnd);
+
+				float valley {};
+				for (auto it {itBegin}; it != itBegin + valleyCount; ++it)
+					valley += *it;
+
+				_contrastValleys.push_back(std::log(valley / valleyCount + 1e-30f));
+			}
+		}
+
+		// ERB bands and their cepstral coefficients
+		{
+			std::array<float, erbBandCount> bandEnergies;
+			for (std::size_t band {}; band < erbBandCount; ++band)
+			{
+				const Triangle& triangle {_erbFilters[band]};
+				const float* __restrict weights {triangle.weights.data()};
+				const float* __restrict bandPower {power + triangle.firstBin};
+				const std::size_t weightCount {std::min(triangle.weights.size(), binCount - triangle.firstBin)};
+
+				float energy {};
+				for (std::size_t i {}; i < weightCount; ++i)
+					energy += weights[i] * bandPower[i];
+
+				bandEnergies[band] = energy;
+				_erbBands.push_back(energy);
+			}
+
+			std::array<float, erbBandCount> logBandEnergies;
+			for (std::size_t band {}; band < erbBandCount; ++band)
+				logBandEnergies[band] = 10 * std::log10(bandEnergies[band] + 1e-10f);
+
+			for (std::size_t k {}; k < gfccCount; ++k)
+			{
+				const float* __restrict dct {_dctMatrix.data() + k * erbBandCount};
+
+				float coefficient {};
+				for (std::size_t n {}; n < erbBandCount; ++n)
+					coefficient += dct[n] * logBandEnergies[n];
+
+				_gfcc.push_back(coefficient);
+			}
+		}
+
+		_frameCount++;
+	}
+
+	std::string
+	FeatureExtractor::getJsonEncodedFeatures() const
+	{
+		if (_frameCount == 0)
+			return {};
+
+		std::ostringstream oss;
+		oss << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+		oss << "{\"lowlevel\":{";
+		writeDescriptor(oss, "erbbands", _erbBands, erbBandCount);
+		oss << ",";
+		writeDescriptor(oss, "gfcc", _gfcc, gfccCount);
+		oss << ",";
+		writeDescriptor(oss, "spectral_contrast_valleys", _contrastValleys, contrastBandCount);
+		oss << ",";
+		writeDescriptor(oss, "spectral_energyband_high", _energyBandHigh, 1);
+		oss << ",";
+		writeDescriptor(oss, "spectral_rolloff", _rolloff, 1);
+		oss << "}}";
+
+		return oss.str();
+	}
+} // namespace Analysis
+
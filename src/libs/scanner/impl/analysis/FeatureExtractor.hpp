@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "FFT.hpp"
+
+namespace Analysis
+{
+	// Computes some of the low level descriptors of AcousticBrainz, from mono samples
+	// Only the descriptors used by the default similarity settings are computed:
+	// spectral_energyband_high, spectral_rolloff, spectral_contrast_valleys, erbbands and gfcc
+	// Values are not expected to match the ones of AcousticBrainz exactly, but they follow the same definitions
+	class FeatureExtractor
+	{
+		public:
+			static constexpr unsigned sampleRate {44100};
+			static constexpr std::size_t frameSize {2048};
+			static constexpr std::size_t hopSize {1024};
+
+			static constexpr std::size_t erbBandCount {40};
+			static constexpr std::size_t gfccCount {13};
+			static constexpr std::size_t contrastBandCount {6};
+
+			FeatureExtractor();
+
+			FeatureExtractor(const FeatureExtractor&) = delete;
+			FeatureExtractor(FeatureExtractor&&) = delete;
+			FeatureExtractor& operator=(const FeatureExtractor&) = delete;
+			FeatureExtractor& operator=(FeatureExtractor&&) = delete;
+
+			// mono samples at sampleRate, may be called several times
+			void		process(const float* samples, std::size_t sampleCount);
+
+			std::size_t	getFrameCount() const { return _frameCount; }
+
+			// Same layout as AcousticBrainz low level documents: "lowlevel" -> descriptor -> statistic
+			// Statistics are mean, median, var, min and max
+			std::string	getJsonEncodedFeatures() const;
+
+		private:
+			void	processFrame();
+
+			struct Triangle
+			{
+				std::size_t firstBin;
+				std::vector<float> weights;
+			};
+
+			FFT				_fft;
+			std::vector<float>		_window;
+			std::vector<float>		_frame;
+			std::size_t			_frameFill {};
+			std::vector<float>		_windowedFrame;
+			std::vector<float>		_powerSpectrum;
+			std::vector<float>		_magnitudes;
+			std::array<Triangle, erbBandCount>	_erbFilters;
+			std::array<std::size_t, contrastBandCount + 1>	_contrastBandBins;
+			std::array<float, erbBandCount * gfccCount>	_dctMatrix;
+
+			// per frame descriptors, frame by frame
+			std::size_t			_frameCount {};
+			std::vector<float>		_energyBandHigh;
+			std::vector<float>		_rolloff;
+			std::vector<float>		_contrastValleys;
+			std::vector<float>		_erbBands;
+			std::vector<float>		_gfcc;
+	};
+} // namespace Analysis
+
@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Fingerprint.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Analysis
+{
+	namespace
+	{
+		constexpr std::uint8_t serializationVersion {1};
+
+		constexpr std::size_t hopSize {FingerprintExtractor::frameSize / 2};
+		constexpr std::size_t smoothingFrameCount {8};	// ~1.5 second
+		constexpr std::size_t chromaFramesPerSubFingerprint {2};
+
+		constexpr float minPitchFrequency {55};
+		constexpr float maxPitchFrequency {3520};
+
+		// quantization of the standardized profile values
+		constexpr float profileOffset {128};
+		constexpr float profileScale {32};
+
+		using Chroma = std::array<float, Fingerprint::chromaCount>;
+
+		unsigned
+		countBits(std::uint32_t value)
+		{
+			value = value - ((value >> 1) & 0x55555555);
+			value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+			return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+		}
+
+		std::uint32_t
+		computeSubFingerprint(const Chroma& chroma, const Chroma& previousChroma)
+		{
+			std::uint32_t res {};
+			std::size_t bit {};
+
+			// evolution of each pitch class
+			for (std::size_t i {}; i < Fingerprint::chromaCount; ++i)
+				res |= static_cast<std::uint32_t>(chroma[i] > previousChroma[i]) << bit++;
+
+			// shape of the chroma: neighbour pitch classes, then pitch classes a fourth apart
+			for (std::size_t i {}; i < Fingerprint::chromaCount; ++i)
+				res |= static_cast<std::uint32_t>(chroma[i] > chroma[(i + 1) % Fingerprint::chromaCount]) << bit++;
+
+			for (std::size_t i {}; i < 8; ++i)
+				res |= static_cast<std::uint32_t>(chroma[i] > chroma[(i + 5) % Fingerprint::chromaCount]) << bit++;
+
+			return res;
+		}
+
+		// Deterministic pseudo random generator, so that profile hashes do not depend on the standard library
+		class XorShift
+		{
+			public:
+				float nextFloat() // in [-1, 1]
+				{
+					_state ^= _state << 13;
+					_state ^= _state >> 7;
+					_state ^= _state << 17;
+					return static_cast<float>(_state >> 40) / static_cast<float>(1 << 23) - 1.f;
+				}
+
+			private:
+				std::uint64_t _state {0x9E3779B97F4A7C15ULL};
+		};
+	}
+
+	std::vector<unsigned char>
+	Fingerprint::serialize() const
+	{
+		std::vector<unsigned char> res;
+		res.reserve(3 + profile.size() + frames.size() * 4);
+
+		res.push_back(serializationVersion);
+		res.push_back(static_cast<unsigned char>(frames.size() & 0xFF));
+		res.push_back(static_cast<unsigned char>((frames.size() >> 8) & 0xFF));
+		res.insert(std::end(res), std::cbegin(profile), std::cend(profile));
+		for (const std::uint32_t frame : frames)
+		{
+			for (std::size_t i {}; i < 4; ++i)
+				res.push_back(static_cast<unsigned char>((frame >> (i * 8)) & 0xFF));
+		}
+
+		return res;
+	}
+
+	std::optional<Fingerprint>
+	Fingerprint::deserialize(const std::vector<unsigned char>& data)
+	{
+		Fingerprint res;
+
+		constexpr std::size_t headerSize {3 + std::tuple_size_v<decltype(res.profile)>};
+		if (data.size() < headerSize || data[0] != serializationVersion)
+			return std::nullopt;
+
+		const std::size_t frameCount {static_cast<std::size_t>(data[1]) | (static_cast<std::size_t>(data[2]) << 8)};
+		if (data.size() != headerSize + frameCount * 4)
+			return std::nullopt;
+
+		std::copy(std::cbegin(data) + 3, std::cbegin(data) + headerSize, std::begin(res.profile));
+
+		res.frames.resize(frameCount);
+		for (std::size_t i {}; i < frameCount; ++i)
+		{
+			const unsigned char* frameData {data.data() + headerSize + i * 4};
+			res.frames[i] = static_cast<std::uint32_t>(frameData[0])
+				| (static_cast<std::uint32_t>(frameData[1]) << 8)
+				| (static_cast<std::uint32_t>(frameData[2]) << 16)
+				| (static_cast<std::uint32_t>(frameData[3]) << 24);
+		}
+
+		return res;
+	}
+
+	FingerprintExtractor::FingerprintExtractor()
+	: _fft {frameSize}
+	, _window(frameSize)
+	, _binPitchClasses(_fft.getSpectrumSize(), -1)
+	, _frame(frameSize)
+	, _windowedFrame(frameSize)
+	, _powerSpectrum(_fft.getSpectrumSize())
+	{
+		for (std::size_t i {}; i < frameSize; ++i)
+			_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * M_PI * i / (frameSize - 1)));
+
+		for (std::size_t bin {1}; bin < _binPitchClasses.size(); ++bin)
+		{
+			const float frequency {static_cast<float>(bin) * sampleRate / frameSize};
+			if (frequency < minPitchFrequency || frequency > maxPitchFrequency)
+				continue;
+
+			// MIDI note number, A4 = 69
+			const long note {std::lround(12 * std::log2(frequency / 440.f)) + 69};
+			_binPitchClasses[bin] = static_cast<int>(note % 12);
+		}
+
+		_chromas.reserve(maxDuration.count() * sampleRate / hopSize);
+	}
+
+	void
+	FingerprintExtractor::process(const float* samples, std::size_t sampleCount)
+	{
+		constexpr std::size_t maxFrameCount {maxDuration.count() * sampleRate / hopSize};
+
+		while (sampleCount > 0 && _chromas.size() < maxFrameCount)
+		{
+			const std::size_t count {std::min(sampleCount, frameSize - _frameFill)};
+			std::copy(samples, samples + count, std::begin(_frame) + _frameFill);
+			_frameFill += count;
+			samples += count;
+			sampleCount -= count;
+
+			if (_frameFill == frameSize)
+			{
+				processFrame();
+
+				std::copy(std::cbegin(_frame) + hopSize, std::cend(_frame), std::begin(_frame));
+				_frameFill = frameSize - hopSize;
+			}
+		}
+	}
+
+	void
+	FingerprintExtractor::processFrame()
+	{
+		{
+			const float* __restrict frame {_frame.data()};
+			const float* __restrict window {_window.data()};
+			float* __restrict output {_windowedFrame.data()};
+			for (std::size_t i {}; i < frameSize; ++i)
+				output[i] = frame[i] * window[i];
+		}
+
+		_fft.computePowerSpectrum(_windowedFrame.data(), _powerSpectrum.data());
+
+		Chroma chroma {};
+		for (std::size_t bin {}; bin < _powerSpectrum.size(); ++bin)
+		{
+			if (_binPitchClasses[bin] >= 0)
+				chroma[_binPitchClasses[bin]] += _powerSpectrum[bin];
+		}
+
+		// Only the relative energy of the pitch classes matters
+		const float sum {std::accumulate(std::cbegin(chroma), std::cend(chroma), 0.f)};
+		if (sum > 1e-6f)
+		{
+			for (float& value : chroma)
+				value /= sum;
+		}
+		else
+			chroma.fill(0);
+
+		_chromas.push_back(chroma);
+	}
+
+	std::optional<Fingerprint>
+	FingerprintExtractor::getFingerprint() const
+	{
+		if (_chromas.size() < smoothingFrameCount + chromaFramesPerSubFingerprint * Fingerprint::profileSegmentCount)
+			return std::nullopt;
+
+		// Smooth the chromas over time, so that the fingerprint is not sensitive to the exact frame alignment
+		std::vector<Chroma> smoothedChromas(_chromas.size() - smoothingFrameCount + 1);
+		for (std::size_t i {}; i < smoothedChromas.size(); ++i)
+		{
+			Chroma& smoothedChroma {smoothedChromas[i]};
+			smoothedChroma.fill(0);
+			for (std::size_t j {}; j < smoothingFrameCount; ++j)
+			{
+				for (std::size_t pitchClass {}; pitchClass < Fingerprint::chromaCount; ++pitchClass)
+					smoothedChroma[pitchClass] += _chromas[i + j][pitchClass];
+			}
+		}
+
+		Fingerprint res;
+		for (std::size_t i {chromaFramesPerSubFingerprint}; i < smoothedChromas.size(); i += chromaFramesPerSubFingerprint)
+			res.frames.push_back(computeSubFingerprint(smoothedChromas[i], smoothedChromas[i - chromaFramesPerSubFingerprint]));
+
+		for (std::size_t segment {}; segment < Fingerprint::profileSegmentCount; ++segment)
+		{
+			const std::size_t begin {segment * _chromas.size() / Fingerprint::profileSegmentCount};
+			const std::size_t end {(segment + 1) * _chromas.size() / Fingerprint::profileSegmentCount};
+
+			Chroma meanChroma {};
+			for (std::size_t i {begin}; i < end; ++i)
+			{
+				for (std::size_t pitchClass {}; pitchClass < Fingerprint::chromaCount; ++pitchClass)
+					meanChroma[pitchClass] += _chromas[i][pitchClass];
+			}
+
+			// Standardize each segment: a noise floor or a different gain must not change the profile
+			const float mean {std::accumulate(std::cbegin(meanChroma), std::cend(meanChroma), 0.f) / Fingerprint::chromaCount};
+			float variance {};
+			for (const float value : meanChroma)
+				variance += (value - mean) * (value - mean);
+			const float stdDev {std::sqrt(variance / Fingerprint::chromaCount)};
+
+			for (std::size_t pitchClass {}; pitchClass < Fingerprint::chromaCount; ++pitchClass)
+			{
+				const float standardValue {stdDev > 0 ? (meanChroma[pitchClass] - mean) / stdDev : 0};
+				res.profile[segment * Fingerprint::chromaCount + pitchClass] = static_cast<std::uint8_t>(std::clamp<long>(std::lround(profileOffset + standardValue * profileScale), 0, 255));
+			}
+		}
+
+		return res;
+	}
+
+	float
+	compareFingerprints(const Fingerprint& fingerprint1, const Fingerprint& fingerprint2, std::size_t maxFrameOffset)
+	{
+		const std::size_t frameCount1 {fingerprint1.frames.size()};
+		const std::size_t frameCount2 {fingerprint2.frames.size()};
+		const std::size_t minOverlap {std::max<std::size_t>(1, std::min(frameCount1, frameCount2) / 2)};
+
+		float res {1};
+		for (std::ptrdiff_t offset {-static_cast<std::ptrdiff_t>(maxFrameOffset)}; offset <= static_cast<std::ptrdiff_t>(maxFrameOffset); ++offset)
+		{
+			// fingerprint1.frames[i] is compared to fingerprint2.frames[i + offset]
+			const std::size_t begin1 {offset < 0 ? static_cast<std::size_t>(-offset) : 0};
+			const std::size_t begin2 {offset > 0 ? static_cast<std::size_t>(offset) : 0};
+			if (begin1 >= frameCount1 || begin2 >= frameCount2)
+				continue;
+
+			const std::size_t overlap {std::min(frameCount1 - begin1, frameCount2 - begin2)};
+			if (overlap < minOverlap)
+				continue;
+
+			const std::uint32_t* frames1 {fingerprint1.frames.data() + begin1};
+			const std::uint32_t* frames2 {fingerprint2.frames.data() + begin2};
+
+			std::size_t errorCount {};
+			for (std::size_t i {}; i < overlap; ++i)
+				errorCount += countBits(frames1[i] ^ frames2[i]);
+
+			res = std::min(res, static_cast<float>(errorCount) / (overlap * 32));
+		}
+
+		return res;
+	}
+
+	void
+	FingerprintIndex::add(Id id, Fingerprint fingerprint, std::chrono::milliseconds duration)
+	{
+		const std::uint64_t hash {computeProfileHash(fingerprint)};
+
+		const std::size_t index {_entries.size()};
+		_entries.push_back(Entry {id, std::move(fingerprint), duration});
+		_hashes.push_back(hash);
+
+		for (std::size_t band {}; band < bandCount; ++band)
+			_buckets[band][static_cast<std::uint16_t>(hash >> (band * bitsPerBand))].push_back(index);
+	}
+
+	std::vector<std::pair<FingerprintIndex::Id, FingerprintIndex::Id>>
+	FingerprintIndex::findDuplicates(float maxBitErrorRate) const
+	{
+		std::vector<std::pair<Id, Id>> res;
+
+		// Each fingerprint is checked against the ones in the same buckets, and in the buckets whose key
+		// differs by one bit: close profiles are found as long as one band has at most one different bit
+		std::vector<std::pair<std::size_t, std::size_t>> candidates;
+		for (std::size_t index {}; index < _entries.size(); ++index)
+		{
+			for (std::size_t band {}; band < bandCount; ++band)
+			{
+				const std::uint16_t key {static_cast<std::uint16_t>(_hashes[index] >> (band * bitsPerBand))};
+
+				auto addCandidates {[&](std::uint16_t bucketKey)
+				{
+					auto itBucket {_buckets[band].find(bucketKey)};
+					if (itBucket == std::cend(_buckets[band]))
+						return;
+
+					for (const std::size_t otherIndex : itBucket->second)
+					{
+						if (otherIndex > index)
+							candidates.emplace_back(index, otherIndex);
+					}
+				}};
+
+				addCandidates(key);
+				for (std::size_t bit {}; bit < bitsPerBand; ++bit)
+					addCandidates(key ^ static_cast<std::uint16_t>(1 << bit));
+			}
+		}
+
+		// a pair may share several buckets
+		std::sort(std::begin(candidates), std::end(candidates));
+		candidates.erase(std::unique(std::begin(candidates), std::end(candidates)), std::end(candidates));
+
+		for (const auto& [index1, index2] : candidates)
+		{
+			const Entry& entry1 {_entries[index1]};
+			const Entry& entry2 {_entries[index2]};
+
+			// Duplicates have roughly the same duration
+			// Fingerprints only cover the beginning of the tracks: the track durations must be used
+			const std::chrono::milliseconds minDuration {std::min(entry1.duration, entry2.duration)};
+			const std::chrono::milliseconds maxDuration {std::max(entry1.duration, entry2.duration)};
+			if (maxDuration > minDuration * 11 / 10 + std::chrono::seconds {2})
+				continue;
+
+			if (compareFingerprints(entry1.fingerprint, entry2.fingerprint) <= maxBitErrorRate)
+				res.emplace_back(entry1.id, entry2.id);
+		}
+
+		return res;
+	}
+
+	std::uint64_t
+	FingerprintIndex::computeProfileHash(const Fingerprint& fingerprint)
+	{
+		// Sign of the projections of the profile on fixed random hyperplanes:
+		// close profiles share most of the bits
+		constexpr std::size_t dimensionCount {std::tuple_size_v<decltype(fingerprint.profile)>};
+
+		std::array<float, dimensionCount> centeredProfile;
+		for (std::size_t i {}; i < dimensionCount; ++i)
+			centeredProfile[i] = fingerprint.profile[i] - profileOffset;
+
+		static const std::vector<float> hyperplanes {[]
+		{
+			XorShift generator;
+
+			std::vector<float> res(bandCount * bitsPerBand * dimensionCount);
+			for (float& value : res)
+				value = generator.nextFloat();
+
+			return res;
+		}()};
+
+		std::uint64_t res {};
+		for (std::size_t bit {}; bit < bandCount * bitsPerBand; ++bit)
+		{
+			const float* hyperplane {hyperplanes.data() + bit * dimensionCount};
+
+			float projection {};
+			for (std::size_t i {}; i < dimensionCount; ++i)
+				projection += hyperplane[i] * centeredProfile[i];
+
+			if (projection > 0)
+				res |= std::uint64_t {1} << bit;
+		}
+
+		return res;
+	}
+} // namespace Analysis
+
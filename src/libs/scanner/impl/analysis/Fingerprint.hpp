@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FFT.hpp"
+
+namespace Analysis
+{
+	// Compact chroma based fingerprint of the beginning of a track
+	// Robust to the encoding: rips of the same recording in different formats have close fingerprints
+	struct Fingerprint
+	{
+		static constexpr std::size_t chromaCount {12};
+		static constexpr std::size_t profileSegmentCount {8};
+
+		std::vector<std::uint32_t>	frames;		// one 32 bits sub fingerprint per frame
+		std::array<std::uint8_t, profileSegmentCount * chromaCount>	profile {};	// quantized standardized mean chroma of each segment of the track
+
+		std::vector<unsigned char>		serialize() const;
+		static std::optional<Fingerprint>	deserialize(const std::vector<unsigned char>& data);
+	};
+
+	class FingerprintExtractor
+	{
+		public:
+			static constexpr unsigned sampleRate {11025};
+			static constexpr std::chrono::seconds maxDuration {120};
+			static constexpr std::size_t frameSize {4096};
+
+			FingerprintExtractor();
+
+			FingerprintExtractor(const FingerprintExtractor&) = delete;
+			FingerprintExtractor(FingerprintExtractor&&) = delete;
+			FingerprintExtractor& operator=(const FingerprintExtractor&) = delete;
+			FingerprintExtractor& operator=(FingerprintExtractor&&) = delete;
+
+			// mono samples at sampleRate, may be called several times
+			void				process(const float* samples, std::size_t sampleCount);
+
+			// not set if there is not enough audio
+			std::optional<Fingerprint>	getFingerprint() const;
+
+		private:
+			void processFrame();
+
+			FFT					_fft;
+			std::vector<float>			_window;
+			std::vector<int>			_binPitchClasses;	// -1 if not used
+			std::vector<float>			_frame;
+			std::size_t				_frameFill {};
+			std::vector<float>			_windowedFrame;
+			std::vector<float>			_powerSpectrum;
+			std::vector<std::array<float, Fingerprint::chromaCount>>	_chromas;
+	};
+
+	// Bit error rate of the best alignment of the fingerprints, in [0, 1]
+	// 0 means identical, unrelated fingerprints are around 0.5
+	float compareFingerprints(const Fingerprint& fingerprint1, const Fingerprint& fingerprint2, std::size_t maxFrameOffset = 16);
+
+	// Finds near duplicate fingerprints
+	// Candidates are found using locality sensitive hashing on the profiles (random projections, split in bands of bits, also probing the buckets one bit away),
+	// then checked using compareFingerprints
+	class FingerprintIndex
+	{
+		public:
+			using Id = std::int64_t;
+
+			// duration is the duration of the whole track, fingerprints only cover its beginning
+			void add(Id id, Fingerprint fingerprint, std::chrono::milliseconds duration);
+
+			// each pair is reported once
+			std::vector<std::pair<Id, Id>> findDuplicates(float maxBitErrorRate) const;
+
+		private:
+			static constexpr std::size_t bandCount {4};
+			static constexpr std::size_t bitsPerBand {16};
+
+			static std::uint64_t computeProfileHash(const Fingerprint& fingerprint);
+
+			struct Entry
+			{
+				Id id;
+				Fingerprint fingerprint;
+				std::chrono::milliseconds duration;
+			};
+
+			std::vector<Entry> _entries;
+			std::vector<std::uint64_t> _hashes;
+			std::array<std::unordered_map<std::uint16_t, std::vector<std::size_t>>, bandCount> _buckets;
+	};
+} // namespace Analysis
+
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LoudnessMeter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Analysis
+{
+	namespace
+	{
+		// K-weighting: high shelf then high pass, BS.1770-4 coefficients at 48 kHz
+		constexpr double kWeightingShelf[] {1.53512485958697, -2.69169618940638, 1.19839281085285, -1.69065929318241, 0.73248077421585};
+		constexpr double kWeightingHighPass[] {1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621};
+
+		constexpr float loudnessOffset {-0.691f};
+		constexpr float relativeGate {-10};
+		constexpr float replayGainReferenceLoudness {-18};
+
+		float
+		energyToLoudness(double energy)
+		{
+			return loudnessOffset + 10 * static_cast<float>(std::log10(energy));
+		}
+	}
+
+	void
+	LoudnessMeter::Histogram::add(double blockEnergy)
+	{
+		if (blockEnergy <= 0)
+			return;
+
+		const float loudness {energyToLoudness(blockEnergy)};
+		if (loudness < minLoudness)
+			return;
+
+		const std::size_t bin {std::min(binCount - 1, static_cast<std::size_t>((loudness - minLoudness) * binsPerLU))};
+		_blockCounts[bin]++;
+		_blockEnergies[bin] += blockEnergy;
+	}
+
+	void
+	LoudnessMeter::Histogram::merge(const Histogram& other)
+	{
+		for (std::size_t bin {}; bin < binCount; ++bin)
+		{
+			_blockCounts[bin] += other._blockCounts[bin];
+			_blockEnergies[bin] += other._blockEnergies[bin];
+		}
+	}
+
+	std::optional<float>
+	LoudnessMeter::Histogram::computeIntegratedLoudness() const
+	{
+		auto computeMeanLoudness {[&](std::size_t firstBin) -> std::optional<float>
+		{
+			std::uint64_t blockCount {};
+			double energy {};
+			for (std::size_t bin {firstBin}; bin < binCount; ++bin)
+			{
+				blockCount += _blockCounts[bin];
+				energy += _blockEnergies[bin];
+			}
+
+			if (blockCount == 0)
+				return std::nullopt;
+
+			return energyToLoudness(energy / blockCount);
+		}};
+
+		const std::optional<float> absoluteGatedLoudness {computeMeanLoudness(0)};
+		if (!absoluteGatedLoudness)
+			return std::nullopt;
+
+		// Blocks are gated with the resolution of the histogram
+		const float relativeGateLoudness {*absoluteGatedLoudness + relativeGate};
+		const std::size_t firstBin {relativeGateLoudness > minLoudness ? static_cast<std::size_t>((relativeGateLoudness - minLoudness) * binsPerLU) : 0};
+
+		return computeMeanLoudness(std::min(firstBin, binCount - 1));
+	}
+
+	LoudnessMeter::LoudnessMeter(std::size_t channelCount)
+	: _channelCount {channelCount}
+	{
+		assert(channelCount > 0 && channelCount <= maxChannelCount);
+
+		for (std::size_t channel {}; channel < _channelCount; ++channel)
+			_channelSamples[channel].resize(tapsPerPhase - 1 + segmentSize);
+
+		// Polyphase decomposition of a windowed sinc low pass filter, cut at the original Nyquist frequency
+		constexpr std::size_t tapCount {tapsPerPhase * oversamplingFactor};
+		float sum {};
+		for (std::size_t tap {}; tap < tapCount; ++tap)
+		{
+			const double x {(static_cast<double>(tap) - (tapCount - 1) / 2.) / oversamplingFactor};
+			const double sinc {x == 0 ? 1. : std::sin(M_PI * x) / (M_PI * x)};
+			const double window {0.5 - 0.5 * std::cos(2 * M_PI * (tap + 1) / (tapCount + 1))};
+
+			const float coef {static_cast<float>(sinc * window)};
+			_oversamplingCoefs[tap / oversamplingFactor][tap % oversamplingFactor] = coef;
+			sum += coef;
+		}
+
+		// unity gain for each phase
+		for (auto& coefs : _oversamplingCoefs)
+		{
+			for (float& coef : coefs)
+				coef *= oversamplingFactor / sum;
+		}
+	}
+
+	void
+	LoudnessMeter::process(const float* samples, std::size_t sampleCount)
+	{
+		constexpr std::size_t historySize {tapsPerPhase - 1};
+
+		std::size_t frameCount {sampleCount / _channelCount};
+		while (frameCount > 0)
+		{
+			const std::size_t count {std::min(frameCount, segmentSize - _segmentFill)};
+
+			for (std::size_t channel {}; channel < _channelCount; ++channel)
+			{
+				float* __restrict channelSamples {_channelSamples[channel].data() + historySize + _segmentFill};
+				for (std::size_t i {}; i < count; ++i)
+					channelSamples[i] = samples[i * _channelCount + channel];
+			}
+
+			_segmentFill += count;
+			samples += count * _channelCount;
+			frameCount -= count;
+
+			if (_segmentFill == segmentSize)
+			{
+				processSegment();
+				_segmentFill = 0;
+			}
+		}
+	}
+
+	void
+	LoudnessMeter::processSegment()
+	{
+		constexpr std::size_t historySize {tapsPerPhase - 1};
+
+		double segmentEnergy {};
+		for (std::size_t channel {}; channel < _channelCount; ++channel)
+		{
+			segmentEnergy += filterChannel(channel);	// channel weights are 1 for left/right
+			_truePeak = std::max(_truePeak, computeChannelTruePeak(channel));
+
+			std::vector<float>& channelSamples {_channelSamples[channel]};
+			std::copy(std::cend(channelSamples) - historySize, std::cend(channelSamples), std::begin(channelSamples));
+		}
+
+		// Gating blocks are 400 ms long, with a 75% overlap
+		_segmentEnergies[_segmentCount % blockSegmentCount] = segmentEnergy;
+		_segmentCount++;
+
+		if (_segmentCount >= blockSegmentCount)
+		{
+			double blockEnergy {};
+			for (const double energy : _segmentEnergies)
+				blockEnergy += energy;
+
+			_histogram.add(blockEnergy / blockSegmentCount);
+		}
+	}
+
+	double
+	LoudnessMeter::filterChannel(std::size_t channel)
+	{
+		constexpr std::size_t historySize {tapsPerPhase - 1};
+
+		// The filters are recursive: samples are processed one by one, in double precision for stability
+		std::array<double, 4>& states {_filterStates[channel]};
+		double s1 {states[0]};
+		double s2 {states[1]};
+		double s3 {states[2]};
+		double s4 {states[3]};
+
+		const float* samples {_channelSamples[channel].data() + historySize};
+		double sumOfSquares {};
+		for (std::size_t i {}; i < segmentSize; ++i)
+		{
+			const double x {samples[i]};
+
+			const double y {kWeightingShelf[0] * x + s1};
+			s1 = kWeightingShelf[1] * x - kWeightingShelf[3] * y + s2;
+			s2 = kWeightingShelf[2] * x - kWeightingShelf[4] * y;
+
+			const double z {kWeightingHighPass[0] * y + s3};
+			s3 = kWeightingHighPass[1] * y - kWeightingHighPass[3] * z + s4;
+			s4 = kWeightingHighPass[2] * y - kWeightingHighPass[4] * z;
+
+			sumOfSquares += z * z;
+		}
+
+		states = {s1, s2, s3, s4};
+
+		return sumOfSquares / segmentSize;
+	}
+
+	float
+	LoudnessMeter::computeChannelTruePeak(std::size_t channel) const
+	{
+		const float* samples {_channelSamples[channel].data()};
+
+		// All the phases of an input sample are computed at once, so that the inner loop can be vectorized
+		std::array<float, oversamplingFactor> peaks {};
+		for (std::size_t i {}; i < segmentSize; ++i)
+		{
+			std::array<float, oversamplingFactor> values {};
+			for (std::size_t tap {}; tap < tapsPerPhase; ++tap)
+			{
+				const float sample {samples[i + tapsPerPhase - 1 - tap]};
+				for (std::size_t phase {}; phase < oversamplingFactor; ++phase)
+					values[phase] += _oversamplingCoefs[tap][phase] * sample;
+			}
+
+			for (std::size_t phase {}; phase < oversamplingFactor; ++phase)
+				peaks[phase] = std::max(peaks[phase], std::abs(values[phase]));
+		}
+
+		return *std::max_element(std::cbegin(peaks), std::cend(peaks));
+	}
+
+	float
+	computeReplayGain(float integratedLoudness, float truePeak)
+	{
+		float gain {replayGainReferenceLoudness - integratedLoudness};
+
+		if (truePeak > 0)
+			gain = std::min(gain, -20 * std::log10(truePeak));
+
+		return gain;
+	}
+} // namespace Analysis
+
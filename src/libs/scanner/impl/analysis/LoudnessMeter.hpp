@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Analysis
+{
+	// Loudness measurement, as specified by EBU R128 (ITU-R BS.1770-4)
+	// Memory is only allocated at construction: the gated blocks are accumulated in a fixed size histogram
+	class LoudnessMeter
+	{
+		public:
+			static constexpr unsigned sampleRate {48000};	// K-weighting filter coefficients are given at this rate
+			static constexpr std::size_t maxChannelCount {2};	// front left/right, other channels are expected to be downmixed
+
+			// Loudness distribution of the gated blocks
+			// Histograms of several tracks can be merged to measure them as a whole (album gain)
+			class Histogram
+			{
+				public:
+					void add(double blockEnergy);
+					void merge(const Histogram& other);
+
+					// LUFS, not set if there is no block above the absolute gate
+					std::optional<float> computeIntegratedLoudness() const;
+
+				private:
+					static constexpr float minLoudness {-70};	// absolute gate
+					static constexpr float maxLoudness {5};
+					static constexpr std::size_t binsPerLU {10};
+					static constexpr std::size_t binCount {static_cast<std::size_t>(maxLoudness - minLoudness) * binsPerLU};
+
+					std::array<std::uint32_t, binCount>	_blockCounts {};
+					std::array<double, binCount>		_blockEnergies {};
+			};
+
+			LoudnessMeter(std::size_t channelCount);
+
+			LoudnessMeter(const LoudnessMeter&) = delete;
+			LoudnessMeter(LoudnessMeter&&) = delete;
+			LoudnessMeter& operator=(const LoudnessMeter&) = delete;
+			LoudnessMeter& operator=(LoudnessMeter&&) = delete;
+
+			// interleaved samples at sampleRate, may be called several times
+			void			process(const float* samples, std::size_t sampleCount);
+
+			const Histogram&	getHistogram() const { return _histogram; }
+			std::optional<float>	getIntegratedLoudness() const { return _histogram.computeIntegratedLoudness(); }
+			float			getTruePeak() const { return _truePeak; }	// linear
+
+		private:
+			static constexpr std::size_t segmentSize {sampleRate / 10};	// 100 ms, blocks are made of 4 overlapping segments
+			static constexpr std::size_t blockSegmentCount {4};
+			static constexpr std::size_t oversamplingFactor {4};	// for true peak
+			static constexpr std::size_t tapsPerPhase {12};
+
+			void	processSegment();
+			double	filterChannel(std::size_t channel);	// returns the mean square of the K-weighted samples
+			float	computeChannelTruePeak(std::size_t channel) const;
+
+			const std::size_t	_channelCount;
+
+			// per channel samples of the current segment, preceded by the last samples of the previous segment (oversampling filter history)
+			std::array<std::vector<float>, maxChannelCount>	_channelSamples;
+			std::size_t					_segmentFill {};
+
+			std::array<std::array<double, 4>, maxChannelCount>	_filterStates {};	// 2 states for each biquad
+			std::array<std::array<float, oversamplingFactor>, tapsPerPhase>	_oversamplingCoefs {};
+
+			std::array<double, blockSegmentCount>	_segmentEnergies {};
+			std::size_t				_segmentCount {};
+
+			Histogram	_histogram;
+			float		_truePeak {};
+	};
+
+	// ReplayGain 2.0 gain (dB), using a -18 LUFS reference level
+	// The gain is limited so that the true peak does not exceed full scale
+	float computeReplayGain(float integratedLoudness, float truePeak);
+
+} // namespace Analysis
+
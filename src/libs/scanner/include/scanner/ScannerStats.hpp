@@ -40,6 +40,7 @@ namespace Scanner {
 	{
 		SameHash,
 		SameMBID,
+		SameFingerprint,	// same audio content
 	};
 
 	struct ScanError
@@ -62,10 +63,13 @@ namespace Scanner {
 		ChekingForMissingFiles = 0,
 		DiscoveringFiles,
 		ScanningFiles,
+		ComputingTrackFingerprints,
+		ComputingTrackLoudness,
 		FetchingTrackFeatures,
+		ExtractingTrackFeatures,
 		ReloadingSimilarityEngine,
 	};
-	static inline constexpr unsigned ScanProgressStepCount {5};
+	static inline constexpr unsigned ScanProgressStepCount {8};
 
 	// reduced scan stats
 	struct ScanStepStats
@@ -95,6 +99,9 @@ namespace Scanner {
 		std::size_t	updates {};			// updated file in DB
 
 		std::size_t	featuresFetched {};	// features fetched in DB
+		std::size_t	featuresExtracted {};	// features computed from the audio files
+		std::size_t	fingerprintsComputed {};	// fingerprints computed from the audio files
+		std::size_t	replayGainsComputed {};	// track replay gains computed from the audio files
 
 		std::vector<ScanError>		errors;
 		std::vector<ScanDuplicate>	duplicates;
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CursorCache.hpp"
+
+#include "utils/Random.hpp"
+
+namespace API::Subsonic
+{
+	CursorCache::CursorCache(std::size_t maxEntryCount)
+	: _maxEntryCount {maxEntryCount}
+	{
+	}
+
+	std::optional<CursorCache::Key>
+	CursorCache::get(std::uint64_t generation, std::string_view query, std::size_t offset)
+	{
+		const std::string entryKey {getEntryKey(query, offset)};
+
+		std::scoped_lock lock {_mutex};
+
+		if (generation != _generation)
+			return std::nullopt;
+
+		auto it {_cache.find(entryKey)};
+		if (it == std::cend(_cache))
+			return std::nullopt;
+
+		return it->second;
+	}
+
+	void
+	CursorCache::put(std::uint64_t generation, std::string_view query, std::size_t offset, const Key& key)
+	{
+		std::string entryKey {getEntryKey(query, offset)};
+
+		std::scoped_lock lock {_mutex};
+
+		if (generation < _generation)
+			return;
+
+		if (generation > _generation)
+		{
+			_cache.clear();
+			_generation = generation;
+		}
+
+		while (_cache.size() >= _maxEntryCount && !_cache.empty())
+			_cache.erase(Random::pickRandom(_cache));
+
+		_cache.insert_or_assign(std::move(entryKey), key);
+	}
+
+	std::string
+	CursorCache::getEntryKey(std::string_view query, std::size_t offset)
+	{
+		std::string entryKey {query};
+		entryKey += '@';
+		entryKey += std::to_string(offset);
+
+		return entryKey;
+	}
+} // namespace API::Subsonic
+
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "database/Types.hpp"
+
+namespace API::Subsonic
+{
+	// Keyset positions reached by offset based requests
+	// Clients usually ask for the pages one after the other: the next page can then be fetched
+	// right after the last entry of the previous one, instead of making the database skip 'offset' entries
+	// Positions of older generations are dropped as soon as a newer generation is seen
+	class CursorCache
+	{
+		public:
+			CursorCache(std::size_t maxEntryCount);
+
+			CursorCache(const CursorCache&) = delete;
+			CursorCache(CursorCache&&) = delete;
+			CursorCache& operator=(const CursorCache&) = delete;
+			CursorCache& operator=(CursorCache&&) = delete;
+
+			using Key = Database::KeysetRange::Key;
+
+			// query identifies the request and its filters, offset is the position of the first entry to get
+			std::optional<Key>	get(std::uint64_t generation, std::string_view query, std::size_t offset);
+			void			put(std::uint64_t generation, std::string_view query, std::size_t offset, const Key& key);
+
+		private:
+			static std::string	getEntryKey(std::string_view query, std::size_t offset);
+
+			const std::size_t _maxEntryCount;
+
+			std::mutex _mutex;
+			std::uint64_t _generation {};
+			std::unordered_map<std::string, Key> _cache;
+	};
+} // namespace API::Subsonic
+
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include <Wt/Http/Request.h>
@@ -32,6 +34,8 @@ namespace Database
 
 namespace API::Subsonic
 {
+	class CursorCache;
+	class UserContext;
 
 	struct RequestContext
 	{
@@ -39,6 +43,9 @@ namespace API::Subsonic
 		Database::Session& dbSession;
 		std::string userName;
 		std::string clientName;
+		std::uint64_t libraryGeneration {};	// got before handling the request
+		CursorCache& cursorCache;
+		std::shared_ptr<const UserContext> userContext;	// set before calling the entry points
 	};
 
 }
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResponseBatch.hpp"
+
+#include "UserContext.hpp"
+
+#include <cassert>
+#include <set>
+
+#include "database/Session.hpp"
+#include "database/TrackArtistLink.hpp"
+
+namespace API::Subsonic
+{
+	using namespace Database;
+
+	ResponseBatch::ResponseBatch(Session& session, User::pointer user, const UserContext& userContext)
+	: _session {session}
+	, _user {user}
+	, _userContext {userContext}
+	{
+		_session.checkSharedLocked();
+	}
+
+	void
+	ResponseBatch::addTracks(const std::vector<Track::pointer>& tracks)
+	{
+		std::vector<IdType> trackIds;
+		std::set<IdType> releaseIds;
+		trackIds.reserve(tracks.size());
+		for (const Track::pointer& track : tracks)
+		{
+			trackIds.push_back(track.id());
+			if (track->getRelease() && _releases.find(track->getRelease().id()) == std::cend(_releases))
+				releaseIds.insert(track->getRelease().id());
+		}
+
+		{
+			const auto trackArtistIds {TrackArtistLink::getTrackArtistIds(_session, trackIds, TrackArtistLinkType::Artist)};
+
+			std::vector<IdType> artistIds;
+			artistIds.reserve(trackArtistIds.size());
+			for (const auto& [trackId, artistId] : trackArtistIds)
+				artistIds.push_back(artistId);
+
+			loadArtists(artistIds);
+
+			for (const auto& [trackId, artistId] : trackArtistIds)
+			{
+				auto itArtist {_artists.find(artistId)};
+				if (itArtist != std::cend(_artists))
+					_trackArtists[trackId].push_back(itArtist->second);
+			}
+		}
+
+		if (!_genreClusterType)
+			_genreClusterType = ClusterType::getByName(_session, ReleaseSummary::genreClusterTypeName);
+
+		if (*_genreClusterType)
+		{
+			// Report the first genre of each track
+			for (const auto& [trackId, clusterName] : Cluster::getTrackClusterNames(_session, trackIds, _genreClusterType->id()))
+				_trackGenres.emplace(trackId, clusterName);
+		}
+
+		if (!releaseIds.empty())
+			addReleases(Release::getByIds(_session, std::vector<IdType>(std::cbegin(releaseIds), std::cend(releaseIds))));
+	}
+
+	void
+	ResponseBatch::addReleases(const std::vector<Release::pointer>& releases)
+	{
+		for (const Release::pointer& release : releases)
+			_releases.emplace(release.id(), release);
+
+		const std::vector<ReleaseSummary::pointer> summaries {ReleaseSummary::get(_session, releases)};
+		assert(summaries.size() == releases.size());
+
+		std::vector<IdType> artistIds;
+		for (const ReleaseSummary::pointer& summary : summaries)
+		{
+			const std::vector<IdType> summaryArtistIds {summary->getArtistIds()};
+			artistIds.insert(std::end(artistIds), std::cbegin(summaryArtistIds), std::cend(summaryArtistIds));
+		}
+		loadArtists(artistIds);
+
+		for (std::size_t i {}; i < releases.size(); ++i)
+		{
+			std::vector<Artist::pointer>& releaseArtists {_releaseArtists[releases[i].id()]};
+			releaseArtists.clear();
+
+			for (const IdType artistId : summaries[i]->getArtistIds())
+			{
+				auto itArtist {_artists.find(artistId)};
+				if (itArtist != std::cend(_artists))
+					releaseArtists.push_back(itArtist->second);
+			}
+
+			_releaseSummaries[releases[i].id()] = summaries[i];
+		}
+	}
+
+	void
+	ResponseBatch::addArtists(const std::vector<Artist::pointer>& artists)
+	{
+		for (const Artist::pointer& artist : artists)
+			_artists.emplace(artist.id(), artist);
+
+		const std::vector<ArtistSummary::pointer> summaries {ArtistSummary::get(_session, artists)};
+		assert(summaries.size() == artists.size());
+
+		for (std::size_t i {}; i < artists.size(); ++i)
+			_artistSummaries[artists[i].id()] = summaries[i];
+	}
+
+	const std::vector<Artist::pointer>&
+	ResponseBatch::getTrackArtists(const Track::pointer& track) const
+	{
+		static const std::vector<Artist::pointer> noArtist;
+
+		auto it {_trackArtists.find(track.id())};
+		return it != std::cend(_trackArtists) ? it->second : noArtist;
+	}
+
+	Release::pointer
+	ResponseBatch::getTrackRelease(const Track::pointer& track) const
+	{
+		if (!track->getRelease())
+			return {};
+
+		auto it {_releases.find(track->getRelease().id())};
+		assert(it != std::cend(_releases));
+
+		return it->second;
+	}
+
+	std::optional<std::string>
+	ResponseBatch::getTrackGenre(const Track::pointer& track) const
+	{
+		auto it {_trackGenres.find(track.id())};
+		if (it == std::cend(_trackGenres))
+			return std::nullopt;
+
+		return it->second;
+	}
+
+	bool
+	ResponseBatch::isTrackStarred(const Track::pointer& track) const
+	{
+		return _userContext.isTrackStarred(track.id());
+	}
+
+	const ReleaseSummary::pointer&
+	ResponseBatch::getReleaseSummary(const Release::pointer& release) const
+	{
+		auto it {_releaseSummaries.find(release.id())};
+		assert(it != std::cend(_releaseSummaries));
+
+		return it->second;
+	}
+
+	const std::vector<Artist::pointer>&
+	ResponseBatch::getReleaseArtists(const Release::pointer& release) const
+	{
+		auto it {_releaseArtists.find(release.id())};
+		assert(it != std::cend(_releaseArtists));
+
+		return it->second;
+	}
+
+	bool
+	ResponseBatch::isReleaseStarred(const Release::pointer& release) const
+	{
+		return _userContext.isReleaseStarred(release.id());
+	}
+
+	const ArtistSummary::pointer&
+	ResponseBatch::getArtistSummary(const Artist::pointer& artist) const
+	{
+		auto it {_artistSummaries.find(artist.id())};
+		assert(it != std::cend(_artistSummaries));
+
+		return it->second;
+	}
+
+	bool
+	ResponseBatch::isArtistStarred(const Artist::pointer& artist) const
+	{
+		return _userContext.isArtistStarred(artist.id());
+	}
+
+	void
+	ResponseBatch::loadArtists(const std::vector<IdType>& artistIds)
+	{
+		std::vector<IdType> missingArtistIds;
+		for (const IdType artistId : artistIds)
+		{
+			if (_artists.find(artistId) == std::cend(_artists))
+				missingArtistIds.push_back(artistId);
+		}
+
+		for (const Artist::pointer& artist : Artist::getByIds(_session, missingArtistIds))
+			_artists.emplace(artist.id(), artist);
+	}
+}
+
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "database/Artist.hpp"
+#include "database/ArtistSummary.hpp"
+#include "database/Cluster.hpp"
+#include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
+#include "database/Track.hpp"
+#include "database/Types.hpp"
+#include "database/User.hpp"
+
+namespace Database
+{
+	class Session;
+}
+
+namespace API::Subsonic
+{
+	class UserContext;
+
+	// Data needed to build the response nodes of a set of entities
+	// Each add* call runs a constant number of set based queries, whatever the number of entities
+	// Starred states are taken from the user context
+	// Entities must be added before being queried
+	class ResponseBatch
+	{
+		public:
+			ResponseBatch(Database::Session& session, Database::User::pointer user, const UserContext& userContext);
+
+			ResponseBatch(const ResponseBatch&) = delete;
+			ResponseBatch(ResponseBatch&&) = delete;
+			ResponseBatch& operator=(const ResponseBatch&) = delete;
+			ResponseBatch& operator=(ResponseBatch&&) = delete;
+
+			// also adds the releases of the tracks
+			void addTracks(const std::vector<Database::Track::pointer>& tracks);
+			void addReleases(const std::vector<Database::Release::pointer>& releases);
+			void addArtists(const std::vector<Database::Artist::pointer>& artists);
+
+			const Database::User::pointer&		getUser() const { return _user; }
+
+			const std::vector<Database::Artist::pointer>&	getTrackArtists(const Database::Track::pointer& track) const;
+			Database::Release::pointer			getTrackRelease(const Database::Track::pointer& track) const;
+			std::optional<std::string>			getTrackGenre(const Database::Track::pointer& track) const;
+			bool						isTrackStarred(const Database::Track::pointer& track) const;
+
+			const Database::ReleaseSummary::pointer&	getReleaseSummary(const Database::Release::pointer& release) const;
+			const std::vector<Database::Artist::pointer>&	getReleaseArtists(const Database::Release::pointer& release) const; // release artists, or artists if none
+			bool						isReleaseStarred(const Database::Release::pointer& release) const;
+
+			const Database::ArtistSummary::pointer&		getArtistSummary(const Database::Artist::pointer& artist) const;
+			bool						isArtistStarred(const Database::Artist::pointer& artist) const;
+
+		private:
+			void	loadArtists(const std::vector<Database::IdType>& artistIds);
+
+			Database::Session&		_session;
+			const Database::User::pointer	_user;
+			const UserContext&		_userContext;
+			std::optional<Database::ClusterType::pointer>	_genreClusterType;
+
+			std::unordered_map<Database::IdType, Database::Artist::pointer>			_artists;
+
+			std::unordered_map<Database::IdType, std::vector<Database::Artist::pointer>>	_trackArtists;
+			std::unordered_map<Database::IdType, std::string>				_trackGenres;
+
+			std::unordered_map<Database::IdType, Database::Release::pointer>		_releases;
+			std::unordered_map<Database::IdType, Database::ReleaseSummary::pointer>		_releaseSummaries;
+			std::unordered_map<Database::IdType, std::vector<Database::Artist::pointer>>	_releaseArtists;
+
+			std::unordered_map<Database::IdType, Database::ArtistSummary::pointer>		_artistSummaries;
+	};
+}
+
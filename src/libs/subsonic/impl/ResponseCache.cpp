@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResponseCache.hpp"
+
+#include <mutex>
+
+#include "utils/Logger.hpp"
+#include "utils/Random.hpp"
+
+namespace API::Subsonic
+{
+	ResponseCache::ResponseCache(std::size_t maxCacheSize)
+	: _maxCacheSize {maxCacheSize}
+	{
+		LMS_LOG(API_SUBSONIC, INFO) << "Response cache max size = " << _maxCacheSize;
+	}
+
+	std::size_t
+	ResponseCache::getMaxEntrySize(const std::string& key) const
+	{
+		return key.size() < _maxCacheSize ? _maxCacheSize - key.size() : 0;
+	}
+
+	ResponseCache::Entry
+	ResponseCache::get(std::uint64_t generation, const std::string& key)
+	{
+		std::shared_lock lock {_mutex};
+
+		if (generation != _generation)
+		{
+			++_cacheMisses;
+			return {};
+		}
+
+		auto it {_cache.find(key)};
+		if (it == std::cend(_cache))
+		{
+			++_cacheMisses;
+			return {};
+		}
+
+		++_cacheHits;
+		return it->second;
+	}
+
+	void
+	ResponseCache::put(std::uint64_t generation, const std::string& key, Entry serializedResponse)
+	{
+		if (key.size() + serializedResponse->size() > _maxCacheSize)
+			return;
+
+		std::unique_lock lock {_mutex};
+
+		if (generation < _generation)
+			return;
+
+		if (generation > _generation)
+		{
+			LMS_LOG(API_SUBSONIC, DEBUG) << "New library generation, dropping " << _cache.size() << " cached responses (hits = " << _cacheHits << ", misses = " << _cacheMisses << ")";
+			_cache.clear();
+			_cacheSize = 0;
+			_generation = generation;
+		}
+
+		const std::size_t entrySize {key.size() + serializedResponse->size()};
+		while (_cacheSize + entrySize > _maxCacheSize && !_cache.empty())
+		{
+			auto itRandom {Random::pickRandom(_cache)};
+			_cacheSize -= itRandom->first.size() + itRandom->second->size();
+			_cache.erase(itRandom);
+		}
+
+		auto [it, inserted] {_cache.emplace(key, nullptr)};
+		if (!inserted)
+			_cacheSize -= it->first.size() + it->second->size();
+
+		it->second = std::move(serializedResponse);
+		_cacheSize += entrySize;
+	}
+} // namespace API::Subsonic
+
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace API::Subsonic
+{
+	// Serialized responses of requests that only depend on the library generation, the user (and its generation, part of the key) and the request parameters
+	// Entries of older generations are dropped as soon as a newer generation is seen
+	class ResponseCache
+	{
+		public:
+			ResponseCache(std::size_t maxCacheSize);
+
+			ResponseCache(const ResponseCache&) = delete;
+			ResponseCache(ResponseCache&&) = delete;
+			ResponseCache& operator=(const ResponseCache&) = delete;
+			ResponseCache& operator=(ResponseCache&&) = delete;
+
+			using Entry = std::shared_ptr<const std::string>;
+
+			// Larger serialized responses are not worth caching for this key
+			std::size_t	getMaxEntrySize(const std::string& key) const;
+
+			Entry	get(std::uint64_t generation, const std::string& key);
+			void	put(std::uint64_t generation, const std::string& key, Entry serializedResponse);
+
+		private:
+			const std::size_t _maxCacheSize;
+
+			std::shared_mutex _mutex;
+			std::uint64_t _generation {};
+			std::unordered_map<std::string, Entry> _cache;
+			std::size_t _cacheSize {};
+			std::atomic<std::size_t> _cacheHits {};
+			std::atomic<std::size_t> _cacheMisses {};
+	};
+} // namespace API::Subsonic
+
@@ -18,9 +18,13 @@
  */
 #include "subsonic/SubsonicResource.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <ctime>
 #include <iomanip>
+#include <optional>
+#include <sstream>
+#include <streambuf>
 #include <unordered_map>
 
 #include <Wt/WLocalDateTime.h>
@@ -28,32 +32,40 @@
 #include "auth/IPasswordService.hpp"
 #include "cover/ICoverArtGrabber.hpp"
 #include "database/Artist.hpp"
+#include "database/ArtistSummary.hpp"
 #include "database/Cluster.hpp"
 #include "database/Db.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
 #include "database/Session.hpp"
 #include "database/Track.hpp"
 #include "database/TrackBookmark.hpp"
 #include "database/TrackList.hpp"
 #include "database/User.hpp"
 #include "recommendation/IEngine.hpp"
+#include "utils/IConfig.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
 #include "utils/Random.hpp"
 #include "utils/Service.hpp"
 #include "utils/String.hpp"
 #include "utils/Utils.hpp"
+#include "CursorCache.hpp"
 #include "ParameterParsing.hpp"
 #include "RequestContext.hpp"
+#include "ResponseBatch.hpp"
+#include "ResponseCache.hpp"
 #include "Scan.hpp"
 #include "Stream.hpp"
 #include "SubsonicResponse.hpp"
+#include "UserContext.hpp"
 
 using namespace Database;
 
 static const std::string	genreClusterName {"GENRE"};
 static const std::string	reportedStarredDate {"2000-01-01T00:00:00"};
 static const std::string	reportedDummyDate {"2000-01-01T00:00:00"};
-static const unsigned long long	reportedDummyDateULong {946684800000ULL}; // 2000-01-01T00:00:00 UTC
 
 namespace API::Subsonic
 {
@@ -132,7 +144,10 @@ struct ClientInfo
 {
 	std::string name;
 	std::string user;
-	std::string password;
+	std::optional<std::string> password;
+	// token based auth
+	std::optional<std::string> token;
+	std::optional<std::string> salt;
 	ClientVersion version;
 };
 
@@ -149,26 +164,44 @@ getClientInfo(const Wt::Http::ParameterMap& parameters)
 		throw ServerMustUpgradeError {};
 	if (res.version.major < API_VERSION_MAJOR)
 		throw ClientMustUpgradeError {};
-	if (res.version.minor > Response::getAPIMinorVersion(res.name))
+	if (res.version.minor > API_VERSION_MINOR)
 		throw ServerMustUpgradeError {};
 
 	res.user = getMandatoryParameterAs<std::string>(parameters, "u");
-	res.password = decodePasswordIfNeeded(getMandatoryParameterAs<std::string>(parameters, "p"));
+
+	// Prefer token based auth (t=md5(apiKey + s))
+	// Clear text passwords are still accepted whatever the client version, as some clients (Audinaut, Sublime Music...) keep on using them
+	res.token = getParameterAs<std::string>(parameters, "t");
+	res.salt = getParameterAs<std::string>(parameters, "s");
+	if (res.token || res.salt)
+	{
+		if (!res.token)
+			throw RequiredParameterMissingError {"t"};
+		if (!res.salt)
+			throw RequiredParameterMissingError {"s"};
+	}
+	else
+		res.password = decodePasswordIfNeeded(getMandatoryParameterAs<std::string>(parameters, "p"));
 
 	return res;
 }
 
 SubsonicResource::SubsonicResource(Db& db)
 : _db {db}
+, _responseCache {std::make_unique<ResponseCache>(Service<IConfig>::get()->getULong("api-subsonic-response-cache-size", 30) * 1000 * 1000)}
+, _cursorCache {std::make_unique<CursorCache>(1000)}
+, _userContextCache {std::make_unique<UserContextCache>(100)}
 {
 }
 
+SubsonicResource::~SubsonicResource() = default;
+
 static
 std::string parameterMapToDebugString(const Wt::Http::ParameterMap& parameterMap)
 {
 	auto censorValue = [](const std::string& type, const std::string& value) -> std::string
 	{
-		if (type == "p" || type == "password")
+		if (type == "p" || type == "password" || type == "t")
 			return "*SENSIBLE DATA*";
 		else
 			return value;
@@ -232,25 +265,23 @@ getArtistNames(const std::vector<Artist::pointer>& artists)
 
 static
 std::string
-getTrackPath(const Track::pointer& track)
+getTrackPath(const Track::pointer& track, const ResponseBatch& batch)
 {
 	std::string path;
 
 	// The track path has to be relative from the root
 
-	const auto release {track->getRelease()};
+	const Release::pointer release {batch.getTrackRelease(track)};
 	if (release)
 	{
-		auto artists {release->getReleaseArtists()};
-		if (artists.empty())
-			artists = release->getArtists();
+		const std::vector<Artist::pointer>& artists {batch.getReleaseArtists(release)};
 
 		if (artists.size() > 1)
 			path = "Various Artists/";
 		else if (artists.size() == 1)
 			path = makeNameFilesystemCompatible(artists.front()->getName()) + "/";
 
-		path += makeNameFilesystemCompatible(track->getRelease()->getName()) + "/";
+		path += makeNameFilesystemCompatible(release->getName()) + "/";
 	}
 
 	if (track->getDiscNumber())
@@ -282,10 +313,32 @@ formatToSuffix(AudioFormat format)
 	return "";
 }
 
+static
+std::string_view
+codecToContentType(std::string_view codec)
+{
+	static const std::unordered_map<std::string_view, std::string_view> codecContentTypes
+	{
+		{"mp3",		"audio/mpeg"},
+		{"flac",	"audio/flac"},
+		{"vorbis",	"audio/ogg"},
+		{"opus",	"audio/ogg"},
+		{"aac",		"audio/mp4"},
+		{"alac",	"audio/mp4"},
+		{"mpc",		"audio/x-musepack"},
+		{"wavpack",	"audio/x-wavpack"},
+		{"wma",		"audio/x-ms-wma"},
+	};
+
+	auto it {codecContentTypes.find(codec)};
+	return it != std::cend(codecContentTypes) ? it->second : "";
+}
+
 static
 Response::Node
-trackToResponseNode(const Track::pointer& track, Session& dbSession, const User::pointer& user)
+trackToResponseNode(const Track::pointer& track, const ResponseBatch& batch)
 {
+	const User::pointer& user {batch.getUser()};
 	Response::Node trackResponse;
 
 	trackResponse.setAttribute("id", IdToString({Id::Type::Track, track.id()}));
@@ -298,13 +351,9 @@ trackToResponseNode(const Track::pointer& track, Session& dbSession, const User:
 	if (track->getYear())
 		trackResponse.setAttribute("year", *track->getYear());
 
-	trackResponse.setAttribute("path", getTrackPath(track));
-	{
-		std::error_code ec;
-		const auto fileSize {std::filesystem::file_size(track->getPath(), ec)};
-		if (!ec)
-			trackResponse.setAttribute("size", fileSize);
-	}
+	trackResponse.setAttribute("path", getTrackPath(track, batch));
+	if (const auto fileSize {track->getFileSize()})
+		trackResponse.setAttribute("size", *fileSize);
 
 	if (track->getPath().has_extension())
 	{
@@ -312,13 +361,21 @@ trackToResponseNode(const Track::pointer& track, Session& dbSession, const User:
 		trackResponse.setAttribute("suffix", extension.string().substr(1));
 	}
 
+	if (const auto codec {track->getCodec()})
+	{
+		const std::string_view contentType {codecToContentType(*codec)};
+		if (!contentType.empty())
+			trackResponse.setAttribute("contentType", contentType);
+	}
+	if (const auto bitrate {track->getBitrate()})
+		trackResponse.setAttribute("bitRate", *bitrate / 1000);
+
 	if (user->getSubsonicTranscodeEnable())
 		trackResponse.setAttribute("transcodedSuffix", formatToSuffix(user->getSubsonicTranscodeFormat()));
 
 	trackResponse.setAttribute("coverArt", IdToString({Id::Type::Track, track.id()}));
 
-	const std::vector<Artist::pointer>& artists {track->getArtists({TrackArtistLinkType::Artist})};
-	LMS_LOG(API_SUBSONIC, DEBUG) << "Artists count = " << artists.size();
+	const std::vector<Artist::pointer>& artists {batch.getTrackArtists(track)};
 	if (!artists.empty())
 	{
 		trackResponse.setAttribute("artist", getArtistNames(artists));
@@ -327,27 +384,22 @@ trackToResponseNode(const Track::pointer& track, Session& dbSession, const User:
 			trackResponse.setAttribute("artistId", IdToString({Id::Type::Artist, artists.front().id()}));
 	}
 
-	if (track->getRelease())
+	if (const Release::pointer release {batch.getTrackRelease(track)})
 	{
-		trackResponse.setAttribute("album", track->getRelease()->getName());
-		trackResponse.setAttribute("albumId", IdToString({Id::Type::Release, track->getRelease().id()}));
-		trackResponse.setAttribute("parent", IdToString({Id::Type::Release, track->getRelease().id()}));
+		trackResponse.setAttribute("album", release->getName());
+		trackResponse.setAttribute("albumId", IdToString({Id::Type::Release, release.id()}));
+		trackResponse.setAttribute("parent", IdToString({Id::Type::Release, release.id()}));
 	}
 
 	trackResponse.setAttribute("duration", std::chrono::duration_cast<std::chrono::seconds>(track->getDuration()).count());
 	trackResponse.setAttribute("type", "music");
 
-	if (user->hasStarredTrack(track))
+	if (batch.isTrackStarred(track))
 		trackResponse.setAttribute("starred", reportedStarredDate);
 
 	// Report the first GENRE for this track
-	ClusterType::pointer clusterType {ClusterType::getByName(dbSession, genreClusterName)};
-	if (clusterType)
-	{
-		auto clusters {track->getClusterGroups({clusterType}, 1)};
-		if (!clusters.empty() && !clusters.front().empty())
-			trackResponse.setAttribute("genre", clusters.front().front()->getName());
-	}
+	if (const auto genre {batch.getTrackGenre(track)})
+		trackResponse.setAttribute("genre", *genre);
 
 	return trackResponse;
 }
@@ -370,15 +422,17 @@ trackBookmarkToResponseNode(const TrackBookmark::pointer& trackBookmark)
 
 static
 Response::Node
-releaseToResponseNode(const Release::pointer& release, Session& dbSession, const User::pointer& user, bool id3)
+releaseToResponseNode(const Release::pointer& release, const ResponseBatch& batch, bool id3)
 {
 	Response::Node albumNode;
 
+	const ReleaseSummary::pointer& summary {batch.getReleaseSummary(release)};
+
 	if (id3)
 	{
 		albumNode.setAttribute("name", release->getName());
-		albumNode.setAttribute("songCount", release->getTracksCount());
-		albumNode.setAttribute("duration", std::chrono::duration_cast<std::chrono::seconds>(release->getDuration()).count());
+		albumNode.setAttribute("songCount", summary->getTracksCount());
+		albumNode.setAttribute("duration", std::chrono::duration_cast<std::chrono::seconds>(summary->getDuration()).count());
 	}
 	else
 	{
@@ -387,7 +441,7 @@ releaseToResponseNode(const Release::pointer& release, Session& dbSession, const
 	}
 
 	{
-		std::time_t t {release->getLastWritten().toTime_t()};
+		std::time_t t {summary->getLastWritten().toTime_t()};
 		std::tm gmTime;
 		std::ostringstream oss; oss << std::put_time(::gmtime_r(&t, &gmTime), "%FT%T");
 		albumNode.setAttribute("created", oss.str());
@@ -395,13 +449,11 @@ releaseToResponseNode(const Release::pointer& release, Session& dbSession, const
 
 	albumNode.setAttribute("id", IdToString({Id::Type::Release, release.id()}));
 	albumNode.setAttribute("coverArt", IdToString({Id::Type::Release, release.id()}));
-	auto releaseYear {release->getReleaseYear()};
+	auto releaseYear {summary->getReleaseYear()};
 	if (releaseYear)
 		albumNode.setAttribute("year", *releaseYear);
 
-	auto artists {release->getReleaseArtists()};
-	if (artists.empty())
-		artists = release->getArtists();
+	const std::vector<Artist::pointer>& artists {batch.getReleaseArtists(release)};
 
 	if (artists.empty() && !id3)
 	{
@@ -427,17 +479,12 @@ releaseToResponseNode(const Release::pointer& release, Session& dbSession, const
 
 	if (id3)
 	{
-		// Report the first GENRE for this track
-		ClusterType::pointer clusterType {ClusterType::getByName(dbSession, genreClusterName)};
-		if (clusterType)
-		{
-			auto clusters {release->getClusterGroups({clusterType}, 1)};
-			if (!clusters.empty() && !clusters.front().empty())
-				albumNode.setAttribute("genre", clusters.front().front()->getName());
-		}
+		// Report the first GENRE for this release
+		if (const auto genre {summary->getGenre()})
+			albumNode.setAttribute("genre", *genre);
 	}
 
-	if (user->hasStarredRelease(release))
+	if (batch.isReleaseStarred(release))
 		albumNode.setAttribute("starred", reportedStarredDate);
 
 	return albumNode;
@@ -445,7 +492,7 @@ releaseToResponseNode(const Release::pointer& release, Session& dbSession, const
 
 static
 Response::Node
-artistToResponseNode(const User::pointer& user, const Artist::pointer& artist, bool id3)
+artistToResponseNode(const Artist::pointer& artist, const ResponseBatch& batch, bool id3)
 {
 	Response::Node artistNode;
 
@@ -453,9 +500,9 @@ artistToResponseNode(const User::pointer& user, const Artist::pointer& artist, b
 	artistNode.setAttribute("name", artist->getName());
 
 	if (id3)
-		artistNode.setAttribute("albumCount", artist->getReleaseCount());
+		artistNode.setAttribute("albumCount", batch.getArtistSummary(artist)->getReleaseCount());
 
-	if (user->hasStarredArtist(artist))
+	if (batch.isArtistStarred(artist))
 		artistNode.setAttribute("starred", reportedStarredDate);
 
 	return artistNode;
@@ -530,6 +577,7 @@ handleChangePassword(RequestContext& context)
 
 	user.modify()->setPasswordHash(hash);
 	user.modify()->clearAuthTokens();
+	Service<Auth::IPasswordService>::get()->clearCachedPasswords(username);
 
 	return Response::createOkResponse(context);
 }
@@ -586,6 +634,8 @@ handleCreatePlaylistRequest(RequestContext& context)
 		TrackListEntry::create(context.dbSession, track, tracklist );
 	}
 
+	context.dbSession.bumpUserGeneration(user.id());
+
 	return Response::createOkResponse(context);
 }
 
@@ -638,6 +688,8 @@ handleDeletePlaylistRequest(RequestContext& context)
 
 	tracklist.remove();
 
+	context.dbSession.bumpUserGeneration(user.id());
+
 	return Response::createOkResponse(context);
 }
 
@@ -658,6 +710,7 @@ handleDeleteUserRequest(RequestContext& context)
 		throw RequestedDataNotFoundError {};
 
 	user.remove();
+	Service<Auth::IPasswordService>::get()->clearCachedPasswords(username);
 
 	return Response::createOkResponse(context);
 }
@@ -694,13 +747,57 @@ handleGetRandomSongsRequest(RequestContext& context)
 
 	Response response {Response::createOkResponse(context)};
 
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addTracks(tracks);
+
 	Response::Node& randomSongsNode {response.createNode("randomSongs")};
 	for (const Track::pointer& track : tracks)
-		randomSongsNode.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+		randomSongsNode.addArrayChild("song", trackToResponseNode(track, batch));
 
 	return response;
 }
 
+// Get a page of entries, starting right after the last entry of the previous page if it is known
+// getEntries is called either with a KeysetRange or with a Range and must return the entries in the same order in both cases
+// getKey must return the keyset key of an entry, as computed by getEntries
+template <typename GetEntriesFunc, typename GetKeyFunc>
+static
+auto
+getPage(const RequestContext& context, const std::string& query, std::size_t offset, std::size_t size, GetEntriesFunc getEntries, GetKeyFunc getKey)
+{
+	bool more {};
+
+	KeysetRange keysetRange;
+	keysetRange.limit = size;
+	if (offset > 0)
+		keysetRange.after = context.cursorCache.get(context.libraryGeneration, query, offset);
+
+	if (offset > 0 && !keysetRange.after)
+	{
+		Range range {offset, size};
+		auto entries {getEntries(range, more)};
+
+		// Next page can use the keyset query
+		if (!entries.empty())
+			context.cursorCache.put(context.libraryGeneration, query, offset + entries.size(), getKey(entries.back()));
+
+		return entries;
+	}
+
+	auto entries {getEntries(keysetRange, more)};
+	if (!entries.empty() && keysetRange.after)
+		context.cursorCache.put(context.libraryGeneration, query, offset + entries.size(), *keysetRange.after);
+
+	return entries;
+}
+
+static
+KeysetRange::Key
+getReleaseKeysetKey(const Release::pointer& release)
+{
+	return {release->getName(), release.id()};
+}
+
 static
 Response
 handleGetAlbumListRequestCommon(const RequestContext& context, bool id3)
@@ -724,7 +821,10 @@ handleGetAlbumListRequestCommon(const RequestContext& context, bool id3)
 
 	if (type == "alphabeticalByName")
 	{
-		releases = Release::getAll(context.dbSession, range);
+		releases = getPage(context, "albumList:alphabeticalByName", offset, size, [&](auto& pageRange, bool& more)
+		{
+			return Release::getByFilter(context.dbSession, {}, {}, pageRange, more);
+		}, getReleaseKeysetKey);
 	}
 	else if (type == "alphabeticalByArtist")
 	{
@@ -756,7 +856,7 @@ handleGetAlbumListRequestCommon(const RequestContext& context, bool id3)
 	else if (type == "frequent")
 	{
 		bool moreResults {};
-		releases = user->getPlayedTrackList(context.dbSession)->getTopReleases({}, range, moreResults);
+		releases = TrackPlayStats::getTopReleases(context.dbSession, user.id(), {}, range, moreResults);
 	}
 	else if (type == "newest")
 	{
@@ -771,7 +871,7 @@ handleGetAlbumListRequestCommon(const RequestContext& context, bool id3)
 	else if (type == "recent")
 	{
 		bool moreResults {};
-		releases = user->getPlayedTrackList(context.dbSession)->getReleasesReverse({}, range, moreResults);
+		releases = TrackPlayStats::getRecentReleases(context.dbSession, user.id(), {}, range, moreResults);
 	}
 	else if (type == "starred")
 	{
@@ -784,8 +884,11 @@ handleGetAlbumListRequestCommon(const RequestContext& context, bool id3)
 	Response response {Response::createOkResponse(context)};
 	Response::Node& albumListNode {response.createNode(id3 ? "albumList2" : "albumList")};
 
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addReleases(releases);
+
 	for (const Release::pointer& release : releases)
-		albumListNode.addArrayChild("album", releaseToResponseNode(release, context.dbSession, user, id3));
+		albumListNode.addArrayChild("album", releaseToResponseNode(release, batch, id3));
 
 	return response;
 }
@@ -824,12 +927,17 @@ handleGetAlbumRequest(RequestContext& context)
 	if (!user)
 		throw UserNotAuthorizedError {};
 
+	auto tracks {release->getTracks()};
+
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addReleases({release});
+	batch.addTracks(tracks);
+
 	Response response {Response::createOkResponse(context)};
-	Response::Node releaseNode {releaseToResponseNode(release, context.dbSession, user, true /* id3 */)};
+	Response::Node releaseNode {releaseToResponseNode(release, batch, true /* id3 */)};
 
-	auto tracks {release->getTracks()};
 	for (const Track::pointer& track : tracks)
-		releaseNode.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+		releaseNode.addArrayChild("song", trackToResponseNode(track, batch));
 
 	response.addNode("album", std::move(releaseNode));
 
@@ -856,12 +964,17 @@ handleGetArtistRequest(RequestContext& context)
 	if (!user)
 		throw UserNotAuthorizedError {};
 
+	auto releases {artist->getReleases()};
+
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addArtists({artist});
+	batch.addReleases(releases);
+
 	Response response {Response::createOkResponse(context)};
-	Response::Node artistNode {artistToResponseNode(user, artist, true /* id3 */)};
+	Response::Node artistNode {artistToResponseNode(artist, batch, true /* id3 */)};
 
-	auto releases {artist->getReleases()};
 	for (const Release::pointer& release : releases)
-		artistNode.addArrayChild("album", releaseToResponseNode(release, context.dbSession, user, true /* id3 */));
+		artistNode.addArrayChild("album", releaseToResponseNode(release, batch, true /* id3 */));
 
 	response.addNode("artist", std::move(artistNode));
 
@@ -907,12 +1020,13 @@ handleGetArtistInfoRequestCommon(RequestContext& context, bool id3)
 		if (!user)
 			throw UserNotAuthorizedError {};
 
-		for ( const auto& similarArtistId : similarArtistsId )
-		{
-			Artist::pointer similarArtist {Artist::getById(context.dbSession, similarArtistId)};
-			if (similarArtist)
-				artistInfoNode.addArrayChild("similarArtist", artistToResponseNode(user, similarArtist, id3));
-		}
+		const std::vector<Artist::pointer> similarArtists {Artist::getByIds(context.dbSession, std::vector<IdType>(std::cbegin(similarArtistsId), std::cend(similarArtistsId)))};
+
+		ResponseBatch batch {context.dbSession, user, *context.userContext};
+		batch.addArtists(similarArtists);
+
+		for (const Artist::pointer& similarArtist : similarArtists)
+			artistInfoNode.addArrayChild("similarArtist", artistToResponseNode(similarArtist, batch, id3));
 	}
 
 	return response;
@@ -932,6 +1046,69 @@ handleGetArtistInfo2Request(RequestContext& context)
 	return handleGetArtistInfoRequestCommon(context, true /* id3 */);
 }
 
+static
+std::optional<TrackArtistLinkType>
+getArtistListLinkType(const User::pointer& user)
+{
+	switch (user->getSubsonicArtistListMode())
+	{
+		case User::SubsonicArtistListMode::AllArtists:
+			break;
+		case User::SubsonicArtistListMode::ReleaseArtists:
+			return TrackArtistLinkType::ReleaseArtist;
+		case User::SubsonicArtistListMode::TrackArtists:
+			return TrackArtistLinkType::Artist;
+	}
+
+	return std::nullopt;
+}
+
+// The whole artist list may be huge: artists are fetched and serialized by chunks while the response is written
+// This avoids building the node tree, but the serialized body is still held in memory by Wt until the request completes
+static
+void
+addArtistNodesGenerator(RequestContext& context, Response::Node& indexNode, std::optional<TrackArtistLinkType> linkType, bool id3)
+{
+	indexNode.addArrayChildGenerator("artist", [&context, linkType, id3](const Response::Node::ArrayChildConsumer& addArtistNode)
+	{
+		static constexpr std::size_t chunkSize {500};
+
+		auto transaction {context.dbSession.createSharedTransaction()};
+
+		const User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
+		if (!user)
+			return;
+
+		KeysetRange range;
+		range.limit = chunkSize;
+		bool more {true};
+		while (more)
+		{
+			const std::vector<Artist::pointer> artists {Artist::getByFilter(context.dbSession,
+					{},
+					{},
+					linkType,
+					Artist::SortMethod::BySortName,
+					range, more)};
+
+			ResponseBatch batch {context.dbSession, user, *context.userContext};
+			batch.addArtists(artists);
+
+			for (const Artist::pointer& artist : artists)
+				addArtistNode(artistToResponseNode(artist, batch, id3));
+		}
+	});
+}
+
+// Listings depend on both the library and the user data (stars, settings)
+// Generations are timestamps, usable as modification dates
+static
+std::uint64_t
+getLastModified(const RequestContext& context)
+{
+	return std::max(context.libraryGeneration, context.userContext->getUserGeneration());
+}
+
 static
 Response
 handleGetArtistsRequest(RequestContext& context)
@@ -940,39 +1117,23 @@ handleGetArtistsRequest(RequestContext& context)
 
 	Response::Node& artistsNode {response.createNode("artists")};
 	artistsNode.setAttribute("ignoredArticles", "");
-	artistsNode.setAttribute("lastModified", reportedDummyDateULong);
+	artistsNode.setAttribute("lastModified", getLastModified(context));
 
 	Response::Node& indexNode {artistsNode.createArrayChild("index")};
 	indexNode.setAttribute("name", "?");
 
-	auto transaction {context.dbSession.createSharedTransaction()};
-
-	User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
-	if (!user)
-		throw UserNotAuthorizedError {};
-
 	std::optional<TrackArtistLinkType> linkType;
-	switch (user->getSubsonicArtistListMode())
 	{
-		case User::SubsonicArtistListMode::AllArtists:
-			break;
-		case User::SubsonicArtistListMode::ReleaseArtists:
-			linkType = TrackArtistLinkType::ReleaseArtist;
-			break;
-		case User::SubsonicArtistListMode::TrackArtists:
-			linkType = TrackArtistLinkType::Artist;
-			break;
+		auto transaction {context.dbSession.createSharedTransaction()};
+
+		User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
+		if (!user)
+			throw UserNotAuthorizedError {};
+
+		linkType = getArtistListLinkType(user);
 	}
 
-	bool more {};
-	const std::vector<Artist::pointer> artists {Artist::getByFilter(context.dbSession,
-			{},
-			{},
-			linkType,
-			Artist::SortMethod::BySortName,
-			std::nullopt, more)};
-	for (const Artist::pointer& artist : artists)
-		indexNode.addArrayChild("artist", artistToResponseNode(user, artist, true /* id3 */));
+	addArtistNodesGenerator(context, indexNode, linkType, true /* id3 */);
 
 	return response;
 }
@@ -995,6 +1156,8 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 	if (!user)
 		throw UserNotAuthorizedError {};
 
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+
 	switch (id.type)
 	{
 		case Id::Type::Root:
@@ -1003,8 +1166,9 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 
 			bool moreResults{};
 			auto artists {Artist::getAll(context.dbSession, Artist::SortMethod::BySortName, std::nullopt, moreResults)};
+			batch.addArtists(artists);
 			for (const Artist::pointer& artist : artists)
-				directoryNode.addArrayChild("child", artistToResponseNode(user, artist, false /* no id3 */));
+				directoryNode.addArrayChild("child", artistToResponseNode(artist, batch, false /* no id3 */));
 
 			break;
 		}
@@ -1018,8 +1182,9 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 			directoryNode.setAttribute("name", makeNameFilesystemCompatible(artist->getName()));
 
 			auto releases {artist->getReleases()};
+			batch.addReleases(releases);
 			for (const Release::pointer& release : releases)
-				directoryNode.addArrayChild("child", releaseToResponseNode(release, context.dbSession, user, false /* no id3 */));
+				directoryNode.addArrayChild("child", releaseToResponseNode(release, batch, false /* no id3 */));
 
 			break;
 		}
@@ -1033,8 +1198,9 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 			directoryNode.setAttribute("name", makeNameFilesystemCompatible(release->getName()));
 
 			auto tracks {release->getTracks()};
+			batch.addTracks(tracks);
 			for (const Track::pointer& track : tracks)
-				directoryNode.addArrayChild("child", trackToResponseNode(track, context.dbSession, user));
+				directoryNode.addArrayChild("child", trackToResponseNode(track, batch));
 
 			break;
 		}
@@ -1088,41 +1254,32 @@ handleGetIndexesRequest(RequestContext& context)
 {
 	Response response {Response::createOkResponse(context)};
 
+	// Optional params
+	const std::optional<unsigned long long> ifModifiedSince {getParameterAs<unsigned long long>(context.parameters, "ifModifiedSince")};
+
 	Response::Node& artistsNode {response.createNode("indexes")};
 	artistsNode.setAttribute("ignoredArticles", "");
-	artistsNode.setAttribute("lastModified", reportedDummyDateULong);
+	const std::uint64_t lastModified {getLastModified(context)};
+	artistsNode.setAttribute("lastModified", lastModified);
+
+	if (ifModifiedSince && *ifModifiedSince >= lastModified)
+		return response;
 
 	Response::Node& indexNode {artistsNode.createArrayChild("index")};
 	indexNode.setAttribute("name", "?");
 
-	auto transaction {context.dbSession.createSharedTransaction()};
-
-	User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
-	if (!user)
-		throw UserNotAuthorizedError {};
-
 	std::optional<TrackArtistLinkType> linkType;
-	switch (user->getSubsonicArtistListMode())
 	{
-		case User::SubsonicArtistListMode::AllArtists:
-			break;
-		case User::SubsonicArtistListMode::ReleaseArtists:
-			linkType = TrackArtistLinkType::ReleaseArtist;
-			break;
-		case User::SubsonicArtistListMode::TrackArtists:
-			linkType = TrackArtistLinkType::Artist;
-			break;
+		auto transaction {context.dbSession.createSharedTransaction()};
+
+		User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
+		if (!user)
+			throw UserNotAuthorizedError {};
+
+		linkType = getArtistListLinkType(user);
 	}
 
-	bool more {};
-	const std::vector<Artist::pointer> artists {Artist::getByFilter(context.dbSession,
-			{},
-			{},
-			linkType,
-			Artist::SortMethod::BySortName,
-			std::nullopt, more)};
-	for (const Artist::pointer& artist : artists)
-		indexNode.addArrayChild("artist", artistToResponseNode(user, artist, false /* no id3 */));
+	addArtistNodesGenerator(context, indexNode, linkType, false /* no id3 */);
 
 	return response;
 }
@@ -1173,8 +1330,12 @@ handleGetSimilarSongsRequestCommon(RequestContext& context, bool id3)
 
 	Response response {Response::createOkResponse(context)};
 	Response::Node& similarSongsNode {response.createNode(id3 ? "similarSongs2" : "similarSongs")};
+
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addTracks(tracks);
+
 	for (const Track::pointer& track : tracks)
-		similarSongsNode.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+		similarSongsNode.addArrayChild("song", trackToResponseNode(track, batch));
 
 	return response;
 }
@@ -1206,25 +1367,30 @@ handleGetStarredRequestCommon(RequestContext& context, bool id3)
 	Response response {Response::createOkResponse(context)};
 	Response::Node& starredNode {response.createNode(id3 ? "starred2" : "starred")};
 
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+
 	{
 		bool moreResults {};
 		const auto artists {Artist::getStarred(context.dbSession, user, {}, std::nullopt, Artist::SortMethod::BySortName, std::nullopt, moreResults)};
+		batch.addArtists(artists);
 		for (const Artist::pointer& artist : artists)
-			starredNode.addArrayChild("artist", artistToResponseNode(user, artist, id3));
+			starredNode.addArrayChild("artist", artistToResponseNode(artist, batch, id3));
 	}
 
 	{
 		bool moreResults {};
 		const auto releases {Release::getStarred(context.dbSession, user, {}, std::nullopt, moreResults)};
+		batch.addReleases(releases);
 		for (const Release::pointer& release : releases)
-			starredNode.addArrayChild("album", releaseToResponseNode(release, context.dbSession, user, id3));
+			starredNode.addArrayChild("album", releaseToResponseNode(release, batch, id3));
 	}
 
 	{
 		bool moreResults {};
 		const auto tracks {Track::getStarred(context.dbSession, user, {}, std::nullopt, moreResults)};
+		batch.addTracks(tracks);
 		for (const Track::pointer& track : tracks)
-			starredNode.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+			starredNode.addArrayChild("song", trackToResponseNode(track, batch));
 	}
 
 	return response;
@@ -1284,9 +1450,30 @@ handleGetPlaylistRequest(RequestContext& context)
 	Response response {Response::createOkResponse(context)};
 	Response::Node playlistNode {tracklistToResponseNode(tracklist, context.dbSession)};
 
-	auto entries {tracklist->getEntries()};
-	for (const TrackListEntry::pointer& entry : entries)
-		playlistNode.addArrayChild("entry", trackToResponseNode(entry->getTrack(), context.dbSession, user));
+	// Loaded all at once, in entry order
+	std::vector<Track::pointer> tracks;
+	{
+		const std::vector<IdType> trackIds {tracklist->getTrackIds()};
+		const std::vector<Track::pointer> uniqueTracks {Track::getByIds(context.dbSession, trackIds)};
+
+		std::unordered_map<IdType, Track::pointer> tracksById;
+		for (const Track::pointer& track : uniqueTracks)
+			tracksById.emplace(track.id(), track);
+
+		tracks.reserve(trackIds.size());
+		for (const IdType trackId : trackIds)
+		{
+			auto itTrack {tracksById.find(trackId)};
+			if (itTrack != std::cend(tracksById))
+				tracks.push_back(itTrack->second);
+		}
+	}
+
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addTracks(tracks);
+
+	for (const Track::pointer& track : tracks)
+		playlistNode.addArrayChild("entry", trackToResponseNode(track, batch));
 
 	response.addNode("playlist", playlistNode );
 
@@ -1345,8 +1532,12 @@ handleGetSongsByGenreRequest(RequestContext& context)
 
 	bool more;
 	auto tracks {Track::getByFilter(context.dbSession, {cluster.id()}, {}, Range {offset, size}, more)};
+
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	batch.addTracks(tracks);
+
 	for (const Track::pointer& track : tracks)
-		songsByGenreNode.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+		songsByGenreNode.addArrayChild("song", trackToResponseNode(track, batch));
 
 	return response;
 }
@@ -1413,23 +1604,36 @@ handleSearchRequestCommon(RequestContext& context, bool id3)
 	Response response {Response::createOkResponse(context)};
 	Response::Node& searchResult2Node {response.createNode(id3 ? "searchResult3" : "searchResult2")};
 
-	bool more;
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+
 	{
-		auto artists {Artist::getByFilter(context.dbSession, {}, keywords, std::nullopt, Artist::SortMethod::BySortName, Range {artistOffset, artistCount}, more)};
+		auto artists {getPage(context, "search:artist:" + query, artistOffset, artistCount, [&](auto& pageRange, bool& more)
+		{
+			return Artist::getByFilter(context.dbSession, {}, keywords, std::nullopt, Artist::SortMethod::BySortName, pageRange, more);
+		}, [](const Artist::pointer& artist) { return KeysetRange::Key {artist->getSortName(), artist.id()}; })};
+		batch.addArtists(artists);
 		for (const Artist::pointer& artist : artists)
-			searchResult2Node.addArrayChild("artist", artistToResponseNode(user, artist, id3));
+			searchResult2Node.addArrayChild("artist", artistToResponseNode(artist, batch, id3));
 	}
 
 	{
-		auto releases {Release::getByFilter(context.dbSession, {}, keywords, Range {albumOffset, albumCount}, more)};
+		auto releases {getPage(context, "search:album:" + query, albumOffset, albumCount, [&](auto& pageRange, bool& more)
+		{
+			return Release::getByFilter(context.dbSession, {}, keywords, pageRange, more);
+		}, getReleaseKeysetKey)};
+		batch.addReleases(releases);
 		for (const Release::pointer& release : releases)
-			searchResult2Node.addArrayChild("album", releaseToResponseNode(release, context.dbSession, user, id3));
+			searchResult2Node.addArrayChild("album", releaseToResponseNode(release, batch, id3));
 	}
 
 	{
-		auto tracks {Track::getByFilter(context.dbSession, {}, keywords, Range {songOffset, songCount}, more)};
+		auto tracks {getPage(context, "search:song:" + query, songOffset, songCount, [&](auto& pageRange, bool& more)
+		{
+			return Track::getByFilter(context.dbSession, {}, keywords, pageRange, more);
+		}, [](const Track::pointer& track) { return KeysetRange::Key {{}, track.id()}; })};
+		batch.addTracks(tracks);
 		for (const Track::pointer& track : tracks)
-			searchResult2Node.addArrayChild("song", trackToResponseNode(track, context.dbSession, user));
+			searchResult2Node.addArrayChild("song", trackToResponseNode(track, batch));
 	}
 
 	return response;
@@ -1486,7 +1690,7 @@ handleStarRequest(RequestContext& context)
 {
 	StarParameters params {getStarParameters(context.parameters)};
 
-	auto transaction {context.dbSession.createSharedTransaction()};
+	auto transaction {context.dbSession.createUniqueTransaction()};
 
 	User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
 	if (!user)
@@ -1519,6 +1723,8 @@ handleStarRequest(RequestContext& context)
 		user.modify()->starTrack(track);
 	}
 
+	context.dbSession.bumpUserGeneration(user.id());
+
 	return Response::createOkResponse(context);
 }
 
@@ -1542,7 +1748,7 @@ handleUnstarRequest(RequestContext& context)
 {
 	StarParameters params {getStarParameters(context.parameters)};
 
-	auto transaction {context.dbSession.createSharedTransaction()};
+	auto transaction {context.dbSession.createUniqueTransaction()};
 
 	User::pointer user {User::getByLoginName(context.dbSession, context.userName)};
 	if (!user)
@@ -1575,6 +1781,7 @@ handleUnstarRequest(RequestContext& context)
 		user.modify()->unstarTrack(track);
 	}
 
+	context.dbSession.bumpUserGeneration(user.id());
 
 	return Response::createOkResponse(context);
 }
@@ -1601,7 +1808,7 @@ handleScrobble(RequestContext& context)
 		if (!track)
 			continue;
 
-		TrackListEntry::create(context.dbSession, track, user->getPlayedTrackList(context.dbSession));
+		user->addPlayedTrack(context.dbSession, track);
 	}
 
 	return Response::createOkResponse(context);
@@ -1634,6 +1841,7 @@ handleUpdateUserRequest(RequestContext& context)
 	{
 		user.modify()->setPasswordHash(hash);
 		user.modify()->clearAuthTokens();
+		Service<Auth::IPasswordService>::get()->clearCachedPasswords(username);
 	}
 
 	return Response::createOkResponse(context);
@@ -1700,6 +1908,8 @@ handleUpdatePlaylistRequest(RequestContext& context)
 		TrackListEntry::create(context.dbSession, track, tracklist );
 	}
 
+	context.dbSession.bumpUserGeneration(user.id());
+
 	return Response::createOkResponse(context);
 }
 
@@ -1715,13 +1925,23 @@ handleGetBookmarks(RequestContext& context)
 
 	const auto bookmarks {TrackBookmark::getByUser(context.dbSession, user)};
 
+	ResponseBatch batch {context.dbSession, user, *context.userContext};
+	{
+		std::vector<IdType> trackIds;
+		trackIds.reserve(bookmarks.size());
+		for (const TrackBookmark::pointer& bookmark : bookmarks)
+			trackIds.push_back(bookmark->getTrack().id());
+
+		batch.addTracks(Track::getByIds(context.dbSession, trackIds));
+	}
+
 	Response response {Response::createOkResponse(context)};
 	Response::Node& bookmarksNode {response.createNode("bookmarks")};
 
 	for (const TrackBookmark::pointer& bookmark : bookmarks)
 	{
 		Response::Node bookmarkNode {trackBookmarkToResponseNode(bookmark)};
-		bookmarkNode.addArrayChild("entry", trackToResponseNode(bookmark->getTrack(), context.dbSession, user));
+		bookmarkNode.addArrayChild("entry", trackToResponseNode(bookmark->getTrack(), batch));
 
 		bookmarksNode.addArrayChild("bookmark", std::move(bookmarkNode));
 	}
@@ -1826,12 +2046,32 @@ handleGetCoverArt(RequestContext& context, const Wt::Http::Request& /*request*/,
 }
 
 using RequestHandlerFunc = std::function<Response(RequestContext& context)>;
+// Tells if the response only depends on the library generation, the user and the request parameters
+// Such responses can be cached and revalidated using the generation
+using GenerationDependentFunc = bool(*)(const Wt::Http::ParameterMap& parameters);
 struct RequestEntryPointInfo
 {
 	RequestHandlerFunc	func;
 	bool			mustBeAdmin;
+	GenerationDependentFunc	isGenerationDependent {};
 };
 
+static
+bool
+alwaysGenerationDependent(const Wt::Http::ParameterMap&)
+{
+	return true;
+}
+
+static
+bool
+isGenerationDependentAlbumList(const Wt::Http::ParameterMap& parameters)
+{
+	// other types depend on the play history or are random
+	const std::optional<std::string> type {getParameterAs<std::string>(parameters, "type")};
+	return type == "alphabeticalByName" || type == "alphabeticalByArtist" || type == "byGenre" || type == "byYear";
+}
+
 static std::unordered_map<std::string, RequestEntryPointInfo> requestEntryPoints
 {
 	// System
@@ -1840,10 +2080,10 @@ static std::unordered_map<std::string, RequestEntryPointInfo> requestEntryPoints
 
 	// Browsing
 	{"getMusicFolders",	{handleGetMusicFoldersRequest,		false}},
-	{"getIndexes",		{handleGetIndexesRequest,		false}},
+	{"getIndexes",		{handleGetIndexesRequest,		false,	alwaysGenerationDependent}},
 	{"getMusicDirectory",	{handleGetMusicDirectoryRequest,	false}},
-	{"getGenres",		{handleGetGenresRequest,		false}},
-	{"getArtists",		{handleGetArtistsRequest,		false}},
+	{"getGenres",		{handleGetGenresRequest,		false,	alwaysGenerationDependent}},
+	{"getArtists",		{handleGetArtistsRequest,		false,	alwaysGenerationDependent}},
 	{"getArtist",		{handleGetArtistRequest,		false}},
 	{"getAlbum",		{handleGetAlbumRequest,			false}},
 	{"getSong",		{handleNotImplemented,			false}},
@@ -1857,8 +2097,8 @@ static std::unordered_map<std::string, RequestEntryPointInfo> requestEntryPoints
 	{"getTopSongs",		{handleNotImplemented,			false}},
 
 	// Album/song lists
-	{"getAlbumList",	{handleGetAlbumListRequest,		false}},
-	{"getAlbumList2",	{handleGetAlbumList2Request,		false}},
+	{"getAlbumList",	{handleGetAlbumListRequest,		false,	isGenerationDependentAlbumList}},
+	{"getAlbumList2",	{handleGetAlbumList2Request,		false,	isGenerationDependentAlbumList}},
 	{"getRandomSongs",	{handleGetRandomSongsRequest,		false}},
 	{"getSongsByGenre",	{handleGetSongsByGenreRequest,		false}},
 	{"getNowPlaying",	{handleNotImplemented,			false}},
@@ -1946,6 +2186,111 @@ static std::unordered_map<std::string, MediaRetrievalHandlerFunc> mediaRetrieval
 	{"getCoverArt",		handleGetCoverArt},
 };
 
+static
+std::string
+getResponseCacheKey(std::string_view requestPath, ResponseFormat format, const RequestContext& context)
+{
+	std::string key {requestPath};
+	key += '\n';
+	key += ResponseFormatToMimeType(format);
+	key += '\n';
+	key += context.userName;
+	key += '\n';
+	key += std::to_string(context.userContext->getUserGeneration());
+
+	// Parameters are sorted by name. Credentials are not part of the key: the user name is already there
+	for (const auto& [name, values] : context.parameters)
+	{
+		if (name == "u" || name == "p" || name == "t" || name == "s" || name == "f")
+			continue;
+
+		for (const std::string& value : values)
+		{
+			key += '\n';
+			key += name;
+			key += '=';
+			key += value;
+		}
+	}
+
+	return key;
+}
+
+namespace
+{
+	// Forwards everything to the destination stream and keeps a copy for the response cache
+	// The copy is given up as soon as it would exceed maxCapturedSize
+	class TeeStreamBuf : public std::streambuf
+	{
+		public:
+			TeeStreamBuf(std::ostream& destination, std::size_t maxCapturedSize)
+			: _destination {destination}
+			, _maxCapturedSize {maxCapturedSize}
+			{}
+
+			// empty if the capture was given up
+			std::optional<std::string> releaseCaptured() { return std::move(_captured); }
+
+		private:
+			int_type
+			overflow(int_type c) override
+			{
+				if (traits_type::eq_int_type(c, traits_type::eof()))
+					return traits_type::not_eof(c);
+
+				const char ch {traits_type::to_char_type(c)};
+				return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+			}
+
+			std::streamsize
+			xsputn(const char* s, std::streamsize count) override
+			{
+				if (!_destination.write(s, count))
+					return 0;
+
+				if (_captured)
+				{
+					if (_captured->size() + static_cast<std::size_t>(count) > _maxCapturedSize)
+						_captured.reset();
+					else
+						_captured->append(s, count);
+				}
+
+				return count;
+			}
+
+			std::ostream& _destination;
+			const std::size_t _maxCapturedSize;
+			std::optional<std::string> _captured {std::string {}};
+	};
+}
+
+static
+Metrics::Histogram&
+getRequestTimeHistogram(const std::string& requestPath)
+{
+	auto createHistogram {[](const std::string& endpoint) -> Metrics::Histogram*
+	{
+		return &Metrics::getRegistry().getHistogram("lms_subsonic_request_seconds", "Time spent handling Subsonic API requests", Metrics::getDurationBuckets(), {{"endpoint", endpoint}});
+	}};
+
+	// Only known endpoints get their own histogram, the request path is client provided
+	static const std::unordered_map<std::string, Metrics::Histogram*> histograms {[&]
+	{
+		std::unordered_map<std::string, Metrics::Histogram*> res;
+		for (const auto& [endpoint, entryPoint] : requestEntryPoints)
+			res.emplace(endpoint, createHistogram(endpoint));
+		for (const auto& [endpoint, handler] : mediaRetrievalHandlers)
+			res.emplace(endpoint, createHistogram(endpoint));
+
+		return res;
+	}()};
+	static Metrics::Histogram& unknownEndpointHistogram {*createHistogram("unknown")};
+
+	auto it {histograms.find(requestPath)};
+	return it != std::cend(histograms) ? *it->second : unknownEndpointHistogram;
+}
+
 void
 SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Response &response)
 {
@@ -1959,25 +2304,26 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 	if (StringUtils::stringEndsWith(requestPath, ".view"))
 		requestPath.resize(requestPath.length() - 5);
 
+	Metrics::ScopedTimer requestTimer {getRequestTimeHistogram(requestPath)};
+
 	const Wt::Http::ParameterMap& parameters {request.getParameterMap()};
 
 	// Optional parameters
 	const ResponseFormat format {getParameterAs<std::string>(parameters, "f").value_or("xml") == "json" ? ResponseFormat::json : ResponseFormat::xml};
 
-	std::string clientName;
-
 	try
 	{
 		// Mandatory parameters
 		const ClientInfo clientInfo {getClientInfo(parameters)};
 
-		clientName = clientInfo.name;
-
 		Session& dbSession {_db.getTLSSession()};
 
-		switch (Service<Auth::IPasswordService>::get()->checkUserPassword(dbSession,
-					boost::asio::ip::address::from_string(request.clientAddress()),
-					clientInfo.user, clientInfo.password))
+		const boost::asio::ip::address clientAddress {boost::asio::ip::address::from_string(request.clientAddress())};
+		const Auth::IPasswordService::PasswordCheckResult checkResult {clientInfo.password
+			? Service<Auth::IPasswordService>::get()->checkUserPassword(dbSession, clientAddress, clientInfo.user, *clientInfo.password)
+			: Service<Auth::IPasswordService>::get()->checkUserApiKeyToken(dbSession, clientAddress, clientInfo.user, *clientInfo.token, *clientInfo.salt)};
+
+		switch (checkResult)
 		{
 			case Auth::IPasswordService::PasswordCheckResult::Match:
 				break;
@@ -1987,7 +2333,7 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 				throw LoginThrottledGenericError {};
 		}
 
-		RequestContext requestContext {parameters, dbSession, clientInfo.user, clientInfo.name};
+		RequestContext requestContext {parameters, dbSession, clientInfo.user, clientInfo.name, dbSession.getLibraryGeneration(), *_cursorCache};
 
 		auto itEntryPoint {requestEntryPoints.find(requestPath)};
 		if (itEntryPoint != requestEntryPoints.end())
@@ -2001,9 +2347,61 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 					throw UserNotAuthorizedError {};
 			}
 
-			Response resp {(itEntryPoint->second.func)(requestContext)};
+			requestContext.userContext = _userContextCache->get(dbSession, clientInfo.user);
+			if (!requestContext.userContext)
+				throw UserNotAuthorizedError {};
 
-			resp.write(response.out(), format);
+			if (itEntryPoint->second.isGenerationDependent && itEntryPoint->second.isGenerationDependent(parameters))
+			{
+				// Same URL (including user and format) + same library and user generations => same response
+				const std::string etag {"\"" + std::to_string(requestContext.libraryGeneration) + "-" + std::to_string(requestContext.userContext->getUserGeneration()) + "\""};
+				// Not set on failed responses, they must not be revalidated
+				auto addCacheHeaders {[&]
+				{
+					response.addHeader("ETag", etag);
+					response.addHeader("Cache-Control", "private, no-cache");
+				}};
+
+				if (request.headerValue("If-None-Match") == etag)
+				{
+					response.setStatus(304);
+					addCacheHeaders();
+					LMS_LOG(API_SUBSONIC, DEBUG) << "Request " << requestId << " '" << requestPath << "' not modified";
+					return;
+				}
+
+				const std::string cacheKey {getResponseCacheKey(requestPath, format, requestContext)};
+				if (const ResponseCache::Entry cachedResponse {_responseCache->get(requestContext.libraryGeneration, cacheKey)})
+				{
+					addCacheHeaders();
+					response.out().write(cachedResponse->data(), cachedResponse->size());
+				}
+				else
+				{
+					// Serialize into the response body, the cache entry is filled on the fly (up to the max entry size)
+					TeeStreamBuf teeBuf {response.out(), _responseCache->getMaxEntrySize(cacheKey)};
+					std::ostream teeStream {&teeBuf};
+
+					Response resp {(itEntryPoint->second.func)(requestContext)};
+					const bool isComplete {resp.write(teeStream, format)};
+
+					// Nothing is sent before the end of handleRequest: headers can still be added
+					// Truncated responses must not be revalidated nor cached
+					if (isComplete)
+					{
+						addCacheHeaders();
+
+						std::optional<std::string> serializedResponse {teeBuf.releaseCaptured()};
+						if (serializedResponse)
+							_responseCache->put(requestContext.libraryGeneration, cacheKey, std::make_shared<const std::string>(std::move(*serializedResponse)));
+					}
+				}
+			}
+			else
+			{
+				Response resp {(itEntryPoint->second.func)(requestContext)};
+				resp.write(response.out(), format);
+			}
 			response.setMimeType(ResponseFormatToMimeType(format));
 
 			LMS_LOG(API_SUBSONIC, DEBUG) << "Request " << requestId << " '" << requestPath << "' handled!";
@@ -2026,7 +2424,7 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 		LMS_LOG(API_SUBSONIC, ERROR) << "Error while processing request '" << requestPath << "'"
 			<< ", params = [" << parameterMapToDebugString(request.getParameterMap()) << "]"
 			<< ", code = " << static_cast<int>(e.getCode()) << ", msg = '" << e.getMessage() << "'";
-		Response resp {Response::createFailedResponse(clientName, e)};
+		Response resp {Response::createFailedResponse(e)};
 		resp.write(response.out(), format);
 		response.setMimeType(ResponseFormatToMimeType(format));
 	}
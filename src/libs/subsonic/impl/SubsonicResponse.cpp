@@ -19,15 +19,11 @@
 
 #include "SubsonicResponse.hpp"
 
-#include <Wt/Json/Array.h>
-#include <Wt/Json/Object.h>
-#include <Wt/Json/Value.h>
-#include <Wt/Json/Serializer.h>
-
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <algorithm>
+#include <iomanip>
 
 #include "utils/Exception.hpp"
+#include "utils/Logger.hpp"
 #include "utils/String.hpp"
 
 namespace API::Subsonic
@@ -48,7 +44,7 @@ ResponseFormatToMimeType(ResponseFormat format)
 void
 Response::Node::setValue(std::string_view value)
 {
-	if (!_children.empty() || !_childrenArrays.empty())
+	if (!_children.empty() || !_childrenArrays.empty() || !_childrenArrayGenerators.empty())
 		throw LmsException {"Node already has children"};
 
 	_value = std::string {value};
@@ -57,7 +53,7 @@ Response::Node::setValue(std::string_view value)
 void
 Response::Node::setValue(long long value)
 {
-	if (!_children.empty() || !_childrenArrays.empty())
+	if (!_children.empty() || !_childrenArrays.empty() || !_childrenArrayGenerators.empty())
 		throw LmsException {"Node already has children"};
 
 	_value = value;
@@ -66,7 +62,18 @@ Response::Node::setValue(long long value)
 void
 Response::Node::setAttribute(std::string_view key, std::string_view value)
 {
-	_attributes[std::string {key}] = std::string {value};
+	setAttributeValue(key, std::string {value});
+}
+
+void
+Response::Node::setAttributeValue(std::string_view key, Value value)
+{
+	// Few attributes per node: a linear search is cheaper than a map
+	auto it {std::find_if(std::begin(_attributes), std::end(_attributes), [&](const auto& attribute) { return attribute.first == key; })};
+	if (it != std::end(_attributes))
+		it->second = std::move(value);
+	else
+		_attributes.emplace_back(std::string {key}, std::move(value));
 }
 
 void
@@ -87,19 +94,29 @@ Response::Node::addArrayChild(const std::string& key, Node node)
 	_childrenArrays[key].emplace_back(std::move(node));
 }
 
+void
+Response::Node::addArrayChildGenerator(const std::string& key, ArrayChildGenerator generator)
+{
+	if (_value)
+		throw LmsException {"Node already has a value"};
+
+	_childrenArrayGenerators[key] = std::move(generator);
+}
 
 Response::Node&
 Response::Node::createChild(const std::string& key)
 {
-	_children[key].emplace_back();
-	return _children[key].back();
+	std::vector<Node>& children {_children[key]};
+	children.emplace_back();
+	return children.back();
 }
 
 Response::Node&
 Response::Node::createArrayChild(const std::string& key)
 {
-	_childrenArrays[key].emplace_back();
-	return _childrenArrays[key].back();
+	std::vector<Node>& children {_childrenArrays[key]};
+	children.emplace_back();
+	return children.back();
 }
 
 Response
@@ -109,19 +126,19 @@ Response::createOkResponse(const RequestContext& context)
 	Node& responseNode {response._root.createChild("subsonic-response")};
 
 	responseNode.setAttribute("status", "ok");
-	responseNode.setAttribute("version", std::string {QUOTEME(API_VERSION_MAJOR) "."} + std::to_string(getAPIMinorVersion(context.clientName)) + ".0");
+	responseNode.setAttribute("version", QUOTEME(API_VERSION_MAJOR) "." QUOTEME(API_VERSION_MINOR) ".0");
 
 	return response;
 }
 
 Response
-Response::createFailedResponse(std::string_view clientName, const Error& error)
+Response::createFailedResponse(const Error& error)
 {
 	Response response;
 	Node& responseNode {response._root.createChild("subsonic-response")};
 
 	responseNode.setAttribute("status", "failed");
-	responseNode.setAttribute("version", std::string {QUOTEME(API_VERSION_MAJOR) "."} + std::to_string(getAPIMinorVersion(clientName)) + ".0");
+	responseNode.setAttribute("version", QUOTEME(API_VERSION_MAJOR) "." QUOTEME(API_VERSION_MINOR) ".0");
 
 	Node& errorNode {responseNode.createChild("error")};
 	errorNode.setAttribute("code", std::to_string(static_cast<int>(error.getCode())));
@@ -148,138 +165,259 @@ Response::createArrayNode(const std::string& key)
 	return _root._children["subsonic-response"].front().createArrayChild(key);
 }
 
-void
+// Part of the document has already been sent when a generator fails:
+// the best that can be done is to stop the array and close the document consistently
+// return false if the array is truncated
+static
+bool
+generateArrayChildren(std::string_view key, const Response::Node::ArrayChildGenerator& generator, const Response::Node::ArrayChildConsumer& consumer)
+{
+	try
+	{
+		generator(consumer);
+		return true;
+	}
+	catch (const Error& e)
+	{
+		LMS_LOG(API_SUBSONIC, ERROR) << "Cannot generate '" << key << "' array, response truncated: code = " << static_cast<int>(e.getCode()) << ", msg = '" << e.getMessage() << "'";
+	}
+	catch (const std::exception& e)
+	{
+		LMS_LOG(API_SUBSONIC, ERROR) << "Cannot generate '" << key << "' array, response truncated: " << e.what();
+	}
+
+	return false;
+}
+
+bool
 Response::write(std::ostream& os, ResponseFormat format)
 {
 	switch (format)
 	{
 		case ResponseFormat::xml:
-			writeXML(os);
-			break;
+			return writeXML(os);
 		case ResponseFormat::json:
-			writeJSON(os);
-			break;
+			return writeJSON(os);
+	}
+
+	return false;
+}
+
+static
+void
+writeXMLEscaped(std::ostream& os, std::string_view str)
+{
+	for (const char c : str)
+	{
+		switch (c)
+		{
+			case '&': os << "&amp;"; break;
+			case '<': os << "&lt;"; break;
+			case '>': os << "&gt;"; break;
+			case '"': os << "&quot;"; break;
+			case '\'': os << "&apos;"; break;
+			case '\n': os << "&#10;"; break;
+			case '\r': os << "&#13;"; break;
+			default: os << c;
+		}
 	}
 }
 
+template <typename Value>
+static
 void
+writeXMLValue(std::ostream& os, const Value& value)
+{
+	if (std::holds_alternative<std::string>(value))
+		writeXMLEscaped(os, std::get<std::string>(value));
+	else if (std::holds_alternative<bool>(value))
+		os << (std::get<bool>(value) ? "true" : "false");
+	else if (std::holds_alternative<long long>(value))
+		os << std::get<long long>(value);
+}
+
+bool
 Response::writeXML(std::ostream& os)
 {
-	std::function<boost::property_tree::ptree(const Response::Node&)> nodeToPropertyTree = [&] (const Response::Node& node)
+	bool isComplete {true};
+
+	std::function<void(std::string_view, const Node&)> writeNode = [&] (std::string_view key, const Node& node)
 	{
-		boost::property_tree::ptree res;
+		os << '<' << key;
+		for (const auto& [name, value] : node._attributes)
+		{
+			os << ' ' << name << "=\"";
+			writeXMLValue(os, value);
+			os << '"';
+		}
 
-		for (auto itAttribute : node._attributes)
+		if (!node._value && node._children.empty() && node._childrenArrays.empty() && node._childrenArrayGenerators.empty())
 		{
-			if (std::holds_alternative<std::string>(itAttribute.second))
-				res.put("<xmlattr>." + itAttribute.first, std::get<std::string>(itAttribute.second));
-			else if (std::holds_alternative<bool>(itAttribute.second))
-				res.put("<xmlattr>." + itAttribute.first, std::get<bool>(itAttribute.second));
-			else if (std::holds_alternative<long long>(itAttribute.second))
-				res.put("<xmlattr>." + itAttribute.first, std::get<long long>(itAttribute.second));
+			os << "/>";
+			return;
 		}
 
+		os << '>';
+
 		if (node._value)
 		{
-			const auto& value {*node._value};
-
-			if (std::holds_alternative<std::string>(value))
-				res.put_value(std::get<std::string>(value));
-			else if (std::holds_alternative<bool>(value))
-				res.put_value(std::get<bool>(value));
-			else if (std::holds_alternative<long long>(value))
-				res.put_value(std::get<long long>(value));
+			writeXMLValue(os, *node._value);
 		}
 		else
 		{
-			for (auto itChildNode : node._children)
+			for (const auto& [childKey, childNodes] : node._children)
 			{
-				for (const Response::Node& childNode : itChildNode.second)
-					res.add_child(itChildNode.first, nodeToPropertyTree(childNode));
+				for (const Node& childNode : childNodes)
+					writeNode(childKey, childNode);
 			}
 
-			for (auto itChildArrayNode : node._childrenArrays)
+			for (const auto& [childKey, childNodes] : node._childrenArrays)
 			{
-				const std::vector<Response::Node>& childArrayNodes {itChildArrayNode.second};
+				for (const Node& childNode : childNodes)
+					writeNode(childKey, childNode);
+			}
 
-				for (const Response::Node& childNode : childArrayNodes )
-					res.add_child(itChildArrayNode.first, nodeToPropertyTree(childNode));
+			for (const auto& [childKey, generator] : node._childrenArrayGenerators)
+			{
+				const std::string_view childKeyView {childKey};
+				if (!generateArrayChildren(childKey, generator, [&](const Node& childNode) { writeNode(childKeyView, childNode); }))
+					isComplete = false;
 			}
 		}
 
-		return res;
+		os << "</" << key << '>';
 	};
 
-	boost::property_tree::ptree root {nodeToPropertyTree(_root)};
-	boost::property_tree::write_xml(os, root);
+	os << R"(<?xml version="1.0" encoding="utf-8"?>)" << '\n';
+	for (const auto& [key, nodes] : _root._children)
+	{
+		for (const Node& node : nodes)
+			writeNode(key, node);
+	}
+
+	return isComplete;
 }
 
-unsigned
-Response::getAPIMinorVersion(std::string_view clientName)
+static
+void
+writeJSONEscaped(std::ostream& os, std::string_view str)
 {
-	// Some clients do not rely on version to enable the clear text password auth scheme
-	if (clientName == "Audinaut")
-		return 16;
-	else if (clientName == "Sublime Music")
-		return 16;
-	else
-		return 12;
+	os << '"';
+	for (const char c : str)
+	{
+		switch (c)
+		{
+			case '"': os << "\\\""; break;
+			case '\\': os << "\\\\"; break;
+			case '\b': os << "\\b"; break;
+			case '\f': os << "\\f"; break;
+			case '\n': os << "\\n"; break;
+			case '\r': os << "\\r"; break;
+			case '\t': os << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+				else
+					os << c;
+		}
+	}
+	os << '"';
 }
 
+template <typename Value>
+static
 void
+writeJSONValue(std::ostream& os, const Value& value)
+{
+	if (std::holds_alternative<std::string>(value))
+		writeJSONEscaped(os, std::get<std::string>(value));
+	else if (std::holds_alternative<bool>(value))
+		os << (std::get<bool>(value) ? "true" : "false");
+	else if (std::holds_alternative<long long>(value))
+		os << std::get<long long>(value);
+}
+
+bool
 Response::writeJSON(std::ostream& os)
 {
-	namespace Json = Wt::Json;
+	bool isComplete {true};
 
-	std::function<Json::Object(const Response::Node&)> nodeToJsonObject = [&] (const Response::Node& node)
+	std::function<void(const Node&)> writeNode = [&] (const Node& node)
 	{
-		Json::Object res;
-
-		auto valueToJsonValue {[](const Node::Value& value) -> Json::Value
+		bool firstMember {true};
+		auto writeMemberName {[&](std::string_view name)
 		{
-			if (std::holds_alternative<std::string>(value))
-				return Json::Value {std::get<std::string>(value)};
-			else if (std::holds_alternative<bool>(value))
-				return Json::Value {std::get<bool>(value)};
-			else if (std::holds_alternative<long long>(value))
-				return Json::Value {std::get<long long>(value)};
-
-			throw LmsException("Unexpected value type");
+			if (!firstMember)
+				os << ',';
+			firstMember = false;
+
+			writeJSONEscaped(os, name);
+			os << ':';
 		}};
 
-		for (auto itAttribute : node._attributes)
-			res[itAttribute.first] = valueToJsonValue(itAttribute.second);
+		os << '{';
+
+		for (const auto& [name, value] : node._attributes)
+		{
+			writeMemberName(name);
+			writeJSONValue(os, value);
+		}
 
 		if (node._value)
 		{
-			res["value"] = valueToJsonValue(*node._value);
+			writeMemberName("value");
+			writeJSONValue(os, *node._value);
 		}
 		else
 		{
-			for (auto itChildNode : node._children)
+			// Only one object per key can be represented
+			for (const auto& [childKey, childNodes] : node._children)
 			{
-				for (const Response::Node& childNode : itChildNode.second)
-					res[itChildNode.first] = nodeToJsonObject(childNode);
+				if (childNodes.empty())
+					continue;
+
+				writeMemberName(childKey);
+				writeNode(childNodes.back());
 			}
 
-			for (auto itChildArrayNode : node._childrenArrays)
+			for (const auto& [childKey, childNodes] : node._childrenArrays)
 			{
-				const std::vector<Response::Node>& childArrayNodes {itChildArrayNode .second};
-
-				Json::Array array;
-				for (const Response::Node& childNode : childArrayNodes )
-					array.emplace_back(nodeToJsonObject(childNode));
+				writeMemberName(childKey);
+				os << '[';
+				for (std::size_t i {}; i < childNodes.size(); ++i)
+				{
+					if (i > 0)
+						os << ',';
+					writeNode(childNodes[i]);
+				}
+				os << ']';
+			}
 
-				res[itChildArrayNode.first] = std::move(array);
+			for (const auto& [childKey, generator] : node._childrenArrayGenerators)
+			{
+				writeMemberName(childKey);
+				os << '[';
+				bool firstChild {true};
+				if (!generateArrayChildren(childKey, generator, [&](const Node& childNode)
+					{
+						if (!firstChild)
+							os << ',';
+						firstChild = false;
+						writeNode(childNode);
+					}))
+				{
+					isComplete = false;
+				}
+				os << ']';
 			}
 		}
 
-		return res;
+		os << '}';
 	};
 
-	Json::Object root {nodeToJsonObject(_root)};
-	os << Json::serialize(root);
+	writeNode(_root);
+
+	return isComplete;
 }
 
 } // namespace
-
@@ -18,6 +18,7 @@
  */
 #pragma once
 
+#include <functional>
 #include <map>
 #include <optional>
 #include <string>
@@ -28,6 +29,7 @@
 #include "RequestContext.hpp"
 
 #define API_VERSION_MAJOR	1
+#define API_VERSION_MINOR	16
 
 namespace API::Subsonic
 {
@@ -191,9 +193,9 @@ class Response
 				void setAttribute(std::string_view key, T value)
 				{
 					if constexpr (std::is_same<bool, T>::value)
-						_attributes[std::string {key}] = value;
+						setAttributeValue(key, value);
 					else
-						_attributes[std::string {key}] = static_cast<long long>(value);
+						setAttributeValue(key, static_cast<long long>(value));
 				}
 
 				// A Node has either a value or some children
@@ -205,17 +207,29 @@ class Response
 				void addChild(const std::string& key, Node node);
 				void addArrayChild(const std::string& key, Node node);
 
+				// Array children produced while the response is being written:
+				// each child is serialized as soon as it is handed to the consumer,
+				// so that no node tree is built for the whole array.
+				// The serialized output itself is still buffered by Wt until handleRequest returns
+				// The generator is called from Response::write, during the lifetime of the request context
+				using ArrayChildConsumer = std::function<void(const Node&)>;
+				using ArrayChildGenerator = std::function<void(const ArrayChildConsumer&)>;
+				void addArrayChildGenerator(const std::string& key, ArrayChildGenerator generator);
+
 			private:
 				friend class Response;
 				using Value = std::variant<std::string, bool, long long>;
-				std::map<std::string, Value> _attributes;
+				void setAttributeValue(std::string_view key, Value value);
+
+				std::vector<std::pair<std::string, Value>> _attributes;
 				std::optional<Value> _value;
 				std::map<std::string, std::vector<Node>> _children;
 				std::map<std::string, std::vector<Node>> _childrenArrays;
+				std::map<std::string, ArrayChildGenerator> _childrenArrayGenerators;
 		};
 
 		static Response createOkResponse(const RequestContext& context);
-		static Response createFailedResponse(std::string_view clientName, const Error& error);
+		static Response createFailedResponse(const Error& error);
 
 		virtual ~Response() {}
 		Response(const Response&) = delete;
@@ -227,13 +241,14 @@ class Response
 		Node& createNode(const std::string& key);
 		Node& createArrayNode(const std::string& key);
 
-		void write(std::ostream& os, ResponseFormat format);
+		// Array generator failures are logged, the document is then truncated but still well formed
+		// return false if the document is truncated
+		bool write(std::ostream& os, ResponseFormat format);
 
-		static unsigned getAPIMinorVersion(std::string_view clientName);
 	private:
 
-		void writeJSON(std::ostream& os);
-		void writeXML(std::ostream& os);
+		bool writeJSON(std::ostream& os);
+		bool writeXML(std::ostream& os);
 
 		Response() = default;
 		Node _root;
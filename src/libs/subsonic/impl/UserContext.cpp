@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UserContext.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "database/Session.hpp"
+#include "database/User.hpp"
+#include "utils/Random.hpp"
+
+namespace API::Subsonic
+{
+	using namespace Database;
+
+	UserContext::UserContext(IdType userId, std::uint64_t userGeneration, std::vector<IdType> starredArtistIds, std::vector<IdType> starredReleaseIds, std::vector<IdType> starredTrackIds)
+	: _userId {userId}
+	, _userGeneration {userGeneration}
+	, _starredArtistIds {std::move(starredArtistIds)}
+	, _starredReleaseIds {std::move(starredReleaseIds)}
+	, _starredTrackIds {std::move(starredTrackIds)}
+	{
+		assert(std::is_sorted(std::cbegin(_starredArtistIds), std::cend(_starredArtistIds)));
+		assert(std::is_sorted(std::cbegin(_starredReleaseIds), std::cend(_starredReleaseIds)));
+		assert(std::is_sorted(std::cbegin(_starredTrackIds), std::cend(_starredTrackIds)));
+	}
+
+	bool
+	UserContext::isArtistStarred(IdType artistId) const
+	{
+		return std::binary_search(std::cbegin(_starredArtistIds), std::cend(_starredArtistIds), artistId);
+	}
+
+	bool
+	UserContext::isReleaseStarred(IdType releaseId) const
+	{
+		return std::binary_search(std::cbegin(_starredReleaseIds), std::cend(_starredReleaseIds), releaseId);
+	}
+
+	bool
+	UserContext::isTrackStarred(IdType trackId) const
+	{
+		return std::binary_search(std::cbegin(_starredTrackIds), std::cend(_starredTrackIds), trackId);
+	}
+
+	UserContextCache::UserContextCache(std::size_t maxUserCount)
+	: _maxUserCount {maxUserCount}
+	{
+	}
+
+	std::shared_ptr<const UserContext>
+	UserContextCache::get(Session& session, const std::string& loginName)
+	{
+		std::shared_ptr<const UserContext> cachedUserContext;
+		{
+			std::scoped_lock lock {_mutex};
+
+			auto it {_cache.find(loginName)};
+			if (it != std::cend(_cache))
+				cachedUserContext = it->second;
+		}
+
+		if (cachedUserContext && cachedUserContext->getUserGeneration() == session.getUserGeneration(cachedUserContext->getUserId()))
+			return cachedUserContext;
+
+		// Load outside of the lock
+		std::shared_ptr<const UserContext> userContext {load(session, loginName)};
+		if (!userContext)
+			return userContext;
+
+		std::scoped_lock lock {_mutex};
+
+		// Do not replace a context loaded in the meantime by a concurrent request with an older one
+		auto it {_cache.find(loginName)};
+		if (it != std::cend(_cache) && it->second->getUserId() == userContext->getUserId() && it->second->getUserGeneration() > userContext->getUserGeneration())
+			return userContext;
+
+		if (it == std::cend(_cache))
+		{
+			while (_cache.size() >= _maxUserCount && !_cache.empty())
+				_cache.erase(Random::pickRandom(_cache));
+		}
+
+		_cache.insert_or_assign(loginName, userContext);
+
+		return userContext;
+	}
+
+	std::shared_ptr<const UserContext>
+	UserContextCache::load(Session& session, const std::string& loginName)
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const User::pointer user {User::getByLoginName(session, loginName)};
+		if (!user)
+			return {};
+
+		// Bumps are done in the transactions modifying the user data: the generation matches the loaded data
+		return std::make_shared<const UserContext>(user.id(),
+				session.getUserGeneration(user.id()),
+				user->getAllStarredArtistIds(),
+				user->getAllStarredReleaseIds(),
+				user->getAllStarredTrackIds());
+	}
+} // namespace API::Subsonic
+
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "database/Types.hpp"
+
+namespace Database
+{
+	class Session;
+}
+
+namespace API::Subsonic
+{
+	// User data needed by most of the responses
+	// Starred entities are kept as sorted id sets so that checking an entity is an in-memory lookup
+	class UserContext
+	{
+		public:
+			UserContext(Database::IdType userId, std::uint64_t userGeneration, std::vector<Database::IdType> starredArtistIds, std::vector<Database::IdType> starredReleaseIds, std::vector<Database::IdType> starredTrackIds);
+
+			Database::IdType	getUserId() const { return _userId; }
+			std::uint64_t		getUserGeneration() const { return _userGeneration; } // generation of the user data when loaded
+
+			bool	isArtistStarred(Database::IdType artistId) const;
+			bool	isReleaseStarred(Database::IdType releaseId) const;
+			bool	isTrackStarred(Database::IdType trackId) const;
+
+		private:
+			const Database::IdType			_userId;
+			const std::uint64_t			_userGeneration;
+			const std::vector<Database::IdType>	_starredArtistIds;
+			const std::vector<Database::IdType>	_starredReleaseIds;
+			const std::vector<Database::IdType>	_starredTrackIds;
+	};
+
+	// User contexts shared between the requests of the same user
+	// Starring/unstarring bumps the user generation: a context is reloaded if its user generation is outdated
+	class UserContextCache
+	{
+		public:
+			UserContextCache(std::size_t maxUserCount);
+
+			UserContextCache(const UserContextCache&) = delete;
+			UserContextCache(UserContextCache&&) = delete;
+			UserContextCache& operator=(const UserContextCache&) = delete;
+			UserContextCache& operator=(UserContextCache&&) = delete;
+
+			// Must be called outside of any transaction, returns nullptr if the user does not exist
+			std::shared_ptr<const UserContext>	get(Database::Session& session, const std::string& loginName);
+
+		private:
+			static std::shared_ptr<const UserContext>	load(Database::Session& session, const std::string& loginName);
+
+			const std::size_t _maxUserCount;
+
+			std::mutex _mutex;
+			std::unordered_map<std::string, std::shared_ptr<const UserContext>> _cache;
+	};
+} // namespace API::Subsonic
+
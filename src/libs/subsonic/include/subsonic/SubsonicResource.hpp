@@ -18,6 +18,8 @@
  */
 #pragma once
 
+#include <memory>
+
 #include <Wt/WResource.h>
 #include <Wt/Http/Response.h>
 
@@ -29,10 +31,14 @@ namespace Database
 namespace API::Subsonic
 {
 
+class CursorCache;
+class ResponseCache;
+class UserContextCache;
 class SubsonicResource final : public Wt::WResource
 {
 	public:
 		SubsonicResource(Database::Db& db);
+		~SubsonicResource();
 
 		static std::string getPath() { return "rest/"; }
 	private:
@@ -40,6 +46,9 @@ class SubsonicResource final : public Wt::WResource
 		void handleRequest(const Wt::Http::Request &request, Wt::Http::Response &response) override;
 
 		Database::Db& _db;
+		std::unique_ptr<ResponseCache> _responseCache;
+		std::unique_ptr<CursorCache> _cursorCache;
+		std::unique_ptr<UserContextCache> _userContextCache;
 };
 
 } // namespace
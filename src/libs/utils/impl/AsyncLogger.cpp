@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/AsyncLogger.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	std::size_t
+	roundUpToPowerOfTwo(std::size_t value)
+	{
+		std::size_t res {1};
+		while (res < value)
+			res <<= 1;
+
+		return res;
+	}
+}
+
+AsyncLogger::AsyncLogger(std::unique_ptr<Logger> logger, std::size_t capacity)
+: _logger {std::move(logger)}
+, _entries(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2)))
+, _mask {_entries.size() - 1}
+{
+	for (std::size_t i {}; i < _entries.size(); ++i)
+		_entries[i].sequence.store(i, std::memory_order_relaxed);
+
+	for (std::size_t i {}; i < ModuleCount; ++i)
+	{
+		for (std::size_t j {}; j < SeverityCount; ++j)
+			setSeverityActive(static_cast<Module>(i), static_cast<Severity>(j), _logger->isSeverityActive(static_cast<Module>(i), static_cast<Severity>(j)));
+	}
+
+	_thread = std::thread {[this] { run(); }};
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	{
+		std::scoped_lock lock {_mutex};
+		_stop = true;
+	}
+	_cv.notify_one();
+	_thread.join();
+
+	// Flush what may have been pushed in the meantime
+	drain();
+	reportDroppedLogs();
+}
+
+void
+AsyncLogger::processLog(const Log& log)
+{
+	// Make sure fatal logs are output before anything else happens
+	if (log.getSeverity() == Severity::FATAL)
+	{
+		Log {_logger.get(), log.getModule(), log.getSeverity()}.getOstream() << log.getMessage();
+		return;
+	}
+
+	if (!push(log.getModule(), log.getSeverity(), log.getMessage()))
+		_droppedLogCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool
+AsyncLogger::push(Module module, Severity severity, std::string&& message)
+{
+	std::size_t index {_pushIndex.load(std::memory_order_relaxed)};
+	while (true)
+	{
+		Entry& entry {_entries[index & _mask]};
+		const std::size_t sequence {entry.sequence.load(std::memory_order_acquire)};
+		if (sequence == index)
+		{
+			if (_pushIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+			{
+				entry.module = module;
+				entry.severity = severity;
+				entry.message = std::move(message);
+				entry.sequence.store(index + 1, std::memory_order_release);
+
+				// The queue was empty: the background thread may be waiting
+				// Paired with the fence in isEmpty, so that either we see it has not consumed everything, or it sees this entry
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (_popIndex.load(std::memory_order_relaxed) == index)
+				{
+					{
+						std::scoped_lock lock {_mutex};
+					}
+					_cv.notify_one();
+				}
+
+				return true;
+			}
+		}
+		else if (sequence < index)
+			return false; // full
+		else
+			index = _pushIndex.load(std::memory_order_relaxed);
+	}
+}
+
+bool
+AsyncLogger::pop(Module& module, Severity& severity, std::string& message)
+{
+	std::size_t index {_popIndex.load(std::memory_order_relaxed)};
+	while (true)
+	{
+		Entry& entry {_entries[index & _mask]};
+		const std::size_t sequence {entry.sequence.load(std::memory_order_acquire)};
+		if (sequence == index + 1)
+		{
+			if (_popIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+			{
+				module = entry.module;
+				severity = entry.severity;
+				message = std::move(entry.message);
+				entry.sequence.store(index + _mask + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (sequence < index + 1)
+			return false; // empty
+		else
+			index = _popIndex.load(std::memory_order_relaxed);
+	}
+}
+
+bool
+AsyncLogger::isEmpty() const
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	const std::size_t index {_popIndex.load(std::memory_order_relaxed)};
+	return _entries[index & _mask].sequence.load(std::memory_order_acquire) != index + 1;
+}
+
+void
+AsyncLogger::run()
+{
+	while (!_stop)
+	{
+		drain();
+		reportDroppedLogs();
+
+		std::unique_lock lock {_mutex};
+		_cv.wait(lock, [this] { return _stop || !isEmpty(); });
+	}
+}
+
+std::size_t
+AsyncLogger::drain()
+{
+	std::size_t count {};
+
+	Module module;
+	Severity severity;
+	std::string message;
+	while (pop(module, severity, message))
+	{
+		Log {_logger.get(), module, severity}.getOstream() << message;
+		count++;
+	}
+
+	return count;
+}
+
+void
+AsyncLogger::reportDroppedLogs()
+{
+	const std::size_t droppedLogCount {_droppedLogCount.exchange(0, std::memory_order_relaxed)};
+	if (droppedLogCount > 0)
+		Log {_logger.get(), Module::UTILS, Severity::WARNING}.getOstream() << droppedLogCount << " log messages dropped!";
+}
@@ -19,120 +19,315 @@
 
 #include "FileResourceHandler.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Wt/WDateTime.h>
 
 #include "utils/Logger.hpp"
+#include "utils/String.hpp"
+
+namespace
+{
+	constexpr const char* httpDateFormat {"ddd, dd MMM yyyy hh:mm:ss 'GMT'"};
+
+	std::string
+	computeETag(const struct ::stat& fileStat)
+	{
+		std::ostringstream oss;
+		oss << "\"" << std::hex << static_cast<::uint64_t>(fileStat.st_mtime) << "-" << static_cast<::uint64_t>(fileStat.st_size) << "\"";
+		return oss.str();
+	}
+
+	bool
+	etagMatches(const std::string& ifNoneMatch, const std::string& etag)
+	{
+		if (ifNoneMatch == "*")
+			return true;
+
+		// may be a list of etags, possibly weak ones
+		return ifNoneMatch.find(etag) != std::string::npos;
+	}
+
+	bool
+	isNotModifiedSince(const std::string& ifModifiedSince, const Wt::WDateTime& lastModified)
+	{
+		const Wt::WDateTime since {Wt::WDateTime::fromString(ifModifiedSince, httpDateFormat)};
+		if (!since.isValid())
+			return false;
+
+		return lastModified <= since;
+	}
+
+	// If-Range holds either a strong ETag or a date, ranges must be ignored if it does not match exactly
+	bool
+	ifRangeMatches(const std::string& ifRange, const std::string& etag, const Wt::WDateTime& lastModified)
+	{
+		if (ifRange.front() == '"' || ifRange.compare(0, 2, "W/") == 0)
+			return ifRange == etag;
+
+		const Wt::WDateTime date {Wt::WDateTime::fromString(ifRange, httpDateFormat)};
+		return date.isValid() && date == lastModified;
+	}
+
+	std::string_view
+	guessMimeType(const std::filesystem::path& path)
+	{
+		static const std::unordered_map<std::string, std::string_view> mimeTypes
+		{
+			{".mp3",	"audio/mpeg"},
+			{".flac",	"audio/flac"},
+			{".ogg",	"audio/ogg"},
+			{".oga",	"audio/ogg"},
+			{".opus",	"audio/ogg"},
+			{".m4a",	"audio/mp4"},
+			{".m4b",	"audio/mp4"},
+			{".aac",	"audio/aac"},
+			{".alac",	"audio/mp4"},
+			{".mpc",	"audio/x-musepack"},
+			{".wv",		"audio/x-wavpack"},
+			{".wma",	"audio/x-ms-wma"},
+			{".wav",	"audio/wav"},
+			{".aif",	"audio/aiff"},
+			{".aiff",	"audio/aiff"},
+			{".ape",	"audio/x-ape"},
+			{".mka",	"audio/x-matroska"},
+			{".webm",	"audio/webm"},
+			{".jpg",	"image/jpeg"},
+			{".jpeg",	"image/jpeg"},
+			{".png",	"image/png"},
+			{".bmp",	"image/bmp"},
+		};
+
+		auto it {mimeTypes.find(StringUtils::stringToLower(path.extension().string()))};
+		return it != std::cend(mimeTypes) ? it->second : "application/octet-stream";
+	}
+}
 
 std::unique_ptr<IResourceHandler>
-createFileResourceHandler(const std::filesystem::path& path)
+createFileResourceHandler(const std::filesystem::path& path, std::string_view mimeType)
 {
-	return std::make_unique<FileResourceHandler>(path);
+	return std::make_unique<FileResourceHandler>(path, !mimeType.empty() ? mimeType : guessMimeType(path));
 }
 
 
-FileResourceHandler::FileResourceHandler(const std::filesystem::path& path)
+FileResourceHandler::FileResourceHandler(const std::filesystem::path& path, std::string_view mimeType)
 : _path {path}
+, _mimeType {mimeType}
 {
 }
 
+FileResourceHandler::~FileResourceHandler()
+{
+	finish();
+}
 
 Wt::Http::ResponseContinuation*
 FileResourceHandler::processRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
 {
-	::uint64_t startByte {_offset};
-	std::ifstream ifs {_path.string().c_str(), std::ios::in | std::ios::binary};
+	if (_isFinished)
+		return {};
 
-	if (startByte == 0)
+	if (_fd < 0)
 	{
-		if (!ifs)
+		if (!prepare(request, response))
 		{
-			LMS_LOG(UTILS, ERROR) << "Cannot open file stream for '" << _path.string() << "'";
-			response.setStatus(404);
-			_isFinished = true;
+			finish();
 			return {};
 		}
-		else
-		{
-			response.setStatus(200);
-		}
+	}
 
-		ifs.seekg(0, std::ios::end);
-		const ::uint64_t fileSize {static_cast<::uint64_t>(ifs.tellg())};
-		ifs.seekg(0, std::ios::beg);
+	return serveChunk(response);
+}
 
-		LMS_LOG(UTILS, DEBUG) << "File '" << _path.string() << "', fileSize = " << fileSize;
+bool
+FileResourceHandler::prepare(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	_fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (_fd < 0)
+	{
+		LMS_LOG(UTILS, ERROR) << "Cannot open file '" << _path.string() << "': " << ::strerror(errno);
+		response.setStatus(404);
+		return false;
+	}
 
-		const Wt::Http::Request::ByteRangeSpecifier ranges {request.getRanges(fileSize)};
-		if (!ranges.isSatisfiable())
-		{
-			std::ostringstream contentRange;
-			contentRange << "bytes */" << fileSize;
-			response.setStatus(416); // Requested range not satisfiable
-			response.addHeader("Content-Range", contentRange.str());
+	struct ::stat fileStat;
+	if (::fstat(_fd, &fileStat) != 0)
+	{
+		LMS_LOG(UTILS, ERROR) << "Cannot stat file '" << _path.string() << "': " << ::strerror(errno);
+		response.setStatus(404);
+		return false;
+	}
 
-			LMS_LOG(UTILS, DEBUG) << "Range not satisfiable";
-			_isFinished = true;
-			return {};
-		}
+	const ::uint64_t fileSize {static_cast<::uint64_t>(fileStat.st_size)};
+	LMS_LOG(UTILS, DEBUG) << "File '" << _path.string() << "', fileSize = " << fileSize;
 
-		if (ranges.size() == 1)
-		{
-			LMS_LOG(UTILS, DEBUG) << "Range requested = " << ranges[0].firstByte() << "/" << ranges[0].lastByte();
+	const std::string etag {computeETag(fileStat)};
+	const Wt::WDateTime lastModified {Wt::WDateTime::fromTime_t(fileStat.st_mtime)};
 
-			response.setStatus(206);
-			startByte = ranges[0].firstByte();
-			_beyondLastByte = ranges[0].lastByte() + 1;
+	response.addHeader("Accept-Ranges", "bytes");
+	response.addHeader("ETag", etag);
+	response.addHeader("Last-Modified", lastModified.toString(httpDateFormat).toUTF8());
 
-			std::ostringstream contentRange;
-			contentRange << "bytes " << startByte << "-"
-				<< _beyondLastByte - 1 << "/" << fileSize;
+	// If-None-Match takes precedence over If-Modified-Since
+	const std::string ifNoneMatch {request.headerValue("If-None-Match")};
+	const bool notModified {!ifNoneMatch.empty() ? etagMatches(ifNoneMatch, etag) : isNotModifiedSince(request.headerValue("If-Modified-Since"), lastModified)};
+	if (notModified)
+	{
+		LMS_LOG(UTILS, DEBUG) << "File '" << _path.string() << "' not modified";
+		response.setStatus(304);
+		return false;
+	}
 
-			response.addHeader("Content-Range", contentRange.str());
-			response.setContentLength(_beyondLastByte - startByte);
-		}
-		else
-		{
-			LMS_LOG(UTILS, DEBUG) << "No range requested";
+	// Only honour ranges if the client has the same version of the file, send the whole file otherwise
+	const std::string ifRange {request.headerValue("If-Range")};
+	const bool honourRanges {ifRange.empty() || ifRangeMatches(ifRange, etag, lastModified)};
 
-			_beyondLastByte = fileSize;
-			response.setContentLength(_beyondLastByte);
-		}
+	const Wt::Http::Request::ByteRangeSpecifier ranges {request.getRanges(fileSize)};
+	if (honourRanges && !ranges.isSatisfiable())
+	{
+		std::ostringstream contentRange;
+		contentRange << "bytes */" << fileSize;
+		response.setStatus(416); // Requested range not satisfiable
+		response.addHeader("Content-Range", contentRange.str());
+
+		LMS_LOG(UTILS, DEBUG) << "Range not satisfiable";
+		return false;
 	}
-	else if (!ifs)
+
+	if (!honourRanges || ranges.empty())
 	{
-		LMS_LOG(UTILS, ERROR) << "Cannot reopen file stream for '" << _path.string() << "'";
-		_isFinished = true;
-		return {};
+		LMS_LOG(UTILS, DEBUG) << (honourRanges ? "No range requested" : "If-Range does not match, sending the whole file");
+
+		response.setStatus(200);
+		response.setMimeType(_mimeType);
+		response.setContentLength(fileSize);
+		_parts.push_back({"", 0, fileSize});
+	}
+	else if (ranges.size() == 1)
+	{
+		LMS_LOG(UTILS, DEBUG) << "Range requested = " << ranges[0].firstByte() << "/" << ranges[0].lastByte();
+
+		const Part part {"", ranges[0].firstByte(), ranges[0].lastByte() + 1};
+
+		std::ostringstream contentRange;
+		contentRange << "bytes " << part.firstByte << "-" << part.beyondLastByte - 1 << "/" << fileSize;
+
+		response.setStatus(206);
+		response.setMimeType(_mimeType);
+		response.addHeader("Content-Range", contentRange.str());
+		response.setContentLength(part.beyondLastByte - part.firstByte);
+		_parts.push_back(part);
 	}
+	else
+	{
+		LMS_LOG(UTILS, DEBUG) << "Multiple ranges requested: " << ranges.size();
+
+		std::string boundary {"lms_byteranges_" + etag.substr(1, etag.size() - 2)};
 
-	ifs.seekg(static_cast<std::istream::pos_type>(startByte));
+		::uint64_t contentLength {};
+		for (const Wt::Http::Request::ByteRange& range : ranges)
+		{
+			std::ostringstream header;
+			header << "\r\n--" << boundary << "\r\n"
+				<< "Content-Type: " << _mimeType << "\r\n"
+				<< "Content-Range: bytes " << range.firstByte() << "-" << range.lastByte() << "/" << fileSize << "\r\n"
+				<< "\r\n";
 
-	std::vector<char> buf;
-	buf.resize(_chunkSize);
+			Part part {header.str(), range.firstByte(), range.lastByte() + 1};
+			contentLength += part.header.size() + (part.beyondLastByte - part.firstByte);
+			_parts.push_back(std::move(part));
+		}
+		_trailer = "\r\n--" + boundary + "--\r\n";
+		contentLength += _trailer.size();
 
-	::uint64_t restSize = _beyondLastByte - startByte;
-	::uint64_t pieceSize = buf.size() > restSize ? restSize : buf.size();
+		response.setStatus(206);
+		response.setMimeType("multipart/byteranges; boundary=" + boundary);
+		response.setContentLength(contentLength);
+	}
 
-	ifs.read(&buf[0], pieceSize);
-	const ::uint64_t actualPieceSize {static_cast<::uint64_t>(ifs.gcount())};
-	response.out().write(&buf[0], actualPieceSize);
+#if defined(POSIX_FADV_SEQUENTIAL)
+	::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
-	LMS_LOG(UTILS, DEBUG) << "Written " << actualPieceSize << " bytes";
+	_buffer.resize(_chunkSize);
 
-	LMS_LOG(UTILS, DEBUG) << "Progress: " << actualPieceSize << "/" << restSize;
-	if (ifs.good() && actualPieceSize < restSize)
+	return true;
+}
+
+Wt::Http::ResponseContinuation*
+FileResourceHandler::serveChunk(Wt::Http::Response& response)
+{
+	std::size_t remainingBudget {_buffer.size()};
+
+	while (remainingBudget > 0 && _currentPart < _parts.size())
 	{
-		_offset = startByte + actualPieceSize;
-		LMS_LOG(UTILS, DEBUG) << "Job not complete! Next chunk offset = " << _offset;
+		const Part& part {_parts[_currentPart]};
+		if (!_currentPartStarted)
+		{
+			response.out() << part.header;
+			_offset = part.firstByte;
+			_currentPartStarted = true;
+		}
+
+		if (_offset >= part.beyondLastByte)
+		{
+			_currentPart++;
+			_currentPartStarted = false;
+			continue;
+		}
+
+		const std::size_t pieceSize {static_cast<std::size_t>(std::min<::uint64_t>(remainingBudget, part.beyondLastByte - _offset))};
+		const ::ssize_t readSize {::pread(_fd, _buffer.data(), pieceSize, static_cast<::off_t>(_offset))};
+		if (readSize < 0 && errno == EINTR)
+			continue;
+
+		if (readSize <= 0)
+		{
+			LMS_LOG(UTILS, ERROR) << "Read failed on '" << _path.string() << "' at offset " << _offset << ": " << (readSize < 0 ? ::strerror(errno) : "unexpected end of file");
+			finish();
+			return {};
+		}
+
+		response.out().write(_buffer.data(), readSize);
+		_offset += readSize;
+		remainingBudget -= readSize;
+	}
 
+	if (_currentPart < _parts.size())
+	{
+		LMS_LOG(UTILS, DEBUG) << "Job not complete! Next chunk offset = " << _offset;
 		return response.createContinuation();
 	}
 
-	_isFinished = true;
+	response.out() << _trailer;
+
 	LMS_LOG(UTILS, DEBUG) << "Job complete!";
+	finish();
 
 	return {};
 }
 
+void
+FileResourceHandler::finish()
+{
+	_isFinished = true;
 
+	if (_fd >= 0)
+	{
+		::close(_fd);
+		_fd = -1;
+	}
+
+	_buffer.clear();
+	_buffer.shrink_to_fit();
+}
 
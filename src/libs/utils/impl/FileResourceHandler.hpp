@@ -19,24 +19,51 @@
 
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "utils/IResourceHandler.hpp"
 
 class FileResourceHandler final : public IResourceHandler
 {
 	public:
-		FileResourceHandler(const std::filesystem::path& filePath);
+		FileResourceHandler(const std::filesystem::path& filePath, std::string_view mimeType);
+		~FileResourceHandler();
 
 	private:
+		FileResourceHandler(const FileResourceHandler&) = delete;
+		FileResourceHandler(FileResourceHandler&&) = delete;
+		FileResourceHandler& operator=(const FileResourceHandler&) = delete;
+		FileResourceHandler& operator=(FileResourceHandler&&) = delete;
 
 		Wt::Http::ResponseContinuation* processRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
 
-		static constexpr std::size_t _chunkSize {65536};
+		// return false if there is nothing more to send
+		bool prepare(const Wt::Http::Request& request, Wt::Http::Response& response);
+		Wt::Http::ResponseContinuation* serveChunk(Wt::Http::Response& response);
+		void finish();
+
+		static constexpr std::size_t _chunkSize {262144};
+
+		struct Part
+		{
+			std::string	header;	// multipart header, empty for a single range
+			::uint64_t	firstByte {};
+			::uint64_t	beyondLastByte {};
+		};
 
 		std::filesystem::path	_path;
-		::uint64_t		_beyondLastByte {};
+		std::string		_mimeType;
+		int			_fd {-1};
+		std::vector<char>	_buffer;
+		std::vector<Part>	_parts;
+		std::string		_trailer;	// multipart closing delimiter
+		std::size_t		_currentPart {};
+		bool			_currentPartStarted {};
 		::uint64_t		_offset {};
 		bool			_isFinished {};
-
 };
 
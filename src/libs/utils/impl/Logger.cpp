@@ -74,3 +74,33 @@ Log::getMessage() const
 	return _oss.str();
 }
 
+Logger::Logger()
+{
+	setSeverityThreshold(Severity::DEBUG);
+}
+
+void
+Logger::setSeverityThreshold(Module module, Severity severity)
+{
+	for (std::size_t i {}; i < SeverityCount; ++i)
+		setSeverityActive(module, static_cast<Severity>(i), static_cast<Severity>(i) <= severity);
+}
+
+void
+Logger::setSeverityThreshold(Severity severity)
+{
+	for (std::size_t i {}; i < ModuleCount; ++i)
+		setSeverityThreshold(static_cast<Module>(i), severity);
+}
+
+void
+Logger::setSeverityActive(Module module, Severity severity, bool active)
+{
+	const std::uint8_t mask {static_cast<std::uint8_t>(1u << static_cast<unsigned>(severity))};
+
+	std::atomic<std::uint8_t>& activeSeverities {_activeSeverities[static_cast<std::size_t>(module)]};
+	if (active)
+		activeSeverities.fetch_or(mask, std::memory_order_relaxed);
+	else
+		activeSeverities.fetch_and(static_cast<std::uint8_t>(~mask), std::memory_order_relaxed);
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/Metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "utils/Exception.hpp"
+
+namespace Metrics {
+
+namespace details
+{
+	std::size_t
+	getCurrentThreadShardIndex()
+	{
+		static std::atomic<std::size_t> nextShardIndex {};
+		static thread_local const std::size_t shardIndex {nextShardIndex++ % ShardCount};
+
+		return shardIndex;
+	}
+}
+
+namespace
+{
+	std::string
+	escapeLabelValue(const std::string& value)
+	{
+		std::string res;
+		res.reserve(value.size());
+
+		for (const char c : value)
+		{
+			switch (c)
+			{
+				case '\\':	res += "\\\\"; break;
+				case '"':	res += "\\\""; break;
+				case '\n':	res += "\\n"; break;
+				default:	res += c;
+			}
+		}
+
+		return res;
+	}
+
+	std::string
+	toString(double value)
+	{
+		if (std::isinf(value))
+			return value > 0 ? "+Inf" : "-Inf";
+
+		std::ostringstream oss;
+		oss.imbue(std::locale::classic());
+		oss << std::setprecision(std::numeric_limits<double>::digits10) << value;
+		return oss.str();
+	}
+
+	void
+	writeLabels(std::ostream& os, const Labels& labels, const std::pair<std::string, std::string>* extraLabel = nullptr)
+	{
+		if (labels.empty() && !extraLabel)
+			return;
+
+		os << "{";
+		bool first {true};
+		auto writeLabel {[&](const std::pair<std::string, std::string>& label)
+		{
+			if (!first)
+				os << ",";
+			os << label.first << "=\"" << escapeLabelValue(label.second) << "\"";
+			first = false;
+		}};
+
+		for (const auto& label : labels)
+			writeLabel(label);
+		if (extraLabel)
+			writeLabel(*extraLabel);
+
+		os << "}";
+	}
+}
+
+std::uint64_t
+Counter::getValue() const
+{
+	std::uint64_t res {};
+	for (const details::CounterShard& shard : _shards)
+		res += shard.value.load(std::memory_order_relaxed);
+
+	return res;
+}
+
+Histogram::Histogram(const std::vector<double>& bounds)
+: _bounds {bounds}
+{
+	if (!std::is_sorted(std::cbegin(_bounds), std::cend(_bounds)))
+		throw LmsException {"Histogram bounds must be sorted"};
+
+	for (Shard& shard : _shards)
+	{
+		shard.bucketCounts = std::make_unique<std::atomic<std::uint64_t>[]>(_bounds.size() + 1);
+		for (std::size_t i {}; i < _bounds.size() + 1; ++i)
+			shard.bucketCounts[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void
+Histogram::observe(double value)
+{
+	const std::size_t bucketIndex {static_cast<std::size_t>(std::distance(std::cbegin(_bounds), std::lower_bound(std::cbegin(_bounds), std::cend(_bounds), value)))};
+
+	Shard& shard {_shards[details::getCurrentThreadShardIndex()]};
+	shard.bucketCounts[bucketIndex].fetch_add(1, std::memory_order_relaxed);
+
+	double sum {shard.sum.load(std::memory_order_relaxed)};
+	while (!shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+		;
+}
+
+Histogram::Snapshot
+Histogram::getSnapshot() const
+{
+	Snapshot snapshot;
+	snapshot.bucketCounts.resize(_bounds.size() + 1);
+
+	for (const Shard& shard : _shards)
+	{
+		for (std::size_t i {}; i < _bounds.size() + 1; ++i)
+		{
+			const std::uint64_t count {shard.bucketCounts[i].load(std::memory_order_relaxed)};
+			snapshot.bucketCounts[i] += count;
+			snapshot.count += count;
+		}
+		snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+	}
+
+	return snapshot;
+}
+
+const std::vector<double>&
+getDurationBuckets()
+{
+	static const std::vector<double> buckets {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+	return buckets;
+}
+
+Registry::Family&
+Registry::getFamily(const std::string& name, const std::string& help, Type type)
+{
+	auto [it, inserted] {_families.try_emplace(name)};
+	if (inserted)
+	{
+		it->second.type = type;
+		it->second.help = help;
+	}
+	else if (it->second.type != type)
+		throw LmsException {"Metric '" + name + "' already registered with another type"};
+
+	return it->second;
+}
+
+Counter&
+Registry::getCounter(const std::string& name, const std::string& help, const Labels& labels)
+{
+	std::scoped_lock lock {_mutex};
+
+	std::unique_ptr<Counter>& counter {getFamily(name, help, Type::Counter).counters[labels]};
+	if (!counter)
+		counter = std::make_unique<Counter>();
+
+	return *counter;
+}
+
+Gauge&
+Registry::getGauge(const std::string& name, const std::string& help, const Labels& labels)
+{
+	std::scoped_lock lock {_mutex};
+
+	std::unique_ptr<Gauge>& gauge {getFamily(name, help, Type::Gauge).gauges[labels]};
+	if (!gauge)
+		gauge = std::make_unique<Gauge>();
+
+	return *gauge;
+}
+
+Histogram&
+Registry::getHistogram(const std::string& name, const std::string& help, const std::vector<double>& bounds, const Labels& labels)
+{
+	std::scoped_lock lock {_mutex};
+
+	std::unique_ptr<Histogram>& histogram {getFamily(name, help, Type::Histogram).histograms[labels]};
+	if (!histogram)
+		histogram = std::make_unique<Histogram>(bounds);
+
+	return *histogram;
+}
+
+void
+Registry::write(std::ostream& os) const
+{
+	std::scoped_lock lock {_mutex};
+
+	for (const auto& [name, family] : _families)
+	{
+		os << "# HELP " << name << " " << family.help << "\n";
+		switch (family.type)
+		{
+			case Type::Counter:
+				os << "# TYPE " << name << " counter\n";
+				for (const auto& [labels, counter] : family.counters)
+				{
+					os << name;
+					writeLabels(os, labels);
+					os << " " << counter->getValue() << "\n";
+				}
+				break;
+
+			case Type::Gauge:
+				os << "# TYPE " << name << " gauge\n";
+				for (const auto& [labels, gauge] : family.gauges)
+				{
+					os << name;
+					writeLabels(os, labels);
+					os << " " << gauge->getValue() << "\n";
+				}
+				break;
+
+			case Type::Histogram:
+				os << "# TYPE " << name << " histogram\n";
+				for (const auto& [labels, histogram] : family.histograms)
+				{
+					const Histogram::Snapshot snapshot {histogram->getSnapshot()};
+					const std::vector<double>& bounds {histogram->getBounds()};
+
+					std::uint64_t cumulativeCount {};
+					for (std::size_t i {}; i < snapshot.bucketCounts.size(); ++i)
+					{
+						cumulativeCount += snapshot.bucketCounts[i];
+
+						const std::pair<std::string, std::string> le {"le", toString(i < bounds.size() ? bounds[i] : std::numeric_limits<double>::infinity())};
+						os << name << "_bucket";
+						writeLabels(os, labels, &le);
+						os << " " << cumulativeCount << "\n";
+					}
+
+					os << name << "_sum";
+					writeLabels(os, labels);
+					os << " " << toString(snapshot.sum) << "\n";
+
+					os << name << "_count";
+					writeLabels(os, labels);
+					os << " " << snapshot.count << "\n";
+				}
+				break;
+		}
+	}
+}
+
+Registry&
+getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+} // namespace Metrics
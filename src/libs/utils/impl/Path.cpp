@@ -23,8 +23,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <array>
 #include <fstream>
+#include <vector>
 
 #include <boost/tokenizer.hpp>
 
@@ -40,10 +40,9 @@ computeCrc32(const std::filesystem::path& p)
 	std::ifstream ifs {p.string().c_str(), std::ios_base::binary};
 	if (ifs)
 	{
+		std::vector<char> buffer(65536);
 		do
 		{
-			std::array<char,1024>	buffer;
-
 			ifs.read( buffer.data(), buffer.size() );
 			crc32.processBytes( reinterpret_cast<const std::byte*>(buffer.data()), ifs.gcount() );
 		}
@@ -19,14 +19,54 @@
 
 #include "utils/WtLogger.hpp"
 
+#include <algorithm>
+
 #include <Wt/WApplication.h>
 #include <Wt/WLogger.h>
 
 #include "utils/Logger.hpp"
 
+namespace
+{
+	std::string
+	getModuleScope(Module module)
+	{
+		std::string scope {getModuleName(module)};
+		scope.erase(std::remove(std::begin(scope), std::end(scope), ' '), std::end(scope));
+
+		return scope;
+	}
+}
+
+WtLogger::WtLogger(const std::string& logConfig, Wt::WLogger* wtLogger)
+: _wtLogger {wtLogger}
+{
+	// Only used to evaluate the configuration, so that filtered out logs are not even formatted
+	Wt::WLogger wtLogger;
+	wtLogger.configure(logConfig);
+
+	for (std::size_t i {}; i < ModuleCount; ++i)
+	{
+		const Module module {static_cast<Module>(i)};
+		const std::string scope {getModuleScope(module)};
+
+		for (std::size_t j {}; j < SeverityCount; ++j)
+		{
+			const Severity severity {static_cast<Severity>(j)};
+			setSeverityActive(module, severity, wtLogger.logging(getSeverityName(severity), scope));
+		}
+	}
+}
+
 void
 WtLogger::processLog(const Log& log)
 {
-	Wt::log(getSeverityName(log.getSeverity())) << Wt::WLogger::sep << "[" << getModuleName(log.getModule()) << "]" << Wt::WLogger::sep << log.getMessage();
+	// Wt filters the entries again using log-config, the scope being the message prefix ending with ": "
+	// Use the same scope as the one used to compute the active severities, otherwise Wt would drop the module specific entries
+	const char* type {getSeverityName(log.getSeverity())};
+	if (_wtLogger)
+		_wtLogger->entry(type) << "[" << type << "]" << Wt::WLogger::sep << getModuleScope(log.getModule()) << ": " << log.getMessage();
+	else
+		Wt::log(type) << Wt::WLogger::sep << getModuleScope(log.getModule()) << ": " << log.getMessage();
 }
 
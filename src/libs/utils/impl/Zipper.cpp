@@ -19,8 +19,14 @@
 
 #include "utils/Zipper.hpp"
 
+#include <cassert>
+#include <cerrno>
 #include <cstddef>
-#include <fstream>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <Wt/WDate.h>
 #include <Wt/WTime.h>
@@ -251,24 +257,47 @@ namespace Zip
 			static constexpr SizeType getHeaderSize() { return 22; }
 	};
 
-	Zipper::Zipper(const std::map<std::string, std::filesystem::path>& files, const Wt::WDateTime& lastModifiedTime)
+	static
+	std::map<std::string, Entry>
+	filesToEntries(const std::map<std::string, std::filesystem::path>& files)
 	{
+		std::map<std::string, Entry> entries;
+
 		for (const auto& [filename, filePath] : files)
+			entries.emplace(filename, Entry {filePath, std::nullopt, {}});
+
+		return entries;
+	}
+
+	Zipper::Zipper(const std::map<std::string, std::filesystem::path>& files, const Wt::WDateTime& lastModifiedTime)
+		: Zipper {filesToEntries(files), lastModifiedTime}
+	{
+	}
+
+	Zipper::Zipper(const std::map<std::string, Entry>& entries, const Wt::WDateTime& lastModifiedTime)
+	{
+		for (const auto& [filename, entry] : entries)
 		{
 			FileContext fileContext;
-			fileContext.filePath = filePath;
+			fileContext.filePath = entry.filePath;
 
 			std::error_code ec;
-			fileContext.fileSize = std::filesystem::file_size(filePath, ec);
+			fileContext.fileSize = std::filesystem::file_size(entry.filePath, ec);
 			if (ec)
-				throw ZipperException {"Cannot get file size for '" + filePath.string() + "': " + ec.message()};
+				throw ZipperException {"Cannot get file size for '" + entry.filePath.string() + "': " + ec.message()};
+
+			const Wt::WDateTime fileLastWriteTime {getLastWriteTime(entry.filePath)};
+			fileContext.fileLastWriteTime = fileLastWriteTime.toTime_t();
 
 			if (lastModifiedTime.isValid())
 				fileContext.lastModifiedTime = lastModifiedTime;
 			else
-				fileContext.lastModifiedTime = getLastWriteTime(filePath);
+				fileContext.lastModifiedTime = fileLastWriteTime;
 
-			_files[filename] = std::move(fileContext);
+			if (entry.crc32 && entry.crc32LastWriteTime.isValid() && entry.crc32LastWriteTime.toTime_t() == fileContext.fileLastWriteTime)
+				fileContext.precomputedCrc32 = entry.crc32;
+			else
+				_isSeekable = false;
 
 			_totalZipSize += LocalFileHeader::getHeaderSize();
 			_totalZipSize += filename.size();
@@ -278,6 +307,8 @@ namespace Zip
 			_totalZipSize += CentralDirectoryHeader::getHeaderSize();
 			_totalZipSize += filename.size();
 			_totalZipSize += Zip64ExtendedInformationExtraField::getHeaderSize(Zip64ExtendedInformationExtraField::WithFileOffset {});
+
+			_files[filename] = std::move(fileContext);
 		}
 
 		_totalZipSize += Zip64EndOfCentralDirectoryRecord::getHeaderSize();
@@ -287,68 +318,127 @@ namespace Zip
 		_currentFile = std::begin(_files);
 	}
 
-	SizeType
-	Zipper::writeSome(std::byte* buffer, SizeType bufferSize)
+	Zipper::~Zipper()
 	{
-		// make sure we have some room for the headers
-		assert(bufferSize >= minOutputBufferSize);
+		closeCurrentFile();
+	}
 
-		SizeType nbTotalWrittenBytes {};
+	void
+	Zipper::openCurrentFile()
+	{
+		assert(_currentFileDescriptor < 0);
+		assert(_currentFile != std::end(_files));
 
-		while (!isComplete() && (bufferSize >= minOutputBufferSize))
-		{
-			SizeType nbWrittenBytes {};
+		const std::filesystem::path& filePath {_currentFile->second.filePath};
 
-			switch (_writeState)
-			{
-				case WriteState::LocalFileHeader:
-					nbWrittenBytes = writeLocalFileHeader(buffer, bufferSize);
-					break;
+		_currentFileDescriptor = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (_currentFileDescriptor < 0)
+			throw ZipperException {"File '" + filePath.string() + "' does no longer exist!"};
 
-				case WriteState::LocalFileHeaderFileName:
-					nbWrittenBytes = writeLocalFileHeaderFileName(buffer, bufferSize);
-					break;
+		struct ::stat fileStat;
+		if (::fstat(_currentFileDescriptor, &fileStat) != 0)
+			throw ZipperException {"Cannot stat file '" + filePath.string() + "': " + ::strerror(errno)};
 
-				case WriteState::LocalFileHeaderExtraFields:
-					nbWrittenBytes = writeLocalFileHeaderExtraFields(buffer, bufferSize);
-					break;
+		if (static_cast<SizeType>(fileStat.st_size) != _currentFile->second.fileSize)
+			throw ZipperException {"File '" + filePath.string() + "': size mismatch!"};
 
-				case WriteState::FileData:
-					nbWrittenBytes = writeFileData(buffer, bufferSize);
-					break;
+		if (_currentFile->second.precomputedCrc32 && fileStat.st_mtime != _currentFile->second.fileLastWriteTime)
+			throw ZipperException {"File '" + filePath.string() + "': modified since its CRC was computed!"};
 
-				case WriteState::DataDescriptor:
-					nbWrittenBytes = writeDataDescriptor(buffer, bufferSize);
-					break;
+#if defined(POSIX_FADV_SEQUENTIAL)
+		::posix_fadvise(_currentFileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	}
 
-				case WriteState::CentralDirectoryHeader:
-					nbWrittenBytes = writeCentralDirectoryHeader(buffer, bufferSize);
-					break;
+	void
+	Zipper::closeCurrentFile()
+	{
+		if (_currentFileDescriptor >= 0)
+		{
+			::close(_currentFileDescriptor);
+			_currentFileDescriptor = -1;
+		}
+	}
 
-				case WriteState::CentralDirectoryHeaderFileName:
-					nbWrittenBytes = writeCentralDirectoryHeaderFileName(buffer, bufferSize);
-					break;
+	std::uint32_t
+	Zipper::getFingerprint() const
+	{
+		Utils::Crc32Calculator fingerprint;
 
-				case WriteState::CentralDirectoryHeaderExtraFields:
-					nbWrittenBytes = writeCentralDirectoryHeaderExtraFields(buffer, bufferSize);
-					break;
+		auto processValue {[&](auto value)
+		{
+			const std::uint64_t value64 {static_cast<std::uint64_t>(value)};
+			fingerprint.processBytes(reinterpret_cast<const std::byte*>(&value64), sizeof(value64));
+		}};
 
-				case WriteState::Zip64EndOfCentralDirectoryRecord:
-					nbWrittenBytes = writeZip64EndOfCentralDirectoryRecord(buffer, bufferSize);
-					break;
+		for (const auto& [filename, fileContext] : _files)
+		{
+			fingerprint.processBytes(reinterpret_cast<const std::byte*>(filename.data()), filename.size() + 1);
+			processValue(fileContext.fileSize);
+			processValue(fileContext.lastModifiedTime.toTime_t());
+			processValue(fileContext.getCrc32());
+		}
 
-				case WriteState::Zip64EndOfCentralDirectoryLocator:
-					nbWrittenBytes = writeZip64EndOfCentralDirectoryLocator(buffer, bufferSize);
-					break;
+		return fingerprint.getResult();
+	}
 
-				case WriteState::EndOfCentralDirectoryRecord:
-					nbWrittenBytes = writeEndOfCentralDirectoryRecord(buffer, bufferSize);
-					break;
+	void
+	Zipper::seek(SizeType offset)
+	{
+		if (!_isSeekable)
+			throw ZipperException {"Archive is not seekable"};
+		if (_currentZipOffset != 0 || _writeState != WriteState::LocalFileHeader)
+			throw ZipperException {"Cannot seek once the archive has been started"};
+		if (offset > _totalZipSize)
+			throw ZipperException {"Seek offset is out of bounds"};
+
+		// Replay the whole layout, without reading file data since CRCs are known
+		while (_currentZipOffset < offset)
+		{
+			const SizeType nbBytesToSkip {offset - _currentZipOffset};
 
-				case WriteState::Complete:
-					break;
+			if (_writeState == WriteState::FileData && _currentOffset < _currentFile->second.fileSize)
+			{
+				const SizeType nbSkippedBytes {std::min(nbBytesToSkip, _currentFile->second.fileSize - _currentOffset)};
+				_currentOffset += nbSkippedBytes;
+				_currentZipOffset += nbSkippedBytes;
+				continue;
 			}
 
+			const SizeType nbWrittenBytes {writeStep(_pendingBytes.data(), _pendingBytes.size())};
+			_currentZipOffset += nbWrittenBytes;
+
+			if (nbWrittenBytes > nbBytesToSkip)
+			{
+				_pendingBytesOffset = nbBytesToSkip;
+				_pendingBytesSize = nbWrittenBytes;
+			}
+		}
+	}
+
+	SizeType
+	Zipper::writeSome(std::byte* buffer, SizeType bufferSize)
+	{
+		// make sure we have some room for the headers
+		assert(bufferSize >= minOutputBufferSize);
+
+		SizeType nbTotalWrittenBytes {};
+
+		if (_pendingBytesOffset < _pendingBytesSize)
+		{
+			const SizeType nbBytesToCopy {std::min(_pendingBytesSize - _pendingBytesOffset, bufferSize)};
+			std::copy(std::next(std::cbegin(_pendingBytes), _pendingBytesOffset), std::next(std::cbegin(_pendingBytes), _pendingBytesOffset + nbBytesToCopy), buffer);
+
+			_pendingBytesOffset += nbBytesToCopy;
+			buffer += nbBytesToCopy;
+			bufferSize -= nbBytesToCopy;
+			nbTotalWrittenBytes += nbBytesToCopy;
+		}
+
+		while (_writeState != WriteState::Complete && (bufferSize >= minOutputBufferSize))
+		{
+			const SizeType nbWrittenBytes {writeStep(buffer, bufferSize)};
+
 			buffer += nbWrittenBytes;
 			bufferSize -= nbWrittenBytes;
 			_currentZipOffset += nbWrittenBytes;
@@ -358,10 +448,55 @@ namespace Zip
 		return nbTotalWrittenBytes;
 	}
 
+	SizeType
+	Zipper::writeStep(std::byte* buffer, SizeType bufferSize)
+	{
+		switch (_writeState)
+		{
+			case WriteState::LocalFileHeader:
+				return writeLocalFileHeader(buffer, bufferSize);
+
+			case WriteState::LocalFileHeaderFileName:
+				return writeLocalFileHeaderFileName(buffer, bufferSize);
+
+			case WriteState::LocalFileHeaderExtraFields:
+				return writeLocalFileHeaderExtraFields(buffer, bufferSize);
+
+			case WriteState::FileData:
+				return writeFileData(buffer, bufferSize);
+
+			case WriteState::DataDescriptor:
+				return writeDataDescriptor(buffer, bufferSize);
+
+			case WriteState::CentralDirectoryHeader:
+				return writeCentralDirectoryHeader(buffer, bufferSize);
+
+			case WriteState::CentralDirectoryHeaderFileName:
+				return writeCentralDirectoryHeaderFileName(buffer, bufferSize);
+
+			case WriteState::CentralDirectoryHeaderExtraFields:
+				return writeCentralDirectoryHeaderExtraFields(buffer, bufferSize);
+
+			case WriteState::Zip64EndOfCentralDirectoryRecord:
+				return writeZip64EndOfCentralDirectoryRecord(buffer, bufferSize);
+
+			case WriteState::Zip64EndOfCentralDirectoryLocator:
+				return writeZip64EndOfCentralDirectoryLocator(buffer, bufferSize);
+
+			case WriteState::EndOfCentralDirectoryRecord:
+				return writeEndOfCentralDirectoryRecord(buffer, bufferSize);
+
+			case WriteState::Complete:
+				break;
+		}
+
+		return 0;
+	}
+
 	bool
 	Zipper::isComplete() const
 	{
-		return _writeState == WriteState::Complete;
+		return _writeState == WriteState::Complete && _pendingBytesOffset == _pendingBytesSize;
 	}
 
 	SizeType
@@ -444,31 +579,34 @@ namespace Zip
 
 		if (_currentOffset == _currentFile->second.fileSize)
 		{
+			closeCurrentFile();
 			_currentOffset = 0;
 			_writeState = WriteState::DataDescriptor;
 			return 0;
 		}
 
-		const std::string filePath {_currentFile->second.filePath.string()};
+		if (_currentFileDescriptor < 0)
+			openCurrentFile();
 
-		std::ifstream ifs {filePath.c_str(), std::ios_base::binary};
-		if (!ifs)
-			throw ZipperException {"File '" + filePath + "' does no longer exist!"};
+		SizeType nbBytesToRead {std::min(_currentFile->second.fileSize - _currentOffset, bufferSize)};
 
-		ifs.seekg(0, std::ios::end);
-		const ::uint64_t fileSize {static_cast<::uint64_t>(ifs.tellg())};
-		ifs.seekg(0, std::ios::beg);
+		// Try to keep the reads aligned on block boundaries
+		if (nbBytesToRead > _readBlockSize && (_currentOffset + nbBytesToRead) < _currentFile->second.fileSize)
+			nbBytesToRead -= (_currentOffset + nbBytesToRead) % _readBlockSize;
 
-		if (fileSize != _currentFile->second.fileSize)
-			throw ZipperException {"File '" + filePath + "': size mismatch!"};
-
-		const SizeType nbBytesToRead {std::min(static_cast<std::size_t>(fileSize) - _currentOffset, bufferSize)};
+		::ssize_t actualReadSize;
+		do
+		{
+			actualReadSize = ::pread(_currentFileDescriptor, buffer, nbBytesToRead, static_cast<::off_t>(_currentOffset));
+		} while (actualReadSize < 0 && errno == EINTR);
 
-		ifs.seekg(_currentOffset, std::ios::beg);
-		ifs.read(reinterpret_cast<char*>(buffer), nbBytesToRead );
-		const ::uint64_t actualReadSize {static_cast<::uint64_t>(ifs.gcount())};
+		if (actualReadSize < 0)
+			throw ZipperException {"Read failed on file '" + _currentFile->second.filePath.string() + "': " + ::strerror(errno)};
+		if (actualReadSize == 0)
+			throw ZipperException {"File '" + _currentFile->second.filePath.string() + "': unexpected end of file!"};
 
-		_currentFile->second.fileCrc32.processBytes(buffer, actualReadSize);
+		if (!_currentFile->second.precomputedCrc32)
+			_currentFile->second.fileCrc32.processBytes(buffer, actualReadSize);
 		_currentOffset += actualReadSize;
 
 		return actualReadSize;
@@ -484,7 +622,7 @@ namespace Zip
 
 		DataDescriptor desc {buffer, bufferSize};
 		desc.setSignature();
-		desc.setCrc32UncompressedData(_currentFile->second.fileCrc32.getResult());
+		desc.setCrc32UncompressedData(_currentFile->second.getCrc32());
 		desc.setCompressedSize(_currentFile->second.fileSize);
 		desc.setUncompressedSize(_currentFile->second.fileSize);
 
@@ -519,7 +657,7 @@ namespace Zip
 		header.setCompressedSize();
 		header.setUncompressedSize();
 		header.setLastModifiedDateTime(_currentFile->second.lastModifiedTime);
-		header.setCrc32UncompressedData(_currentFile->second.fileCrc32.getResult());
+		header.setCrc32UncompressedData(_currentFile->second.getCrc32());
 		header.setFileNameLength(_currentFile->first.size());
 		header.setExtraFieldLength(Zip64ExtendedInformationExtraField::getHeaderSize(Zip64ExtendedInformationExtraField::WithFileOffset {}));
 		header.setFileCommentLength(0);
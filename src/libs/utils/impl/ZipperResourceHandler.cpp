@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ZipperResourceHandler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "utils/Logger.hpp"
+
+namespace
+{
+	std::string
+	computeETag(const Zip::Zipper& zipper)
+	{
+		std::ostringstream oss;
+		oss << "\"" << std::hex << zipper.getFingerprint() << "-" << zipper.getTotalZipFile() << "\"";
+		return oss.str();
+	}
+
+	void
+	setRangeNotSatisfiable(Wt::Http::Response& response, Zip::SizeType totalSize)
+	{
+		std::ostringstream contentRange;
+		contentRange << "bytes */" << totalSize;
+		response.setStatus(416); // Requested range not satisfiable
+		response.addHeader("Content-Range", contentRange.str());
+	}
+}
+
+std::unique_ptr<IResourceHandler>
+createZipperResourceHandler(std::unique_ptr<Zip::Zipper> zipper)
+{
+	return std::make_unique<ZipperResourceHandler>(std::move(zipper));
+}
+
+ZipperResourceHandler::ZipperResourceHandler(std::unique_ptr<Zip::Zipper> zipper)
+: _zipper {std::move(zipper)}
+{
+}
+
+Wt::Http::ResponseContinuation*
+ZipperResourceHandler::processRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	if (_isFinished)
+		return {};
+
+	try
+	{
+		if (_buffer.empty())
+		{
+			if (!prepare(request, response))
+			{
+				finish();
+				return {};
+			}
+		}
+
+		// the zipper may output more than requested, just drop the extra bytes
+		std::size_t nbWrittenBytes {_zipper->writeSome(_buffer.data(), _buffer.size())};
+		nbWrittenBytes = std::min<Zip::SizeType>(nbWrittenBytes, _remainingBytes);
+		_remainingBytes -= nbWrittenBytes;
+
+		response.out().write(reinterpret_cast<const char *>(_buffer.data()), nbWrittenBytes);
+
+		if (!_zipper->isComplete() && _remainingBytes > 0)
+			return response.createContinuation();
+	}
+	catch (const Zip::ZipperException& exception)
+	{
+		LMS_LOG(UTILS, ERROR) << "Zipper exception: " << exception.what();
+	}
+
+	finish();
+	return {};
+}
+
+bool
+ZipperResourceHandler::prepare(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	const Zip::SizeType totalSize {_zipper->getTotalZipFile()};
+
+	response.setMimeType("application/zip");
+
+	_remainingBytes = totalSize;
+	_buffer.resize(_bufferSize);
+
+	if (!_zipper->isSeekable())
+	{
+		response.setStatus(200);
+		response.setContentLength(totalSize);
+		return true;
+	}
+
+	const std::string etag {computeETag(*_zipper)};
+	response.addHeader("Accept-Ranges", "bytes");
+	response.addHeader("ETag", etag);
+
+	const Wt::Http::Request::ByteRangeSpecifier ranges {request.getRanges(totalSize)};
+	if (!ranges.isSatisfiable())
+	{
+		LMS_LOG(UTILS, DEBUG) << "Range not satisfiable";
+		setRangeNotSatisfiable(response, totalSize);
+		return false;
+	}
+
+	// Multiple ranges are not supported, just send the whole archive
+	// Only honour ranges if the client has the same version of the archive
+	const std::string ifRange {request.headerValue("If-Range")};
+	if (ranges.size() != 1 || (!ifRange.empty() && ifRange != etag))
+	{
+		response.setStatus(200);
+		response.setContentLength(totalSize);
+		return true;
+	}
+
+	const Zip::SizeType firstByte {ranges[0].firstByte()};
+	const Zip::SizeType lastByte {ranges[0].lastByte()};
+
+	LMS_LOG(UTILS, DEBUG) << "Range requested = " << firstByte << "-" << lastByte << "/" << totalSize;
+
+	// Seek before committing any header: nothing would be sent otherwise
+	try
+	{
+		_zipper->seek(firstByte);
+	}
+	catch (const Zip::ZipperException& exception)
+	{
+		LMS_LOG(UTILS, ERROR) << "Cannot seek archive to offset " << firstByte << ": " << exception.what();
+		setRangeNotSatisfiable(response, totalSize);
+		return false;
+	}
+
+	std::ostringstream contentRange;
+	contentRange << "bytes " << firstByte << "-" << lastByte << "/" << totalSize;
+
+	response.setStatus(206);
+	response.addHeader("Content-Range", contentRange.str());
+	response.setContentLength(lastByte - firstByte + 1);
+
+	_remainingBytes = lastByte - firstByte + 1;
+
+	return true;
+}
+
+void
+ZipperResourceHandler::finish()
+{
+	_isFinished = true;
+	_zipper.reset();
+
+	_buffer.clear();
+	_buffer.shrink_to_fit();
+}
+
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "utils/IResourceHandler.hpp"
+#include "utils/Zipper.hpp"
+
+class ZipperResourceHandler final : public IResourceHandler
+{
+	public:
+		ZipperResourceHandler(std::unique_ptr<Zip::Zipper> zipper);
+
+	private:
+		ZipperResourceHandler(const ZipperResourceHandler&) = delete;
+		ZipperResourceHandler(ZipperResourceHandler&&) = delete;
+		ZipperResourceHandler& operator=(const ZipperResourceHandler&) = delete;
+		ZipperResourceHandler& operator=(ZipperResourceHandler&&) = delete;
+
+		Wt::Http::ResponseContinuation* processRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+		// Set up the zipper and the response according to the requested range, if any
+		// return false if there is nothing to send
+		bool prepare(const Wt::Http::Request& request, Wt::Http::Response& response);
+		void finish();
+
+		static constexpr std::size_t _bufferSize {262144};
+
+		std::unique_ptr<Zip::Zipper>	_zipper;
+		std::vector<std::byte>		_buffer;
+		Zip::SizeType			_remainingBytes {};
+		bool				_isFinished {};
+};
+
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.hpp"
+
+// Formats the logs in the calling thread and hands them to a background thread
+// that forwards them to the wrapped logger
+// Logs are dropped (and later reported) if the buffer is full, the calling thread never blocks
+class AsyncLogger final : public Logger
+{
+	public:
+		// capacity is rounded up to a power of two
+		AsyncLogger(std::unique_ptr<Logger> logger, std::size_t capacity = 8192);
+		~AsyncLogger() override;
+
+		AsyncLogger(const AsyncLogger&) = delete;
+		AsyncLogger(AsyncLogger&&) = delete;
+		AsyncLogger& operator=(const AsyncLogger&) = delete;
+		AsyncLogger& operator=(AsyncLogger&&) = delete;
+
+		void processLog(const Log& log) override;
+
+	private:
+		struct Entry
+		{
+			std::atomic<std::size_t> sequence;
+			Module module;
+			Severity severity;
+			std::string message;
+		};
+
+		// bounded multi producer queue, see http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+		bool push(Module module, Severity severity, std::string&& message);
+		bool pop(Module& module, Severity& severity, std::string& message);
+
+		bool isEmpty() const;
+
+		void run();
+		std::size_t drain();
+		void reportDroppedLogs();
+
+		std::unique_ptr<Logger> _logger;
+		std::vector<Entry> _entries;
+		const std::size_t _mask;
+		alignas(64) std::atomic<std::size_t> _pushIndex {};
+		alignas(64) std::atomic<std::size_t> _popIndex {};
+		alignas(64) std::atomic<std::size_t> _droppedLogCount {};
+		std::atomic<bool> _stop {};
+
+		// the background thread sleeps while the queue is empty, it is woken up by the push that makes it non empty
+		std::mutex _mutex;
+		std::condition_variable _cv;
+		std::thread _thread;
+};
+
@@ -19,10 +19,59 @@
 
 #pragma once
 
-#include <boost/crc.hpp>  // for boost::crc_32_type
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 
 namespace Utils
 {
+	namespace details
+	{
+		// Tables for the "slicing-by-8" algorithm (reflected polynomial 0xEDB88320, same results as boost::crc_32_type)
+		using Crc32Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+		constexpr Crc32Tables
+		computeCrc32Tables()
+		{
+			Crc32Tables tables {};
+
+			for (std::uint32_t i {}; i < 256; ++i)
+			{
+				std::uint32_t crc {i};
+				for (unsigned j {}; j < 8; ++j)
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+
+				tables[0][i] = crc;
+			}
+
+			for (std::size_t slice {1}; slice < tables.size(); ++slice)
+			{
+				for (std::uint32_t i {}; i < 256; ++i)
+					tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+			}
+
+			return tables;
+		}
+
+		inline constexpr Crc32Tables crc32Tables {computeCrc32Tables()};
+
+		constexpr bool
+		isBigEndian()
+		{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		constexpr std::uint32_t
+		byteSwap(std::uint32_t value)
+		{
+			return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+		}
+	}
 
 	class Crc32Calculator
 	{
@@ -30,18 +79,49 @@ namespace Utils
 
 			void processBytes(const std::byte* _data, std::size_t dataSize)
 			{
-				_result.process_bytes(_data, dataSize);
+				const auto& tables {details::crc32Tables};
+				std::uint32_t crc {_crc};
+
+				// process 8 bytes at a time
+				while (dataSize >= 8)
+				{
+					std::uint32_t low;
+					std::uint32_t high;
+					std::memcpy(&low, _data, sizeof(low));
+					std::memcpy(&high, _data + 4, sizeof(high));
+					if constexpr (details::isBigEndian())
+					{
+						low = details::byteSwap(low);
+						high = details::byteSwap(high);
+					}
+					low ^= crc;
+
+					crc = tables[7][low & 0xFF]
+						^ tables[6][(low >> 8) & 0xFF]
+						^ tables[5][(low >> 16) & 0xFF]
+						^ tables[4][low >> 24]
+						^ tables[3][high & 0xFF]
+						^ tables[2][(high >> 8) & 0xFF]
+						^ tables[1][(high >> 16) & 0xFF]
+						^ tables[0][high >> 24];
+
+					_data += 8;
+					dataSize -= 8;
+				}
+
+				while (dataSize-- > 0)
+					crc = (crc >> 8) ^ tables[0][(crc ^ std::to_integer<std::uint32_t>(*_data++)) & 0xFF];
+
+				_crc = crc;
 			}
 
 			std::uint32_t getResult() const
 			{
-				return _result.checksum();
+				return ~_crc;
 			}
 
 		private:
-			using Crc32Type = boost::crc_32_type;
-			Crc32Type _result;
+			std::uint32_t _crc {0xFFFFFFFF};
 	};
 
 }
-
@@ -21,8 +21,10 @@
 
 #include <filesystem>
 #include <memory>
+#include <string_view>
 
 #include "utils/IResourceHandler.hpp"
 
-std::unique_ptr<IResourceHandler> createFileResourceHandler(const std::filesystem::path& path);
+// mimeType is guessed from the file extension if empty
+std::unique_ptr<IResourceHandler> createFileResourceHandler(const std::filesystem::path& path, std::string_view mimeType = "");
 
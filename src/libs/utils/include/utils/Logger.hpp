@@ -19,6 +19,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <sstream>
 
@@ -32,6 +35,8 @@ enum class Severity
 	INFO,
 	DEBUG,
 };
+static inline constexpr std::size_t SeverityCount {5};
+static_assert(static_cast<std::size_t>(Severity::DEBUG) + 1 == SeverityCount, "SeverityCount must match the Severity enum");
 
 enum class Module
 {
@@ -52,6 +57,8 @@ enum class Module
 	UI,
 	UTILS,
 };
+static inline constexpr std::size_t ModuleCount {16};
+static_assert(static_cast<std::size_t>(Module::UTILS) + 1 == ModuleCount, "ModuleCount must match the Module enum");
 
 const char* getModuleName(Module mod);
 const char* getSeverityName(Severity sev);
@@ -79,9 +86,42 @@ class Log
 class Logger
 {
 	public:
+		Logger();
 		virtual ~Logger() = default;
+
 		virtual void processLog(const Log& log) = 0;
+
+		// Checked before the log is formatted: must be cheap
+		bool isSeverityActive(Module module, Severity severity) const
+		{
+			return _activeSeverities[static_cast<std::size_t>(module)].load(std::memory_order_relaxed) & (1u << static_cast<unsigned>(severity));
+		}
+
+		// Activates the given severity and the more important ones, deactivates the others
+		void setSeverityThreshold(Module module, Severity severity);
+		void setSeverityThreshold(Severity severity);
+
+	protected:
+		void setSeverityActive(Module module, Severity severity, bool active);
+
+	private:
+		// bit mask of active severities, for each module
+		std::array<std::atomic<std::uint8_t>, ModuleCount> _activeSeverities;
+};
+
+inline bool
+isLogActive(Module module, Severity severity)
+{
+	const Logger* logger {Service<Logger>::get()};
+	return logger && logger->isSeverityActive(module, severity);
+}
+
+// Used to turn the log stream expression into a void expression
+struct LogVoidify
+{
+	void operator&(std::ostream&) {}
 };
 
-#define LMS_LOG(module, severity)	Log(Service<Logger>::get(), Module::module, Severity::severity).getOstream()
+// Nothing after LMS_LOG(...) is evaluated if the severity is not active for the module
+#define LMS_LOG(module, severity)	!isLogActive(Module::module, Severity::severity) ? (void)0 : LogVoidify {} & Log(Service<Logger>::get(), Module::module, Severity::severity).getOstream()
 
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Process wide metrics, exposed using the Prometheus text format
+// Updating a metric is lock free: values are spread over per thread shards that are summed on read
+// Metrics are created once and never destroyed: references can be kept in static variables
+namespace Metrics {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+namespace details
+{
+	static inline constexpr std::size_t ShardCount {16};
+	std::size_t getCurrentThreadShardIndex();
+
+	struct alignas(64) CounterShard
+	{
+		std::atomic<std::uint64_t> value {};
+	};
+}
+
+class Counter
+{
+	public:
+		Counter() = default;
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+
+		void inc(std::uint64_t value = 1)
+		{
+			_shards[details::getCurrentThreadShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		std::uint64_t getValue() const;
+
+	private:
+		std::array<details::CounterShard, details::ShardCount> _shards;
+};
+
+class Gauge
+{
+	public:
+		Gauge() = default;
+		Gauge(const Gauge&) = delete;
+		Gauge& operator=(const Gauge&) = delete;
+
+		void set(std::int64_t value) { _value.store(value, std::memory_order_relaxed); }
+		void inc(std::int64_t value = 1) { _value.fetch_add(value, std::memory_order_relaxed); }
+		void dec(std::int64_t value = 1) { _value.fetch_sub(value, std::memory_order_relaxed); }
+
+		std::int64_t getValue() const { return _value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<std::int64_t> _value {};
+};
+
+class Histogram
+{
+	public:
+		// bounds: sorted upper bounds of the buckets, the +Inf bucket is implicit
+		Histogram(const std::vector<double>& bounds);
+		Histogram(const Histogram&) = delete;
+		Histogram& operator=(const Histogram&) = delete;
+
+		void observe(double value);
+
+		struct Snapshot
+		{
+			std::vector<std::uint64_t>	bucketCounts; // not cumulative, last one is +Inf
+			double				sum {};
+			std::uint64_t			count {};
+		};
+		Snapshot getSnapshot() const;
+		const std::vector<double>& getBounds() const { return _bounds; }
+
+	private:
+		struct alignas(64) Shard
+		{
+			std::unique_ptr<std::atomic<std::uint64_t>[]>	bucketCounts;
+			std::atomic<double>				sum {};
+		};
+
+		const std::vector<double> _bounds;
+		std::array<Shard, details::ShardCount> _shards;
+};
+
+// Observes the elapsed time in seconds, on destruction
+class ScopedTimer
+{
+	public:
+		ScopedTimer(Histogram& histogram) : _histogram {histogram} {}
+		~ScopedTimer()
+		{
+			_histogram.observe(std::chrono::duration<double> {std::chrono::steady_clock::now() - _start}.count());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		Histogram& _histogram;
+		const std::chrono::steady_clock::time_point _start {std::chrono::steady_clock::now()};
+};
+
+// Buckets suitable for most latencies, in seconds
+const std::vector<double>& getDurationBuckets();
+
+class Registry
+{
+	public:
+		Registry() = default;
+		Registry(const Registry&) = delete;
+		Registry& operator=(const Registry&) = delete;
+
+		// Get or create the metric. Throws LmsException if the name is already used by another kind of metric
+		// Names should follow the Prometheus conventions (ex: lms_foo_bar_seconds, lms_foo_total)
+		Counter&	getCounter(const std::string& name, const std::string& help, const Labels& labels = {});
+		Gauge&		getGauge(const std::string& name, const std::string& help, const Labels& labels = {});
+		Histogram&	getHistogram(const std::string& name, const std::string& help, const std::vector<double>& bounds, const Labels& labels = {});
+
+		// Prometheus text exposition format
+		void write(std::ostream& os) const;
+
+	private:
+		enum class Type
+		{
+			Counter,
+			Gauge,
+			Histogram,
+		};
+
+		struct Family
+		{
+			Type type;
+			std::string help;
+			std::map<Labels, std::unique_ptr<Counter>>	counters;
+			std::map<Labels, std::unique_ptr<Gauge>>	gauges;
+			std::map<Labels, std::unique_ptr<Histogram>>	histograms;
+		};
+
+		Family& getFamily(const std::string& name, const std::string& help, Type type);
+
+		mutable std::mutex _mutex;
+		std::map<std::string, Family> _families;
+};
+
+Registry& getRegistry();
+
+} // namespace Metrics
+
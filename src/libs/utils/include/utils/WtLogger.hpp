@@ -19,11 +19,26 @@
 
 #pragma once
 
+#include <string>
+
 #include "Logger.hpp"
 
+namespace Wt
+{
+	class WLogger;
+}
+
 class WtLogger final : public Logger
 {
 	public:
+		static inline const std::string defaultLogConfig {"* -debug -info:WebRequest"};
+
+		// logConfig uses the Wt log-config syntax, module names can be used as scopes (ex: "* -debug debug:DBUPDATER")
+		// Logs are written to wtLogger if set, otherwise to the logger of the current Wt application or server
+		WtLogger(const std::string& logConfig = defaultLogConfig, Wt::WLogger* wtLogger = nullptr);
+
 		void processLog(const Log& log) override;
-};
 
+	private:
+		Wt::WLogger* _wtLogger {};
+};
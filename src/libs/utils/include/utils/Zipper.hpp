@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <array>
+#include <ctime>
 #include <filesystem>
 #include <map>
+#include <optional>
 
 #include <Wt/WDateTime.h>
 
@@ -36,12 +39,29 @@ namespace Zip
 		using LmsException::LmsException;
 	};
 
+	struct Entry
+	{
+		std::filesystem::path filePath;
+		// Precomputed CRC, only used if the file has not been modified since crc32LastWriteTime
+		std::optional<std::uint32_t> crc32;
+		Wt::WDateTime crc32LastWriteTime;
+	};
+
 	// Very simple on-the-fly zip creator, "store" method only
+	// If the CRCs of all the files are known in advance, the archive layout is fully
+	// deterministic and the output can start at any offset (see seek)
 	class Zipper
 	{
 		public:
 
 			Zipper(const std::map<std::string, std::filesystem::path>& files, const Wt::WDateTime& lastModifiedTime = {});
+			Zipper(const std::map<std::string, Entry>& entries, const Wt::WDateTime& lastModifiedTime = {});
+			~Zipper();
+
+			Zipper(const Zipper&) = delete;
+			Zipper(Zipper&&) = delete;
+			Zipper& operator=(const Zipper&) = delete;
+			Zipper& operator=(Zipper&&) = delete;
 
 			static constexpr SizeType minOutputBufferSize {64};
 			SizeType writeSome(std::byte* buffer, SizeType bufferSize);
@@ -49,8 +69,17 @@ namespace Zip
 
 			SizeType getTotalZipFile() const { return _totalZipSize; }
 
+			bool isSeekable() const { return _isSeekable; }
+			// Identifies the archive content, only meaningful if seekable
+			std::uint32_t getFingerprint() const;
+			// Must be called before any write, throws if not seekable
+			void seek(SizeType offset);
+
 		private:
 			void setComplete();
+			SizeType writeStep(std::byte* buffer, SizeType bufferSize);
+			void openCurrentFile();
+			void closeCurrentFile();
 
 			SizeType writeLocalFileHeader(std::byte* buffer, SizeType bufferSize);
 			SizeType writeLocalFileHeaderFileName(std::byte* buffer, SizeType bufferSize);
@@ -69,8 +98,12 @@ namespace Zip
 				std::filesystem::path filePath;
 				SizeType fileSize;
 				Wt::WDateTime lastModifiedTime;
+				std::time_t fileLastWriteTime {};
 				Utils::Crc32Calculator fileCrc32;
+				std::optional<std::uint32_t> precomputedCrc32;
 				SizeType localFileHeaderOffset {};
+
+				std::uint32_t getCrc32() const { return precomputedCrc32 ? *precomputedCrc32 : fileCrc32.getResult(); }
 			};
 
 			using FileContainer = std::map<std::string, FileContext>;
@@ -93,6 +126,7 @@ namespace Zip
 			};
 
 			SizeType _totalZipSize {};
+			bool _isSeekable {true};
 			WriteState _writeState {WriteState::LocalFileHeader};
 			FileContainer::iterator _currentFile;
 			SizeType _currentOffset {};
@@ -100,6 +134,15 @@ namespace Zip
 			SizeType _centralDirectoryOffset {};
 			SizeType _centralDirectorySize {};
 			SizeType _zip64EndOfCentralDirectoryRecordOffset {};
+
+			// file being written, kept open until all its data is written
+			static constexpr SizeType _readBlockSize {4096};
+			int _currentFileDescriptor {-1};
+
+			// bytes generated while seeking that still have to be output
+			std::array<std::byte, minOutputBufferSize> _pendingBytes;
+			SizeType _pendingBytesOffset {};
+			SizeType _pendingBytesSize {};
 	};
 
 } // namespace Zip
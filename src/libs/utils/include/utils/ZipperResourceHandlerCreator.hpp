@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2018 Emeric Poupon
+ * Copyright (C) 2021 Emeric Poupon
  *
  * This file is part of LMS.
  *
@@ -19,12 +19,11 @@
 
 #pragma once
 
-#include <string>
+#include <memory>
 
-class UUID;
+#include "utils/IResourceHandler.hpp"
+#include "utils/Zipper.hpp"
 
-namespace AcousticBrainz
-{
-	std::string extractLowLevelFeatures(const UUID& MBID);
-}
+// Serves the archive as "application/zip", honours single byte ranges if the archive is seekable
+std::unique_ptr<IResourceHandler> createZipperResourceHandler(std::unique_ptr<Zip::Zipper> zipper);
 
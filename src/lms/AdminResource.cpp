@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AdminResource.hpp"
+
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/Utils.h>
+
+#include "auth/IPasswordService.hpp"
+#include "database/Db.hpp"
+#include "database/Session.hpp"
+#include "database/User.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+
+AdminResource::AdminResource(Database::Db& db)
+: _db {db}
+{
+}
+
+void
+AdminResource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	if (!isAdminRequest(request))
+	{
+		response.setStatus(401);
+		response.addHeader("WWW-Authenticate", "Basic realm=\"LMS admin\"");
+		return;
+	}
+
+	handleAdminRequest(request, response);
+}
+
+bool
+AdminResource::isAdminRequest(const Wt::Http::Request& request) const
+{
+	static const std::string basicPrefix {"Basic "};
+
+	const std::string authorization {request.headerValue("Authorization")};
+	if (authorization.compare(0, basicPrefix.size(), basicPrefix) != 0)
+		return false;
+
+	const std::string credentials {Wt::Utils::base64Decode(authorization.substr(basicPrefix.size()))};
+	const std::string::size_type separatorPos {credentials.find(':')};
+	if (separatorPos == std::string::npos)
+		return false;
+
+	const std::string loginName {credentials.substr(0, separatorPos)};
+	const std::string password {credentials.substr(separatorPos + 1)};
+
+	try
+	{
+		Database::Session& session {_db.getTLSSession()};
+
+		const boost::asio::ip::address clientAddress {boost::asio::ip::address::from_string(request.clientAddress())};
+		if (Service<Auth::IPasswordService>::get()->checkUserPassword(session, clientAddress, loginName, password) != Auth::IPasswordService::PasswordCheckResult::Match)
+		{
+			LMS_LOG(MAIN, INFO) << "Admin resource: bad credentials for user '" << loginName << "'";
+			return false;
+		}
+
+		auto transaction {session.createSharedTransaction()};
+
+		const Database::User::pointer user {Database::User::getByLoginName(session, loginName)};
+		return user && user->isAdmin();
+	}
+	catch (const std::exception& e)
+	{
+		LMS_LOG(MAIN, ERROR) << "Admin resource: cannot check credentials: " << e.what();
+		return false;
+	}
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Wt/WResource.h>
+
+namespace Database
+{
+	class Db;
+}
+
+// Resource only accessible to admin users, using HTTP basic authentication
+class AdminResource : public Wt::WResource
+{
+	public:
+		AdminResource(Database::Db& db);
+
+	protected:
+		virtual void handleAdminRequest(const Wt::Http::Request& request, Wt::Http::Response& response) = 0;
+
+		Database::Db& getDb() { return _db; }
+
+	private:
+		void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+		bool isAdminRequest(const Wt::Http::Request& request) const;
+
+		Database::Db& _db;
+};
+
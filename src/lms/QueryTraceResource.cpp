@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "QueryTraceResource.hpp"
+
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+
+#include "database/Db.hpp"
+#include "database/QueryTracer.hpp"
+
+QueryTraceResource::QueryTraceResource(Database::Db& db)
+: AdminResource {db}
+{
+}
+
+QueryTraceResource::~QueryTraceResource()
+{
+	beingDeleted();
+}
+
+void
+QueryTraceResource::handleAdminRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	Database::QueryTracer* queryTracer {getDb().getQueryTracer()};
+	if (!queryTracer)
+	{
+		response.setStatus(404);
+		response.out() << "Query tracing is not enabled, see db-query-tracing in the configuration file\n";
+		return;
+	}
+
+	response.setMimeType("text/plain");
+
+	if (request.method() == "GET")
+	{
+		queryTracer->writeReport(response.out());
+	}
+	else if (request.method() == "POST")
+	{
+		queryTracer->clear();
+		response.out() << "Query traces cleared\n";
+	}
+	else
+	{
+		response.setStatus(405);
+		response.addHeader("Allow", "GET, POST");
+	}
+}
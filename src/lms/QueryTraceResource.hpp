@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "AdminResource.hpp"
+
+// Dumps the slowest database queries, if query tracing is enabled
+// GET dumps the traces, POST resets them
+class QueryTraceResource final : public AdminResource
+{
+	public:
+		QueryTraceResource(Database::Db& db);
+		~QueryTraceResource();
+
+		static inline const std::string path {"/admin/slow-queries"};
+
+	private:
+		void handleAdminRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+};
+
@@ -17,6 +17,8 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <optional>
 #include <thread>
 
 #include <boost/property_tree/xml_parser.hpp>
@@ -33,10 +35,24 @@
 #include "recommendation/IEngine.hpp"
 #include "subsonic/SubsonicResource.hpp"
 #include "ui/LmsApplication.hpp"
+#include "utils/AsyncLogger.hpp"
 #include "utils/IChildProcessManager.hpp"
 #include "utils/IConfig.hpp"
 #include "utils/Service.hpp"
 #include "utils/WtLogger.hpp"
+#include "MetricsResource.hpp"
+#include "QueryTraceResource.hpp"
+
+static
+std::unique_ptr<Logger>
+createLogger()
+{
+	auto logger {std::make_unique<WtLogger>(Service<IConfig>::get()->getString("log-config", WtLogger::defaultLogConfig))};
+	if (Service<IConfig>::get()->getBool("log-async", false))
+		return std::make_unique<AsyncLogger>(std::move(logger));
+
+	return logger;
+}
 
 static
 std::vector<std::string>
@@ -86,7 +102,7 @@ generateWtConfig(std::string execPath)
 
 	pt.put("server.application-settings.<xmlattr>.location", "*");
 	pt.put("server.application-settings.log-file", wtLogFilePath.string());
-	pt.put("server.application-settings.log-config", Service<IConfig>::get()->getString("log-config", "* -debug -info:WebRequest"));
+	pt.put("server.application-settings.log-config", Service<IConfig>::get()->getString("log-config", WtLogger::defaultLogConfig));
 	pt.put("server.application-settings.behind-reverse-proxy", Service<IConfig>::get()->getBool("behind-reverse-proxy", false));
 
 	{
@@ -182,7 +198,7 @@ int main(int argc, char* argv[])
 		close(STDIN_FILENO);
 
 		Service<IConfig> config {createConfig(configFilePath)};
-		Service<Logger> logger {std::make_unique<WtLogger>()};
+		Service<Logger> logger {createLogger()};
 
 		// Make sure the working directory exists
 		std::filesystem::create_directories(config->getPath("working-dir"));
@@ -202,7 +218,15 @@ int main(int argc, char* argv[])
 		server.setServerConfiguration(wtServerArgs.size(), const_cast<char**>(&wtArgv[0]));
 
 		// Initializing a connection pool to the database that will be shared along services
-		Database::Db database {config->getPath("working-dir") / "lms.db"};
+		std::optional<Database::QueryTracer::Settings> queryTracerSettings;
+		if (config->getBool("db-query-tracing", false))
+		{
+			queryTracerSettings.emplace();
+			queryTracerSettings->maxEntryCount = config->getULong("db-query-tracing-max-entry-count", 50);
+			queryTracerSettings->queryPlanThreshold = std::chrono::milliseconds {config->getULong("db-query-tracing-plan-threshold", 100)};
+		}
+
+		Database::Db database {config->getPath("working-dir") / "lms.db", queryTracerSettings, config->getBool("metrics", false)};
 		{
 			Database::Session session {database};
 			session.prepareTables();
@@ -231,10 +255,16 @@ int main(int argc, char* argv[])
 		});
 
 		API::Subsonic::SubsonicResource subsonicResource {database};
+		MetricsResource metricsResource {database};
+		QueryTraceResource queryTraceResource {database};
 
 		// bind API resources
 		if (config->getBool("api-subsonic", true))
 			server.addResource(&subsonicResource, subsonicResource.getPath());
+		if (config->getBool("metrics", false))
+			server.addResource(&metricsResource, MetricsResource::path);
+		if (config->getBool("db-query-tracing", false))
+			server.addResource(&queryTraceResource, QueryTraceResource::path);
 
 		// bind UI entry point
 		server.addEntryPoint(Wt::EntryPointType::Application,
@@ -300,7 +300,7 @@ MediaPlayer::loadTrack(Database::IdType trackId, bool play, float replayGain)
 
 		const Database::Track::pointer track {Database::Track::getById(LmsApp->getDbSession(), trackId)};
 		if (track)
-			Database::TrackListEntry::create(LmsApp->getDbSession(), track, LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession()));
+			LmsApp->getUser()->addPlayedTrack(LmsApp->getDbSession(), track);
 
 	};
 
@@ -410,7 +410,13 @@ PlayQueue::addSome()
 
 	auto tracklist = getTrackList();
 
-	auto tracklistEntries = tracklist->getEntries(_entriesContainer->count(), 50);
+	// resume after the last displayed entry: removing entries does not make us skip the next ones
+	if (_entriesContainer->count() == 0)
+		_entriesRange = {};
+	_entriesRange.limit = 50;
+
+	bool moreResults {};
+	auto tracklistEntries = tracklist->getEntries(_entriesRange, moreResults);
 	for (const Database::TrackListEntry::pointer& tracklistEntry : tracklistEntries)
 		addEntry(tracklistEntry);
 
@@ -528,6 +534,8 @@ PlayQueue::addEntry(const Database::TrackListEntry::pointer& tracklistEntry)
 					LmsApp->getUser().modify()->unstarTrack(track);
 				else
 					LmsApp->getUser().modify()->starTrack(track);
+
+				LmsApp->getDbSession().bumpUserGeneration(LmsApp->getUser().id());
 			});
 		popup->addItem(Wt::WString::tr("Lms.Explore.download"))
 			->setLink(Wt::WLink {std::make_unique<DownloadTrackResource>(trackId)});
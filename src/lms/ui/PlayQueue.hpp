@@ -89,6 +89,7 @@ class PlayQueue : public Wt::WTemplate
 		bool _mediaPlayerSettingsLoaded {};
 		Database::IdType _tracklistId {};
 		Wt::WContainerWidget* _entriesContainer {};
+		Database::KeysetRange _entriesRange;	// entries already displayed
 		Wt::WTemplate* _loadingIndicator {};
 		Wt::WText* _nbTracks {};
 		Wt::WText* _repeatBtn {};
@@ -26,6 +26,7 @@
 #include <Wt/WFormModel.h>
 #include <Wt/WLineEdit.h>
 #include <Wt/WPushButton.h>
+#include <Wt/WRandom.h>
 #include <Wt/WString.h>
 #include <Wt/WTemplateFormView.h>
 
@@ -61,6 +62,7 @@ class SettingsModel : public Wt::WFormModel
 		static inline const Field SubsonicTranscodeEnableField {"subsonic-transcode-enable"};
 		static inline const Field SubsonicTranscodeFormatField {"subsonic-transcode-format"};
 		static inline const Field SubsonicTranscodeBitrateField {"subsonic-transcode-bitrate"};
+		static inline const Field SubsonicApiKeyField {"subsonic-api-key"};
 		static inline const Field PasswordOldField {"password-old"};
 		static inline const Field PasswordField {"password"};
 		static inline const Field PasswordConfirmField {"password-confirm"};
@@ -83,6 +85,8 @@ class SettingsModel : public Wt::WFormModel
 			addField(SubsonicTranscodeEnableField);
 			addField(SubsonicTranscodeBitrateField);
 			addField(SubsonicTranscodeFormatField);
+			addField(SubsonicApiKeyField);
+			setReadOnly(SubsonicApiKeyField, true);
 
 			if (_withOldPassword)
 				addField(PasswordOldField);
@@ -176,11 +180,26 @@ class SettingsModel : public Wt::WFormModel
 			{
 				user.modify()->setPasswordHash(passwordHash);
 				user.modify()->clearAuthTokens();
+				Service<::Auth::IPasswordService>::get()->clearCachedPasswords(user->getLoginName());
 			}
 
 			auto subsonicArtistListModeRow {_subsonicArtistListModeModel->getRowFromString(valueText(SubsonicArtistListModeField))};
-			if (subsonicArtistListModeRow)
+			if (subsonicArtistListModeRow && _subsonicArtistListModeModel->getValue(*subsonicArtistListModeRow) != user->getSubsonicArtistListMode())
+			{
 				user.modify()->setSubsonicArtistListMode(_subsonicArtistListModeModel->getValue(*subsonicArtistListModeRow));
+				// Subsonic artist listings depend on this setting
+				LmsApp->getDbSession().bumpUserGeneration(user.id());
+			}
+		}
+
+		void generateSubsonicApiKey()
+		{
+			const std::string apiKey {Wt::WRandom::generateId(32)};
+
+			auto transaction {LmsApp->getDbSession().createUniqueTransaction()};
+
+			LmsApp->getUser().modify()->setSubsonicApiKey(apiKey);
+			setValue(SubsonicApiKeyField, apiKey);
 		}
 
 		void loadData()
@@ -232,6 +251,8 @@ class SettingsModel : public Wt::WFormModel
 			auto subsonicArtistListModeRow {_subsonicArtistListModeModel->getRowFromValue(user->getSubsonicArtistListMode())};
 			if (subsonicArtistListModeRow)
 				setValue(SubsonicArtistListModeField, _subsonicArtistListModeModel->getString(*subsonicArtistListModeRow));
+
+			setValue(SubsonicApiKeyField, user->getSubsonicApiKey());
 		}
 
 	private:
@@ -500,6 +521,25 @@ SettingsView::refreshView()
 			t->updateModel(model.get());
 			t->updateView(model.get());
 		});
+
+		// API key, for token based authentication
+		t->setFormWidget(SettingsModel::SubsonicApiKeyField, std::make_unique<Wt::WLineEdit>());
+		Wt::WPushButton* generateApiKeyBtn {t->bindNew<Wt::WPushButton>("subsonic-api-key-generate-btn", Wt::WString::tr("Lms.Settings.subsonic-api-key-generate"))};
+		generateApiKeyBtn->clicked().connect([=]()
+		{
+			{
+				auto transaction {LmsApp->getDbSession().createSharedTransaction()};
+
+				if (LmsApp->getUser()->isDemo())
+				{
+					LmsApp->notifyMsg(LmsApplication::MsgType::Warning, Wt::WString::tr("Lms.Settings.demo-cannot-save"));
+					return;
+				}
+			}
+
+			model->generateSubsonicApiKey();
+			t->updateView(model.get());
+		});
 	}
 
 	// Buttons
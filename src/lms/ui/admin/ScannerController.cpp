@@ -123,6 +123,7 @@ class ReportResource : public Wt::WResource
 			{
 				case Scanner::DuplicateReason::SameHash: return Wt::WString::tr("Lms.Admin.ScannerController.same-hash");
 				case Scanner::DuplicateReason::SameMBID: return Wt::WString::tr("Lms.Admin.ScannerController.same-mbid");
+				case Scanner::DuplicateReason::SameFingerprint: return Wt::WString::tr("Lms.Admin.ScannerController.same-fingerprint");
 			}
 			return "?";
 		}
@@ -233,12 +234,34 @@ ScannerController::refreshContents()
 						.arg(status.currentScanStepStats->progress()));
 					break;
 
+				case Scanner::ScanProgressStep::ComputingTrackFingerprints:
+					bindString("step-status", Wt::WString::tr("Lms.Admin.ScannerController.step-computing-track-fingerprints")
+						.arg(status.currentScanStepStats->processedElems)
+						.arg(status.currentScanStepStats->totalElems)
+						.arg(status.currentScanStepStats->progress()));
+					break;
+
+				case Scanner::ScanProgressStep::ComputingTrackLoudness:
+					bindString("step-status", Wt::WString::tr("Lms.Admin.ScannerController.step-computing-track-loudness")
+						.arg(status.currentScanStepStats->processedElems)
+						.arg(status.currentScanStepStats->totalElems)
+						.arg(status.currentScanStepStats->progress()));
+					break;
+
 				case Scanner::ScanProgressStep::FetchingTrackFeatures:
 					bindString("step-status", Wt::WString::tr("Lms.Admin.ScannerController.step-fetching-track-features")
 						.arg(status.currentScanStepStats->processedElems)
 						.arg(status.currentScanStepStats->totalElems)
 						.arg(status.currentScanStepStats->progress()));
 					break;
+
+				case Scanner::ScanProgressStep::ExtractingTrackFeatures:
+					bindString("step-status", Wt::WString::tr("Lms.Admin.ScannerController.step-extracting-track-features")
+						.arg(status.currentScanStepStats->processedElems)
+						.arg(status.currentScanStepStats->totalElems)
+						.arg(status.currentScanStepStats->progress()));
+					break;
+
 				case Scanner::ScanProgressStep::ReloadingSimilarityEngine:
 					bindString("step-status", Wt::WString::tr("Lms.Admin.ScannerController.step-reloading-similarity-engine")
 						.arg(status.currentScanStepStats->progress()));
@@ -101,6 +101,7 @@ class UserModel : public Wt::WFormModel
 					user.modify()->setPasswordHash(*passwordHash);
 					user.modify()->clearAuthTokens();
 				}
+				Service<::Auth::IPasswordService>::get()->clearCachedPasswords(user->getLoginName());
 			}
 			else
 			{
@@ -23,9 +23,11 @@
 #include <Wt/WMessageBox.h>
 #include <Wt/WTemplate.h>
 
+#include "auth/IPasswordService.hpp"
 #include "database/User.hpp"
 #include "database/Session.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Service.hpp"
 
 #include "LmsApplication.hpp"
 
@@ -105,7 +107,10 @@ UsersView::refreshView()
 
 					Database::User::pointer user {Database::User::getById(LmsApp->getDbSession(), userId)};
 					if (user)
+					{
+						Service<::Auth::IPasswordService>::get()->clearCachedPasswords(user->getLoginName());
 						user.remove();
+					}
 
 					_container->removeWidget(entry);
 				}
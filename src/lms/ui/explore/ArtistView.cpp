@@ -158,6 +158,8 @@ Artist::refreshView()
 							LmsApp->getUser().modify()->unstarArtist(artist);
 						else
 							LmsApp->getUser().modify()->starArtist(artist);
+
+						LmsApp->getDbSession().bumpUserGeneration(LmsApp->getUser().id());
 					});
 			popup->addItem(Wt::WString::tr("Lms.Explore.download"))
 				->setLink(Wt::WLink {std::make_unique<DownloadArtistResource>(*artistId)});
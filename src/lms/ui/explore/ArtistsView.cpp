@@ -25,6 +25,7 @@
 
 #include "common/ValueStringModel.hpp"
 #include "database/Artist.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Session.hpp"
 #include "database/User.hpp"
 #include "database/TrackArtistLink.hpp"
@@ -92,6 +93,7 @@ Artists::refreshView()
 {
 	_container->clear();
 	_randomArtists.clear();
+	_allArtistsRange = {};
 	addSome();
 }
 
@@ -212,15 +214,17 @@ Artists::getArtists(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::RecentlyPlayed:
-			artists = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())
-				->getArtistsReverse(_filters->getClusterIds(),
+			artists = TrackPlayStats::getRecentArtists(LmsApp->getDbSession(),
+						LmsApp->getUser().id(),
+						_filters->getClusterIds(),
 						linkType,
 						range, moreResults);
 			break;
 
 		case Mode::MostPlayed:
-			artists = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())
-				->getTopArtists(_filters->getClusterIds(),
+			artists = TrackPlayStats::getTopArtists(LmsApp->getDbSession(),
+						LmsApp->getUser().id(),
+						_filters->getClusterIds(),
 						linkType,
 						range, moreResults);
 			break;
@@ -234,12 +238,29 @@ Artists::getArtists(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::All:
-			artists = Artist::getByFilter(LmsApp->getDbSession(),
-						_filters->getClusterIds(),
-						{},
-						linkType,
-						Artist::SortMethod::BySortName,
-						range, moreResults);
+			if (range)
+			{
+				// pages are requested one after the other: resume after the last displayed artist
+				if (range->offset == 0)
+					_allArtistsRange = {};
+				_allArtistsRange.limit = range->limit;
+
+				artists = Artist::getByFilter(LmsApp->getDbSession(),
+							_filters->getClusterIds(),
+							{},
+							linkType,
+							Artist::SortMethod::BySortName,
+							_allArtistsRange, moreResults);
+			}
+			else
+			{
+				artists = Artist::getByFilter(LmsApp->getDbSession(),
+							_filters->getClusterIds(),
+							{},
+							linkType,
+							Artist::SortMethod::BySortName,
+							range, moreResults);
+			}
 			break;
 
 		default:
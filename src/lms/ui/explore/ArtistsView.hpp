@@ -77,6 +77,7 @@ class Artists : public Wt::WTemplate
 
 		Mode _mode {defaultMode};
 		std::vector<Database::IdType> _randomArtists;
+		Database::KeysetRange _allArtistsRange;	// for Mode::All, to get the next page right after the last displayed artist
 		Filters* _filters {};
 		Wt::WTemplate* _loadingIndicator {};
 		Wt::WContainerWidget* _container {};
@@ -25,6 +25,7 @@
 
 #include "database/Artist.hpp"
 #include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
 #include "resource/CoverResource.hpp"
 
 #include "LmsApplication.hpp"
@@ -49,32 +50,34 @@ namespace UserInterface::ReleaseListHelpers
 		cover->setAttributeValue("onload", LmsApp->javaScriptClass() + ".onLoadCover(this)");
 		anchor->setImage(std::move(cover));
 
-		auto artists = release->getReleaseArtists();
-		if (artists.empty())
-			artists = release->getArtists();
+		const ReleaseSummary::pointer summary {ReleaseSummary::get(LmsApp->getDbSession(), release)};
 
-		bool isSameArtist {(std::find(std::cbegin(artists), std::cend(artists), artist) != artists.end())};
+		const std::vector<IdType> artistIds {summary->getArtistIds()};
+		bool isSameArtist {(std::find(std::cbegin(artistIds), std::cend(artistIds), artist.id()) != artistIds.end())};
 
-		if (artists.size() > 1)
+		if (artistIds.size() > 1)
 		{
 			entry->setCondition("if-has-artist", true);
 			entry->bindNew<Wt::WText>("artist-name", Wt::WString::tr("Lms.Explore.various-artists"));
 		}
-		else if (artists.size() == 1 && !isSameArtist)
+		else if (artistIds.size() == 1 && !isSameArtist)
 		{
-			entry->setCondition("if-has-artist", true);
-			entry->bindWidget("artist-name", LmsApplication::createArtistAnchor(artists.front()));
+			if (const Artist::pointer releaseArtist {Artist::getById(LmsApp->getDbSession(), artistIds.front())})
+			{
+				entry->setCondition("if-has-artist", true);
+				entry->bindWidget("artist-name", LmsApplication::createArtistAnchor(releaseArtist));
+			}
 		}
 
 		if (showYear)
 		{
-			if (std::optional<int> year {release->getReleaseYear()})
+			if (std::optional<int> year {summary->getReleaseYear()})
 			{
 				entry->setCondition("if-has-year", true);
 
 				std::string strYear {std::to_string(*year)};
 
-				std::optional<int> originalYear {release->getReleaseYear(true)};
+				std::optional<int> originalYear {summary->getReleaseYear(true)};
 				if (originalYear && *originalYear != *year)
 				{
 					strYear += " (" + std::to_string(*originalYear) + ")";
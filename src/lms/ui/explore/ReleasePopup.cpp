@@ -69,6 +69,8 @@ namespace UserInterface
 							LmsApp->getUser().modify()->unstarRelease(release);
 						else
 							LmsApp->getUser().modify()->starRelease(release);
+
+						LmsApp->getDbSession().bumpUserGeneration(LmsApp->getUser().id());
 					});
 			popup->addItem(Wt::WString::tr("Lms.Explore.download"))
 				->setLink(Wt::WLink {std::make_unique<DownloadReleaseResource>(releaseId)});
@@ -27,6 +27,7 @@
 #include <Wt/WPopupMenu.h>
 #include <Wt/WText.h>
 
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
 #include "database/Session.hpp"
 #include "database/TrackList.hpp"
@@ -106,6 +107,7 @@ Releases::refreshView()
 {
 	_container->clear();
 	_randomReleases.clear();
+	_allReleasesRange = {};
 	addSome();
 }
 
@@ -205,11 +207,11 @@ Releases::getReleases(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::RecentlyPlayed:
-			releases = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())->getReleasesReverse(_filters->getClusterIds(), range, moreResults);
+			releases = TrackPlayStats::getRecentReleases(LmsApp->getDbSession(), LmsApp->getUser().id(), _filters->getClusterIds(), range, moreResults);
 			break;
 
 		case Mode::MostPlayed:
-			releases = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())->getTopReleases(_filters->getClusterIds(), range, moreResults);
+			releases = TrackPlayStats::getTopReleases(LmsApp->getDbSession(), LmsApp->getUser().id(), _filters->getClusterIds(), range, moreResults);
 			break;
 
 		case Mode::RecentlyAdded:
@@ -217,7 +219,17 @@ Releases::getReleases(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::All:
-			releases = Release::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, range, moreResults);
+			if (range)
+			{
+				// pages are requested one after the other: resume after the last displayed release
+				if (range->offset == 0)
+					_allReleasesRange = {};
+				_allReleasesRange.limit = range->limit;
+
+				releases = Release::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, _allReleasesRange, moreResults);
+			}
+			else
+				releases = Release::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, range, moreResults);
 			break;
 	}
 
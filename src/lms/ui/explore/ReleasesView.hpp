@@ -81,6 +81,7 @@ class Releases : public Wt::WTemplate
 		Mode _mode {defaultMode};
 		Filters* _filters {};
 		std::vector<Database::IdType> _randomReleases;
+		Database::KeysetRange _allReleasesRange;	// for Mode::All, to get the next page right after the last displayed release
 		Wt::WContainerWidget* _container {};
 		Wt::WTemplate* _loadingIndicator {};
 };
@@ -63,6 +63,8 @@ namespace UserInterface
 							LmsApp->getUser().modify()->unstarTrack(track);
 						else
 							LmsApp->getUser().modify()->starTrack(track);
+
+						LmsApp->getDbSession().bumpUserGeneration(LmsApp->getUser().id());
 					});
 			popup->addItem(Wt::WString::tr("Lms.Explore.download"))
 				->setLink(Wt::WLink {std::make_unique<DownloadTrackResource>(trackId)});
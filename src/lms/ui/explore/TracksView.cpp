@@ -26,6 +26,7 @@
 #include <Wt/WText.h>
 
 #include "database/Artist.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
 #include "database/Session.hpp"
 #include "database/Track.hpp"
@@ -112,6 +113,7 @@ Tracks::refreshView()
 {
 	_tracksContainer->clear();
 	_randomTracks.clear();
+	_allTracksRange = {};
 	addSome();
 }
 
@@ -192,11 +194,11 @@ Tracks::getTracks(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::RecentlyPlayed:
-			tracks = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())->getTracksReverse(_filters->getClusterIds(), range, moreResults);
+			tracks = TrackPlayStats::getRecentTracks(LmsApp->getDbSession(), LmsApp->getUser().id(), _filters->getClusterIds(), range, moreResults);
 			break;
 
 		case Mode::MostPlayed:
-			tracks = LmsApp->getUser()->getPlayedTrackList(LmsApp->getDbSession())->getTopTracks(_filters->getClusterIds(), range, moreResults);
+			tracks = TrackPlayStats::getTopTracks(LmsApp->getDbSession(), LmsApp->getUser().id(), _filters->getClusterIds(), range, moreResults);
 			break;
 
 		case Mode::RecentlyAdded:
@@ -204,7 +206,17 @@ Tracks::getTracks(std::optional<Range> range, bool& moreResults)
 			break;
 
 		case Mode::All:
-			tracks = Track::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, range, moreResults);
+			if (range)
+			{
+				// pages are requested one after the other: resume after the last displayed track
+				if (range->offset == 0)
+					_allTracksRange = {};
+				_allTracksRange.limit = range->limit;
+
+				tracks = Track::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, _allTracksRange, moreResults);
+			}
+			else
+				tracks = Track::getByFilter(LmsApp->getDbSession(), _filters->getClusterIds(), {}, range, moreResults);
 			break;
 	}
 
@@ -79,6 +79,7 @@ class Tracks : public Wt::WTemplate
 		Mode _mode {defaultMode};
 		Filters* _filters {};
 		std::vector<Database::IdType> _randomTracks;
+		Database::KeysetRange _allTracksRange;	// for Mode::All, to get the next page right after the last displayed track
 		Wt::WContainerWidget* _tracksContainer {};
 		Wt::WTemplate* _loadingIndicator {};
 };
@@ -19,12 +19,11 @@
 
 #include "DownloadResource.hpp"
 
-#include <array>
-#include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <vector>
 
 #include <Wt/Http/Response.h>
-#include <Wt/WLocalDateTime.h>
 
 #include "database/Artist.hpp"
 #include "database/Release.hpp"
@@ -33,6 +32,7 @@
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Zipper.hpp"
+#include "utils/ZipperResourceHandlerCreator.hpp"
 
 #include "LmsApplication.hpp"
 
@@ -48,39 +48,32 @@ DownloadResource::~DownloadResource()
 void
 DownloadResource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
 {
-	try
-	{
-		std::shared_ptr<Zip::Zipper> zipper;
+	std::shared_ptr<IResourceHandler> resourceHandler;
 
-		// First, see if this request is for a continuation
-		Wt::Http::ResponseContinuation *continuation = request.continuation();
-		if (continuation)
-			zipper = Wt::cpp17::any_cast<std::shared_ptr<Zip::Zipper>>(continuation->data());
-		else
+	if (!request.continuation())
+	{
+		try
 		{
-			zipper = createZipper();
-			response.setContentLength(zipper->getTotalZipFile());
-			response.setMimeType("application/zip");
-		}
-
-		if (!zipper)
-			return;
+			std::unique_ptr<Zip::Zipper> zipper {createZipper()};
+			if (!zipper)
+				return;
 
-		std::array<std::byte, bufferSize> buffer;
-		std::size_t nbWrittenBytes {zipper->writeSome(buffer.data(), buffer.size())};
-
-		response.out().write(reinterpret_cast<const char *>(buffer.data()), nbWrittenBytes);
-
-		if (!zipper->isComplete())
+			resourceHandler = createZipperResourceHandler(std::move(zipper));
+		}
+		catch (Zip::ZipperException& exception)
 		{
-			auto* continuation {response.createContinuation()};
-			continuation->setData(zipper);
+			LOG(ERROR) << "Zipper exception: " << exception.what();
+			return;
 		}
 	}
-	catch (Zip::ZipperException& exception)
+	else
 	{
-		LOG(ERROR) << "Zipper exception: " << exception.what();
+		resourceHandler = Wt::cpp17::any_cast<std::shared_ptr<IResourceHandler>>(request.continuation()->data());
 	}
+
+	auto* continuation {resourceHandler->processRequest(request, response)};
+	if (continuation)
+		continuation->setData(resourceHandler);
 }
 
 
@@ -146,7 +139,7 @@ static
 std::unique_ptr<Zip::Zipper>
 createZipper(const std::vector<Database::Track::pointer>& tracks)
 {
-	std::map<std::string, std::filesystem::path> files;
+	std::map<std::string, Zip::Entry> files;
 
 	for (const Database::Track::pointer& track : tracks)
 	{
@@ -165,10 +158,11 @@ createZipper(const std::vector<Database::Track::pointer>& tracks)
 			fileName += releaseName + "/";
 		fileName += getTrackPathName(track);
 
-		files.emplace(fileName, track->getPath());
+		files.emplace(fileName, Zip::Entry {track->getPath(), track->getFileCrc32(), track->getLastWriteTime()});
 	}
 
-	return std::make_unique<Zip::Zipper>(files, Wt::WLocalDateTime::currentDateTime().toUTC());
+	// Use the file last write times to keep the archive content stable across requests
+	return std::make_unique<Zip::Zipper>(files);
 }
 
 DownloadArtistResource::DownloadArtistResource(Database::IdType artistId)
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "PasswordCache.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+using namespace Auth;
+
+static
+void
+testPasswordCacheHit()
+{
+	PasswordCache cache {10, std::chrono::minutes {10}};
+
+	CHECK(!cache.isVerified("user", "password", "hash"));
+
+	cache.onVerified("user", "password", "hash");
+	CHECK(cache.isVerified("user", "password", "hash"));
+
+	// Other password, other user
+	CHECK(!cache.isVerified("user", "password2", "hash"));
+	CHECK(!cache.isVerified("user2", "password", "hash"));
+	// Login and password must not be mixed up
+	CHECK(!cache.isVerified("userp", "assword", "hash"));
+
+	// Stored password changed by another path
+	CHECK(!cache.isVerified("user", "password", "hash2"));
+}
+
+static
+void
+testPasswordCacheExpiry()
+{
+	PasswordCache cache {10, std::chrono::seconds {1}};
+
+	cache.onVerified("user", "password", "hash");
+	CHECK(cache.isVerified("user", "password", "hash"));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds {1100});
+	CHECK(!cache.isVerified("user", "password", "hash"));
+
+	// Can be cached again
+	cache.onVerified("user", "password", "hash");
+	CHECK(cache.isVerified("user", "password", "hash"));
+}
+
+static
+void
+testPasswordCacheInvalidation()
+{
+	PasswordCache cache {10, std::chrono::minutes {10}};
+
+	cache.onVerified("user", "password", "");
+	cache.onVerified("user", "oldPassword", "");
+	cache.onVerified("user2", "password", "");
+
+	cache.invalidate("user");
+	CHECK(!cache.isVerified("user", "password", ""));
+	CHECK(!cache.isVerified("user", "oldPassword", ""));
+	CHECK(cache.isVerified("user2", "password", ""));
+
+	// Prefix of another login name
+	cache.invalidate("user2x");
+	cache.invalidate("use");
+	CHECK(cache.isVerified("user2", "password", ""));
+}
+
+static
+void
+testPasswordCacheMaxEntries()
+{
+	constexpr std::size_t maxEntries {5};
+	PasswordCache cache {maxEntries, std::chrono::minutes {10}};
+
+	for (std::size_t i {}; i < maxEntries * 2; ++i)
+		cache.onVerified("user" + std::to_string(i), "password", "hash");
+
+	std::size_t verifiedCount {};
+	for (std::size_t i {}; i < maxEntries * 2; ++i)
+	{
+		if (cache.isVerified("user" + std::to_string(i), "password", "hash"))
+			verifiedCount++;
+	}
+	CHECK(verifiedCount == maxEntries);
+
+	// last one is always kept
+	CHECK(cache.isVerified("user" + std::to_string(maxEntries * 2 - 1), "password", "hash"));
+}
+
+int main()
+{
+	try
+	{
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testPasswordCacheHit);
+		RUN_TEST(testPasswordCacheExpiry);
+		RUN_TEST(testPasswordCacheInvalidation);
+		RUN_TEST(testPasswordCacheMaxEntries);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -23,9 +23,12 @@
 #include <list>
 
 #include "database/Artist.hpp"
+#include "database/ArtistSummary.hpp"
 #include "database/Cluster.hpp"
 #include "database/Db.hpp"
+#include "database/PlayStats.hpp"
 #include "database/Release.hpp"
+#include "database/ReleaseSummary.hpp"
 #include "database/Session.hpp"
 #include "database/Track.hpp"
 #include "database/TrackArtistLink.hpp"
@@ -173,6 +176,57 @@ testSingleTrack(Session& session)
 		CHECK(Track::getAll(session).size() == 1);
 		CHECK(Track::getCount(session) == 1);
 
+		CHECK(!track->getFileSize());
+		CHECK(!track->getBitrate());
+		CHECK(!track->getCodec());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track.get().modify()->setFileSize(1234);
+		track.get().modify()->setBitrate(320000);
+		track.get().modify()->setSampleRate(44100);
+		track.get().modify()->setChannelCount(2);
+		track.get().modify()->setCodec("mp3");
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(track->getFileSize() == 1234);
+		CHECK(track->getBitrate() == 320000);
+		CHECK(track->getSampleRate() == 44100);
+		CHECK(track->getChannelCount() == 2);
+		CHECK(track->getCodec() == "mp3");
+	}
+}
+
+static
+void
+testSingleTrackLoudnessMeasured(Session& session)
+{
+	ScopedTrack track {session, "MyTrackFile"};
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(!track->isLoudnessMeasured());
+		CHECK(Track::getAllWithMissingReplayGain(session).size() == 1);
+	}
+
+	{
+		// silent track: measured, but no gain
+		auto transaction {session.createUniqueTransaction()};
+		track.get().modify()->setLoudnessMeasured(true);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(track->isLoudnessMeasured());
+		CHECK(!track->getTrackReplayGain());
+		CHECK(Track::getAllWithMissingReplayGain(session).empty());
 	}
 }
 
@@ -296,6 +350,16 @@ testSingleTrackSingleArtist(Session& session)
 		CHECK(track->getArtists({TrackArtistLinkType::Artist}).size() == 1);
 		CHECK(track->getArtists({TrackArtistLinkType::ReleaseArtist}).empty());
 		CHECK(track->getArtists({}).size() == 1);
+
+		const auto trackArtistIds {TrackArtistLink::getTrackArtistIds(session, {track.getId()}, TrackArtistLinkType::Artist)};
+		CHECK(trackArtistIds.size() == 1);
+		CHECK(std::get<0>(trackArtistIds.front()) == track.getId());
+		CHECK(std::get<1>(trackArtistIds.front()) == artist.getId());
+		CHECK(TrackArtistLink::getTrackArtistIds(session, {track.getId()}, TrackArtistLinkType::ReleaseArtist).empty());
+
+		CHECK(Track::getByIds(session, {track.getId()}).size() == 1);
+		CHECK(Artist::getByIds(session, {artist.getId()}).size() == 1);
+		CHECK(Artist::getByIds(session, {}).empty());
 	}
 
 	{
@@ -469,6 +533,186 @@ testMultiArtistsSortMethod(Session& session)
 	}
 }
 
+static
+void
+testMultiArtistsKeysetPagination(Session& session)
+{
+	// Equal names for the collation, sorted using the id
+	ScopedArtist artistSame1 {session, "Same"};
+	ScopedArtist artistSame2 {session, "same"};
+	ScopedArtist artistSame3 {session, "SAME"};
+	ScopedArtist artistOther {session, "Other"};
+	ScopedArtist artistLast {session, "Zed"};
+	ScopedTrack track {session, "MyTrack"}; // filters does not work on orphans
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		for (ScopedArtist* artist : {&artistSame1, &artistSame2, &artistSame3, &artistOther, &artistLast})
+			TrackArtistLink::create(session, track.get(), artist->get(), TrackArtistLinkType::Artist);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const std::vector<IdType> expectedIds {artistOther.getId(), artistSame1.getId(), artistSame2.getId(), artistSame3.getId(), artistLast.getId()};
+
+		// The offset version must give the same order
+		{
+			bool more {};
+			const auto artists {Artist::getByFilter(session, {}, {}, std::nullopt, Artist::SortMethod::ByName, Range {0, 10}, more)};
+			CHECK(!more);
+			CHECK(artists.size() == expectedIds.size());
+			for (std::size_t i {}; i < artists.size(); ++i)
+				CHECK(artists[i].id() == expectedIds[i]);
+		}
+
+		KeysetRange range;
+		range.limit = 2;
+		CHECK(!range.after);
+
+		bool more {};
+		auto artists {Artist::getByFilter(session, {}, {}, std::nullopt, Artist::SortMethod::ByName, range, more)};
+		CHECK(more);
+		CHECK(artists.size() == 2);
+		CHECK(artists[0].id() == expectedIds[0]);
+		CHECK(artists[1].id() == expectedIds[1]);
+		CHECK(range.after);
+		CHECK(range.after->id == expectedIds[1]);
+
+		// Page boundary between entries that have the same sort key
+		artists = Artist::getByFilter(session, {}, {}, std::nullopt, Artist::SortMethod::ByName, range, more);
+		CHECK(more);
+		CHECK(artists.size() == 2);
+		CHECK(artists[0].id() == expectedIds[2]);
+		CHECK(artists[1].id() == expectedIds[3]);
+
+		// Last page
+		artists = Artist::getByFilter(session, {}, {}, std::nullopt, Artist::SortMethod::ByName, range, more);
+		CHECK(!more);
+		CHECK(artists.size() == 1);
+		CHECK(artists[0].id() == expectedIds[4]);
+		CHECK(range.after->id == expectedIds[4]);
+
+		// Past the last page
+		artists = Artist::getByFilter(session, {}, {}, std::nullopt, Artist::SortMethod::ByName, range, more);
+		CHECK(!more);
+		CHECK(artists.empty());
+		CHECK(range.after->id == expectedIds[4]);
+	}
+}
+
+static
+void
+testMultiReleasesKeysetPagination(Session& session)
+{
+	ScopedRelease release1 {session, "MyRelease"};
+	ScopedRelease release2 {session, "MyRelease"};
+	ScopedRelease release3 {session, "myrelease"};
+	ScopedTrack track1 {session, "MyTrack1"};
+	ScopedTrack track2 {session, "MyTrack2"};
+	ScopedTrack track3 {session, "MyTrack3"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track1.get().modify()->setRelease(release1.get());
+		track2.get().modify()->setRelease(release2.get());
+		track3.get().modify()->setRelease(release3.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		// Last page exactly filled
+		{
+			KeysetRange range;
+			range.limit = 3;
+
+			bool more {};
+			const auto releases {Release::getByFilter(session, {}, {}, range, more)};
+			CHECK(!more);
+			CHECK(releases.size() == 3);
+			CHECK(releases[0].id() == release1.getId());
+			CHECK(releases[1].id() == release2.getId());
+			CHECK(releases[2].id() == release3.getId());
+		}
+
+		// Resuming from a given key, as the offset fallback does
+		{
+			KeysetRange range;
+			range.after = KeysetRange::Key {"MYRELEASE", release1.getId()};
+			range.limit = 1;
+
+			bool more {};
+			auto releases {Release::getByFilter(session, {}, {}, range, more)};
+			CHECK(more);
+			CHECK(releases.size() == 1);
+			CHECK(releases.front().id() == release2.getId());
+
+			releases = Release::getByFilter(session, {}, {}, range, more);
+			CHECK(!more);
+			CHECK(releases.size() == 1);
+			CHECK(releases.front().id() == release3.getId());
+		}
+	}
+}
+
+// Uses its own database, with query tracing to get the plan of the executed queries
+static
+void
+testReleasesKeysetPaginationQueryPlan(const std::filesystem::path& dbPath)
+{
+	QueryTracer::Settings queryTracerSettings;
+	queryTracerSettings.queryPlanThreshold = std::chrono::milliseconds {0};
+
+	Db db {dbPath, queryTracerSettings};
+	Session session {db};
+	session.prepareTables();
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		// releases without tracks are reported when there is no filter
+		for (const char* name : {"A", "b", "C", "d"})
+			Release::create(session, name);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		KeysetRange range;
+		range.limit = 2;
+
+		bool more {};
+		auto releases {Release::getByFilter(session, {}, {}, range, more)};
+		CHECK(more);
+		CHECK(releases.size() == 2);
+		CHECK(releases.back()->getName() == "b");
+
+		releases = Release::getByFilter(session, {}, {}, range, more);
+		CHECK(!more);
+		CHECK(releases.size() == 2);
+		CHECK(releases.front()->getName() == "C");
+		CHECK(releases.back()->getName() == "d");
+	}
+
+	// The page resumed from a key must seek the name index, not scan it
+	bool planChecked {};
+	for (const QueryTraceEntry& entry : db.getQueryTracer()->getEntries())
+	{
+		if (entry.sql.find("from release r") == std::string::npos || entry.sql.find(">= ?") == std::string::npos)
+			continue;
+
+		CHECK(entry.queryPlan);
+		CHECK(entry.queryPlan->find("SEARCH r USING INDEX release_name_nocase_idx") != std::string::npos);
+		CHECK(entry.queryPlan->find("SCAN") == std::string::npos);
+		CHECK(entry.queryPlan->find("TEMP B-TREE") == std::string::npos);
+		planChecked = true;
+	}
+	CHECK(planChecked);
+}
+
 static
 void
 testSingleTrackSingleRelease(Session& session)
@@ -750,6 +994,51 @@ testMultipleTracksSingleCluster(Session& session)
 	}
 }
 
+static
+void
+testMultipleTracksRandom(Session& session)
+{
+	std::list<ScopedTrack> tracks;
+	for (std::size_t i {}; i < 10; ++i)
+		tracks.emplace_back(session, "MyTrack" + std::to_string(i));
+
+	session.bumpLibraryGeneration();
+
+	auto isTrack = [&](IdType trackId)
+	{
+		return std::any_of(std::cbegin(tracks), std::cend(tracks), [&](const ScopedTrack& track) { return track.getId() == trackId; });
+	};
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto trackIds {Track::getAllIdsRandom(session, {})};
+		CHECK(trackIds.size() == tracks.size());
+		CHECK(std::set<IdType>(std::cbegin(trackIds), std::cend(trackIds)).size() == tracks.size());
+
+		for (std::size_t i {}; i < 10; ++i)
+		{
+			const auto someTrackIds {Track::getAllIdsRandom(session, {}, 4)};
+			CHECK(someTrackIds.size() == 5);
+			CHECK(std::set<IdType>(std::cbegin(someTrackIds), std::cend(someTrackIds)).size() == someTrackIds.size());
+			CHECK(std::all_of(std::cbegin(someTrackIds), std::cend(someTrackIds), isTrack));
+		}
+
+		CHECK(Track::getAllRandom(session, {}).size() == tracks.size());
+	}
+
+	// ids are reloaded on new generations
+	tracks.emplace_back(session, "MyTrack");
+	session.bumpLibraryGeneration();
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		const auto trackIds {Track::getAllIdsRandom(session, {})};
+		CHECK(trackIds.size() == tracks.size());
+		CHECK(std::all_of(std::cbegin(trackIds), std::cend(trackIds), isTrack));
+	}
+}
+
 static
 void
 testMultipleTracksMultipleClustersTopRelease(Session& session)
@@ -1191,6 +1480,98 @@ testSingleTrackSingleReleaseSingleArtist(Session& session)
 	}
 }
 
+static
+void
+testSingleTrackSingleReleaseSingleArtistSummary(Session& session)
+{
+	ScopedTrack track {session, "MyTrack"};
+	ScopedRelease release {session, "MyRelease"};
+	ScopedArtist artist {session, "MyArtist"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		auto trackArtistLink {TrackArtistLink::create(session, track.get(), artist.get(), TrackArtistLinkType::Artist)};
+		track.get().modify()->setRelease(release.get());
+		track.get().modify()->setDuration(std::chrono::seconds {42});
+		track.get().modify()->setYear(1995);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(!ReleaseSummary::getByRelease(session, release.getId()));
+		CHECK(!ArtistSummary::getByArtist(session, artist.getId()));
+
+		// Computed on the fly
+		auto releaseSummary {ReleaseSummary::get(session, release.get())};
+		CHECK(releaseSummary->getTracksCount() == 1);
+		CHECK(releaseSummary->getDuration() == std::chrono::seconds {42});
+		CHECK(ArtistSummary::get(session, artist.get())->getReleaseCount() == 1);
+
+		auto missingReleaseIds {ReleaseSummary::getAllReleaseIdsToRefresh(session)};
+		CHECK(missingReleaseIds.size() == 1 && missingReleaseIds.front() == release.getId());
+		auto missingArtistIds {ArtistSummary::getAllArtistIdsToRefresh(session)};
+		CHECK(missingArtistIds.size() == 1 && missingArtistIds.front() == artist.getId());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		ReleaseSummary::refresh(session, release.get());
+		ArtistSummary::refresh(session, artist.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(ReleaseSummary::getAllReleaseIdsToRefresh(session).empty());
+		CHECK(ArtistSummary::getAllArtistIdsToRefresh(session).empty());
+
+		auto releaseSummary {ReleaseSummary::getByRelease(session, release.getId())};
+		CHECK(releaseSummary);
+		CHECK(releaseSummary->getTracksCount() == 1);
+		CHECK(releaseSummary->getDuration() == std::chrono::seconds {42});
+		CHECK(releaseSummary->getReleaseYear() == 1995);
+		CHECK(!releaseSummary->getReleaseYear(true));
+		CHECK(!releaseSummary->getGenre());
+		CHECK(releaseSummary->getArtistIds() == std::vector<IdType> {artist.getId()});
+
+		auto artistSummary {ArtistSummary::getByArtist(session, artist.getId())};
+		CHECK(artistSummary);
+		CHECK(artistSummary->getReleaseCount() == 1);
+	}
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		ReleaseSummary::markOutdated(session, release.getId());
+		ArtistSummary::markOutdated(session, artist.getId());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		// Outdated summaries are still used until refreshed
+		CHECK(ReleaseSummary::getByRelease(session, release.getId()));
+		CHECK(ReleaseSummary::getAllReleaseIdsToRefresh(session) == std::vector<IdType> {release.getId()});
+		CHECK(ArtistSummary::getAllArtistIdsToRefresh(session) == std::vector<IdType> {artist.getId()});
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		ReleaseSummary::refresh(session, release.get());
+		ArtistSummary::refresh(session, artist.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(ReleaseSummary::getAllReleaseIdsToRefresh(session).empty());
+		CHECK(ArtistSummary::getAllArtistIdsToRefresh(session).empty());
+	}
+}
+
 static
 void
 testSingleTrackSingleReleaseSingleArtistSingleCluster(Session& session)
@@ -1298,6 +1679,219 @@ testSingleUser(Session& session)
 	}
 }
 
+static
+void
+testMultipleTracksSingleUserPlayStats(Session& session)
+{
+	ScopedUser user {session, "MyUser"};
+	ScopedClusterType clusterType {session, "MyClusterType"};
+	ScopedCluster cluster {session, clusterType.lockAndGet(), "MyCluster"};
+	ScopedArtist artist1 {session, "MyArtist1"};
+	ScopedArtist artist2 {session, "MyArtist2"};
+	ScopedRelease release1 {session, "MyRelease1"};
+	ScopedRelease release2 {session, "MyRelease2"};
+	ScopedTrack track1 {session, "MyTrack1"};
+	ScopedTrack track2 {session, "MyTrack2"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track1.get().modify()->setRelease(release1.get());
+		track2.get().modify()->setRelease(release2.get());
+		TrackArtistLink::create(session, track1.get(), artist1.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track1.get(), artist1.get(), TrackArtistLinkType::Composer);
+		TrackArtistLink::create(session, track2.get(), artist2.get(), TrackArtistLinkType::Artist);
+		cluster.get().modify()->addTrack(track2.get());
+
+		user->addPlayedTrack(session, track1.get());
+		user->addPlayedTrack(session, track1.get());
+		user->addPlayedTrack(session, track2.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		CHECK(user->getPlayedTrackList(session)->getCount() == 3);
+
+		bool moreResults {};
+		const auto topTracks {TrackPlayStats::getTopTracks(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topTracks.size() == 2);
+		CHECK(topTracks[0].id() == track1.getId());
+		CHECK(topTracks[1].id() == track2.getId());
+
+		const auto recentTracks {TrackPlayStats::getRecentTracks(session, user.getId(), {}, Range {0, 1}, moreResults)};
+		CHECK(recentTracks.size() == 1);
+		CHECK(recentTracks[0].id() == track2.getId());
+		CHECK(moreResults);
+
+		const auto topReleases {TrackPlayStats::getTopReleases(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topReleases.size() == 2);
+		CHECK(topReleases[0].id() == release1.getId());
+
+		const auto clusterReleases {TrackPlayStats::getRecentReleases(session, user.getId(), {cluster.getId()}, std::nullopt, moreResults)};
+		CHECK(clusterReleases.size() == 1);
+		CHECK(clusterReleases[0].id() == release2.getId());
+
+		// a play counts once per artist, even with several roles
+		const auto topArtists {TrackPlayStats::getTopArtists(session, user.getId(), {}, std::nullopt, std::nullopt, moreResults)};
+		CHECK(topArtists.size() == 2);
+		CHECK(topArtists[0].id() == artist1.getId());
+
+		const auto composers {TrackPlayStats::getTopArtists(session, user.getId(), {}, TrackArtistLinkType::Composer, std::nullopt, moreResults)};
+		CHECK(composers.size() == 1);
+		CHECK(composers[0].id() == artist1.getId());
+
+		const auto recentArtists {TrackPlayStats::getRecentArtists(session, user.getId(), {cluster.getId()}, TrackArtistLinkType::Artist, std::nullopt, moreResults)};
+		CHECK(recentArtists.size() == 1);
+		CHECK(recentArtists[0].id() == artist2.getId());
+	}
+}
+
+// With filters, only the plays of the matching tracks are taken into account
+static
+void
+testMultipleTracksSingleUserFilteredPlayStats(Session& session)
+{
+	ScopedUser user {session, "MyUser"};
+	ScopedClusterType clusterType {session, "MyClusterType"};
+	ScopedCluster cluster {session, clusterType.lockAndGet(), "MyCluster"};
+	ScopedArtist artist1 {session, "MyArtist1"};
+	ScopedArtist artist2 {session, "MyArtist2"};
+	ScopedRelease release1 {session, "MyRelease1"};
+	ScopedRelease release2 {session, "MyRelease2"};
+	ScopedTrack track1InCluster {session, "MyTrack1InCluster"};
+	ScopedTrack track1 {session, "MyTrack1"};
+	ScopedTrack track2InCluster {session, "MyTrack2InCluster"};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		track1InCluster.get().modify()->setRelease(release1.get());
+		track1.get().modify()->setRelease(release1.get());
+		track2InCluster.get().modify()->setRelease(release2.get());
+		TrackArtistLink::create(session, track1InCluster.get(), artist1.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track1.get(), artist1.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track2InCluster.get(), artist2.get(), TrackArtistLinkType::Artist);
+		cluster.get().modify()->addTrack(track1InCluster.get());
+		cluster.get().modify()->addTrack(track2InCluster.get());
+
+		user->addPlayedTrack(session, track1InCluster.get());
+		for (int i {}; i < 3; ++i)
+			user->addPlayedTrack(session, track1.get());
+		for (int i {}; i < 2; ++i)
+			user->addPlayedTrack(session, track2InCluster.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		bool moreResults {};
+		const auto topReleases {TrackPlayStats::getTopReleases(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topReleases.size() == 2);
+		CHECK(topReleases[0].id() == release1.getId());
+
+		const auto topClusterReleases {TrackPlayStats::getTopReleases(session, user.getId(), {cluster.getId()}, std::nullopt, moreResults)};
+		CHECK(topClusterReleases.size() == 2);
+		CHECK(topClusterReleases[0].id() == release2.getId());
+		CHECK(topClusterReleases[1].id() == release1.getId());
+
+		const auto topArtists {TrackPlayStats::getTopArtists(session, user.getId(), {}, std::nullopt, std::nullopt, moreResults)};
+		CHECK(topArtists.size() == 2);
+		CHECK(topArtists[0].id() == artist1.getId());
+
+		const auto topClusterArtists {TrackPlayStats::getTopArtists(session, user.getId(), {cluster.getId()}, TrackArtistLinkType::Artist, std::nullopt, moreResults)};
+		CHECK(topClusterArtists.size() == 2);
+		CHECK(topClusterArtists[0].id() == artist2.getId());
+		CHECK(topClusterArtists[1].id() == artist1.getId());
+	}
+}
+
+// Rankings follow the current track links: retagged and deleted tracks must not leave stale entries
+static
+void
+testRetaggedTracksSingleUserPlayStats(Session& session)
+{
+	ScopedUser user {session, "MyUser"};
+	ScopedArtist artist1 {session, "MyArtist1"};
+	ScopedArtist artist2 {session, "MyArtist2"};
+	ScopedRelease release1 {session, "MyRelease1"};
+	ScopedRelease release2 {session, "MyRelease2"};
+	ScopedTrack track1 {session, "MyTrack1"};
+	IdType track2Id {};
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		auto track2 {Track::create(session, "MyTrack2")};
+		track2Id = track2.id();
+
+		track1.get().modify()->setRelease(release1.get());
+		track2.modify()->setRelease(release2.get());
+		TrackArtistLink::create(session, track1.get(), artist1.get(), TrackArtistLinkType::Artist);
+		TrackArtistLink::create(session, track2, artist2.get(), TrackArtistLinkType::Artist);
+
+		user->addPlayedTrack(session, track1.get());
+		user->addPlayedTrack(session, track2);
+		user->addPlayedTrack(session, track2);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		bool moreResults {};
+		const auto topReleases {TrackPlayStats::getTopReleases(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topReleases.size() == 2);
+		CHECK(topReleases[0].id() == release2.getId());
+
+		const auto topArtists {TrackPlayStats::getTopArtists(session, user.getId(), {}, std::nullopt, std::nullopt, moreResults)};
+		CHECK(topArtists.size() == 2);
+		CHECK(topArtists[0].id() == artist2.getId());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		// retag track1 onto release2 / artist2
+		track1.get().modify()->setRelease(release2.get());
+		track1.get().modify()->clearArtistLinks();
+		TrackArtistLink::create(session, track1.get(), artist2.get(), TrackArtistLinkType::Artist);
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		bool moreResults {};
+		const auto topReleases {TrackPlayStats::getTopReleases(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topReleases.size() == 1);
+		CHECK(topReleases[0].id() == release2.getId());
+
+		const auto topArtists {TrackPlayStats::getTopArtists(session, user.getId(), {}, std::nullopt, std::nullopt, moreResults)};
+		CHECK(topArtists.size() == 1);
+		CHECK(topArtists[0].id() == artist2.getId());
+	}
+
+	{
+		auto transaction {session.createUniqueTransaction()};
+
+		Track::getById(session, track2Id).remove();
+		track1.get().modify()->setRelease(release1.get());
+	}
+
+	{
+		auto transaction {session.createSharedTransaction()};
+
+		bool moreResults {};
+		const auto topReleases {TrackPlayStats::getTopReleases(session, user.getId(), {}, std::nullopt, moreResults)};
+		CHECK(topReleases.size() == 1);
+		CHECK(topReleases[0].id() == release1.getId());
+
+		const auto recentArtists {TrackPlayStats::getRecentArtists(session, user.getId(), {}, std::nullopt, std::nullopt, moreResults)};
+		CHECK(recentArtists.size() == 1);
+		CHECK(recentArtists[0].id() == artist2.getId());
+		CHECK(!moreResults);
+	}
+}
+
 static
 void
 testSingleStarredArtist(Session& session)
@@ -1371,6 +1965,9 @@ testSingleStarredTrack(Session& session)
 		auto transaction {session.createUniqueTransaction()};
 
 		CHECK(user->hasStarredTrack(track.get()));
+		CHECK(user->getStarredTrackIds({track.getId(), track.getId() + 1}) == std::set<IdType> {track.getId()});
+		CHECK(user->getStarredTrackIds({}).empty());
+		CHECK(user->getAllStarredTrackIds() == std::vector<IdType> {track.getId()});
 
 		bool hasMore {};
 		auto tracks {Track::getStarred(session, user.get(), {}, std::nullopt, hasMore)};
@@ -1994,6 +2591,7 @@ int main()
 		RUN_TEST(testRemoveDefaultEntries);
 
 		RUN_TEST(testSingleTrack);
+		RUN_TEST(testSingleTrackLoudnessMeasured);
 		RUN_TEST(testSingleArtist);
 		RUN_TEST(testSingleRelease);
 		RUN_TEST(testSingleCluster);
@@ -2004,6 +2602,8 @@ int main()
 
 		RUN_TEST(testSingleArtistSearchByName);
 		RUN_TEST(testMultiArtistsSortMethod);
+		RUN_TEST(testMultiArtistsKeysetPagination);
+		RUN_TEST(testMultiReleasesKeysetPagination);
 
 		RUN_TEST(testSingleTrackSingleRelease);
 		RUN_TEST(testMultiTracksSingleReleaseTotalDiscTrack);
@@ -2011,6 +2611,7 @@ int main()
 
 		RUN_TEST(testSingleTrackSingleCluster);
 		RUN_TEST(testMultipleTracksSingleCluster);
+		RUN_TEST(testMultipleTracksRandom);
 
 		RUN_TEST(testMultipleTracksMultipleClustersTopRelease);
 
@@ -2024,11 +2625,15 @@ int main()
 		RUN_TEST(testMultiTracksSingleArtistSingleRelease);
 
 		RUN_TEST(testSingleTrackSingleReleaseSingleArtist);
+		RUN_TEST(testSingleTrackSingleReleaseSingleArtistSummary);
 
 		RUN_TEST(testSingleTrackSingleReleaseSingleArtistSingleCluster);
 		RUN_TEST(testSingleTrackSingleReleaseSingleArtistMultiClusters);
 
 		RUN_TEST(testSingleUser);
+		RUN_TEST(testMultipleTracksSingleUserPlayStats);
+		RUN_TEST(testMultipleTracksSingleUserFilteredPlayStats);
+		RUN_TEST(testRetaggedTracksSingleUserPlayStats);
 
 		RUN_TEST(testSingleStarredArtist);
 		RUN_TEST(testSingleStarredRelease);
@@ -2043,6 +2648,15 @@ int main()
 		RUN_TEST(testMultipleTracksMultipleReleasesMultiClusters);
 
 		RUN_TEST(testSingleTrackSingleUserSingleBookmark);
+
+		{
+			const std::filesystem::path queryPlanTmpFile {std::tmpnam(nullptr)};
+			ScopedFileDeleter queryPlanTmpFileDeleter {queryPlanTmpFile};
+
+			std::cout << "Running test 'testReleasesKeysetPaginationQueryPlan'..." << std::endl;
+			testReleasesKeysetPaginationQueryPlan(queryPlanTmpFile);
+			std::cout << "Running test 'testReleasesKeysetPaginationQueryPlan': SUCCESS" << std::endl;
+		}
 	}
 	catch (std::exception& e)
 	{
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+#include "utils/String.hpp"
+#include "utils/UUID.hpp"
+
+#include "AcousticBrainzFetcher.hpp"
+#include "MockHttpServer.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+class ScopedDirectory final
+{
+	public:
+		ScopedDirectory() : _path {createTemporaryDirectory()} {}
+		~ScopedDirectory() { std::filesystem::remove_all(_path); }
+
+		ScopedDirectory(const ScopedDirectory&) = delete;
+		ScopedDirectory(ScopedDirectory&&) = delete;
+		ScopedDirectory operator=(const ScopedDirectory&) = delete;
+		ScopedDirectory operator=(ScopedDirectory&&) = delete;
+
+		const std::filesystem::path& getPath() const { return _path; }
+
+	private:
+		static std::filesystem::path createTemporaryDirectory()
+		{
+			std::string pathTemplate {(std::filesystem::temp_directory_path() / "lms-test-XXXXXX").string()};
+			if (!::mkdtemp(pathTemplate.data()))
+				throw std::runtime_error {"Cannot create temporary directory: " + std::string {::strerror(errno)}};
+
+			return pathTemplate;
+		}
+
+		const std::filesystem::path _path;
+};
+
+static
+std::vector<UUID>
+generateMBIDs(std::size_t count)
+{
+	std::vector<UUID> res;
+	for (std::size_t i {}; i < count; ++i)
+	{
+		std::ostringstream oss;
+		oss << "00000000-0000-0000-0000-" << std::setfill('0') << std::setw(12) << i;
+		res.push_back(*UUID::fromString(oss.str()));
+	}
+
+	return res;
+}
+
+// Mimics the bulk low level API: every requested recording is found, except the missing ones
+static
+MockHttpServer::Response
+getBulkResponse(const std::string& target, const std::set<std::string>& missingMBIDs = {})
+{
+	static const std::string prefix {"/low-level?recording_ids="};
+	if (target.compare(0, prefix.size(), prefix) != 0)
+		return {404, {}};
+
+	std::vector<std::string> entries;
+	for (const std::string& mbid : StringUtils::splitString(target.substr(prefix.size()), ";"))
+	{
+		if (missingMBIDs.find(mbid) == std::cend(missingMBIDs))
+			entries.push_back("\"" + mbid + "\": {\"0\": {\"lowlevel\": {\"average_loudness\": 0.5, \"mfcc\": {\"mean\": [1, 2, 3]}}}}");
+	}
+	entries.push_back("\"mbid_mapping\": {}");
+
+	const std::string body {"{" + StringUtils::joinStrings(entries, ", ") + "}"};
+
+	return {200, body};
+}
+
+using FetchResult = std::map<std::string, std::string>;
+
+static
+FetchResult
+fetch(const AcousticBrainz::Fetcher::Parameters& parameters, const std::vector<UUID>& mbids)
+{
+	FetchResult res;
+	const std::atomic<bool> abort {};
+
+	AcousticBrainz::Fetcher fetcher {parameters};
+	fetcher.fetch(mbids, [&](const UUID& mbid, const std::string& features)
+	{
+		CHECK(res.find(std::string {mbid.getAsString()}) == std::cend(res));
+		res.emplace(mbid.getAsString(), features);
+	}, abort);
+
+	return res;
+}
+
+static
+void
+testBulkFetch()
+{
+	const std::vector<UUID> mbids {generateMBIDs(60)};
+	const std::string missingMBID {mbids[7].getAsString()};
+
+	MockHttpServer server {[&](const std::string& target) { return getBulkResponse(target, {missingMBID}); }};
+	ScopedDirectory cacheDirectory;
+
+	AcousticBrainz::Fetcher::Parameters parameters;
+	parameters.apiUrl = server.getUrl();
+	parameters.cacheDirectory = cacheDirectory.getPath();
+	parameters.maxConcurrentRequests = 2;
+
+	{
+		const FetchResult res {fetch(parameters, mbids)};
+		CHECK(res.size() == mbids.size());
+		CHECK(res.at(missingMBID).empty());
+		CHECK(res.at(std::string {mbids[0].getAsString()}).find("average_loudness") != std::string::npos);
+		CHECK(server.getRequestCount() == 3); // 25 recordings per request
+	}
+
+	{
+		// Everything is served from the cache, including missing recordings
+		const FetchResult res {fetch(parameters, mbids)};
+		CHECK(res.size() == mbids.size());
+		CHECK(res.at(missingMBID).empty());
+		CHECK(res.at(std::string {mbids[0].getAsString()}).find("average_loudness") != std::string::npos);
+		CHECK(server.getRequestCount() == 3);
+	}
+}
+
+static
+void
+testRetry()
+{
+	const std::vector<UUID> mbids {generateMBIDs(1)};
+
+	std::atomic<std::size_t> failureCount {2};
+	MockHttpServer server {[&](const std::string& target) -> MockHttpServer::Response
+	{
+		if (failureCount > 0)
+		{
+			failureCount--;
+			return {503, {}};
+		}
+
+		return getBulkResponse(target);
+	}};
+
+	AcousticBrainz::Fetcher::Parameters parameters;
+	parameters.apiUrl = server.getUrl();
+	parameters.retryBaseDelay = std::chrono::milliseconds {1};
+
+	const FetchResult res {fetch(parameters, mbids)};
+	CHECK(res.size() == 1);
+	CHECK(!res.begin()->second.empty());
+	CHECK(server.getRequestCount() == 3);
+}
+
+static
+void
+testGiveUp()
+{
+	const std::vector<UUID> mbids {generateMBIDs(2)};
+
+	MockHttpServer server {[&](const std::string&) { return MockHttpServer::Response {500, {}}; }};
+	ScopedDirectory cacheDirectory;
+
+	AcousticBrainz::Fetcher::Parameters parameters;
+	parameters.apiUrl = server.getUrl();
+	parameters.cacheDirectory = cacheDirectory.getPath();
+	parameters.maxRetryCount = 2;
+	parameters.retryBaseDelay = std::chrono::milliseconds {1};
+
+	{
+		const FetchResult res {fetch(parameters, mbids)};
+		CHECK(res.size() == 2);
+		CHECK(res.begin()->second.empty());
+		CHECK(server.getRequestCount() == 3);
+	}
+
+	{
+		// Failures must not be cached
+		const FetchResult res {fetch(parameters, mbids)};
+		CHECK(res.size() == 2);
+		CHECK(server.getRequestCount() == 6);
+	}
+}
+
+static
+void
+testUnusableCacheDirectory()
+{
+	const std::vector<UUID> mbids {generateMBIDs(2)};
+
+	MockHttpServer server {[&](const std::string& target) { return getBulkResponse(target); }};
+	ScopedDirectory workingDirectory;
+
+	// A regular file is in the way
+	const std::filesystem::path filePath {workingDirectory.getPath() / "file"};
+	std::ofstream {filePath} << "dummy";
+
+	AcousticBrainz::Fetcher::Parameters parameters;
+	parameters.apiUrl = server.getUrl();
+	parameters.cacheDirectory = filePath / "cache";
+
+	// Features are still fetched, without cache
+	for (std::size_t i {1}; i <= 2; ++i)
+	{
+		const FetchResult res {fetch(parameters, mbids)};
+		CHECK(res.size() == 2);
+		CHECK(!res.begin()->second.empty());
+		CHECK(server.getRequestCount() == i);
+	}
+}
+
+int main()
+{
+	try
+	{
+		// log to stdout
+		Service<Logger> logger {std::make_unique<StreamLogger>(std::cout)};
+
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testBulkFetch);
+		RUN_TEST(testRetry);
+		RUN_TEST(testGiveUp);
+		RUN_TEST(testUnusableCacheDirectory);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
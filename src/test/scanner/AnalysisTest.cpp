@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "analysis/FeatureExtractor.hpp"
+#include "analysis/FFT.hpp"
+#include "analysis/Fingerprint.hpp"
+#include "analysis/LoudnessMeter.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+static
+std::vector<float>
+generateSine(float frequency, unsigned sampleRate, std::size_t sampleCount, float amplitude = 0.5f)
+{
+	std::vector<float> samples(sampleCount);
+	for (std::size_t i {}; i < sampleCount; ++i)
+		samples[i] = amplitude * static_cast<float>(std::sin(2 * M_PI * frequency * i / sampleRate));
+
+	return samples;
+}
+
+static
+void
+testFFT()
+{
+	constexpr std::size_t size {1024};
+	Analysis::FFT fft {size};
+	CHECK(fft.getSpectrumSize() == size / 2 + 1);
+
+	// sine centered on bin 64
+	const std::vector<float> samples {generateSine(64, size, size)};
+	std::vector<float> spectrum(fft.getSpectrumSize());
+	fft.computePowerSpectrum(samples.data(), spectrum.data());
+
+	const auto itMax {std::max_element(std::cbegin(spectrum), std::cend(spectrum))};
+	CHECK(std::distance(std::cbegin(spectrum), itMax) == 64);
+	CHECK(std::abs(*itMax - (0.5f * size / 2) * (0.5f * size / 2)) < 1.f);
+
+	float leakage {};
+	for (std::size_t i {}; i < spectrum.size(); ++i)
+	{
+		if (i != 64)
+			leakage += spectrum[i];
+	}
+	CHECK(leakage < 1e-3f * *itMax);
+}
+
+static
+boost::property_tree::ptree
+extractFeatures(const std::vector<float>& samples)
+{
+	Analysis::FeatureExtractor extractor;
+
+	// feed in several chunks, as done while decoding
+	constexpr std::size_t chunkSize {1000};
+	for (std::size_t i {}; i < samples.size(); i += chunkSize)
+		extractor.process(samples.data() + i, std::min(chunkSize, samples.size() - i));
+
+	CHECK(extractor.getFrameCount() == (samples.size() - Analysis::FeatureExtractor::frameSize) / Analysis::FeatureExtractor::hopSize + 1);
+
+	std::istringstream iss {extractor.getJsonEncodedFeatures()};
+	boost::property_tree::ptree root;
+	boost::property_tree::read_json(iss, root);
+
+	return root;
+}
+
+static
+void
+testFeatureExtractorLayout()
+{
+	const auto root {extractFeatures(generateSine(440, Analysis::FeatureExtractor::sampleRate, Analysis::FeatureExtractor::sampleRate))};
+
+	CHECK(root.get_child("lowlevel.erbbands.mean").size() == Analysis::FeatureExtractor::erbBandCount);
+	CHECK(root.get_child("lowlevel.gfcc.mean").size() == Analysis::FeatureExtractor::gfccCount);
+	CHECK(root.get_child("lowlevel.spectral_contrast_valleys.var").size() == Analysis::FeatureExtractor::contrastBandCount);
+	CHECK(root.get_child("lowlevel.spectral_energyband_high.mean").empty());
+	CHECK(root.get_child("lowlevel.spectral_rolloff.median").empty());
+}
+
+static
+void
+testFeatureExtractorValues()
+{
+	constexpr unsigned sampleRate {Analysis::FeatureExtractor::sampleRate};
+
+	const auto lowRoot {extractFeatures(generateSine(1000, sampleRate, sampleRate))};
+	const auto highRoot {extractFeatures(generateSine(8000, sampleRate, sampleRate))};
+
+	const float lowRolloff {lowRoot.get<float>("lowlevel.spectral_rolloff.median")};
+	const float highRolloff {highRoot.get<float>("lowlevel.spectral_rolloff.median")};
+	CHECK(std::abs(lowRolloff - 1000) < 50);
+	CHECK(std::abs(highRolloff - 8000) < 50);
+
+	CHECK(lowRoot.get<float>("lowlevel.spectral_energyband_high.mean") < 1e-3f * highRoot.get<float>("lowlevel.spectral_energyband_high.mean"));
+
+	// Silence must not produce invalid values
+	const auto silenceRoot {extractFeatures(std::vector<float>(sampleRate))};
+	CHECK(silenceRoot.get<float>("lowlevel.spectral_rolloff.median") == 0);
+	for (const auto& [key, value] : silenceRoot.get_child("lowlevel.gfcc.mean"))
+		CHECK(std::isfinite(value.get_value<float>()));
+}
+
+// Random chord progression, one chord every half second
+static
+std::vector<float>
+generateChords(unsigned seed, unsigned sampleRate, std::chrono::seconds duration)
+{
+	std::mt19937 generator {seed};
+	std::uniform_int_distribution<int> noteDistribution {48, 72};
+
+	const std::size_t chordSampleCount {sampleRate / 2};
+	std::vector<float> samples(duration.count() * sampleRate);
+	for (std::size_t chordOffset {}; chordOffset < samples.size(); chordOffset += chordSampleCount)
+	{
+		for (std::size_t note {}; note < 3; ++note)
+		{
+			const float frequency {440.f * std::pow(2.f, (noteDistribution(generator) - 69) / 12.f)};
+			for (std::size_t i {chordOffset}; i < std::min(samples.size(), chordOffset + chordSampleCount); ++i)
+				samples[i] += 0.2f * static_cast<float>(std::sin(2 * M_PI * frequency * i / sampleRate));
+		}
+	}
+
+	return samples;
+}
+
+static
+Analysis::Fingerprint
+computeFingerprint(const std::vector<float>& samples)
+{
+	Analysis::FingerprintExtractor extractor;
+
+	// feed in small chunks, as the decoder does
+	constexpr std::size_t chunkSize {1000};
+	for (std::size_t offset {}; offset < samples.size(); offset += chunkSize)
+		extractor.process(samples.data() + offset, std::min(chunkSize, samples.size() - offset));
+
+	const std::optional<Analysis::Fingerprint> fingerprint {extractor.getFingerprint()};
+	CHECK(fingerprint);
+
+	return *fingerprint;
+}
+
+static
+void
+testFingerprintSerialization()
+{
+	constexpr unsigned sampleRate {Analysis::FingerprintExtractor::sampleRate};
+
+	const Analysis::Fingerprint fingerprint {computeFingerprint(generateChords(1, sampleRate, std::chrono::seconds {20}))};
+	CHECK(!fingerprint.frames.empty());
+
+	const std::optional<Analysis::Fingerprint> deserializedFingerprint {Analysis::Fingerprint::deserialize(fingerprint.serialize())};
+	CHECK(deserializedFingerprint);
+	CHECK(deserializedFingerprint->frames == fingerprint.frames);
+	CHECK(deserializedFingerprint->profile == fingerprint.profile);
+
+	CHECK(!Analysis::Fingerprint::deserialize({}));
+	std::vector<unsigned char> truncatedData {fingerprint.serialize()};
+	truncatedData.pop_back();
+	CHECK(!Analysis::Fingerprint::deserialize(truncatedData));
+
+	// not enough audio
+	Analysis::FingerprintExtractor extractor;
+	const std::vector<float> samples {generateChords(1, sampleRate, std::chrono::seconds {1})};
+	extractor.process(samples.data(), samples.size());
+	CHECK(!extractor.getFingerprint());
+}
+
+static
+void
+testFingerprintMatching()
+{
+	constexpr unsigned sampleRate {Analysis::FingerprintExtractor::sampleRate};
+
+	const std::vector<float> samples {generateChords(1, sampleRate, std::chrono::seconds {60})};
+
+	// Same recording: different gain, some noise and a few ms of extra silence
+	std::vector<float> otherEncodingSamples(sampleRate / 20);
+	{
+		std::mt19937 generator {42};
+		std::uniform_real_distribution<float> noiseDistribution {-0.02f, 0.02f};
+		for (const float sample : samples)
+			otherEncodingSamples.push_back(0.6f * sample + noiseDistribution(generator));
+	}
+
+	const Analysis::Fingerprint fingerprint {computeFingerprint(samples)};
+	const Analysis::Fingerprint otherEncodingFingerprint {computeFingerprint(otherEncodingSamples)};
+	const Analysis::Fingerprint otherRecordingFingerprint {computeFingerprint(generateChords(2, sampleRate, std::chrono::seconds {60}))};
+	const Analysis::Fingerprint otherRecordingFingerprint2 {computeFingerprint(generateChords(3, sampleRate, std::chrono::seconds {60}))};
+
+	CHECK(Analysis::compareFingerprints(fingerprint, fingerprint) == 0);
+	CHECK(Analysis::compareFingerprints(fingerprint, otherEncodingFingerprint) < 0.1f);
+	CHECK(Analysis::compareFingerprints(fingerprint, otherRecordingFingerprint) > 0.3f);
+
+	Analysis::FingerprintIndex index;
+	index.add(1, fingerprint, std::chrono::seconds {60});
+	index.add(2, otherRecordingFingerprint, std::chrono::seconds {60});
+	index.add(3, otherEncodingFingerprint, std::chrono::milliseconds {60050});
+	index.add(4, otherRecordingFingerprint2, std::chrono::seconds {60});
+	// Same beginning, but a much longer track (extended version for instance)
+	index.add(5, fingerprint, std::chrono::minutes {5});
+
+	const auto duplicates {index.findDuplicates(0.15f)};
+	CHECK(duplicates.size() == 1);
+	CHECK(duplicates.front() == std::make_pair(Analysis::FingerprintIndex::Id {1}, Analysis::FingerprintIndex::Id {3}));
+}
+
+static
+std::vector<float>
+interleave(const std::vector<float>& left, const std::vector<float>& right)
+{
+	std::vector<float> samples;
+	samples.reserve(left.size() * 2);
+	for (std::size_t i {}; i < left.size(); ++i)
+	{
+		samples.push_back(left[i]);
+		samples.push_back(right[i]);
+	}
+
+	return samples;
+}
+
+static
+void
+testLoudnessMeter()
+{
+	constexpr unsigned sampleRate {Analysis::LoudnessMeter::sampleRate};
+	const float amplitude {std::pow(10.f, -23.f / 20)};	// -23 dBFS
+
+	// EBU Tech 3341: stereo 1 kHz sine at -23 dBFS is -23 LUFS
+	{
+		const std::vector<float> sine {generateSine(1000, sampleRate, sampleRate * 20, amplitude)};
+		const std::vector<float> samples {interleave(sine, sine)};
+
+		Analysis::LoudnessMeter meter {2};
+		// feed in small chunks, as the decoder does
+		for (std::size_t offset {}; offset < samples.size(); offset += 2000)
+			meter.process(samples.data() + offset, std::min<std::size_t>(2000, samples.size() - offset));
+
+		CHECK(meter.getIntegratedLoudness());
+		CHECK(std::abs(*meter.getIntegratedLoudness() + 23) < 0.1f);
+		CHECK(std::abs(meter.getTruePeak() - amplitude) < 0.01f * amplitude);
+	}
+
+	// Mono: one channel only
+	{
+		const std::vector<float> sine {generateSine(1000, sampleRate, sampleRate * 20, amplitude)};
+
+		Analysis::LoudnessMeter meter {1};
+		meter.process(sine.data(), sine.size());
+
+		CHECK(meter.getIntegratedLoudness());
+		CHECK(std::abs(*meter.getIntegratedLoudness() + 26) < 0.1f);
+	}
+
+	// Silence is gated
+	{
+		const std::vector<float> sine {generateSine(1000, sampleRate, sampleRate * 10, amplitude)};
+		std::vector<float> samples {interleave(sine, sine)};
+		samples.resize(samples.size() * 2);
+
+		Analysis::LoudnessMeter meter {2};
+		meter.process(samples.data(), samples.size());
+
+		CHECK(std::abs(*meter.getIntegratedLoudness() + 23) < 0.1f);
+
+		Analysis::LoudnessMeter silenceMeter {2};
+		silenceMeter.process(samples.data() + sine.size() * 2, sine.size() * 2);
+		CHECK(!silenceMeter.getIntegratedLoudness());
+		CHECK(silenceMeter.getTruePeak() == 0);
+	}
+
+	// True peak between samples: sine at a quarter of the sample rate, sampled at +/- 45 degrees
+	{
+		std::vector<float> samples(sampleRate);
+		for (std::size_t i {}; i < samples.size(); ++i)
+			samples[i] = 0.5f * static_cast<float>(std::sin(M_PI / 2 * i + M_PI / 4));
+
+		Analysis::LoudnessMeter meter {1};
+		meter.process(samples.data(), samples.size());
+
+		CHECK(std::abs(meter.getTruePeak() - 0.5f) < 0.02f);
+	}
+}
+
+static
+void
+testLoudnessHistogramMerge()
+{
+	constexpr unsigned sampleRate {Analysis::LoudnessMeter::sampleRate};
+
+	Analysis::LoudnessMeter meter1 {1};
+	Analysis::LoudnessMeter meter2 {1};
+
+	const std::vector<float> samples1 {generateSine(1000, sampleRate, sampleRate * 10, 0.1f)};
+	const std::vector<float> samples2 {generateSine(1000, sampleRate, sampleRate * 10, 0.1f * std::pow(10.f, -10.f / 20))};
+	meter1.process(samples1.data(), samples1.size());
+	meter2.process(samples2.data(), samples2.size());
+
+	Analysis::LoudnessMeter::Histogram histogram {meter1.getHistogram()};
+	histogram.merge(meter2.getHistogram());
+
+	// Both tracks are above the relative gate: mean of the energies
+	const float expectedLoudness {*meter1.getIntegratedLoudness() + 10 * std::log10(1.1f / 2)};
+	CHECK(std::abs(*histogram.computeIntegratedLoudness() - expectedLoudness) < 0.1f);
+
+	// Gain is limited by the true peak
+	CHECK(std::abs(Analysis::computeReplayGain(-23, 0.1f) - 5) < 1e-3f);
+	CHECK(std::abs(Analysis::computeReplayGain(-23, 0.9f) + 20 * std::log10(0.9f)) < 1e-3f);
+	CHECK(std::abs(Analysis::computeReplayGain(-10, 0.9f) + 8) < 1e-3f);
+}
+
+int main()
+{
+	try
+	{
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testFFT);
+		RUN_TEST(testFeatureExtractorLayout);
+		RUN_TEST(testFeatureExtractorValues);
+		RUN_TEST(testFingerprintSerialization);
+		RUN_TEST(testFingerprintMatching);
+		RUN_TEST(testLoudnessMeter);
+		RUN_TEST(testLoudnessHistogramMerge);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+// Minimal HTTP server, listening on the loopback interface
+// Each connection serves a single request, using the handler from a dedicated thread
+class MockHttpServer final
+{
+	public:
+		struct Response
+		{
+			unsigned status {200};
+			std::string body;
+		};
+
+		// target is the requested path, including the query string
+		using RequestHandler = std::function<Response(const std::string& target)>;
+
+		MockHttpServer(RequestHandler handler)
+		: _acceptor {_ioService, boost::asio::ip::tcp::endpoint {boost::asio::ip::address_v4::loopback(), 0}}
+		, _handler {std::move(handler)}
+		{
+			doAccept();
+			_thread = std::thread {[this] { _ioService.run(); }};
+		}
+
+		~MockHttpServer()
+		{
+			_ioService.stop();
+			_thread.join();
+		}
+
+		MockHttpServer(const MockHttpServer&) = delete;
+		MockHttpServer(MockHttpServer&&) = delete;
+		MockHttpServer& operator=(const MockHttpServer&) = delete;
+		MockHttpServer& operator=(MockHttpServer&&) = delete;
+
+		std::string getUrl() const { return "http://127.0.0.1:" + std::to_string(_acceptor.local_endpoint().port()) + "/"; }
+		std::size_t getRequestCount() const { return _requestCount; }
+
+	private:
+		void doAccept()
+		{
+			_acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket)
+			{
+				if (ec)
+					return;
+
+				handleConnection(socket);
+				doAccept();
+			});
+		}
+
+		void handleConnection(boost::asio::ip::tcp::socket& socket)
+		{
+			boost::system::error_code ec;
+
+			boost::asio::streambuf buffer;
+			boost::asio::read_until(socket, buffer, "\r\n\r\n", ec);
+			if (ec)
+				return;
+
+			// "GET <target> HTTP/1.1"
+			std::istream is {&buffer};
+			std::string method;
+			std::string target;
+			is >> method >> target;
+
+			_requestCount++;
+			const Response response {_handler(target)};
+
+			std::string rawResponse {"HTTP/1.1 " + std::to_string(response.status) + " Mock\r\n"};
+			rawResponse += "Content-Type: application/json\r\n";
+			rawResponse += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+			rawResponse += "Connection: close\r\n\r\n";
+			rawResponse += response.body;
+
+			boost::asio::write(socket, boost::asio::buffer(rawResponse), ec);
+			socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+		}
+
+		boost::asio::io_service _ioService;
+		boost::asio::ip::tcp::acceptor _acceptor;
+		RequestHandler _handler;
+		std::atomic<std::size_t> _requestCount {};
+		std::thread _thread;
+};
+
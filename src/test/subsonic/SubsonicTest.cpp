@@ -0,0 +1,425 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <Wt/Utils.h>
+#include <Wt/WServer.h>
+
+#include "auth/IPasswordService.hpp"
+#include "database/Db.hpp"
+#include "database/Session.hpp"
+#include "database/User.hpp"
+#include "subsonic/SubsonicResource.hpp"
+#include "utils/IConfig.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+
+#include "SubsonicResponse.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+class ScopedDirectory final
+{
+	public:
+		ScopedDirectory() : _path {createTemporaryDirectory()} {}
+		~ScopedDirectory() { std::filesystem::remove_all(_path); }
+
+		ScopedDirectory(const ScopedDirectory&) = delete;
+		ScopedDirectory(ScopedDirectory&&) = delete;
+		ScopedDirectory operator=(const ScopedDirectory&) = delete;
+		ScopedDirectory operator=(ScopedDirectory&&) = delete;
+
+		const std::filesystem::path& getPath() const { return _path; }
+
+	private:
+		static std::filesystem::path createTemporaryDirectory()
+		{
+			std::string pathTemplate {(std::filesystem::temp_directory_path() / "lms-test-XXXXXX").string()};
+			if (!::mkdtemp(pathTemplate.data()))
+				throw std::runtime_error {"Cannot create temporary directory: " + std::string {::strerror(errno)}};
+
+			return pathTemplate;
+		}
+
+		const std::filesystem::path _path;
+};
+
+static const std::string userName {"user"};
+static const std::string userPassword {"user-password"};
+static const std::string userApiKey {"0123456789abcdef"};
+
+// In-process server, with an empty database with a single user
+class TestServer final
+{
+	public:
+		TestServer()
+		: _config {createConfig(createEmptyFile(_workingDir.getPath() / "lms.conf"))}
+		, _db {_workingDir.getPath() / "lms.db"}
+		, _passwordService {Auth::createPasswordService(100)}
+		, _subsonicResource {_db}
+		, _server {"test-subsonic"}
+		{
+			{
+				Database::Session session {_db};
+				session.prepareTables();
+
+				auto transaction {session.createUniqueTransaction()};
+
+				Database::User::pointer user {Database::User::create(session, userName)};
+				user.modify()->setPasswordHash(_passwordService->hashPassword(userPassword));
+				user.modify()->setSubsonicApiKey(userApiKey);
+			}
+
+			const std::filesystem::path wtConfigPath {_workingDir.getPath() / "wt_config.xml"};
+			{
+				std::ofstream ofs {wtConfigPath};
+				ofs << "<server><application-settings location=\"*\"><log-config>* -debug -info</log-config></application-settings></server>\n";
+			}
+
+			const std::vector<std::string> wtServerArgs
+			{
+				"test-subsonic",
+				"--config=" + wtConfigPath.string(),
+				"--docroot=" + _workingDir.getPath().string(),
+				"--http-address=127.0.0.1",
+				"--http-port=0",
+				"--accesslog=-",
+			};
+			std::vector<const char*> wtArgv;
+			for (const std::string& arg : wtServerArgs)
+				wtArgv.push_back(arg.c_str());
+
+			_server.setServerConfiguration(wtArgv.size(), const_cast<char**>(wtArgv.data()));
+			_server.addResource(&_subsonicResource, _subsonicResource.getPath());
+			_server.start();
+		}
+
+		~TestServer()
+		{
+			_server.stop();
+		}
+
+		TestServer(const TestServer&) = delete;
+		TestServer(TestServer&&) = delete;
+		TestServer operator=(const TestServer&) = delete;
+		TestServer operator=(TestServer&&) = delete;
+
+		struct HttpResponse
+		{
+			unsigned statusCode {};
+			std::string headers;
+			std::string body;
+		};
+
+		HttpResponse sendRequest(const std::string& target, const std::string& extraHeaders)
+		{
+			boost::asio::ip::tcp::iostream stream {"127.0.0.1", std::to_string(_server.httpPort())};
+			CHECK(stream);
+
+			stream << "GET " << target << " HTTP/1.0\r\n"
+				<< "Host: 127.0.0.1\r\n"
+				<< extraHeaders
+				<< "Connection: close\r\n\r\n" << std::flush;
+
+			HttpResponse res;
+			std::string httpVersion;
+			stream >> httpVersion >> res.statusCode;
+
+			const std::string response {std::istreambuf_iterator<char> {stream}, std::istreambuf_iterator<char> {}};
+			const std::size_t bodyOffset {response.find("\r\n\r\n")};
+			CHECK(bodyOffset != std::string::npos);
+
+			res.headers = response.substr(0, bodyOffset);
+			res.body = response.substr(bodyOffset + 4);
+			return res;
+		}
+
+		// returns the response body
+		std::string sendRequest(const std::string& target)
+		{
+			const HttpResponse res {sendRequest(target, "")};
+			CHECK(res.statusCode == 200);
+
+			return res.body;
+		}
+
+	private:
+		static std::filesystem::path createEmptyFile(const std::filesystem::path& path)
+		{
+			std::ofstream ofs {path};
+			return path;
+		}
+
+		ScopedDirectory _workingDir;
+		Service<IConfig> _config;
+		Database::Db _db;
+		Service<Auth::IPasswordService> _passwordService;
+		API::Subsonic::SubsonicResource _subsonicResource;
+		Wt::WServer _server;
+};
+
+static
+bool
+isOkResponse(const std::string& body)
+{
+	return body.find("\"status\":\"ok\"") != std::string::npos
+		&& body.find("\"version\":\"1.16.0\"") != std::string::npos;
+}
+
+static
+bool
+isFailedResponse(const std::string& body, unsigned errorCode)
+{
+	return body.find("\"status\":\"failed\"") != std::string::npos
+		&& body.find("\"code\":\"" + std::to_string(errorCode) + "\"") != std::string::npos;
+}
+
+// Each bad attempt throttles the client for a while
+static
+void
+waitForLoginThrottler()
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds {3100});
+}
+
+static
+std::string
+computeToken(const std::string& secret, const std::string& salt)
+{
+	return Wt::Utils::hexEncode(Wt::Utils::md5(secret + salt));
+}
+
+static
+void
+testTokenAuth()
+{
+	TestServer server;
+
+	const std::string salt {"c19b2d"};
+	const std::string baseTarget {"/rest/ping.view?u=" + userName + "&c=test&f=json"};
+
+	// token auth is a 1.13.0 feature
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.16.0&s=" + salt + "&t=" + computeToken(userApiKey, salt))));
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.13.0&s=" + salt + "&t=" + computeToken(userApiKey, salt))));
+
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=1.16.0&s=" + salt), 10));
+
+	// Passwords are stored hashed: only the API key can be used as the token secret
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=1.16.0&s=" + salt + "&t=" + computeToken(userPassword, salt)), 40));
+	waitForLoginThrottler();
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=1.16.0&s=" + salt + "&t=" + computeToken(userApiKey, salt + "x")), 40));
+}
+
+static
+void
+testPasswordAuth()
+{
+	TestServer server;
+
+	const std::string baseTarget {"/rest/ping.view?u=" + userName + "&c=test&f=json"};
+
+	// Clear text passwords must be accepted whatever the client version
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.12.0&p=" + userPassword)));
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.16.0&p=" + userPassword)));
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.16.0&p=enc:" + Wt::Utils::hexEncode(userPassword))));
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=1.16.0&p=bad-password"), 40));
+}
+
+static
+void
+testClientVersion()
+{
+	TestServer server;
+
+	const std::string baseTarget {"/rest/ping.view?u=" + userName + "&p=" + userPassword + "&c=test&f=json"};
+
+	CHECK(isOkResponse(server.sendRequest(baseTarget + "&v=1.0.0")));
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=1.17.0"), 30));
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=2.0.0"), 30));
+	CHECK(isFailedResponse(server.sendRequest(baseTarget + "&v=0.9.0"), 20));
+}
+
+static
+void
+testGenerationDependentCaching()
+{
+	TestServer server;
+
+	const std::string target {"/rest/getGenres.view?u=" + userName + "&p=" + userPassword + "&v=1.16.0&c=test&f=json"};
+
+	const TestServer::HttpResponse first {server.sendRequest(target, "")};
+	CHECK(first.statusCode == 200);
+	CHECK(isOkResponse(first.body));
+	CHECK(first.headers.find("ETag: ") != std::string::npos);
+	CHECK(first.headers.find("Cache-Control: private, no-cache") != std::string::npos);
+
+	// Served from the response cache
+	const TestServer::HttpResponse second {server.sendRequest(target, "")};
+	CHECK(second.statusCode == 200);
+	CHECK(second.body == first.body);
+
+	const std::size_t etagOffset {first.headers.find("ETag: ") + 6};
+	const std::string etag {first.headers.substr(etagOffset, first.headers.find("\r\n", etagOffset) - etagOffset)};
+
+	const TestServer::HttpResponse notModified {server.sendRequest(target, "If-None-Match: " + etag + "\r\n")};
+	CHECK(notModified.statusCode == 304);
+	CHECK(notModified.headers.find("ETag: " + etag) != std::string::npos);
+	CHECK(notModified.headers.find("Cache-Control: private, no-cache") != std::string::npos);
+
+	// Modifying the user data invalidates the responses of this user
+	CHECK(isOkResponse(server.sendRequest("/rest/createPlaylist.view?u=" + userName + "&p=" + userPassword + "&v=1.16.0&c=test&f=json&name=MyPlaylist")));
+
+	const TestServer::HttpResponse modified {server.sendRequest(target, "If-None-Match: " + etag + "\r\n")};
+	CHECK(modified.statusCode == 200);
+	CHECK(modified.body == first.body);
+	CHECK(modified.headers.find("ETag: ") != std::string::npos);
+	CHECK(modified.headers.find("ETag: " + etag) == std::string::npos);
+}
+
+// A failed response does not need any request context
+class TestError : public API::Subsonic::GenericError
+{
+	std::string getMessage() const override { return "test"; }
+};
+
+static
+void
+testResponseGeneratorFailure()
+{
+	using namespace API::Subsonic;
+
+	// Produces childCount children, then fails if requested
+	auto createResponse {[](std::size_t childCount, bool fail, bool nested)
+	{
+		auto generator {[=](const Response::Node::ArrayChildConsumer& consumer)
+		{
+			for (std::size_t i {}; i < childCount; ++i)
+			{
+				Response::Node childNode;
+				childNode.setAttribute("id", "tr-" + std::to_string(i));
+				consumer(childNode);
+			}
+
+			if (fail)
+				throw std::runtime_error {"generator failure"};
+		}};
+
+		Response response {Response::createFailedResponse(TestError {})};
+		Response::Node& songsNode {response.createNode("songs")};
+		if (nested)
+		{
+			Response::Node& directoryNode {songsNode.createChild("directory")};
+			directoryNode.addArrayChildGenerator("child", generator);
+		}
+		else
+			songsNode.addArrayChildGenerator("song", generator);
+		songsNode.setAttribute("name", "after");
+
+		return response;
+	}};
+
+	for (const ResponseFormat format : {ResponseFormat::xml, ResponseFormat::json})
+	{
+		for (const bool nested : {false, true})
+		{
+			for (const std::size_t childCount : {std::size_t {0}, std::size_t {1}, std::size_t {3}})
+			{
+				std::ostringstream expected;
+				CHECK(createResponse(childCount, false, nested).write(expected, format));
+
+				// Same document as if the generator had produced only the children before the failure
+				std::ostringstream truncated;
+				CHECK(!createResponse(childCount, true, nested).write(truncated, format));
+				CHECK(truncated.str() == expected.str());
+			}
+		}
+	}
+
+	// Errors are also caught
+	{
+		Response response {Response::createFailedResponse(TestError {})};
+		response.createNode("songs").addArrayChildGenerator("song", [](const Response::Node::ArrayChildConsumer&)
+		{
+			throw RequestedDataNotFoundError {};
+		});
+
+		std::ostringstream oss;
+		CHECK(!response.write(oss, ResponseFormat::json));
+		CHECK(oss.str().find("\"song\":[]") != std::string::npos);
+	}
+}
+
+int main()
+{
+	try
+	{
+		// log to stdout
+		Service<Logger> logger {std::make_unique<StreamLogger>(std::cout)};
+
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testResponseGeneratorFailure);
+		RUN_TEST(testTokenAuth);
+		RUN_TEST(testPasswordAuth);
+		RUN_TEST(testClientVersion);
+		RUN_TEST(testGenerationDependentCaching);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/AsyncLogger.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+// Keeps the messages, may block the background thread of the async logger
+// Outlives the async logger, which owns the logger it forwards logs to
+class LogRecorder final
+{
+	public:
+		void record(const std::string& message)
+		{
+			std::unique_lock lock {_mutex};
+
+			if (_blocked)
+			{
+				_blockedLogReached = true;
+				_cv.notify_all();
+				_cv.wait(lock, [this] { return !_blocked; });
+			}
+
+			_messages.push_back(message);
+		}
+
+		// next log blocks until unblock is called
+		void block()
+		{
+			std::scoped_lock lock {_mutex};
+			_blocked = true;
+			_blockedLogReached = false;
+		}
+
+		void waitUntilBlocked()
+		{
+			std::unique_lock lock {_mutex};
+			_cv.wait(lock, [this] { return _blockedLogReached; });
+		}
+
+		void unblock()
+		{
+			{
+				std::scoped_lock lock {_mutex};
+				_blocked = false;
+			}
+			_cv.notify_all();
+		}
+
+		std::vector<std::string> getMessages()
+		{
+			std::scoped_lock lock {_mutex};
+			return _messages;
+		}
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable _cv;
+		bool _blocked {};
+		bool _blockedLogReached {};
+		std::vector<std::string> _messages;
+};
+
+class RecordingLogger final : public Logger
+{
+	public:
+		RecordingLogger(LogRecorder& recorder) : _recorder {recorder} {}
+
+		void processLog(const Log& log) override { _recorder.record(log.getMessage()); }
+
+	private:
+		LogRecorder& _recorder;
+};
+
+static
+void
+runProducers(Logger& logger, std::size_t producerCount, std::size_t logCountPerProducer)
+{
+	std::vector<std::thread> producers;
+	for (std::size_t producer {}; producer < producerCount; ++producer)
+	{
+		producers.emplace_back([&, producer]
+		{
+			for (std::size_t i {}; i < logCountPerProducer; ++i)
+				Log {&logger, Module::UTILS, Severity::INFO}.getOstream() << producer << "-" << i;
+		});
+	}
+
+	for (std::thread& producer : producers)
+		producer.join();
+}
+
+static
+void
+testAsyncLoggerNoLoss()
+{
+	constexpr std::size_t capacity {1024};
+	constexpr std::size_t producerCount {4};
+	constexpr std::size_t logCountPerProducer {200};	// below capacity
+
+	LogRecorder recorder;
+	{
+		AsyncLogger asyncLogger {std::make_unique<RecordingLogger>(recorder), capacity};
+		runProducers(asyncLogger, producerCount, logCountPerProducer);
+	}
+
+	const std::vector<std::string> messages {recorder.getMessages()};
+	CHECK(messages.size() == producerCount * logCountPerProducer);
+
+	// Logs of each producer are forwarded in order
+	std::map<std::size_t, std::size_t> nextLogIndexes;
+	for (const std::string& message : messages)
+	{
+		const std::size_t separator {message.find('-')};
+		CHECK(separator != std::string::npos);
+
+		const std::size_t producer {std::stoul(message.substr(0, separator))};
+		const std::size_t logIndex {std::stoul(message.substr(separator + 1))};
+		CHECK(logIndex == nextLogIndexes[producer]++);
+	}
+
+	CHECK(nextLogIndexes.size() == producerCount);
+	for (const auto& [producer, logCount] : nextLogIndexes)
+		CHECK(logCount == logCountPerProducer);
+}
+
+static
+void
+testAsyncLoggerDroppedLogs()
+{
+	constexpr std::size_t capacity {256};
+	constexpr std::size_t producerCount {4};
+	constexpr std::size_t logCountPerProducer {89};	// 100 logs above capacity
+
+	LogRecorder recorder;
+	{
+		AsyncLogger asyncLogger {std::make_unique<RecordingLogger>(recorder), capacity};
+
+		// The background thread is stuck on this log, the queue is empty and cannot be drained
+		recorder.block();
+		Log {&asyncLogger, Module::UTILS, Severity::INFO}.getOstream() << "blocking";
+		recorder.waitUntilBlocked();
+
+		runProducers(asyncLogger, producerCount, logCountPerProducer);
+
+		recorder.unblock();
+	}
+
+	const std::vector<std::string> messages {recorder.getMessages()};
+	CHECK(messages.size() == 1 + capacity + 1);
+	CHECK(messages.front() == "blocking");
+	CHECK(messages.back() == std::to_string(producerCount * logCountPerProducer - capacity) + " log messages dropped!");
+}
+
+int main()
+{
+	try
+	{
+		// log to stdout
+		Service<Logger> logger {std::make_unique<StreamLogger>(std::cout)};
+
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testAsyncLoggerNoLoss);
+		RUN_TEST(testAsyncLoggerDroppedLogs);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
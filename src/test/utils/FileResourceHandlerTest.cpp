@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+#include <Wt/WServer.h>
+
+#include "utils/FileResourceHandlerCreator.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+class ScopedDirectory final
+{
+	public:
+		ScopedDirectory() : _path {createTemporaryDirectory()} {}
+		~ScopedDirectory() { std::filesystem::remove_all(_path); }
+
+		ScopedDirectory(const ScopedDirectory&) = delete;
+		ScopedDirectory(ScopedDirectory&&) = delete;
+		ScopedDirectory operator=(const ScopedDirectory&) = delete;
+		ScopedDirectory operator=(ScopedDirectory&&) = delete;
+
+		const std::filesystem::path& getPath() const { return _path; }
+
+	private:
+		static std::filesystem::path createTemporaryDirectory()
+		{
+			std::string pathTemplate {(std::filesystem::temp_directory_path() / "lms-test-XXXXXX").string()};
+			if (!::mkdtemp(pathTemplate.data()))
+				throw std::runtime_error {"Cannot create temporary directory: " + std::string {::strerror(errno)}};
+
+			return pathTemplate;
+		}
+
+		const std::filesystem::path _path;
+};
+
+class FileResource final : public Wt::WResource
+{
+	public:
+		FileResource(const std::filesystem::path& path) : _path {path} {}
+		~FileResource() { beingDeleted(); }
+
+	private:
+		void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override
+		{
+			std::shared_ptr<IResourceHandler> resourceHandler;
+
+			if (!request.continuation())
+				resourceHandler = createFileResourceHandler(_path);
+			else
+				resourceHandler = Wt::cpp17::any_cast<std::shared_ptr<IResourceHandler>>(request.continuation()->data());
+
+			auto* continuation {resourceHandler->processRequest(request, response)};
+			if (continuation)
+				continuation->setData(resourceHandler);
+		}
+
+		const std::filesystem::path _path;
+};
+
+struct HttpResponse
+{
+	unsigned status {};
+	std::map<std::string, std::string> headers;
+	std::string body;
+};
+
+static
+HttpResponse
+sendRequest(unsigned short port, const std::string& path, const std::map<std::string, std::string>& headers)
+{
+	boost::asio::ip::tcp::iostream stream {"127.0.0.1", std::to_string(port)};
+	CHECK(stream);
+
+	stream << "GET " << path << " HTTP/1.0\r\n"
+		<< "Host: 127.0.0.1\r\n";
+	for (const auto& [name, value] : headers)
+		stream << name << ": " << value << "\r\n";
+	stream << "Connection: close\r\n\r\n" << std::flush;
+
+	HttpResponse response;
+
+	std::string line;
+	std::getline(stream, line);
+	{
+		std::istringstream iss {line};
+		std::string httpVersion;
+		iss >> httpVersion >> response.status;
+	}
+
+	while (std::getline(stream, line) && line != "\r")
+	{
+		const std::size_t separator {line.find(':')};
+		if (separator == std::string::npos)
+			continue;
+
+		std::string value {line.substr(separator + 1)};
+		value.erase(0, value.find_first_not_of(' '));
+		if (!value.empty() && value.back() == '\r')
+			value.pop_back();
+
+		response.headers[line.substr(0, separator)] = value;
+	}
+
+	response.body.assign(std::istreambuf_iterator<char> {stream}, std::istreambuf_iterator<char> {});
+
+	return response;
+}
+
+static
+void
+testFileResourceHandler()
+{
+	const ScopedDirectory workingDir;
+
+	// Bigger than a chunk, so that the file is served using continuations
+	std::string content;
+	for (std::size_t i {}; i < 300000; ++i)
+		content.push_back(static_cast<char>((i * 7) % 251));
+
+	const std::filesystem::path filePath {workingDir.getPath() / "file.bin"};
+	{
+		std::ofstream ofs {filePath, std::ios_base::binary};
+		ofs << content;
+	}
+
+	const std::filesystem::path wtConfigPath {workingDir.getPath() / "wt_config.xml"};
+	{
+		std::ofstream ofs {wtConfigPath};
+		ofs << "<server><application-settings location=\"*\"><log-config>* -debug -info</log-config></application-settings></server>\n";
+	}
+
+	const std::vector<std::string> wtServerArgs
+	{
+		"test-file-resource-handler",
+		"--config=" + wtConfigPath.string(),
+		"--docroot=" + workingDir.getPath().string(),
+		"--http-address=127.0.0.1",
+		"--http-port=0",
+		"--accesslog=-",
+	};
+	std::vector<const char*> wtArgv;
+	for (const std::string& arg : wtServerArgs)
+		wtArgv.push_back(arg.c_str());
+
+	Wt::WServer server {wtServerArgs.front()};
+	server.setServerConfiguration(wtArgv.size(), const_cast<char**>(wtArgv.data()));
+
+	FileResource fileResource {filePath};
+	FileResource missingFileResource {workingDir.getPath() / "missing.bin"};
+	server.addResource(&fileResource, "/file.bin");
+	server.addResource(&missingFileResource, "/missing.bin");
+	server.start();
+
+	const unsigned short port {static_cast<unsigned short>(server.httpPort())};
+	const std::string contentSize {std::to_string(content.size())};
+
+	// Whole file
+	std::string etag;
+	std::string lastModified;
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {})};
+		CHECK(response.status == 200);
+		CHECK(response.headers.at("Accept-Ranges") == "bytes");
+		CHECK(response.headers.at("Content-Type") == "application/octet-stream");
+		CHECK(response.body == content);
+
+		etag = response.headers.at("ETag");
+		lastModified = response.headers.at("Last-Modified");
+	}
+
+	// Single ranges
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=100-199"}})};
+		CHECK(response.status == 206);
+		CHECK(response.headers.at("Content-Range") == "bytes 100-199/" + contentSize);
+		CHECK(response.body == content.substr(100, 100));
+	}
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=1000-"}})};
+		CHECK(response.status == 206);
+		CHECK(response.headers.at("Content-Range") == "bytes 1000-" + std::to_string(content.size() - 1) + "/" + contentSize);
+		CHECK(response.body == content.substr(1000));
+	}
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=-10"}})};
+		CHECK(response.status == 206);
+		CHECK(response.body == content.substr(content.size() - 10));
+	}
+
+	// Multiple ranges
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=0-9,280000-280099"}})};
+		CHECK(response.status == 206);
+
+		const std::string boundary {"lms_byteranges_" + etag.substr(1, etag.size() - 2)};
+		CHECK(response.headers.at("Content-Type") == "multipart/byteranges; boundary=" + boundary);
+
+		const std::string expectedBody {"\r\n--" + boundary + "\r\n"
+			"Content-Type: application/octet-stream\r\n"
+			"Content-Range: bytes 0-9/" + contentSize + "\r\n"
+			"\r\n" + content.substr(0, 10) +
+			"\r\n--" + boundary + "\r\n"
+			"Content-Type: application/octet-stream\r\n"
+			"Content-Range: bytes 280000-280099/" + contentSize + "\r\n"
+			"\r\n" + content.substr(280000, 100) +
+			"\r\n--" + boundary + "--\r\n"};
+		CHECK(response.body == expectedBody);
+	}
+
+	// Not modified
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"If-None-Match", etag}})};
+		CHECK(response.status == 304);
+		CHECK(response.body.empty());
+	}
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"If-Modified-Since", lastModified}})};
+		CHECK(response.status == 304);
+		CHECK(response.body.empty());
+	}
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"If-None-Match", "\"0-0\""}})};
+		CHECK(response.status == 200);
+		CHECK(response.body == content);
+	}
+
+	// Beyond the end
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=" + contentSize + "-"}})};
+		CHECK(response.status == 416);
+		CHECK(response.headers.at("Content-Range") == "bytes */" + contentSize);
+		CHECK(response.body.empty());
+	}
+
+	// Same version of the file
+	for (const std::string& ifRange : {etag, lastModified})
+	{
+		const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", "bytes=100-199"}, {"If-Range", ifRange}})};
+		CHECK(response.status == 206);
+		CHECK(response.body == content.substr(100, 100));
+	}
+
+	// Outdated file, or weak validator: the whole file is sent, even if the range is not satisfiable
+	for (const std::string& ifRange : {std::string {"\"0-0\""}, "W/" + etag, std::string {"Thu, 01 Jan 1970 00:00:00 GMT"}})
+	{
+		for (const std::string& range : {std::string {"bytes=100-199"}, "bytes=" + contentSize + "-"})
+		{
+			const HttpResponse response {sendRequest(port, "/file.bin", {{"Range", range}, {"If-Range", ifRange}})};
+			CHECK(response.status == 200);
+			CHECK(response.body == content);
+		}
+	}
+
+	// Missing file
+	{
+		const HttpResponse response {sendRequest(port, "/missing.bin", {})};
+		CHECK(response.status == 404);
+	}
+
+	server.stop();
+}
+
+int main()
+{
+	try
+	{
+		// log to stdout
+		Service<Logger> logger {std::make_unique<StreamLogger>(std::cout)};
+
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testFileResourceHandler);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
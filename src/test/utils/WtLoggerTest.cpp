@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <Wt/WLogger.h>
+
+#include "utils/Logger.hpp"
+#include "utils/WtLogger.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+static
+void
+testWtLoggerModuleScope()
+{
+	// Example given in lms.conf
+	const std::string logConfig {"* -debug debug:DBUPDATER"};
+
+	// Same filtering as the server logger
+	std::ostringstream oss;
+	Wt::WLogger wtLogger;
+	wtLogger.setStream(oss);
+	wtLogger.addField("type", false);
+	wtLogger.addField("message", true);
+	wtLogger.configure(logConfig);
+
+	WtLogger logger {logConfig, &wtLogger};
+	CHECK(logger.isSeverityActive(Module::DBUPDATER, Severity::DEBUG));
+	CHECK(logger.isSeverityActive(Module::DBUPDATER, Severity::INFO));
+	CHECK(!logger.isSeverityActive(Module::UI, Severity::DEBUG));
+	CHECK(logger.isSeverityActive(Module::UI, Severity::INFO));
+
+	Log {&logger, Module::DBUPDATER, Severity::DEBUG}.getOstream() << "Scanning file: /music/track.mp3";
+	Log {&logger, Module::UI, Severity::INFO}.getOstream() << "Session created";
+
+	const std::string output {oss.str()};
+	std::cout << output;
+
+	// Not filtered out by Wt
+	CHECK(output.find("DBUPDATER: Scanning file: /music/track.mp3") != std::string::npos);
+	CHECK(output.find("UI: Session created") != std::string::npos);
+}
+
+int main()
+{
+	try
+	{
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testWtLoggerModuleScope);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+#include <Wt/WServer.h>
+
+#include "utils/Logger.hpp"
+#include "utils/Path.hpp"
+#include "utils/Service.hpp"
+#include "utils/StreamLogger.hpp"
+#include "utils/Zipper.hpp"
+#include "utils/ZipperResourceHandlerCreator.hpp"
+
+#define CHECK(PRED)  \
+	do \
+	{ \
+		if (!(PRED)) \
+		{ \
+			std::string error {"Predicate FAILED '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+			std::cerr << error << std::endl; \
+			throw std::runtime_error {error}; \
+		} \
+	} while (0)
+
+class ScopedDirectory final
+{
+	public:
+		ScopedDirectory() : _path {createTemporaryDirectory()} {}
+		~ScopedDirectory() { std::filesystem::remove_all(_path); }
+
+		ScopedDirectory(const ScopedDirectory&) = delete;
+		ScopedDirectory(ScopedDirectory&&) = delete;
+		ScopedDirectory operator=(const ScopedDirectory&) = delete;
+		ScopedDirectory operator=(ScopedDirectory&&) = delete;
+
+		const std::filesystem::path& getPath() const { return _path; }
+
+	private:
+		static std::filesystem::path createTemporaryDirectory()
+		{
+			std::string pathTemplate {(std::filesystem::temp_directory_path() / "lms-test-XXXXXX").string()};
+			if (!::mkdtemp(pathTemplate.data()))
+				throw std::runtime_error {"Cannot create temporary directory: " + std::string {::strerror(errno)}};
+
+			return pathTemplate;
+		}
+
+		const std::filesystem::path _path;
+};
+
+// Files of various sizes, with some content that depends on the offset
+class TestFiles final
+{
+	public:
+		TestFiles()
+		{
+			for (const std::size_t fileSize : {std::size_t {1000}, std::size_t {0}, std::size_t {300000}, std::size_t {17}})
+			{
+				const std::filesystem::path filePath {_directory.getPath() / ("file" + std::to_string(_files.size()) + ".bin")};
+				{
+					std::ofstream ofs {filePath, std::ios_base::binary};
+					for (std::size_t i {}; i < fileSize; ++i)
+						ofs.put(static_cast<char>((i * 7 + _files.size()) % 251));
+				}
+
+				_files.emplace("dir/file" + std::to_string(_files.size()) + ".bin", filePath);
+			}
+		}
+
+		// CRCs are provided, so that the archive is seekable
+		std::unique_ptr<Zip::Zipper> createSeekableZipper() const
+		{
+			std::map<std::string, Zip::Entry> entries;
+			for (const auto& [fileName, filePath] : _files)
+				entries.emplace(fileName, Zip::Entry {filePath, computeCrc32(filePath), getLastWriteTime(filePath)});
+
+			return std::make_unique<Zip::Zipper>(entries);
+		}
+
+		std::unique_ptr<Zip::Zipper> createNonSeekableZipper() const
+		{
+			return std::make_unique<Zip::Zipper>(_files);
+		}
+
+	private:
+		ScopedDirectory _directory;
+		std::map<std::string, std::filesystem::path> _files;
+};
+
+static
+std::string
+readAll(Zip::Zipper& zipper)
+{
+	std::string res;
+
+	std::vector<std::byte> buffer(1000);
+	while (!zipper.isComplete())
+	{
+		const Zip::SizeType nbWrittenBytes {zipper.writeSome(buffer.data(), buffer.size())};
+		res.append(reinterpret_cast<const char*>(buffer.data()), nbWrittenBytes);
+	}
+
+	return res;
+}
+
+static
+void
+testZipperSeek()
+{
+	const TestFiles testFiles;
+
+	std::string archive;
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createSeekableZipper()};
+		CHECK(zipper->isSeekable());
+		archive = readAll(*zipper);
+		CHECK(archive.size() == zipper->getTotalZipFile());
+	}
+
+	// Must match the archive created without precomputed CRCs
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createNonSeekableZipper()};
+		CHECK(!zipper->isSeekable());
+		CHECK(readAll(*zipper) == archive);
+	}
+
+	// First local header is 30 bytes + file name + zip64 extra field
+	const std::vector<Zip::SizeType> offsets
+	{
+		0,
+		1,					// inside the first local header
+		29,					// inside the first local header
+		30,					// file name of the first local header
+		80,					// inside the first file data
+		1000,					// inside the first file data
+		archive.size() / 2,			// inside the biggest file data
+		archive.size() - 100,			// inside the central directory
+		archive.size() - 1,
+		archive.size(),				// end of the archive
+	};
+
+	for (const Zip::SizeType offset : offsets)
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createSeekableZipper()};
+		zipper->seek(offset);
+		CHECK(readAll(*zipper) == archive.substr(offset));
+	}
+
+	// Seek after the end
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createSeekableZipper()};
+
+		bool exceptionCaught {};
+		try
+		{
+			zipper->seek(archive.size() + 1);
+		}
+		catch (const Zip::ZipperException&)
+		{
+			exceptionCaught = true;
+		}
+		CHECK(exceptionCaught);
+	}
+
+	// Not seekable
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createNonSeekableZipper()};
+
+		bool exceptionCaught {};
+		try
+		{
+			zipper->seek(1);
+		}
+		catch (const Zip::ZipperException&)
+		{
+			exceptionCaught = true;
+		}
+		CHECK(exceptionCaught);
+	}
+}
+
+class ZipperResource final : public Wt::WResource
+{
+	public:
+		using ZipperCreator = std::function<std::unique_ptr<Zip::Zipper>()>;
+
+		ZipperResource(ZipperCreator zipperCreator) : _zipperCreator {std::move(zipperCreator)} {}
+		~ZipperResource() { beingDeleted(); }
+
+	private:
+		void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override
+		{
+			std::shared_ptr<IResourceHandler> resourceHandler;
+
+			if (!request.continuation())
+				resourceHandler = createZipperResourceHandler(_zipperCreator());
+			else
+				resourceHandler = Wt::cpp17::any_cast<std::shared_ptr<IResourceHandler>>(request.continuation()->data());
+
+			auto* continuation {resourceHandler->processRequest(request, response)};
+			if (continuation)
+				continuation->setData(resourceHandler);
+		}
+
+		ZipperCreator _zipperCreator;
+};
+
+struct HttpResponse
+{
+	unsigned status {};
+	std::map<std::string, std::string> headers;
+	std::string body;
+};
+
+static
+HttpResponse
+sendRequest(unsigned short port, const std::string& path, const std::map<std::string, std::string>& headers)
+{
+	boost::asio::ip::tcp::iostream stream {"127.0.0.1", std::to_string(port)};
+	CHECK(stream);
+
+	stream << "GET " << path << " HTTP/1.0\r\n"
+		<< "Host: 127.0.0.1\r\n";
+	for (const auto& [name, value] : headers)
+		stream << name << ": " << value << "\r\n";
+	stream << "Connection: close\r\n\r\n" << std::flush;
+
+	HttpResponse response;
+
+	std::string line;
+	std::getline(stream, line);
+	{
+		std::istringstream iss {line};
+		std::string httpVersion;
+		iss >> httpVersion >> response.status;
+	}
+
+	while (std::getline(stream, line) && line != "\r")
+	{
+		const std::size_t separator {line.find(':')};
+		if (separator == std::string::npos)
+			continue;
+
+		std::string value {line.substr(separator + 1)};
+		value.erase(0, value.find_first_not_of(' '));
+		if (!value.empty() && value.back() == '\r')
+			value.pop_back();
+
+		response.headers[line.substr(0, separator)] = value;
+	}
+
+	response.body.assign(std::istreambuf_iterator<char> {stream}, std::istreambuf_iterator<char> {});
+
+	return response;
+}
+
+static
+void
+testZipperResourceHandlerRanges()
+{
+	const TestFiles testFiles;
+	const ScopedDirectory workingDir;
+
+	std::string archive;
+	{
+		std::unique_ptr<Zip::Zipper> zipper {testFiles.createSeekableZipper()};
+		archive = readAll(*zipper);
+	}
+
+	const std::filesystem::path wtConfigPath {workingDir.getPath() / "wt_config.xml"};
+	{
+		std::ofstream ofs {wtConfigPath};
+		ofs << "<server><application-settings location=\"*\"><log-config>* -debug -info</log-config></application-settings></server>\n";
+	}
+
+	const std::vector<std::string> wtServerArgs
+	{
+		"test-utils",
+		"--config=" + wtConfigPath.string(),
+		"--docroot=" + workingDir.getPath().string(),
+		"--http-address=127.0.0.1",
+		"--http-port=0",
+		"--accesslog=-",
+	};
+	std::vector<const char*> wtArgv;
+	for (const std::string& arg : wtServerArgs)
+		wtArgv.push_back(arg.c_str());
+
+	Wt::WServer server {wtServerArgs.front()};
+	server.setServerConfiguration(wtArgv.size(), const_cast<char**>(wtArgv.data()));
+
+	ZipperResource seekableResource {[&] { return testFiles.createSeekableZipper(); }};
+	ZipperResource nonSeekableResource {[&] { return testFiles.createNonSeekableZipper(); }};
+	server.addResource(&seekableResource, "/seekable.zip");
+	server.addResource(&nonSeekableResource, "/nonseekable.zip");
+	server.start();
+
+	const unsigned short port {static_cast<unsigned short>(server.httpPort())};
+
+	// Whole archive
+	{
+		const HttpResponse response {sendRequest(port, "/seekable.zip", {})};
+		CHECK(response.status == 200);
+		CHECK(response.headers.at("Accept-Ranges") == "bytes");
+		CHECK(response.body == archive);
+	}
+
+	// Ranges starting inside a local header, inside file data, and the last byte
+	for (const Zip::SizeType firstByte : {Zip::SizeType {10}, Zip::SizeType {2000}, Zip::SizeType {archive.size() - 1}})
+	{
+		const std::string etag {sendRequest(port, "/seekable.zip", {{"Range", "bytes=0-0"}}).headers.at("ETag")};
+
+		const HttpResponse response {sendRequest(port, "/seekable.zip", {{"Range", "bytes=" + std::to_string(firstByte) + "-"}, {"If-Range", etag}})};
+		CHECK(response.status == 206);
+		CHECK(response.headers.at("Content-Range") == "bytes " + std::to_string(firstByte) + "-" + std::to_string(archive.size() - 1) + "/" + std::to_string(archive.size()));
+		CHECK(response.body == archive.substr(firstByte));
+	}
+
+	// Bounded range
+	{
+		const HttpResponse response {sendRequest(port, "/seekable.zip", {{"Range", "bytes=100-199"}})};
+		CHECK(response.status == 206);
+		CHECK(response.body == archive.substr(100, 100));
+	}
+
+	// Outdated archive
+	{
+		const HttpResponse response {sendRequest(port, "/seekable.zip", {{"Range", "bytes=100-199"}, {"If-Range", "\"0-0\""}})};
+		CHECK(response.status == 200);
+		CHECK(response.body == archive);
+	}
+
+	// Beyond the end
+	{
+		const HttpResponse response {sendRequest(port, "/seekable.zip", {{"Range", "bytes=" + std::to_string(archive.size()) + "-"}})};
+		CHECK(response.status == 416);
+		CHECK(response.headers.at("Content-Range") == "bytes */" + std::to_string(archive.size()));
+		CHECK(response.body.empty());
+	}
+
+	// Ranges are ignored if the archive is not seekable
+	{
+		const HttpResponse response {sendRequest(port, "/nonseekable.zip", {{"Range", "bytes=100-199"}})};
+		CHECK(response.status == 200);
+		CHECK(response.headers.count("Accept-Ranges") == 0);
+		CHECK(response.body == archive);
+	}
+
+	server.stop();
+}
+
+int main()
+{
+	try
+	{
+		// log to stdout
+		Service<Logger> logger {std::make_unique<StreamLogger>(std::cout)};
+
+		auto runTest = [](const std::string& name, std::function<void()> testFunc)
+		{
+			std::cout << "Running test '" << name << "'..." << std::endl;
+			testFunc();
+			std::cout << "Running test '" << name << "': SUCCESS" << std::endl;
+		};
+
+#define RUN_TEST(test)	runTest(#test, test)
+
+		RUN_TEST(testZipperSeek);
+		RUN_TEST(testZipperResourceHandlerRanges);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,498 @@
+/*
+ * Copyright (C) 2021 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Generates a synthetic music library, to benchmark the scanner and the APIs on large collections
+// Layout: <output>/<artist>/<year> - <release>/<disc>-<track> - <title>.mp3
+// Audio is made of silent MPEG frames: files are small and fast to write, but have a real duration
+// and are recognized as regular mp3 files by both TagLib and FFmpeg
+// Generation is deterministic for a given seed
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <taglib/attachedpictureframe.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mpegfile.h>
+#include <taglib/tpropertymap.h>
+
+#include "cover/IEncodedImage.hpp"
+
+#if LMS_SUPPORT_IMAGE_STB
+#include "stb/RawImage.hpp"
+using RawImage = CoverArt::STB::RawImage;
+#elif LMS_SUPPORT_IMAGE_GM
+#include "graphicsmagick/RawImage.hpp"
+using RawImage = CoverArt::GraphicsMagick::RawImage;
+#endif
+
+namespace
+{
+	struct GeneratorParameters
+	{
+		std::filesystem::path	outputPath;
+		std::size_t		artistCount;
+		std::size_t		releaseCountPerArtist;
+		std::size_t		trackCountPerRelease;
+		std::size_t		trackDuration;		// in seconds
+		float			collaborationRatio;	// ratio of tracks featuring another artist
+		float			coverRatio;		// ratio of releases having an embedded cover
+		unsigned		coverSize;
+		std::uint32_t		seed;
+	};
+
+	struct ArtistDesc
+	{
+		std::string	name;
+		std::string	mbid;
+	};
+
+	struct TrackDesc
+	{
+		std::string		title;
+		std::string		mbid;
+		std::size_t		trackNumber;
+		std::size_t		discNumber;
+		std::vector<std::size_t>	featuredArtists;	// indexes in the artist list
+	};
+
+	struct ReleaseDesc
+	{
+		std::string		name;
+		std::string		mbid;
+		std::size_t		artist;		// index in the artist list
+		unsigned		year;
+		std::size_t		discCount;
+		std::vector<std::string>	genres;
+		bool			hasCover;
+		std::vector<TrackDesc>	tracks;
+	};
+
+	const std::vector<std::string> syllables
+	{
+		"ka", "lo", "mi", "ra", "ne", "to", "su", "vi", "da", "mor", "tan", "gel", "ri", "po", "sha", "lum",
+		"ber", "qui", "zen", "fa", "dor", "nal", "wes", "ty", "cro", "bel", "an", "ost", "ive", "par", "el", "yon",
+	};
+
+	const std::vector<std::string> genres
+	{
+		"Rock", "Pop", "Jazz", "Blues", "Classical", "Electronic", "Hip-Hop", "Folk", "Metal", "Punk",
+		"Reggae", "Soul", "Funk", "Ambient", "Techno", "House", "Country", "Soundtrack", "Indie", "Alternative",
+		"Progressive Rock", "Trip-Hop", "Drum and Bass", "Post-Rock", "Shoegaze", "Disco", "Latin", "World",
+	};
+
+	std::string
+	generateWord(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<std::size_t> syllableCountDist {1, 3};
+		std::uniform_int_distribution<std::size_t> syllableDist {0, syllables.size() - 1};
+
+		std::string word;
+		const std::size_t syllableCount {syllableCountDist(rng)};
+		for (std::size_t i {}; i < syllableCount; ++i)
+			word += syllables[syllableDist(rng)];
+
+		word.front() = static_cast<char>(std::toupper(word.front()));
+		return word;
+	}
+
+	std::string
+	generateName(std::mt19937& rng, std::size_t minWordCount, std::size_t maxWordCount)
+	{
+		std::uniform_int_distribution<std::size_t> wordCountDist {minWordCount, maxWordCount};
+
+		std::string name;
+		const std::size_t wordCount {wordCountDist(rng)};
+		for (std::size_t i {}; i < wordCount; ++i)
+		{
+			if (!name.empty())
+				name += " ";
+			name += generateWord(rng);
+		}
+
+		return name;
+	}
+
+	std::string
+	generateMBID(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<unsigned> nibbleDist {0, 15};
+
+		std::ostringstream oss;
+		oss << std::hex;
+		for (std::size_t i {}; i < 32; ++i)
+		{
+			if (i == 8 || i == 12 || i == 16 || i == 20)
+				oss << "-";
+			oss << nibbleDist(rng);
+		}
+
+		return oss.str();
+	}
+
+	// Names are not unique: this is on purpose, as homonyms have to be handled by the scanner
+	void
+	generateLibraryDesc(const GeneratorParameters& params, std::vector<ArtistDesc>& artists, std::vector<ReleaseDesc>& releases)
+	{
+		std::mt19937 rng {params.seed};
+		std::uniform_real_distribution<float> ratioDist {0, 1};
+		std::uniform_int_distribution<unsigned> yearDist {1960, 2021};
+		std::uniform_int_distribution<std::size_t> genreDist {0, genres.size() - 1};
+		std::uniform_int_distribution<std::size_t> artistDist {0, params.artistCount - 1};
+
+		artists.reserve(params.artistCount);
+		for (std::size_t i {}; i < params.artistCount; ++i)
+			artists.push_back(ArtistDesc {generateName(rng, 1, 3), generateMBID(rng)});
+
+		releases.reserve(params.artistCount * params.releaseCountPerArtist);
+		for (std::size_t artist {}; artist < params.artistCount; ++artist)
+		{
+			for (std::size_t i {}; i < params.releaseCountPerArtist; ++i)
+			{
+				ReleaseDesc release;
+				release.name = generateName(rng, 1, 4);
+				release.mbid = generateMBID(rng);
+				release.artist = artist;
+				release.year = yearDist(rng);
+				release.discCount = (params.trackCountPerRelease > 10 && ratioDist(rng) < 0.1f) ? 2 : 1;
+				release.genres.push_back(genres[genreDist(rng)]);
+				if (ratioDist(rng) < 0.3f)
+					release.genres.push_back(genres[genreDist(rng)]);
+				release.hasCover = ratioDist(rng) < params.coverRatio;
+
+				const std::size_t trackCountPerDisc {(params.trackCountPerRelease + release.discCount - 1) / release.discCount};
+				for (std::size_t iTrack {}; iTrack < params.trackCountPerRelease; ++iTrack)
+				{
+					TrackDesc track;
+					track.title = generateName(rng, 1, 5);
+					track.mbid = generateMBID(rng);
+					track.discNumber = 1 + iTrack / trackCountPerDisc;
+					track.trackNumber = 1 + iTrack % trackCountPerDisc;
+					if (params.artistCount > 1 && ratioDist(rng) < params.collaborationRatio)
+					{
+						const std::size_t featuredArtist {artistDist(rng)};
+						if (featuredArtist != artist)
+							track.featuredArtists.push_back(featuredArtist);
+					}
+
+					release.tracks.push_back(std::move(track));
+				}
+
+				releases.push_back(std::move(release));
+			}
+		}
+	}
+
+	void
+	writeLittleEndian(std::vector<std::byte>& data, std::uint32_t value, std::size_t byteCount)
+	{
+		for (std::size_t i {}; i < byteCount; ++i)
+			data.push_back(static_cast<std::byte>((value >> (i * 8)) & 0xFF));
+	}
+
+	// Uncompressed 24 bits BMP, decoded by all the supported image libraries
+	// Each release gets its own colors, so that the encoded covers differ
+	std::vector<std::byte>
+	generateBMPImage(std::uint32_t size, std::uint32_t seed)
+	{
+		const std::uint32_t rowSize {(size * 3 + 3) & ~3u};
+		const std::uint32_t headerSize {14 + 40};
+
+		std::vector<std::byte> data;
+		data.reserve(headerSize + rowSize * size);
+
+		// file header
+		data.push_back(std::byte {'B'});
+		data.push_back(std::byte {'M'});
+		writeLittleEndian(data, headerSize + rowSize * size, 4);
+		writeLittleEndian(data, 0, 4);
+		writeLittleEndian(data, headerSize, 4);
+
+		// info header
+		writeLittleEndian(data, 40, 4);
+		writeLittleEndian(data, size, 4);
+		writeLittleEndian(data, size, 4);
+		writeLittleEndian(data, 1, 2);	// planes
+		writeLittleEndian(data, 24, 2);	// bits per pixel
+		writeLittleEndian(data, 0, 4);	// no compression
+		writeLittleEndian(data, rowSize * size, 4);
+		writeLittleEndian(data, 2835, 4);
+		writeLittleEndian(data, 2835, 4);
+		writeLittleEndian(data, 0, 4);
+		writeLittleEndian(data, 0, 4);
+
+		const std::uint32_t baseColor {seed * 2654435761u};
+		const std::uint32_t tileSize {8 + seed % 24};
+		for (std::uint32_t y {}; y < size; ++y)
+		{
+			for (std::uint32_t x {}; x < size; ++x)
+			{
+				const bool tile {(((x / tileSize) ^ (y / tileSize)) & 1) != 0};
+				data.push_back(static_cast<std::byte>(((baseColor & 0xFF) + x * 255 / size) & 0xFF));
+				data.push_back(static_cast<std::byte>((((baseColor >> 8) & 0xFF) + y * 255 / size) & 0xFF));
+				data.push_back(static_cast<std::byte>(tile ? (baseColor >> 16) & 0xFF : 50));
+			}
+			for (std::uint32_t i {size * 3}; i < rowSize; ++i)
+				data.push_back(std::byte {0});
+		}
+
+		return data;
+	}
+
+	TagLib::ByteVector
+	generateCover(unsigned size, std::uint32_t seed)
+	{
+		const std::vector<std::byte> bmpImage {generateBMPImage(size, seed)};
+
+		const RawImage image {bmpImage.data(), bmpImage.size()};
+		const std::unique_ptr<CoverArt::IEncodedImage> encodedImage {image.encodeToJPEG(85)};
+
+		return TagLib::ByteVector {reinterpret_cast<const char*>(encodedImage->getData()), static_cast<unsigned>(encodedImage->getDataSize())};
+	}
+
+	// MPEG-1 Layer III, 32 kbps, 32 kHz, mono: 144 bytes per frame, 1152 samples per frame
+	// A zeroed side info and main data decode as silence
+	void
+	writeSilentMPEGAudio(std::ostream& os, std::size_t duration)
+	{
+		constexpr std::size_t frameSize {144};
+		constexpr std::size_t samplesPerFrame {1152};
+		constexpr std::size_t sampleRate {32000};
+
+		std::vector<char> frame(frameSize, 0);
+		frame[0] = static_cast<char>(0xFF);
+		frame[1] = static_cast<char>(0xFB);	// MPEG-1, layer III, no CRC
+		frame[2] = static_cast<char>(0x18);	// 32 kbps, 32 kHz, no padding
+		frame[3] = static_cast<char>(0xC0);	// mono
+
+		const std::size_t frameCount {(duration * sampleRate + samplesPerFrame - 1) / samplesPerFrame};
+		for (std::size_t i {}; i < frameCount; ++i)
+			os.write(frame.data(), frame.size());
+	}
+
+	std::string
+	makeNameFilesystemCompatible(std::string name)
+	{
+		std::replace_if(std::begin(name), std::end(name), [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+		return name;
+	}
+
+	void
+	writeTrack(const std::filesystem::path& trackPath,
+			const std::vector<ArtistDesc>& artists,
+			const ReleaseDesc& release,
+			const TrackDesc& track,
+			const TagLib::ByteVector& cover,
+			std::size_t duration)
+	{
+		{
+			std::ofstream ofs {trackPath, std::ios_base::binary | std::ios_base::trunc};
+			if (!ofs)
+				throw std::runtime_error {"Cannot create file '" + trackPath.string() + "'"};
+
+			writeSilentMPEGAudio(ofs, duration);
+		}
+
+		const ArtistDesc& releaseArtist {artists[release.artist]};
+
+		std::string artistName {releaseArtist.name};
+		TagLib::StringList artistNames {TagLib::String {releaseArtist.name, TagLib::String::UTF8}};
+		TagLib::StringList artistMBIDs {TagLib::String {releaseArtist.mbid, TagLib::String::UTF8}};
+		for (std::size_t featuredArtist : track.featuredArtists)
+		{
+			artistName += " feat. " + artists[featuredArtist].name;
+			artistNames.append(TagLib::String {artists[featuredArtist].name, TagLib::String::UTF8});
+			artistMBIDs.append(TagLib::String {artists[featuredArtist].mbid, TagLib::String::UTF8});
+		}
+
+		TagLib::StringList genreNames;
+		for (const std::string& genre : release.genres)
+			genreNames.append(TagLib::String {genre, TagLib::String::UTF8});
+
+		TagLib::PropertyMap properties;
+		properties.insert("TITLE", TagLib::StringList {TagLib::String {track.title, TagLib::String::UTF8}});
+		properties.insert("ARTIST", TagLib::StringList {TagLib::String {artistName, TagLib::String::UTF8}});
+		properties.insert("ARTISTS", artistNames);
+		properties.insert("MUSICBRAINZ_ARTISTID", artistMBIDs);
+		properties.insert("ALBUMARTIST", TagLib::StringList {TagLib::String {releaseArtist.name, TagLib::String::UTF8}});
+		properties.insert("MUSICBRAINZ_ALBUMARTISTID", TagLib::StringList {TagLib::String {releaseArtist.mbid, TagLib::String::UTF8}});
+		properties.insert("ALBUM", TagLib::StringList {TagLib::String {release.name, TagLib::String::UTF8}});
+		properties.insert("MUSICBRAINZ_ALBUMID", TagLib::StringList {TagLib::String {release.mbid, TagLib::String::UTF8}});
+		properties.insert("MUSICBRAINZ_TRACKID", TagLib::StringList {TagLib::String {track.mbid, TagLib::String::UTF8}});
+		properties.insert("TRACKNUMBER", TagLib::StringList {TagLib::String {std::to_string(track.trackNumber)}});
+		properties.insert("DISCNUMBER", TagLib::StringList {TagLib::String {std::to_string(track.discNumber) + "/" + std::to_string(release.discCount)}});
+		properties.insert("DATE", TagLib::StringList {TagLib::String {std::to_string(release.year)}});
+		properties.insert("GENRE", genreNames);
+
+		TagLib::MPEG::File file {trackPath.c_str()};
+		if (!file.isValid())
+			throw std::runtime_error {"Cannot open generated file '" + trackPath.string() + "'"};
+
+		TagLib::ID3v2::Tag* tag {file.ID3v2Tag(true)};
+		tag->setProperties(properties);
+
+		if (!cover.isEmpty())
+		{
+			auto* frame {new TagLib::ID3v2::AttachedPictureFrame};
+			frame->setMimeType("image/jpeg");
+			frame->setType(TagLib::ID3v2::AttachedPictureFrame::FrontCover);
+			frame->setPicture(cover);
+			tag->addFrame(frame);	// owned by the tag
+		}
+
+		if (!file.save(TagLib::MPEG::File::ID3v2))
+			throw std::runtime_error {"Cannot write tags in '" + trackPath.string() + "'"};
+	}
+
+	void
+	writeRelease(const GeneratorParameters& params, const std::vector<ArtistDesc>& artists, const ReleaseDesc& release, std::size_t releaseIndex)
+	{
+		const std::filesystem::path releasePath {params.outputPath
+			/ makeNameFilesystemCompatible(artists[release.artist].name)
+			/ makeNameFilesystemCompatible(std::to_string(release.year) + " - " + release.name + " [" + release.mbid.substr(0, 8) + "]")};
+
+		std::filesystem::create_directories(releasePath);
+
+		const TagLib::ByteVector cover {release.hasCover ? generateCover(params.coverSize, params.seed + static_cast<std::uint32_t>(releaseIndex)) : TagLib::ByteVector {}};
+
+		for (const TrackDesc& track : release.tracks)
+		{
+			std::ostringstream fileName;
+			fileName << track.discNumber << "-" << std::setw(2) << std::setfill('0') << track.trackNumber << " - " << track.title << ".mp3";
+
+			writeTrack(releasePath / makeNameFilesystemCompatible(fileName.str()), artists, release, track, cover, params.trackDuration);
+		}
+	}
+
+	void
+	generateLibrary(const GeneratorParameters& params, std::size_t threadCount)
+	{
+		std::vector<ArtistDesc> artists;
+		std::vector<ReleaseDesc> releases;
+		generateLibraryDesc(params, artists, releases);
+
+		std::cout << "Generating " << artists.size() << " artists, " << releases.size() << " releases, " << releases.size() * params.trackCountPerRelease << " tracks in '" << params.outputPath.string() << "' using " << threadCount << " threads..." << std::endl;
+
+		std::atomic<std::size_t> nextRelease {};
+		std::atomic<std::size_t> errorCount {};
+
+		std::vector<std::thread> threads;
+		for (std::size_t i {}; i < threadCount; ++i)
+		{
+			threads.emplace_back([&]
+			{
+				for (std::size_t releaseIndex {nextRelease++}; releaseIndex < releases.size(); releaseIndex = nextRelease++)
+				{
+					try
+					{
+						writeRelease(params, artists, releases[releaseIndex], releaseIndex);
+					}
+					catch (const std::exception& e)
+					{
+						std::cerr << "Cannot generate release '" << releases[releaseIndex].name << "': " << e.what() << std::endl;
+						errorCount++;
+					}
+
+					if ((releaseIndex + 1) % 100 == 0)
+						std::cout << "Generated " << releaseIndex + 1 << "/" << releases.size() << " releases" << std::endl;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		if (errorCount > 0)
+			throw std::runtime_error {std::to_string(errorCount) + " releases could not be generated"};
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		namespace po = boost::program_options;
+
+		po::options_description desc{"Allowed options"};
+		desc.add_options()
+		("help,h", "print usage message")
+		("output,o", po::value<std::string>()->required(), "output directory")
+		("artists,a", po::value<std::size_t>()->default_value(500), "number of artists")
+		("releases,r", po::value<std::size_t>()->default_value(4), "number of releases per artist")
+		("tracks,t", po::value<std::size_t>()->default_value(12), "number of tracks per release")
+		("duration,d", po::value<std::size_t>()->default_value(2), "duration of each track, in seconds")
+		("collaborations", po::value<float>()->default_value(0.15f), "ratio of tracks featuring another artist")
+		("covers", po::value<float>()->default_value(0.8f), "ratio of releases having an embedded cover")
+		("cover-size", po::value<unsigned>()->default_value(500), "size of the embedded covers, in pixels")
+		("seed", po::value<std::uint32_t>()->default_value(42), "random seed")
+		("threads,j", po::value<std::size_t>()->default_value(std::max<std::size_t>(std::thread::hardware_concurrency(), 1)), "number of threads")
+		;
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+
+		if (vm.count("help"))
+		{
+			std::cout << desc << std::endl;
+			return EXIT_SUCCESS;
+		}
+		po::notify(vm);
+
+#if LMS_SUPPORT_IMAGE_GM
+		CoverArt::GraphicsMagick::init(argv[0]);
+#endif
+
+		GeneratorParameters params;
+		params.outputPath = vm["output"].as<std::string>();
+		params.artistCount = vm["artists"].as<std::size_t>();
+		params.releaseCountPerArtist = vm["releases"].as<std::size_t>();
+		params.trackCountPerRelease = vm["tracks"].as<std::size_t>();
+		params.trackDuration = std::max<std::size_t>(vm["duration"].as<std::size_t>(), 1);
+		params.collaborationRatio = vm["collaborations"].as<float>();
+		params.coverRatio = vm["covers"].as<float>();
+		params.coverSize = vm["cover-size"].as<unsigned>();
+		params.seed = vm["seed"].as<std::uint32_t>();
+
+		if (params.artistCount == 0 || params.releaseCountPerArtist == 0 || params.trackCountPerRelease == 0)
+			throw std::runtime_error {"artist, release and track counts must be positive"};
+
+		generateLibrary(params, std::max<std::size_t>(vm["threads"].as<std::size_t>(), 1));
+		std::cout << "Done!" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
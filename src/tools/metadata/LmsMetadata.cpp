@@ -143,7 +143,16 @@ void parse(MetaData::IParser& parser, const std::filesystem::path& file)
 	std::cout << "HasCover = " << std::boolalpha << track->hasCover << std::endl;
 
 	for (const auto& audioStream : track->audioStreams)
-		std::cout << "Audio stream: " << audioStream.bitRate << " bps" << std::endl;
+	{
+		std::cout << "Audio stream: " << audioStream.bitRate << " bps";
+		if (audioStream.sampleRate)
+			std::cout << ", " << audioStream.sampleRate << " Hz";
+		if (audioStream.channelCount)
+			std::cout << ", " << audioStream.channelCount << " channel(s)";
+		if (!audioStream.codec.empty())
+			std::cout << ", codec = " << audioStream.codec;
+		std::cout << std::endl;
+	}
 
 	if (track->trackReplayGain)
 		std::cout << "Track replay gain: " << *track->trackReplayGain << std::endl;
@@ -17,7 +17,16 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iostream>
 #include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
 
 #include "utils/Random.hpp"
 
@@ -91,7 +100,6 @@ GeneticAlgorithm<Individual>::simulate(const std::vector<Individual>& initialPop
 	{
 		assert(scoredPopulation.size() == initialPopulation.size());
 		std::cout << "Processing generation " << currentGeneration << "..." << std::endl;
-		std::cout << "Need to create " << childrenCountPerGeneration << " new children" << std::endl;
 
 		// breed
 		const Score populationTotalScore {getTotalScore(scoredPopulation)};
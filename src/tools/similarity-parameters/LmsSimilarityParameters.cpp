@@ -17,366 +17,422 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
+// Searches the feature set that gives the best track similarity results, using a genetic algorithm
+// The feature values of all the tracks are loaded once into a shared read-only matrix, then each
+// candidate feature set is evaluated (train + score) on all the cores, without any database access.
+// Each evaluation seeds its random generator from the feature set, so that results are reproducible.
+
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdlib.h>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/program_options.hpp>
 
-#include "database/Artist.hpp"
-#include "database/Cluster.hpp"
 #include "database/Db.hpp"
 #include "database/Release.hpp"
-#include "database/SessionPool.hpp"
+#include "database/Session.hpp"
 #include "database/Track.hpp"
 #include "database/TrackFeatures.hpp"
-#include "similarity/features/SimilarityFeaturesSearcher.hpp"
-#include "utils/Config.hpp"
+#include "features/FeaturesClassifier.hpp"
+#include "features/FeaturesDefs.hpp"
+#include "som/Matrix.hpp"
+#include "som/Network.hpp"
+#include "utils/IConfig.hpp"
+#include "utils/Random.hpp"
 #include "utils/Service.hpp"
-#include "utils/StreamLogger.hpp"
 
 #include "GeneticAlgorithm.hpp"
 
-using namespace Similarity;
+using namespace Recommendation;
 using SimilarityScore = GeneticAlgorithm<FeatureSettingsMap>::Score;
 
-// An individual is just a FeatureSettingsMap
-// The goal is to get the FeatureSettingsMap that maximize the score
-const FeatureSettingsMap featuresSettings
+namespace
 {
-	{ "lowlevel.average_loudness",			{1}},
-	{ "lowlevel.barkbands.mean",			{1}},
-	{ "lowlevel.barkbands.median",			{1}},
-	{ "lowlevel.barkbands.var",			{1}},
-	{ "lowlevel.barkbands_crest.mean",		{1}},
-	{ "lowlevel.barkbands_crest.median",		{1}},
-	{ "lowlevel.barkbands_crest.var",		{1}},
-	{ "lowlevel.barkbands_flatness_db.mean",	{1}},
-	{ "lowlevel.barkbands_flatness_db.median",	{1}},
-	{ "lowlevel.barkbands_flatness_db.var",		{1}},
-	{ "lowlevel.barkbands_kurtosis.mean",		{1}},
-	{ "lowlevel.barkbands_kurtosis.median",		{1}},
-	{ "lowlevel.barkbands_kurtosis.var",		{1}},
-	{ "lowlevel.barkbands_skewness.mean",		{1}},
-	{ "lowlevel.barkbands_skewness.median",		{1}},
-	{ "lowlevel.barkbands_skewness.var",		{1}},
-	{ "lowlevel.barkbands_spread.mean",		{1}},
-	{ "lowlevel.barkbands_spread.median",		{1}},
-	{ "lowlevel.barkbands_spread.var",		{1}},
-	{ "lowlevel.dissonance.mean",			{1}},
-	{ "lowlevel.dissonance.median",			{1}},
-	{ "lowlevel.dissonance.var",			{1}},
-	{ "lowlevel.dynamic_complexity",		{1}},
-	{ "lowlevel.spectral_contrast_coeffs.mean",	{1}},
-	{ "lowlevel.spectral_contrast_coeffs.median",	{1}},
-	{ "lowlevel.spectral_contrast_coeffs.var",	{1}},
-	{ "lowlevel.erbbands.mean",			{1}},
-	{ "lowlevel.erbbands.median",			{1}},
-	{ "lowlevel.erbbands.var",			{1}},
-	{ "lowlevel.gfcc.mean",				{1}},
-	{ "lowlevel.hfc.mean",				{1}},
-	{ "lowlevel.hfc.median",			{1}},
-	{ "lowlevel.hfc.var",				{1}},
-	{ "tonal.hpcp.median",				{1}},
-	{ "lowlevel.melbands.mean",			{1}},
-	{ "lowlevel.melbands.median",			{1}},
-	{ "lowlevel.melbands.var",			{1}},
-	{ "lowlevel.melbands_crest.mean",		{1}},
-	{ "lowlevel.melbands_crest.median",		{1}},
-	{ "lowlevel.melbands_crest.var",		{1}},
-	{ "lowlevel.melbands_flatness_db.mean",		{1}},
-	{ "lowlevel.melbands_flatness_db.median",	{1}},
-	{ "lowlevel.melbands_flatness_db.var",		{1}},
-	{ "lowlevel.melbands_kurtosis.mean",		{1}},
-	{ "lowlevel.melbands_kurtosis.median",		{1}},
-	{ "lowlevel.melbands_kurtosis.var",		{1}},
-	{ "lowlevel.melbands_skewness.mean",		{1}},
-	{ "lowlevel.melbands_skewness.median",		{1}},
-	{ "lowlevel.melbands_skewness.var",		{1}},
-	{ "lowlevel.melbands_spread.mean",		{1}},
-	{ "lowlevel.melbands_spread.median",		{1}},
-	{ "lowlevel.melbands_spread.var",		{1}},
-	{ "lowlevel.mfcc.mean",				{1}},
-	{ "lowlevel.pitch_salience.mean",		{1}},
-	{ "lowlevel.pitch_salience.median",		{1}},
-	{ "lowlevel.pitch_salience.var",		{1}},
-	{ "lowlevel.silence_rate_30dB.mean",		{1}},
-	{ "lowlevel.silence_rate_30dB.median",		{1}},
-	{ "lowlevel.silence_rate_30dB.var",		{1}},
-	{ "lowlevel.silence_rate_60dB.mean",		{1}},
-	{ "lowlevel.silence_rate_60dB.median",		{1}},
-	{ "lowlevel.silence_rate_60dB.var",		{1}},
-	{ "lowlevel.spectral_centroid.mean",		{1}},
-	{ "lowlevel.spectral_centroid.median",		{1}},
-	{ "lowlevel.spectral_centroid.var",		{1}},
-	{ "lowlevel.spectral_complexity.mean",		{1}},
-	{ "lowlevel.spectral_complexity.median",	{1}},
-	{ "lowlevel.spectral_complexity.var",		{1}},
-	{ "lowlevel.spectral_contrast_coeffs.mean",	{1}},
-	{ "lowlevel.spectral_contrast_coeffs.median",	{1}},
-	{ "lowlevel.spectral_contrast_coeffs.var",	{1}},
-	{ "lowlevel.spectral_contrast_valleys.mean",	{1}},
-	{ "lowlevel.spectral_contrast_valleys.median",	{1}},
-	{ "lowlevel.spectral_contrast_valleys.var",	{1}},
-	{ "lowlevel.spectral_decrease.mean",		{1}},
-	{ "lowlevel.spectral_decrease.median",		{1}},
-	{ "lowlevel.spectral_decrease.var",		{1}},
-	{ "lowlevel.spectral_energy.mean",		{1}},
-	{ "lowlevel.spectral_energy.median",		{1}},
-	{ "lowlevel.spectral_energy.var",		{1}},
-	{ "lowlevel.spectral_energyband_high.mean",	{1}},
-	{ "lowlevel.spectral_energyband_high.median",	{1}},
-	{ "lowlevel.spectral_energyband_high.var",	{1}},
-	{ "lowlevel.spectral_energyband_low.mean",	{1}},
-	{ "lowlevel.spectral_energyband_low.median",	{1}},
-	{ "lowlevel.spectral_energyband_low.var",	{1}},
-	{ "lowlevel.spectral_energyband_middle_high.mean",	{1}},
-	{ "lowlevel.spectral_energyband_middle_high.median",	{1}},
-	{ "lowlevel.spectral_energyband_middle_high.var",	{1}},
-	{ "lowlevel.spectral_energyband_middle_low.mean",	{1}},
-	{ "lowlevel.spectral_energyband_middle_low.median",	{1}},
-	{ "lowlevel.spectral_energyband_middle_low.var",	{1}},
-	{ "lowlevel.spectral_entropy.mean",		{1}},
-	{ "lowlevel.spectral_entropy.median",		{1}},
-	{ "lowlevel.spectral_entropy.var",		{1}},
-	{ "lowlevel.spectral_flux.mean",		{1}},
-	{ "lowlevel.spectral_flux.median",		{1}},
-	{ "lowlevel.spectral_flux.var",			{1}},
-	{ "lowlevel.spectral_kurtosis.mean",		{1}},
-	{ "lowlevel.spectral_kurtosis.median",		{1}},
-	{ "lowlevel.spectral_kurtosis.var",		{1}},
-	{ "lowlevel.spectral_rms.mean",			{1}},
-	{ "lowlevel.spectral_rms.median",		{1}},
-	{ "lowlevel.spectral_rms.var",			{1}},
-	{ "lowlevel.spectral_rolloff.mean",		{1}},
-	{ "lowlevel.spectral_rolloff.median",		{1}},
-	{ "lowlevel.spectral_rolloff.var",		{1}},
-	{ "lowlevel.spectral_skewness.mean",		{1}},
-	{ "lowlevel.spectral_skewness.median",		{1}},
-	{ "lowlevel.spectral_skewness.var",		{1}},
-	{ "lowlevel.spectral_spread.mean",		{1}},
-	{ "lowlevel.spectral_spread.median",		{1}},
-	{ "lowlevel.spectral_spread.var",		{1}},
-	{ "lowlevel.zerocrossingrate.mean",		{1}},
-	{ "lowlevel.zerocrossingrate.median",		{1}},
-	{ "lowlevel.zerocrossingrate.var",		{1}},
-};
-
-static
-std::unordered_map<Database::IdType, FeatureValuesMap>
-constructFeaturesCache(Database::Session& session, const FeatureSettingsMap& featureSettings)
-{
-	std::unordered_map<Database::IdType, FeatureValuesMap> cache;
+	// What we know about a track, to tell if two tracks are similar
+	struct TrackInfo
+	{
+		Database::IdType		releaseId {};
+		std::vector<Database::IdType>	artistIds;	// sorted
+		std::vector<Database::IdType>	clusterIds;	// sorted
+	};
+
+	// Feature values of all the tracks, one row per track
+	// Only the features available for all the tracks can be used
+	class FeaturesMatrix
+	{
+		public:
+			FeaturesMatrix(const std::vector<FeatureName>& featureNames)
+			{
+				for (const FeatureName& featureName : featureNames)
+				{
+					_featureOffsets.emplace(featureName, _rowSize);
+					_rowSize += getFeatureDef(featureName).nbDimensions;
+				}
+			}
 
-	std::unordered_set<FeatureName> names;
-	std::transform(std::cbegin(featureSettings), std::cend(featureSettings), std::inserter(names, std::begin(names)),
-			[](const auto& itFeature) { return itFeature.first; });
+			void addTrack(const FeatureValuesMap& featureValuesMap, TrackInfo trackInfo)
+			{
+				std::vector<FeatureValue> row(_rowSize);
+				for (const auto& [featureName, offset] : _featureOffsets)
+				{
+					auto itValues {featureValuesMap.find(featureName)};
+					if (itValues == std::cend(featureValuesMap) || itValues->second.size() != getFeatureDef(featureName).nbDimensions)
+					{
+						_incompleteFeatures.insert(featureName);
+						continue;
+					}
+
+					std::copy(std::cbegin(itValues->second), std::cend(itValues->second), std::next(std::begin(row), offset));
+				}
+
+				_values.insert(std::end(_values), std::cbegin(row), std::cend(row));
+				_tracks.emplace_back(std::move(trackInfo));
+			}
 
-	auto transaction {session.createSharedTransaction()};
+			std::vector<FeatureName> getCompleteFeatureNames() const
+			{
+				std::vector<FeatureName> res;
+				for (const auto& [featureName, offset] : _featureOffsets)
+				{
+					if (_incompleteFeatures.find(featureName) == std::cend(_incompleteFeatures))
+						res.push_back(featureName);
+				}
 
-	for (auto trackId : Database::Track::getAllIdsWithFeatures(session))
-	{
-		const Database::Track::pointer track {Database::Track::getById(session, trackId)};
-		const Database::TrackFeatures::pointer trackFeatures {track->getTrackFeatures()};
+				std::sort(std::begin(res), std::end(res));
+				return res;
+			}
 
-		cache[trackId] = trackFeatures->getFeatureValuesMap(names);
-	}
+			std::size_t getTrackCount() const { return _tracks.size(); }
+			const TrackInfo& getTrackInfo(std::size_t trackIndex) const { return _tracks[trackIndex]; }
 
-	return cache;
-}
+			SOM::InputVector getInputVector(std::size_t trackIndex, const FeatureSettingsMap& featureSettingsMap) const
+			{
+				SOM::InputVector res {FeaturesClassifier::getInputDimCount(featureSettingsMap)};
 
-static
-std::optional<FeatureValuesMap>
-getFeaturesFromCache(const std::unordered_map<Database::IdType, FeatureValuesMap>& cache, Database::IdType trackId, const FeatureNames& names)
-{
-	std::optional<FeatureValuesMap> res;
+				std::size_t i {};
+				for (const auto& [featureName, featureSettings] : featureSettingsMap)
+				{
+					const std::size_t offset {trackIndex * _rowSize + _featureOffsets.at(featureName)};
+					const std::size_t nbDimensions {getFeatureDef(featureName).nbDimensions};
 
-	auto it {cache.find(trackId)};
-	if (it == std::cend(cache))
-		return res;
+					for (std::size_t dimension {}; dimension < nbDimensions; ++dimension)
+						res[i++] = _values[offset + dimension];
+				}
+
+				return res;
+			}
 
-	res = FeatureValuesMap{};
+		private:
+			std::map<FeatureName, std::size_t>	_featureOffsets;
+			std::size_t				_rowSize {};
+			std::vector<FeatureValue>		_values;
+			std::vector<TrackInfo>			_tracks;
+			std::unordered_set<FeatureName>		_incompleteFeatures;
+	};
 
-	const FeatureValuesMap& trackFeatures {it->second};
-	for (const FeatureName& name : names)
+	FeaturesMatrix
+	loadFeaturesMatrix(Database::Session& session, std::optional<std::size_t> maxTrackCount)
 	{
-		auto itFeatures {trackFeatures.find(name)};
-		if (itFeatures == std::cend(trackFeatures))
+		const FeatureNames allFeatureNames {getFeatureNames()};
+		std::vector<FeatureName> featureNames {std::cbegin(allFeatureNames), std::cend(allFeatureNames)};
+		std::sort(std::begin(featureNames), std::end(featureNames));
+
+		FeaturesMatrix matrix {featureNames};
+
+		auto transaction {session.createSharedTransaction()};
+
+		std::size_t incompleteTrackCount {};
+		const std::vector<Database::IdType> trackIds {Database::Track::getAllIdsWithFeatures(session, maxTrackCount)};
+		for (const Database::IdType trackId : trackIds)
 		{
-			res.reset();
-			break;
-		}
+			const Database::Track::pointer track {Database::Track::getById(session, trackId)};
+			if (!track)
+				continue;
+
+			TrackInfo trackInfo;
+			trackInfo.releaseId = track->getRelease() ? track->getRelease().id() : Database::IdType {};
+			trackInfo.artistIds = track->getArtistIds({});
+			trackInfo.clusterIds = track->getClusterIds();
+			std::sort(std::begin(trackInfo.artistIds), std::end(trackInfo.artistIds));
+			trackInfo.artistIds.erase(std::unique(std::begin(trackInfo.artistIds), std::end(trackInfo.artistIds)), std::end(trackInfo.artistIds));
+			std::sort(std::begin(trackInfo.clusterIds), std::end(trackInfo.clusterIds));
+
+			const Database::TrackFeatures::pointer trackFeatures {track->getTrackFeatures()};
+
+			// The whole map is empty as soon as one feature is missing: fall back on probing each feature
+			FeatureValuesMap featureValuesMap {trackFeatures->getFeatureValuesMap(allFeatureNames)};
+			if (featureValuesMap.empty())
+			{
+				incompleteTrackCount++;
+				for (const FeatureName& featureName : allFeatureNames)
+					featureValuesMap.merge(trackFeatures->getFeatureValuesMap({featureName}));
+			}
 
-		res->emplace(name, itFeatures ->second);
-	}
+			matrix.addTrack(featureValuesMap, std::move(trackInfo));
+		}
 
-	return res;
-}
+		if (incompleteTrackCount > 0)
+			std::cout << incompleteTrackCount << " track(s) with missing features" << std::endl;
 
-static
-void
-printFeatureSettingsMap(const FeatureSettingsMap& featureSettings)
-{
-	std::cout << "FeatureSettingsMap: (" << featureSettings.size() << " features)" << std::endl;
-	for (const auto& [name, settings] : featureSettings)
-		std::cout << "\t" << name << std::endl;
-}
+		return matrix;
+	}
 
-static
-std::string
-trackToString(Database::Session& session, Database::IdType trackId)
-{
-	std::string res;
-	auto transaction {session.createSharedTransaction()};
-	Database::Track::pointer track {Database::Track::getById(session, trackId)};
-
-	res += track->getName();
-	if (track->getRelease())
-		res += " [" + track->getRelease()->getName() + "]";
-	for (auto artist : track->getArtists())
-		res += " - " + artist->getName();
-	for (auto cluster : track->getClusters())
-		res += " {" + cluster->getType()->getName() + "-"+ cluster->getName() + "}";
-
-	return res;
-}
+	SimilarityScore
+	computeTrackScore(const TrackInfo& track1, const TrackInfo& track2)
+	{
+		SimilarityScore score {};
 
-static
-SimilarityScore
-computeTrackScore(Database::Session& session, Database::IdType track1Id, Database::IdType track2Id)
-{
-	SimilarityScore score {};
+		if (track1.releaseId && track1.releaseId == track2.releaseId)
+			score += 1;
 
-	auto transaction {session.createSharedTransaction()};
+		auto countCommonIds {[](const std::vector<Database::IdType>& ids1, const std::vector<Database::IdType>& ids2)
+		{
+			std::vector<Database::IdType> commonIds;
+			std::set_intersection(std::cbegin(ids1), std::cend(ids1), std::cbegin(ids2), std::cend(ids2), std::back_inserter(commonIds));
+			return commonIds.size();
+		}};
 
-	auto track1 {Database::Track::getById(session, track1Id)};
-	auto track2 {Database::Track::getById(session, track2Id)};
+		score += countCommonIds(track1.artistIds, track2.artistIds);
+		score += countCommonIds(track1.clusterIds, track2.clusterIds);
 
-	if (track1->getRelease() == track2->getRelease())
-		score += 1;
+		return score;
+	}
 
-	// Artists in common
+	std::string
+	featureSettingsMapToString(const FeatureSettingsMap& featureSettings)
 	{
-		auto track1ArtistIds {track1->getArtistIds()};
-		auto track2ArtistIds {track2->getArtistIds()};
+		std::map<FeatureName, FeatureSettings> sortedFeatureSettings {std::cbegin(featureSettings), std::cend(featureSettings)};
 
-		std::vector<Database::IdType> commonArtistIds;
-		std::set_intersection(std::cbegin(track1ArtistIds), std::cend(track1ArtistIds),
-				std::cbegin(track2ArtistIds), std::cend(track2ArtistIds),
-				std::back_inserter(commonArtistIds));
+		std::string res;
+		for (const auto& [name, settings] : sortedFeatureSettings)
+		{
+			if (!res.empty())
+				res += ",";
+			res += name;
+			if (settings.weight != 1)
+				res += "*" + std::to_string(settings.weight);
+		}
 
-		score += commonArtistIds.size();
+		return res;
 	}
 
-	// Clusters in common
+	struct Evaluation
 	{
-		auto track1ClusterIds {track1->getClusterIds()};
-		auto track2ClusterIds {track2->getClusterIds()};
+		SimilarityScore			score {};	// mean score per track
+		SOM::Coordinate			networkSize {};
+		std::chrono::duration<double>	trainingDuration {};
+	};
+
+	// Same strategy as the features classifier: look in the track cell first, then in the closest cells
+	Evaluation
+	evaluate(const FeaturesMatrix& matrix, FeaturesClassifier::TrainSettings trainSettings, std::uint32_t seed)
+	{
+		constexpr std::size_t nbSimilarTracks {3};
 
-		std::vector<Database::IdType> commonClusterIds;
-		std::set_intersection(std::cbegin(track1ClusterIds), std::cend(track1ClusterIds),
-				std::cbegin(track2ClusterIds), std::cend(track2ClusterIds),
-				std::back_inserter(commonClusterIds));
+		// Dimensions follow the iteration order of the feature settings: make it only depend on the features
+		{
+			const std::map<FeatureName, FeatureSettings> sortedFeatureSettings {std::cbegin(trainSettings.featureSettingsMap), std::cend(trainSettings.featureSettingsMap)};
+			trainSettings.featureSettingsMap = FeatureSettingsMap {std::cbegin(sortedFeatureSettings), std::cend(sortedFeatureSettings)};
+		}
 
-		score += commonClusterIds.size();
-	}
+		// The network uses the thread random generator. Restore it afterwards, since this may be the breeding thread
+		Random::RandGenerator& randGenerator {Random::getRandGenerator()};
+		const Random::RandGenerator savedRandGenerator {randGenerator};
+		randGenerator.seed(seed);
 
-	return score;
-}
+		std::vector<SOM::InputVector> samples;
+		samples.reserve(matrix.getTrackCount());
+		for (std::size_t i {}; i < matrix.getTrackCount(); ++i)
+			samples.push_back(matrix.getInputVector(i, trainSettings.featureSettingsMap));
 
-static
-SimilarityScore
-computeSimilarityScore(Database::Session& session, FeaturesSearcher::TrainSettings trainSettings)
-{
-	std::cout << "Compute score of: ";
-	printFeatureSettingsMap(trainSettings.featureSettingsMap);
-	std::cout << std::endl;
+		Evaluation res;
 
-	FeaturesSearcher searcher {session, trainSettings};
+		const auto trainingStart {std::chrono::steady_clock::now()};
+		const SOM::Network network {FeaturesClassifier::trainNetwork(samples, trainSettings)};
+		res.trainingDuration = std::chrono::steady_clock::now() - trainingStart;
+		res.networkSize = network.getWidth();
 
-	const std::vector<Database::IdType> trackIds = std::invoke([&]()
-			{
-				auto transaction {session.createSharedTransaction()};
-				return Database::Track::getAllIdsWithFeatures(session);
-			});
+		SOM::Matrix<std::vector<std::size_t>> tracksMap {network.getWidth(), network.getHeight()};
+		std::vector<SOM::Position> trackPositions;
+		trackPositions.reserve(samples.size());
+		for (std::size_t i {}; i < samples.size(); ++i)
+		{
+			const SOM::Position position {network.getClosestRefVectorPosition(samples[i])};
+			trackPositions.push_back(position);
+			tracksMap[position].push_back(i);
+		}
 
-	SimilarityScore score {};
-	for (Database::IdType trackId : trackIds)
-	{
-		constexpr std::size_t nbSimilarTracks {3};
-//		std::cout << "Processing track '" << trackToString(session, trackId) << "'" << std::endl;
-		SimilarityScore factor {1};		
-		for (Database::IdType similarTrackId : searcher.getSimilarTracks({trackId}, nbSimilarTracks))
+		const SOM::InputVector::Distance maxDistance {network.computeRefVectorsDistanceMedian() * 0.75};
+
+		SimilarityScore totalScore {};
+		for (std::size_t trackIndex {}; trackIndex < samples.size(); ++trackIndex)
 		{
-			SimilarityScore trackScore {computeTrackScore(session, trackId, similarTrackId)};
-//			std::cout << "\tScore = " << trackScore << " (*" << factor << ") with track '" << trackToString(session, similarTrackId) << "'" << std::endl;
-			trackScore *= factor;
-			score += trackScore;
+			std::vector<std::size_t> similarTracks;
+			std::unordered_set<SOM::Position> searchedPositions {trackPositions[trackIndex]};
+			std::vector<SOM::Position> orderedSearchedPositions {trackPositions[trackIndex]};
+
+			for (std::size_t processedPositionCount {}; ;)
+			{
+				for (; processedPositionCount < orderedSearchedPositions.size() && similarTracks.size() < nbSimilarTracks; ++processedPositionCount)
+				{
+					for (const std::size_t similarTrackIndex : tracksMap.get(orderedSearchedPositions[processedPositionCount]))
+					{
+						if (similarTrackIndex == trackIndex)
+							continue;
+
+						similarTracks.push_back(similarTrackIndex);
+						if (similarTracks.size() == nbSimilarTracks)
+							break;
+					}
+				}
+
+				if (similarTracks.size() == nbSimilarTracks)
+					break;
+
+				const std::optional<SOM::Position> closestPosition {network.getClosestRefVectorPosition(searchedPositions, maxDistance)};
+				if (!closestPosition)
+					break;
+
+				searchedPositions.insert(*closestPosition);
+				orderedSearchedPositions.push_back(*closestPosition);
+			}
 
-			factor -= (SimilarityScore {1}/nbSimilarTracks );
+			// the first similar tracks matter more
+			SimilarityScore factor {1};
+			for (const std::size_t similarTrackIndex : similarTracks)
+			{
+				totalScore += factor * computeTrackScore(matrix.getTrackInfo(trackIndex), matrix.getTrackInfo(similarTrackIndex));
+				factor -= SimilarityScore {1} / nbSimilarTracks;
+			}
 		}
+
+		randGenerator = savedRandGenerator;
+
+		res.score = totalScore / samples.size();
+		return res;
 	}
 
-	std::cout << "Total score = " << score << std::endl;
+	// The same feature sets are often bred again: do not train them twice
+	class EvaluationCache
+	{
+		public:
+			EvaluationCache(const FeaturesMatrix& matrix, std::uint32_t seed)
+				: _matrix {matrix}
+				, _seed {seed}
+			{}
 
-	return score;
-}
+			Evaluation get(const FeaturesClassifier::TrainSettings& trainSettings)
+			{
+				{
+					std::scoped_lock lock {_mutex};
 
-static
-void
-printBadlyClassifiedTracks(Database::Session& session, FeaturesSearcher::TrainSettings trainSettings)
-{
-	
-	FeaturesSearcher searcher {session, trainSettings};
+					auto it {_cache.find(getKey(trainSettings))};
+					if (it != std::cend(_cache))
+						return it->second;
+				}
+
+				// Concurrent evaluations of the same settings give the same result: no need to serialize them
+				return evaluate(trainSettings);
+			}
 
-	const std::vector<Database::IdType> trackIds = std::invoke([&]()
+			// Always evaluates, to get a fresh training duration
+			Evaluation evaluate(const FeaturesClassifier::TrainSettings& trainSettings)
 			{
-				auto transaction {session.createSharedTransaction()};
-				return Database::Track::getAllIdsWithFeatures(session);
-			});
+				const std::string key {getKey(trainSettings)};
+				const Evaluation evaluation {::evaluate(_matrix, trainSettings, _seed ^ static_cast<std::uint32_t>(std::hash<std::string> {}(key)))};
 
-	for (Database::IdType trackId : trackIds)
-	{
-		constexpr std::size_t nbSimilarTracks {3};
-		for (Database::IdType similarTrackId : searcher.getSimilarTracks({trackId}, nbSimilarTracks))
-		{
-			SimilarityScore trackScore {computeTrackScore(session, trackId, similarTrackId)};
-			if (trackScore == 0)
-				std::cout << "Badly classified tracks: '" << trackToString(session, trackId) << "'\n\twith track '" << trackToString(session, similarTrackId) << "'" <<std::endl;
-		}
-	}
-}
+				std::scoped_lock lock {_mutex};
+				_cache.insert_or_assign(key, evaluation);
 
+				return evaluation;
+			}
 
-static
-FeatureSettingsMap 
-breedFeatureSettingsMap(const FeatureSettingsMap& a, const FeatureSettingsMap& b)
-{
-	FeatureSettingsMap res;
+		private:
+			static std::string getKey(const FeaturesClassifier::TrainSettings& trainSettings)
+			{
+				return featureSettingsMapToString(trainSettings.featureSettingsMap)
+					+ "/" + std::to_string(trainSettings.iterationCount)
+					+ "/" + std::to_string(trainSettings.sampleCountPerNeuron);
+			}
 
-	res.insert(std::cbegin(a), std::cend(a));
-	res.insert(std::cbegin(b), std::cend(b));
+			const FeaturesMatrix&	_matrix;
+			const std::uint32_t	_seed;
+			std::mutex		_mutex;
+			std::unordered_map<std::string, Evaluation> _cache;
+	};
 
-	// just kill random elements until size is good
-	while (res.size() > a.size())
+	FeatureSettingsMap
+	breedFeatureSettingsMap(const FeatureSettingsMap& a, const FeatureSettingsMap& b)
 	{
-		const auto itFeature {Random::pickRandom(res)};
-		res.erase(itFeature);
+		FeatureSettingsMap res;
+
+		res.insert(std::cbegin(a), std::cend(a));
+		res.insert(std::cbegin(b), std::cend(b));
+
+		// just kill random elements until size is good
+		while (res.size() > a.size())
+		{
+			const auto itFeature {Random::pickRandom(res)};
+			res.erase(itFeature);
+		}
+
+		return res;
 	}
 
-	return res;
-}
+	void
+	mutateFeatureSettingsMap(FeatureSettingsMap& a, const std::vector<FeatureName>& featureNames)
+	{
+		const std::size_t size {a.size()};
+		// Replace one of the feature with another one, random
+		a.erase(Random::pickRandom(a));
 
-static
-void
-mutateFeatureSettingsMap(FeatureSettingsMap& a)
-{
-	const std::size_t size {a.size()};
-	// Replace one of the feature with another one, random
-	a.erase(Random::pickRandom(a));
+		while (a.size() != size)
+			a.emplace(*Random::pickRandom(featureNames), FeatureSettings {1});
+	}
 
-	while (a.size() != size)
+	// Quality vs training time, for several network sizes and iteration counts
+	// Evaluations are run one at a time, so that training durations are comparable
+	void
+	writeReport(std::ostream& os, EvaluationCache& evaluationCache, const std::vector<std::pair<std::string, FeatureSettingsMap>>& featureSets)
 	{
-		const auto itFeatureSetting {Random::pickRandom(featuresSettings)};
-		a.emplace(itFeatureSetting->first, itFeatureSetting->second);
+		const std::vector<float> sampleCountPerNeuronValues {1, 2, 4, 8};
+		const std::vector<std::size_t> iterationCountValues {5, 10, 20};
+
+		os << "feature_set,features,sample_count_per_neuron,network_size,iteration_count,score,training_duration_ms" << std::endl;
+		for (const auto& [featureSetName, featureSettingsMap] : featureSets)
+		{
+			for (const float sampleCountPerNeuron : sampleCountPerNeuronValues)
+			{
+				for (const std::size_t iterationCount : iterationCountValues)
+				{
+					FeaturesClassifier::TrainSettings trainSettings;
+					trainSettings.featureSettingsMap = featureSettingsMap;
+					trainSettings.sampleCountPerNeuron = sampleCountPerNeuron;
+					trainSettings.iterationCount = iterationCount;
+
+					const Evaluation evaluation {evaluationCache.evaluate(trainSettings)};
+
+					os << featureSetName
+						<< ",\"" << featureSettingsMapToString(featureSettingsMap) << "\""
+						<< "," << sampleCountPerNeuron
+						<< "," << evaluation.networkSize
+						<< "," << iterationCount
+						<< "," << std::fixed << std::setprecision(4) << evaluation.score
+						<< "," << std::setprecision(1) << std::chrono::duration<double, std::milli> {evaluation.trainingDuration}.count()
+						<< std::defaultfloat << std::endl;
+				}
+			}
+		}
 	}
 }
 
@@ -384,106 +440,134 @@ int main(int argc, char *argv[])
 {
 	try
 	{
-
-		// log to stdout
-//		ServiceProvider<Logger>::create<StreamLogger>(std::cout);
-
-		if (argc != 3)
+		namespace po = boost::program_options;
+
+		po::options_description desc{"Allowed options"};
+		desc.add_options()
+		("help,h", "print usage message")
+		("conf,c", po::value<std::string>()->default_value("/etc/lms.conf"), "LMS config file")
+		("workers,j", po::value<std::size_t>()->default_value(std::max<std::size_t>(std::thread::hardware_concurrency(), 1)), "number of workers")
+		("seed", po::value<std::uint32_t>()->default_value(42), "random seed")
+		("max-tracks", po::value<std::size_t>(), "max number of tracks to use")
+		("population", po::value<std::size_t>()->default_value(100), "population size")
+		("generations", po::value<std::size_t>()->default_value(5), "number of generations")
+		("features", po::value<std::size_t>()->default_value(FeaturesClassifier::getDefaultTrainFeatureSettings().size()), "number of features per individual")
+		("iterations", po::value<std::size_t>()->default_value(FeaturesClassifier::TrainSettings {}.iterationCount), "number of training iterations")
+		("sample-count-per-neuron", po::value<float>()->default_value(FeaturesClassifier::TrainSettings {}.sampleCountPerNeuron), "number of samples per neuron")
+		("report", po::value<std::string>(), "quality vs training time CSV report of the default and the best feature sets")
+		;
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+
+		if (vm.count("help"))
 		{
-			std::cerr << "usage: <lms_conf_file> <nb_workers>" << std::endl;
-			return EXIT_FAILURE;
+			std::cout << desc << std::endl;
+			return EXIT_SUCCESS;
 		}
 
-		const std::filesystem::path configFilePath {std::string(argv[1], 0, 256)};
-		const std::size_t nbWorkers = atoi(argv[2]);
+		const std::uint32_t seed {vm["seed"].as<std::uint32_t>()};
+		// breeding and mutations are made in this thread
+		Random::getRandGenerator().seed(seed);
 
-		ServiceProvider<Config>::create(configFilePath);
+		Service<IConfig> config {createConfig(vm["conf"].as<std::string>())};
 
-		Database::Db db {ServiceProvider<Config>::get()->getPath("working-dir") / "lms.db"};
-		Database::SessionPool sessionPool {db, nbWorkers};
+		Database::Db db {config->getPath("working-dir") / "lms.db"};
+		Database::Session session {db};
 
-		std::cout << "Caching all features..." << std::endl;
-		// Cache all the features of all the music in order to speed up the multiple trainings
-		const auto cachedFeatures { constructFeaturesCache(Database::SessionPool::ScopedSession {sessionPool}.get(), featuresSettings) };
-		std::cout << "Caching all features DONE" << std::endl;
+		std::cout << "Loading features..." << std::endl;
+		const std::optional<std::size_t> maxTrackCount {vm.count("max-tracks") ? std::make_optional(vm["max-tracks"].as<std::size_t>()) : std::nullopt};
+		const FeaturesMatrix featuresMatrix {loadFeaturesMatrix(session, maxTrackCount)};
+		const std::vector<FeatureName> featureNames {featuresMatrix.getCompleteFeatureNames()};
+		std::cout << "Loaded " << featuresMatrix.getTrackCount() << " tracks, " << featureNames.size() << " usable features" << std::endl;
 
-		FeaturesSearcher::setFeaturesFetchFunc(
-				[&](Database::IdType trackId, const FeatureNames& featureNames)
-				{
-					return getFeaturesFromCache(cachedFeatures, trackId, featureNames);
-				});
+		const std::size_t nbFeatures {vm["features"].as<std::size_t>()};
+		if (featuresMatrix.getTrackCount() == 0 || featureNames.size() < nbFeatures || nbFeatures == 0)
+			throw std::runtime_error {"Not enough tracks or features"};
 
-		// Create some random settings (i.e random population)
-		std::vector<FeatureSettingsMap> initialPopulation;
+		EvaluationCache evaluationCache {featuresMatrix, seed};
 
-		constexpr std::size_t populationSize {200};
-		constexpr std::size_t nbFeatures {5};
+		FeaturesClassifier::TrainSettings trainSettings;
+		trainSettings.iterationCount = vm["iterations"].as<std::size_t>();
+		trainSettings.sampleCountPerNeuron = vm["sample-count-per-neuron"].as<float>();
 
+		// Create some random settings (i.e random population)
+		std::vector<FeatureSettingsMap> initialPopulation;
+		const std::size_t populationSize {vm["population"].as<std::size_t>()};
 		for (std::size_t i {}; i < populationSize; ++i)
 		{
 			FeatureSettingsMap settings;
-
 			while (settings.size() < nbFeatures)
-			{
-				const auto itFeatureSetting {Random::pickRandom(featuresSettings)};
-				settings.emplace(itFeatureSetting->first, itFeatureSetting->second);
-			}
+				settings.emplace(*Random::pickRandom(featureNames), FeatureSettings {1});
 
 			initialPopulation.emplace_back(std::move(settings));
 		}
 
-		FeaturesSearcher::TrainSettings trainSettings;
-		trainSettings.iterationCount = 8;
-		trainSettings.sampleCountPerNeuron = 1.5;
-
 		GeneticAlgorithm<FeatureSettingsMap>::Params params;
-		params.nbWorkers = nbWorkers;
-		params.nbGenerations = 1;
+		params.nbWorkers = std::max<std::size_t>(vm["workers"].as<std::size_t>(), 1);
+		params.nbGenerations = vm["generations"].as<std::size_t>();
 		params.crossoverRatio = 0.78;
 		params.mutationProbability = 0.2;
 		params.breedFunction = breedFeatureSettingsMap;
-		params.mutateFunction = mutateFeatureSettingsMap;
-		params.scoreFunction =
-			[&](const FeatureSettingsMap& featureSettings)
-			{
-				FeaturesSearcher::TrainSettings settings {trainSettings};
-				settings.featureSettingsMap = featureSettings;
-
-				Database::SessionPool::ScopedSession scopedSession {sessionPool};
-				return computeSimilarityScore(scopedSession.get(), settings);
-			};
+		params.mutateFunction = [&](FeatureSettingsMap& featureSettings) { mutateFeatureSettingsMap(featureSettings, featureNames); };
+		params.scoreFunction = [&](const FeatureSettingsMap& featureSettings)
+		{
+			FeaturesClassifier::TrainSettings settings {trainSettings};
+			settings.featureSettingsMap = featureSettings;
 
-		GeneticAlgorithm<FeatureSettingsMap> geneticAlgorithm {params};
+			return evaluationCache.get(settings).score;
+		};
 
 		std::cout << "Parameters:\n"
-			<< "\tnb total settings = "<< featuresSettings.size() << "\n"
+			<< "\tnb usable features = "<< featureNames.size() << "\n"
 			<< "\tnb generations = " << params.nbGenerations << "\n"
 			<< "\tpopulationSize = " << populationSize << "\n"
 			<< "\tnbFeatures = " << nbFeatures << "\n"
 			<< "\tcrossoverRatio = " << params.crossoverRatio << "\n"
 			<< "\tmutationProbability = " << params.mutationProbability << "\n"
+			<< "\tnbWorkers = " << params.nbWorkers << "\n"
 			<< std::endl;
-			
+
 		std::cout << "Starting simulation..." << std::endl;
+		GeneticAlgorithm<FeatureSettingsMap> geneticAlgorithm {params};
 		const FeatureSettingsMap selectedSettings {geneticAlgorithm.simulate(initialPopulation)};
-		std::cout << "Simulation complete! Best result:" << std::endl;
-		printFeatureSettingsMap(selectedSettings);
 
-		// print all badly classified tracks
+		std::cout << "Simulation complete!" << std::endl;
+		std::cout << "Best feature set: " << featureSettingsMapToString(selectedSettings) << std::endl;
+
+		std::vector<std::pair<std::string, FeatureSettingsMap>> reportedFeatureSets;
+
+		const FeatureSettingsMap& defaultFeatureSettings {FeaturesClassifier::getDefaultTrainFeatureSettings()};
+		const bool defaultFeaturesUsable {std::all_of(std::cbegin(defaultFeatureSettings), std::cend(defaultFeatureSettings),
+				[&](const auto& itFeatureSetting) { return std::binary_search(std::cbegin(featureNames), std::cend(featureNames), itFeatureSetting.first); })};
+		if (defaultFeaturesUsable)
 		{
-			FeaturesSearcher::TrainSettings settings {trainSettings};
-			settings.featureSettingsMap = selectedSettings;
+			FeaturesClassifier::TrainSettings defaultTrainSettings {trainSettings};
+			defaultTrainSettings.featureSettingsMap = defaultFeatureSettings;
 
-			Database::SessionPool::ScopedSession scopedSession {sessionPool};
-			printBadlyClassifiedTracks(scopedSession.get(), settings);
+			std::cout << "Default feature set score = " << evaluationCache.get(defaultTrainSettings).score << std::endl;
+			reportedFeatureSets.emplace_back("default", defaultFeatureSettings);
+		}
+		else
+			std::cout << "Default feature set not available for all the tracks" << std::endl;
+
+		reportedFeatureSets.emplace_back("best", selectedSettings);
+
+		if (vm.count("report"))
+		{
+			std::ofstream report {vm["report"].as<std::string>()};
+			if (!report)
+				throw std::runtime_error {"Cannot open report file"};
+
+			std::cout << "Writing report..." << std::endl;
+			writeReport(report, evaluationCache, reportedFeatureSets);
 		}
 	}
 	catch (std::exception& e)
 	{
 		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
 	}
 
 	return EXIT_SUCCESS;
 }
-
-
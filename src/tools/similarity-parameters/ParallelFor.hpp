@@ -17,10 +17,19 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
+#include <exception>
 #include <functional>
+#include <mutex>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 
+// Calls func on each element, using nbWorkers threads (including the calling one)
+// The first exception thrown by func is rethrown once all the tasks are processed
 template <typename It, typename Func>
 void parallel_foreach(std::size_t nbWorkers, It begin, It end, Func&& func)
 {
@@ -29,10 +38,25 @@ void parallel_foreach(std::size_t nbWorkers, It begin, It end, Func&& func)
 
 	boost::asio::io_context ioContext;
 
+	std::mutex exceptionMutex;
+	std::exception_ptr exception;
+
 	for (It it {begin}; it != end; ++it)
 	{
-		auto refValue {std::ref<typename It::value_type>(*it)};
-		ioContext.post([refValue, &func]() { std::cout << "EXEC FROM WORKER" << std::endl; func(refValue); std::cout << "END EXEC FROM WORKER" << std::endl; });
+		auto& value {*it};
+		boost::asio::post(ioContext, [&value, &func, &exceptionMutex, &exception]
+		{
+			try
+			{
+				func(value);
+			}
+			catch (...)
+			{
+				std::scoped_lock lock {exceptionMutex};
+				if (!exception)
+					exception = std::current_exception();
+			}
+		});
 	}
 
 	std::vector<std::thread> threads;
@@ -43,5 +67,7 @@ void parallel_foreach(std::size_t nbWorkers, It begin, It end, Func&& func)
 
 	for (std::thread& t : threads)
 		t.join();
-}
 
+	if (exception)
+		std::rethrow_exception(exception);
+}